@@ -0,0 +1,82 @@
+"""Anchor erosions, dilations, openings and closings of NumPy arrays.
+
+The arrays are processed where they are, whatever their strides: the
+result is written to out, which may be the input array for an in place
+computation, or to a new array. The GIL is released during the
+computation.
+
+The radius is given in the order of the axes of the array. lines = 0
+selects a box, otherwise a polygon with that number of lines.
+"""
+
+import ctypes
+import os
+
+import numpy
+
+_lib = ctypes.CDLL(os.environ.get('ANCHOR_STRIDED_LIBRARY',
+                                  os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                               'libanchorStrided.so')))
+_lib.anchorStridedMorphology.restype = ctypes.c_int
+_lib.anchorStridedMorphology.argtypes = [
+    ctypes.c_int, ctypes.c_uint, ctypes.c_int, ctypes.c_uint,
+    ctypes.POINTER(ctypes.c_ulong),
+    ctypes.c_void_p, ctypes.POINTER(ctypes.c_long),
+    ctypes.c_void_p, ctypes.POINTER(ctypes.c_long),
+    ctypes.POINTER(ctypes.c_ulong)]
+
+# must match anchorStrided.cxx
+_PIXEL_TYPES = {numpy.dtype(numpy.uint8): 0,
+                numpy.dtype(numpy.uint16): 1,
+                numpy.dtype(numpy.int16): 2,
+                numpy.dtype(numpy.float32): 3}
+ERODE, DILATE, OPEN, CLOSE = range(4)
+
+
+def _run(operation, image, radius, lines, out):
+    image = numpy.asanyarray(image)
+    if image.dtype not in _PIXEL_TYPES:
+        raise TypeError('unsupported pixel type %s' % image.dtype)
+    if image.ndim not in (2, 3):
+        raise ValueError('only 2D and 3D arrays are supported')
+    if out is None:
+        out = numpy.empty_like(image)
+    elif out.shape != image.shape or out.dtype != image.dtype:
+        raise ValueError('out must have the shape and type of the input')
+    elif not out.flags.writeable:
+        raise ValueError('out is read only')
+    if numpy.isscalar(radius):
+        radius = (radius,) * image.ndim
+    if len(radius) != image.ndim:
+        raise ValueError('one radius per axis is needed')
+
+    # the last axis of the array is the first dimension of the image
+    dim = image.ndim
+    rad = (ctypes.c_ulong * dim)(*reversed([int(r) for r in radius]))
+    size = (ctypes.c_ulong * dim)(*reversed(image.shape))
+    in_strides = (ctypes.c_long * dim)(*reversed(image.strides))
+    out_strides = (ctypes.c_long * dim)(*reversed(out.strides))
+    status = _lib.anchorStridedMorphology(
+        _PIXEL_TYPES[image.dtype], dim, operation, int(lines), rad,
+        image.ctypes.data, in_strides, out.ctypes.data, out_strides, size)
+    if status == 1:
+        raise TypeError('unsupported pixel type or dimension')
+    if status:
+        raise RuntimeError('anchor morphology failed')
+    return out
+
+
+def erode(image, radius, lines=0, out=None):
+    return _run(ERODE, image, radius, lines, out)
+
+
+def dilate(image, radius, lines=0, out=None):
+    return _run(DILATE, image, radius, lines, out)
+
+
+def opening(image, radius, lines=0, out=None):
+    return _run(OPEN, image, radius, lines, out)
+
+
+def closing(image, radius, lines=0, out=None):
+    return _run(CLOSE, image, radius, lines, out)
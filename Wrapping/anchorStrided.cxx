@@ -0,0 +1,94 @@
+// C entry point to AnchorStridedMorphology, for the Python module
+// anchorMorphology.py, which calls it through ctypes. ctypes releases
+// the GIL during the call, and the arrays are passed as pointers and
+// byte strides, so nothing is copied.
+
+#include "itkAnchorStridedMorphology.h"
+
+namespace {
+
+enum { UCHAR, USHORT, SHORT, FLOAT };
+
+template <class TPixel, unsigned int VDimension>
+int run(int operation, unsigned int lines, const unsigned long * radius,
+	const void * input, const long * inputStrides,
+	void * output, const long * outputStrides,
+	const unsigned long * size)
+{
+  typedef itk::AnchorStridedMorphology<TPixel, VDimension> StridedType;
+  typename StridedType::KernelType::RadiusType Rad;
+  typename StridedType::StrideType InStrides, OutStrides;
+  typename StridedType::SizeType Size;
+  for (unsigned d = 0; d < VDimension; d++)
+    {
+    Rad[d] = radius[d];
+    InStrides[d] = inputStrides[d];
+    OutStrides[d] = outputStrides[d];
+    Size[d] = size[d];
+    }
+  try
+    {
+    typename StridedType::Pointer strided = StridedType::New();
+    if (lines)
+      {
+      strided->SetKernel(StridedType::KernelType::Poly(Rad, lines));
+      }
+    else
+      {
+      strided->SetKernel(StridedType::KernelType::Box(Rad));
+      }
+    strided->SetOperation((typename StridedType::OperationType)operation);
+    strided->Run(static_cast<const TPixel *>(input), InStrides,
+		 static_cast<TPixel *>(output), OutStrides, Size);
+    }
+  catch (itk::ExceptionObject & excep)
+    {
+    std::cerr << excep << std::endl;
+    return 2;
+    }
+  return 0;
+}
+
+template <class TPixel>
+int runDimension(unsigned int dimension, int operation, unsigned int lines,
+		 const unsigned long * radius,
+		 const void * input, const long * inputStrides,
+		 void * output, const long * outputStrides,
+		 const unsigned long * size)
+{
+  switch (dimension)
+    {
+    case 2:
+      return run<TPixel, 2>(operation, lines, radius, input, inputStrides, output, outputStrides, size);
+    case 3:
+      return run<TPixel, 3>(operation, lines, radius, input, inputStrides, output, outputStrides, size);
+    }
+  return 1;
+}
+
+}
+
+/** Returns 0 on success, 1 for an unsupported pixel type or
+ * dimension, 2 if the computation failed. Dimension 0 is the fastest
+ * varying one. lines == 0 selects a box, otherwise a polygon with
+ * that number of lines. */
+extern "C" int anchorStridedMorphology(int pixelType, unsigned int dimension,
+				       int operation, unsigned int lines,
+				       const unsigned long * radius,
+				       const void * input, const long * inputStrides,
+				       void * output, const long * outputStrides,
+				       const unsigned long * size)
+{
+  switch (pixelType)
+    {
+    case UCHAR:
+      return runDimension<unsigned char>(dimension, operation, lines, radius, input, inputStrides, output, outputStrides, size);
+    case USHORT:
+      return runDimension<unsigned short>(dimension, operation, lines, radius, input, inputStrides, output, outputStrides, size);
+    case SHORT:
+      return runDimension<short>(dimension, operation, lines, radius, input, inputStrides, output, outputStrides, size);
+    case FLOAT:
+      return runDimension<float>(dimension, operation, lines, radius, input, inputStrides, output, outputStrides, size);
+    }
+  return 1;
+}
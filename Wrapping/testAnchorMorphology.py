@@ -0,0 +1,96 @@
+"""Check anchorMorphology on strided NumPy views.
+
+Each operation on a view, with negative and non unit strides, must
+give what it gives on a contiguous copy of the view, and the box
+erosions and dilations must match a brute force NumPy version. The
+results are also written to a strided view of another array and in
+place, leaving the rest of the arrays alone.
+
+Usage: testAnchorMorphology.py module_directory radius
+"""
+
+import itertools
+import sys
+
+sys.path.insert(0, sys.argv[1])
+import numpy
+import anchorMorphology
+
+RADIUS = int(sys.argv[2])
+OPERATIONS = (anchorMorphology.erode, anchorMorphology.dilate,
+              anchorMorphology.opening, anchorMorphology.closing)
+failures = []
+
+
+def check(condition, message):
+    if not condition:
+        failures.append(message)
+
+
+def box_reference(image, radius, erode):
+    # the pixels outside the image never win
+    info = numpy.iinfo(image.dtype)
+    fill = erode and info.max or info.min
+    combine = erode and numpy.minimum or numpy.maximum
+    padded = numpy.pad(image, [(radius, radius)] * image.ndim,
+                       'constant', constant_values=fill)
+    result = image.copy()
+    for shift in itertools.product(range(2 * radius + 1), repeat=image.ndim):
+        window = tuple(slice(s, s + n) for s, n in zip(shift, image.shape))
+        result = combine(result, padded[window])
+    return result
+
+
+def check_view(name, base, view, lines):
+    plain = numpy.ascontiguousarray(view)
+    for op in OPERATIONS:
+        label = '%s %s lines=%d' % (name, op.__name__, lines)
+        expected = op(plain, RADIUS, lines)
+        check(numpy.array_equal(op(view, RADIUS, lines), expected),
+              label + ': view differs from the contiguous copy')
+        if lines == 0 and op in (anchorMorphology.erode, anchorMorphology.dilate):
+            check(numpy.array_equal(expected,
+                                    box_reference(plain, RADIUS, op is anchorMorphology.erode)),
+                  label + ': differs from the NumPy box')
+
+        # to a view of another array with the same layout
+        out_base = numpy.zeros_like(base)
+        out_view = out_base[view_slices[name]]
+        op(view, RADIUS, lines, out=out_view)
+        check(numpy.array_equal(out_view, expected), label + ': out view differs')
+        mask = numpy.ones(base.shape, bool)
+        mask[view_slices[name]] = False
+        check(not out_base[mask].any(), label + ': out written outside the view')
+
+        # in place
+        work = base.copy()
+        work_view = work[view_slices[name]]
+        op(work_view, RADIUS, lines, out=work_view)
+        check(numpy.array_equal(work_view, expected), label + ': in place differs')
+        check(numpy.array_equal(work[mask], base[mask]),
+              label + ': in place written outside the view')
+
+
+rng = numpy.random.RandomState(7)
+base2 = rng.randint(0, 256, (3 * 40, 2 * 50 + 1)).astype(numpy.uint8)
+base3 = rng.randint(0, 256, (2 * 12, 20, 3 * 15)).astype(numpy.uint8)
+view_slices = {'2D': (slice(1, None, 3), slice(None, None, -2)),
+               '3D': (slice(None, None, 2), slice(None), slice(None, None, -3))}
+
+for lines in (0, 4):
+    check_view('2D', base2, base2[view_slices['2D']], lines)
+check_view('3D', base3, base3[view_slices['3D']], 0)
+
+# the transpose of a view is a view too
+view = base2[view_slices['2D']]
+check(numpy.array_equal(anchorMorphology.dilate(view.T, RADIUS),
+                        box_reference(numpy.ascontiguousarray(view.T), RADIUS, False)),
+      'transposed view differs from the NumPy box')
+
+# a kernel without lines copies the view
+check(numpy.array_equal(anchorMorphology.erode(view, 0), view),
+      'radius 0 did not copy the view')
+
+for f in failures:
+    print(f)
+sys.exit(failures and 1 or 0)
@@ -0,0 +1,604 @@
+// Batch erosions, dilations, openings and closings of raw and
+// MetaImage volumes.
+//
+// usage: anchorBatch jobfile [outputdir]
+//
+// The job file has one job per line, blank lines and lines starting
+// with # being ignored:
+//
+//   operation kernel radius type input output [size]
+//
+//   operation  erode, dilate, open or close
+//   kernel     box, polyN for a polygon or polyhedron of N lines, or
+//              periodic for a disc or a sphere with periodic lines
+//   radius     a single value, or one per dimension: 5x5x2
+//   type       uchar, ushort, short or float
+//   input      a .mhd file with its data in a separate raw file, or a
+//              raw file, whose size must then be given: 256x256x40
+//   output     a .mhd or raw file, with the size and type of the input
+//
+// Relative inputs are relative to the job file, relative outputs to
+// outputdir, the directory of the job file by default.
+//
+// The volumes are not read but memory mapped, and the output is
+// written through a mapped file. While a job is computed, the input of
+// the next one is already mapped and the system is asked to page it
+// in, so the reads overlap the computation, unless the next job reads
+// the output of this one. The output and its header are written to
+// temporary files renamed over the output at the end of the job, so a
+// job may write over its own input and a failed job leaves no
+// partial output.
+
+#include "itkAnchorStridedMorphology.h"
+#include "itkTimeProbe.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+struct Job
+{
+  unsigned int Line;
+  std::string Operation;
+  std::string Kernel;
+  std::vector<unsigned long> Radius;
+  std::string Type;
+  std::string Input;
+  std::string Output;
+  std::vector<unsigned long> Size;
+};
+
+// a file mapped in memory, the pixels starting at Data
+struct MappedVolume
+{
+  MappedVolume() : Map(0), MapLength(0), Data(0) {}
+  void * Map;
+  size_t MapLength;
+  char * Data;
+  std::vector<unsigned long> Size;
+  std::string Type;
+  // MetaImage fields copied to the output header
+  std::string Spacing;
+  std::string Offset;
+  // for an output, the file the temporary file is renamed to
+  std::string FileName;
+  // and the header renamed after it, if any
+  std::string HeaderName;
+};
+
+std::string dirName(const std::string &path)
+{
+  std::string::size_type slash = path.rfind('/');
+  if (slash == std::string::npos)
+    {
+    return ".";
+    }
+  return path.substr(0, slash);
+}
+
+std::string joinPath(const std::string &dir, const std::string &name)
+{
+  if (name.empty() || name[0] == '/')
+    {
+    return name;
+    }
+  return dir + "/" + name;
+}
+
+bool endsWith(const std::string &s, const std::string &end)
+{
+  return s.size() >= end.size() && s.compare(s.size() - end.size(), end.size(), end) == 0;
+}
+
+// the raw file of an output
+std::string outputRawName(const Job &job)
+{
+  if (endsWith(job.Output, ".mhd"))
+    {
+    return job.Output.substr(0, job.Output.size() - 4) + ".raw";
+    }
+  return job.Output;
+}
+
+bool sameFile(const std::string &a, const std::string &b)
+{
+  struct stat sa, sb;
+  if (a == b)
+    {
+    return true;
+    }
+  return !stat(a.c_str(), &sa) && !stat(b.c_str(), &sb) &&
+    sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+// whether next reads the output of job
+bool readsOutput(const Job &next, const Job &job)
+{
+  return sameFile(next.Input, job.Output) || sameFile(next.Input, outputRawName(job));
+}
+
+// 5x5x2 or 5
+bool parseList(const std::string &s, std::vector<unsigned long> &values)
+{
+  values.clear();
+  std::istringstream in(s);
+  std::string item;
+  while (std::getline(in, item, 'x'))
+    {
+    char * end;
+    unsigned long v = strtoul(item.c_str(), &end, 10);
+    if (item.empty() || *end)
+      {
+      return false;
+      }
+    values.push_back(v);
+    }
+  return !values.empty();
+}
+
+unsigned int pixelSize(const std::string &type)
+{
+  if (type == "uchar") return sizeof(unsigned char);
+  if (type == "ushort") return sizeof(unsigned short);
+  if (type == "short") return sizeof(short);
+  if (type == "float") return sizeof(float);
+  return 0;
+}
+
+std::string metaType(const std::string &type)
+{
+  if (type == "uchar") return "MET_UCHAR";
+  if (type == "ushort") return "MET_USHORT";
+  if (type == "short") return "MET_SHORT";
+  if (type == "float") return "MET_FLOAT";
+  return "";
+}
+
+unsigned long numberOfPixels(const std::vector<unsigned long> &size)
+{
+  unsigned long n = 1;
+  for (unsigned i = 0; i < size.size(); i++)
+    {
+    n *= size[i];
+    }
+  return n;
+}
+
+bool readJobs(const char * fileName, const std::string &outputDir, std::vector<Job> &jobs)
+{
+  std::ifstream in(fileName);
+  if (!in)
+    {
+    std::cerr << "Can't read " << fileName << std::endl;
+    return false;
+    }
+  std::string inputDir = dirName(fileName);
+  std::string text;
+  unsigned int line = 0;
+  while (std::getline(in, text))
+    {
+    ++line;
+    std::istringstream fields(text);
+    Job job;
+    job.Line = line;
+    if (!(fields >> job.Operation) || job.Operation[0] == '#')
+      {
+      continue;
+      }
+    std::string radius, size;
+    if (!(fields >> job.Kernel >> radius >> job.Type >> job.Input >> job.Output))
+      {
+      std::cerr << fileName << ":" << line << ": missing fields" << std::endl;
+      return false;
+      }
+    fields >> size;
+    if (job.Operation != "erode" && job.Operation != "dilate" &&
+	job.Operation != "open" && job.Operation != "close")
+      {
+      std::cerr << fileName << ":" << line << ": unknown operation " << job.Operation << std::endl;
+      return false;
+      }
+    if (job.Kernel != "box" && job.Kernel != "periodic" && job.Kernel.compare(0, 4, "poly") != 0)
+      {
+      std::cerr << fileName << ":" << line << ": unknown kernel " << job.Kernel << std::endl;
+      return false;
+      }
+    if (!parseList(radius, job.Radius))
+      {
+      std::cerr << fileName << ":" << line << ": bad radius " << radius << std::endl;
+      return false;
+      }
+    if (!pixelSize(job.Type))
+      {
+      std::cerr << fileName << ":" << line << ": unknown type " << job.Type << std::endl;
+      return false;
+      }
+    if (!size.empty() && !parseList(size, job.Size))
+      {
+      std::cerr << fileName << ":" << line << ": bad size " << size << std::endl;
+      return false;
+      }
+    job.Input = joinPath(inputDir, job.Input);
+    job.Output = joinPath(outputDir, job.Output);
+    jobs.push_back(job);
+    }
+  return true;
+}
+
+// the key = value pairs of a MetaImage header
+bool readMetaHeader(const std::string &fileName, std::map<std::string, std::string> &header)
+{
+  std::ifstream in(fileName.c_str());
+  if (!in)
+    {
+    return false;
+    }
+  std::string text;
+  while (std::getline(in, text))
+    {
+    std::string::size_type eq = text.find('=');
+    if (eq == std::string::npos)
+      {
+      continue;
+      }
+    std::string key = text.substr(0, eq);
+    std::string value = text.substr(eq + 1);
+    key.erase(key.find_last_not_of(" \t\r") + 1);
+    value.erase(0, value.find_first_not_of(" \t"));
+    value.erase(value.find_last_not_of(" \t\r") + 1);
+    header[key] = value;
+    }
+  return true;
+}
+
+bool mapInput(const Job &job, MappedVolume &volume)
+{
+  std::string rawName = job.Input;
+  size_t headerSize = 0;
+  volume.Size = job.Size;
+  volume.Type = job.Type;
+  if (endsWith(job.Input, ".mhd"))
+    {
+    std::map<std::string, std::string> header;
+    if (!readMetaHeader(job.Input, header))
+      {
+      std::cerr << "Can't read " << job.Input << std::endl;
+      return false;
+      }
+    if (header["ElementType"] != metaType(job.Type))
+      {
+      std::cerr << job.Input << " has type " << header["ElementType"] << ", not " << job.Type << std::endl;
+      return false;
+      }
+    if (header["CompressedData"] == "True" ||
+	(pixelSize(job.Type) > 1 && (header["BinaryDataByteOrderMSB"] == "True" ||
+				     header["ElementByteOrderMSB"] == "True")))
+      {
+      std::cerr << job.Input << " is compressed or big endian, it can't be mapped" << std::endl;
+      return false;
+      }
+    if (header["ElementDataFile"].empty() || header["ElementDataFile"] == "LOCAL")
+      {
+      std::cerr << job.Input << " must have its data in a separate file" << std::endl;
+      return false;
+      }
+    volume.Size.clear();
+    std::istringstream dims(header["DimSize"]);
+    unsigned long d;
+    while (dims >> d)
+      {
+      volume.Size.push_back(d);
+      }
+    if (!header["HeaderSize"].empty())
+      {
+      headerSize = strtoul(header["HeaderSize"].c_str(), 0, 10);
+      }
+    volume.Spacing = header["ElementSpacing"];
+    volume.Offset = header["Offset"];
+    rawName = joinPath(dirName(job.Input), header["ElementDataFile"]);
+    }
+  if (volume.Size.size() < 2 || volume.Size.size() > 3)
+    {
+    std::cerr << job.Input << ": only 2D and 3D volumes of known size are supported" << std::endl;
+    return false;
+    }
+  if (job.Radius.size() != 1 && job.Radius.size() != volume.Size.size())
+    {
+    std::cerr << "line " << job.Line << ": the radius doesn't match the dimension of " << job.Input << std::endl;
+    return false;
+    }
+
+  size_t bytes = numberOfPixels(volume.Size) * pixelSize(job.Type);
+  int fd = open(rawName.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+    std::cerr << "Can't open " << rawName << std::endl;
+    return false;
+    }
+  struct stat st;
+  if (fstat(fd, &st) || (size_t)st.st_size < headerSize + bytes)
+    {
+    std::cerr << rawName << " is too small for the volume" << std::endl;
+    close(fd);
+    return false;
+    }
+  volume.MapLength = headerSize + bytes;
+  volume.Map = mmap(0, volume.MapLength, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (volume.Map == MAP_FAILED)
+    {
+    std::cerr << "Can't map " << rawName << std::endl;
+    volume.Map = 0;
+    return false;
+    }
+  volume.Data = static_cast<char *>(volume.Map) + headerSize;
+  // page in ahead of the computation
+  madvise(volume.Map, volume.MapLength, MADV_WILLNEED);
+  return true;
+}
+
+// remove the temporary header of an output
+void unlinkHeader(MappedVolume &volume)
+{
+  if (!volume.HeaderName.empty())
+    {
+    unlink((volume.HeaderName + ".tmp").c_str());
+    volume.HeaderName.clear();
+    }
+}
+
+bool mapOutput(const Job &job, const MappedVolume &input, MappedVolume &volume)
+{
+  std::string rawName = outputRawName(job);
+  volume.Size = input.Size;
+  volume.Type = input.Type;
+  if (endsWith(job.Output, ".mhd"))
+    {
+    std::string headerTemp = job.Output + ".tmp";
+    std::ofstream header(headerTemp.c_str());
+    header << "ObjectType = Image" << std::endl;
+    header << "NDims = " << volume.Size.size() << std::endl;
+    header << "BinaryData = True" << std::endl;
+    header << "BinaryDataByteOrderMSB = False" << std::endl;
+    if (!input.Offset.empty())
+      {
+      header << "Offset = " << input.Offset << std::endl;
+      }
+    if (!input.Spacing.empty())
+      {
+      header << "ElementSpacing = " << input.Spacing << std::endl;
+      }
+    header << "DimSize =";
+    for (unsigned i = 0; i < volume.Size.size(); i++)
+      {
+      header << " " << volume.Size[i];
+      }
+    header << std::endl;
+    header << "ElementType = " << metaType(volume.Type) << std::endl;
+    std::string::size_type slash = rawName.rfind('/');
+    header << "ElementDataFile = " << (slash == std::string::npos ? rawName : rawName.substr(slash + 1)) << std::endl;
+    header.close();
+    if (!header)
+      {
+      std::cerr << "Can't write " << headerTemp << std::endl;
+      unlink(headerTemp.c_str());
+      return false;
+      }
+    volume.HeaderName = job.Output;
+    }
+
+  // the input may be the raw file, so it is left alone until the
+  // end of the job
+  std::string tempName = rawName + ".tmp";
+  volume.MapLength = numberOfPixels(volume.Size) * pixelSize(volume.Type);
+  int fd = open(tempName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || ftruncate(fd, volume.MapLength))
+    {
+    std::cerr << "Can't create " << tempName << std::endl;
+    if (fd >= 0)
+      {
+      close(fd);
+      unlink(tempName.c_str());
+      }
+    unlinkHeader(volume);
+    return false;
+    }
+  volume.Map = mmap(0, volume.MapLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (volume.Map == MAP_FAILED)
+    {
+    std::cerr << "Can't map " << tempName << std::endl;
+    volume.Map = 0;
+    unlink(tempName.c_str());
+    unlinkHeader(volume);
+    return false;
+    }
+  volume.Data = static_cast<char *>(volume.Map);
+  volume.FileName = rawName;
+  return true;
+}
+
+void unmap(MappedVolume &volume)
+{
+  if (volume.Map)
+    {
+    munmap(volume.Map, volume.MapLength);
+    }
+  volume = MappedVolume();
+}
+
+// unmap an output, and rename its temporary files to the output if
+// keep is true or remove them. The header is renamed last, so that it
+// never names data that isn't there yet.
+bool closeOutput(MappedVolume &volume, bool keep)
+{
+  std::string rawName = volume.FileName;
+  std::string headerName = volume.HeaderName;
+  unmap(volume);
+  if (rawName.empty())
+    {
+    return !keep;
+    }
+  std::string tempName = rawName + ".tmp";
+  std::string headerTemp = headerName + ".tmp";
+  if (keep && !rename(tempName.c_str(), rawName.c_str()))
+    {
+    if (headerName.empty() || !rename(headerTemp.c_str(), headerName.c_str()))
+      {
+      return true;
+      }
+    std::cerr << "Can't rename " << headerTemp << " to " << headerName << std::endl;
+    unlink(headerTemp.c_str());
+    return false;
+    }
+  if (keep)
+    {
+    std::cerr << "Can't rename " << tempName << " to " << rawName << std::endl;
+    }
+  unlink(tempName.c_str());
+  if (!headerName.empty())
+    {
+    unlink(headerTemp.c_str());
+    }
+  return !keep;
+}
+
+template <class TPixel, unsigned int VDimension>
+void run(const Job &job, const MappedVolume &input, MappedVolume &output)
+{
+  typedef itk::AnchorStridedMorphology<TPixel, VDimension> StridedType;
+  typename StridedType::KernelType::RadiusType Rad;
+  typename StridedType::StrideType Strides;
+  typename StridedType::SizeType Size;
+  long stride = sizeof(TPixel);
+  for (unsigned d = 0; d < VDimension; d++)
+    {
+    Rad[d] = job.Radius.size() == 1 ? job.Radius[0] : job.Radius[d];
+    Size[d] = input.Size[d];
+    Strides[d] = stride;
+    stride *= input.Size[d];
+    }
+  typename StridedType::Pointer strided = StridedType::New();
+  if (job.Kernel == "box")
+    {
+    strided->SetKernel(StridedType::KernelType::Box(Rad));
+    }
+  else if (job.Kernel == "periodic")
+    {
+    strided->SetKernel(StridedType::KernelType::Periodic(Rad));
+    }
+  else
+    {
+    strided->SetKernel(StridedType::KernelType::Poly(Rad, atoi(job.Kernel.c_str() + 4)));
+    }
+  if (job.Operation == "erode") strided->SetOperation(StridedType::ERODE);
+  if (job.Operation == "dilate") strided->SetOperation(StridedType::DILATE);
+  if (job.Operation == "open") strided->SetOperation(StridedType::OPEN);
+  if (job.Operation == "close") strided->SetOperation(StridedType::CLOSE);
+  strided->Run(reinterpret_cast<const TPixel *>(input.Data), Strides,
+	       reinterpret_cast<TPixel *>(output.Data), Strides, Size);
+}
+
+template <class TPixel>
+void runDimension(const Job &job, const MappedVolume &input, MappedVolume &output)
+{
+  if (input.Size.size() == 2)
+    {
+    run<TPixel, 2>(job, input, output);
+    }
+  else
+    {
+    run<TPixel, 3>(job, input, output);
+    }
+}
+
+void runJob(const Job &job, const MappedVolume &input, MappedVolume &output)
+{
+  if (job.Type == "uchar") runDimension<unsigned char>(job, input, output);
+  if (job.Type == "ushort") runDimension<unsigned short>(job, input, output);
+  if (job.Type == "short") runDimension<short>(job, input, output);
+  if (job.Type == "float") runDimension<float>(job, input, output);
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " jobfile [outputdir]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::vector<Job> jobs;
+  if (!readJobs(argv[1], argc > 2 ? argv[2] : dirName(argv[1]), jobs))
+    {
+    return EXIT_FAILURE;
+    }
+
+  int status = EXIT_SUCCESS;
+  // the input of the current job, and the one being paged in
+  MappedVolume current, next;
+  bool currentOk = !jobs.empty() && mapInput(jobs[0], current);
+  for (unsigned i = 0; i < jobs.size(); i++)
+    {
+    // the input of the next job is only mapped now if it isn't the
+    // output of this one
+    bool chained = (i + 1 < jobs.size()) && readsOutput(jobs[i + 1], jobs[i]);
+    bool nextOk = (i + 1 < jobs.size()) && !chained && mapInput(jobs[i + 1], next);
+    MappedVolume output;
+    itk::TimeProbe timer;
+    if (currentOk && mapOutput(jobs[i], current, output))
+      {
+      timer.Start();
+      try
+	{
+	runJob(jobs[i], current, output);
+	msync(output.Map, output.MapLength, MS_ASYNC);
+	}
+      catch (itk::ExceptionObject & excep)
+	{
+	std::cerr << "line " << jobs[i].Line << ": " << excep << std::endl;
+	status = EXIT_FAILURE;
+	closeOutput(output, false);
+	}
+      timer.Stop();
+      }
+    else
+      {
+      status = EXIT_FAILURE;
+      }
+    if (output.Map)
+      {
+      double seconds = timer.GetMeanTime();
+      double pixels = numberOfPixels(current.Size);
+      std::cout << std::setprecision(3) << jobs[i].Operation << " " << jobs[i].Kernel
+		<< " " << jobs[i].Input << ": " << seconds << " s, "
+		<< pixels / seconds / 1e6 << " Mpixels/s, "
+		<< pixels * pixelSize(current.Type) / seconds / (1024 * 1024) << " MB/s" << std::endl;
+      if (!closeOutput(output, true))
+	{
+	status = EXIT_FAILURE;
+	}
+      }
+    unmap(current);
+    if (chained)
+      {
+      nextOk = mapInput(jobs[i + 1], next);
+      }
+    current = next;
+    currentOk = nextOk;
+    next = MappedVolume();
+    }
+  return status;
+}
@@ -0,0 +1,83 @@
+#ifndef __itkAnchorChordTable_h
+#define __itkAnchorChordTable_h
+
+#include "itkImage.h"
+#include "itkAnchorSmallKernel.h"
+#include <vector>
+
+namespace itk {
+
+class AnchorSweepMonitor;
+
+/**
+ * \class AnchorChordPlan
+ * \brief a flat kernel of any shape, such as Ball or a mask read with
+ * FromImage, as runs of contiguous pixels along the first axis, the
+ * chords, in the manner of Urbach and Wilkinson. Tables holds the
+ * distinct chord lengths, with the lengths in between needed to
+ * compute each one from a table at least half as long: table 0 is a
+ * single pixel, and table t of Length pixels is computed from table
+ * Source, shifted by Length minus the length of Source.
+**/
+template <unsigned int VDimension>
+class AnchorChordPlan
+{
+public:
+  typedef Offset<VDimension> OffsetType;
+  typedef Size<VDimension> RadiusType;
+
+  struct Chord
+  {
+    // the offset of the first pixel of the chord from the centre
+    OffsetType Start;
+    unsigned int Table;
+  };
+
+  struct Table
+  {
+    unsigned int Length;
+    unsigned int Source;
+  };
+
+  std::vector<Chord> Chords;
+  std::vector<Table> Tables;
+  RadiusType Radius;
+};
+
+/** The chords of the pixels of a flat kernel. With reflect, the
+ * kernel is mirrored through its centre, as the neighbourhood filters
+ * do for a dilation. */
+template <class TKernel>
+AnchorChordPlan<TKernel::NeighborhoodDimension>
+mkChordPlan(const TKernel &kernel, const bool reflect = false);
+
+/** An erosion or a dilation of input by the kernel of plan, over
+ * region. The running extrema, by TFunction, of the rows of input are
+ * computed once per row for each table, and each pixel of output
+ * takes the extremum of the entries of its chords, which are folded
+ * into the row of the output with AnchorRowFold. The cost per pixel
+ * grows with the number of chords and of tables, which is linear in
+ * the radius of a disc, rather than with the number of pixels of the
+ * kernel. The rows in reach of the row being computed are kept in a
+ * window of 2 * radius + 1 rows along each axis but the first.
+ *
+ * The pixels outside the buffered region of input are ignored, as
+ * the lines are clipped by the anchor filters, so region must be in
+ * the buffered region of input and the result is that of the
+ * neighbourhood filters with a boundary that never wins. input and
+ * output must be different images. If a monitor is given, it is told
+ * about every row, and the pass stops and returns false when the
+ * filter has been asked to abort. */
+template <class TImage, class TFunction>
+bool doChordPass(const TImage * input, TImage * output,
+		 const AnchorChordPlan<TImage::ImageDimension> &plan,
+		 const typename TImage::RegionType &region,
+		 AnchorSweepMonitor * monitor = 0);
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorChordTable.txx"
+#endif
+
+#endif
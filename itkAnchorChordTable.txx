@@ -0,0 +1,204 @@
+#ifndef __itkAnchorChordTable_txx
+#define __itkAnchorChordTable_txx
+
+#include "itkAnchorChordTable.h"
+#include "itkAnchorSweepMonitor.h"
+#include "itkNumericTraits.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TKernel>
+AnchorChordPlan<TKernel::NeighborhoodDimension>
+mkChordPlan(const TKernel &kernel, const bool reflect)
+{
+  typedef AnchorChordPlan<TKernel::NeighborhoodDimension> PlanType;
+  PlanType plan;
+  for (unsigned d = 0; d < TKernel::NeighborhoodDimension; d++)
+    {
+    plan.Radius[d] = kernel.GetRadius(d);
+    }
+  // the runs of the rows of the kernel, which are contiguous in its
+  // buffer
+  const unsigned long width = kernel.GetSize()[0];
+  std::vector<unsigned int> lengths;
+  for (unsigned long row = 0; row < kernel.Size(); row += width)
+    {
+    unsigned long x = 0;
+    while (x < width)
+      {
+      if (!kernel[row + x])
+	{
+	++x;
+	continue;
+	}
+      unsigned long first = x;
+      while ((x < width) && kernel[row + x]) ++x;
+      typename PlanType::Chord chord;
+      if (reflect)
+	{
+	// the mirrored run starts at the mirror of its last pixel
+	typename PlanType::OffsetType last = kernel.GetOffset(row + x - 1);
+	for (unsigned d = 0; d < TKernel::NeighborhoodDimension; d++)
+	  {
+	  chord.Start[d] = -last[d];
+	  }
+	}
+      else
+	{
+	chord.Start = kernel.GetOffset(row + first);
+	}
+      chord.Table = x - first;
+      plan.Chords.push_back(chord);
+      lengths.push_back(x - first);
+      }
+    }
+
+  // the tables, each at most twice as long as the previous one
+  std::sort(lengths.begin(), lengths.end());
+  lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+  typename PlanType::Table single;
+  single.Length = 1;
+  single.Source = 0;
+  plan.Tables.push_back(single);
+  for (unsigned i = 0; i < lengths.size(); i++)
+    {
+    while (plan.Tables.back().Length < lengths[i])
+      {
+      typename PlanType::Table table;
+      table.Source = plan.Tables.size() - 1;
+      table.Length = std::min(lengths[i], 2 * plan.Tables.back().Length);
+      plan.Tables.push_back(table);
+      }
+    }
+  // the chords refer to their table rather than to their length
+  for (unsigned c = 0; c < plan.Chords.size(); c++)
+    {
+    unsigned int t = 0;
+    while (plan.Tables[t].Length != plan.Chords[c].Table) ++t;
+    plan.Chords[c].Table = t;
+    }
+  return plan;
+}
+
+template <class TImage, class TFunction>
+bool doChordPass(const TImage * input, TImage * output,
+		 const AnchorChordPlan<TImage::ImageDimension> &plan,
+		 const typename TImage::RegionType &region,
+		 AnchorSweepMonitor * monitor)
+{
+  typedef typename TImage::PixelType PixelType;
+  typedef typename TImage::IndexType IndexType;
+  const unsigned int dim = TImage::ImageDimension;
+  const typename TImage::RegionType InReg = input->GetBufferedRegion();
+  const PixelType * inBuffer = input->GetBufferPointer();
+  PixelType * outBuffer = output->GetBufferPointer();
+  const long width = region.GetSize()[0];
+  if (!region.GetNumberOfPixels())
+    {
+    return true;
+    }
+
+  // the value that never wins: the largest one for an erosion, whose
+  // TFunction is less, and the smallest one for a dilation
+  TFunction compare;
+  const PixelType identity = compare(NumericTraits<PixelType>::max(),
+				     NumericTraits<PixelType>::NonpositiveMin()) ?
+    NumericTraits<PixelType>::NonpositiveMin() : NumericTraits<PixelType>::max();
+
+  // the part of the rows of input in reach of region, padded by the
+  // radius on both sides
+  const long radius = plan.Radius[0];
+  const long rowStart = std::max(InReg.GetIndex()[0], region.GetIndex()[0] - radius);
+  const long rowEnd = std::min(InReg.GetIndex()[0] + (long)InReg.GetSize()[0],
+			       region.GetIndex()[0] + width + radius);
+  const long span = rowEnd - rowStart;
+  const long padded = span + 2 * radius;
+
+  // the window of rows, each with its tables, and the row held by
+  // each slot
+  const unsigned int tables = plan.Tables.size();
+  unsigned long slots = 1;
+  std::vector<unsigned long> strides(dim, 0);
+  for (unsigned d = 1; d < dim; d++)
+    {
+    strides[d] = slots;
+    slots *= 2 * plan.Radius[d] + 1;
+    }
+  PixelType * window = new PixelType[slots * tables * padded];
+  std::vector<IndexType> held(slots);
+  std::vector<bool> filled(slots, false);
+
+  typename TImage::RegionType rows = region;
+  rows.SetSize(0, 1);
+  ImageRegionConstIteratorWithIndex<TImage> it(output, rows);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    const IndexType Ind = it.GetIndex();
+    PixelType * out = outBuffer + output->ComputeOffset(Ind);
+    std::fill(out, out + width, identity);
+    for (unsigned c = 0; c < plan.Chords.size(); c++)
+      {
+      const typename AnchorChordPlan<TImage::ImageDimension>::Chord &chord = plan.Chords[c];
+      // the row of the chord, if it is in the input
+      IndexType Row = Ind + chord.Start;
+      Row[0] = rowStart;
+      bool inside = true;
+      unsigned long slot = 0;
+      for (unsigned d = 1; d < dim; d++)
+	{
+	long pos = Row[d] - InReg.GetIndex()[d];
+	if ((pos < 0) || (pos >= (long)InReg.GetSize()[d]))
+	  {
+	  inside = false;
+	  break;
+	  }
+	slot += (pos % (2 * plan.Radius[d] + 1)) * strides[d];
+	}
+      if (!inside)
+	{
+	continue;
+	}
+      PixelType * rowTables = window + slot * tables * padded;
+      if (!filled[slot] || (held[slot] != Row))
+	{
+	// the single pixels, padded, then each table from its source
+	std::fill(rowTables, rowTables + radius, identity);
+	const PixelType * in = inBuffer + input->ComputeOffset(Row);
+	std::copy(in, in + span, rowTables + radius);
+	std::fill(rowTables + radius + span, rowTables + padded, identity);
+	for (unsigned t = 1; t < tables; t++)
+	  {
+	  const unsigned int length = plan.Tables[t].Length;
+	  const unsigned int source = plan.Tables[t].Source;
+	  const long valid = padded - (long)length + 1;
+	  if (valid <= 0)
+	    {
+	    continue;
+	    }
+	  const PixelType * src = rowTables + source * padded;
+	  PixelType * dest = rowTables + t * padded;
+	  std::copy(src, src + valid, dest);
+	  AnchorRowFold<PixelType, TFunction>::Apply(dest, src + length - plan.Tables[source].Length, valid);
+	  }
+	held[slot] = Row;
+	filled[slot] = true;
+	}
+      // the entry of the chord of the first pixel of the row
+      const long first = Ind[0] + chord.Start[0] - rowStart + radius;
+      AnchorRowFold<PixelType, TFunction>::Apply(out, rowTables + chord.Table * padded + first, width);
+      }
+    if (monitor && !monitor->Completed(width))
+      {
+      delete [] window;
+      return false;
+      }
+    }
+  delete [] window;
+  return true;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef __itkAnchorCloseBankImageFilter_h
+#define __itkAnchorCloseBankImageFilter_h
+
+#include "itkAnchorOpenCloseBankImageFilter.h"
+#include "itkImage.h"
+
+namespace itk {
+
+// the smallest of the closings by lines at several orientations
+template<class TImage, class TOrientationImage = Image<unsigned short, TImage::ImageDimension> >
+class  ITK_EXPORT AnchorCloseBankImageFilter :
+    public AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, std::greater<typename TImage::PixelType>, std::less<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType> >
+
+{
+public:
+  typedef AnchorCloseBankImageFilter Self;
+  typedef AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, std::greater<typename TImage::PixelType>, std::less<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType> > Superclass;
+
+  typedef SmartPointer<Self>   Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  virtual ~AnchorCloseBankImageFilter() {}
+protected:
+  AnchorCloseBankImageFilter(){}
+  void PrintSelf(std::ostream& os, Indent indent) const
+  {
+    os << indent << "Anchor closing bank: " << std::endl;
+  }
+
+private:
+  
+  AnchorCloseBankImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __itkAnchorClosingByReconstructionImageFilter_h
+#define __itkAnchorClosingByReconstructionImageFilter_h
+
+#include "itkAnchorOpenCloseByReconstructionImageFilter.h"
+
+namespace itk {
+
+template<class TImage, class TKernel>
+class  ITK_EXPORT AnchorClosingByReconstructionImageFilter :
+    public AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, std::greater<typename TImage::PixelType>, std::less<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType> >
+
+{
+public:
+  typedef AnchorClosingByReconstructionImageFilter Self;
+  typedef AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, std::greater<typename TImage::PixelType>, std::less<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType> > Superclass;
+
+  typedef SmartPointer<Self>   Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  virtual ~AnchorClosingByReconstructionImageFilter() {}
+protected:
+  AnchorClosingByReconstructionImageFilter(){}
+  void PrintSelf(std::ostream& os, Indent indent) const
+  {
+    os << indent << "Anchor closing by reconstruction: " << std::endl;
+  }
+
+private:
+  
+  AnchorClosingByReconstructionImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+
+} // namespace itk
+
+#endif
@@ -3,8 +3,17 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkProgressReporter.h"
+#include "itkAnchorSweepMonitor.h"
 #include "itkAnchorErodeDilateLine.h"
 #include "itkBresenhamLine.h"
+#include "itkAnchorUtilities.h"
+#include "itkFlatStructuringElement.h"
+#include "itkMultiThreader.h"
+#include "itkAnchorLineScheduler.h"
+#include "itkAnchorThreadPlacement.h"
+#include "itkAnchorSmallKernel.h"
+#include "itkAnchorChordTable.h"
+#include <vector>
 
 #define ANCHOR_ALGORITHM
 
@@ -15,6 +24,15 @@ namespace itk {
  * \brief class to implement erosions and dilations using anchor
  * methods. This is the base class that must be instantiated with
  * appropriate definitions of greater, less and so on
+ *
+ * Kernels that aren't decomposable, such as Ball or a mask read with
+ * FromImage, are computed exactly by their chords, see
+ * doChordPass, except in batch mode.
+ *
+ * With worker processes, see SetNumberOfProcesses, the workers share
+ * the whole input with the calling process through fork(), so the
+ * whole input must be resident, not just the slabs, and the output
+ * lives in a shared memory segment of the size of the image.
 
 **/
 template<class TImage, class TKernel, 
@@ -59,19 +77,248 @@ public:
   {
     m_Kernel=kernel;
     m_KernelSet = true;
+    m_SliceMode = false;
+    // the previous result was computed with another kernel
+    m_Previous = 0;
+    this->Modified();
   }
 
+  /** Kernel of one dimension less than the image, for batch mode */
+  typedef FlatStructuringElement<itkGetStaticConstMacro(InputImageDimension) - 1> SliceKernelType;
 
+  /** Batch mode: apply a kernel of one dimension less than the image
+   * to every slice perpendicular to axis, e.g. a 2D kernel to every
+   * slice of a stack or a 3D kernel to every frame of a time
+   * series. The lines are swept directly in the image, the plan is
+   * computed once and the slices are split between the threads. Replaces
+   * the kernel given to SetKernel. */
+  void SetSliceKernel( const SliceKernelType& kernel, unsigned int axis );
+
+  /** Process the image in tiles, applying several passes of the
+   * decomposition to a tile before moving to the next one. Tiles
+   * overlap by the reach of the lines, so the result is the same as
+   * without tiling, but much less of the image goes through main
+   * memory for each pass. Off by default. */
+  itkSetMacro(UseTiling, bool);
+  itkGetConstReferenceMacro(UseTiling, bool);
+  itkBooleanMacro(UseTiling);
+
+  /** The size of the part of a tile that is written to the output. A
+   * zero size means that it is computed from TileBytes. */
+  itkSetMacro(TileSize, SizeType);
+  itkGetConstReferenceMacro(TileSize, SizeType);
+
+  /** The memory, in bytes, that a tile including its halo should
+   * use. Should be about the size of the L2 cache. Default is 256K. */
+  itkSetMacro(TileBytes, unsigned long);
+  itkGetConstReferenceMacro(TileBytes, unsigned long);
+
+  /** The number of consecutive passes applied to a tile. The halo
+   * grows with the number of passes, so large structuring elements
+   * may do better with fewer. 0, the default, fuses all passes. */
+  itkSetMacro(FusedPasses, unsigned int);
+  itkGetConstReferenceMacro(FusedPasses, unsigned int);
+
+  /** Split the image into this number of slabs along the slowest
+   * axis and compute each slab in a separate worker process. Each
+   * worker copies its slab with a halo of the reach of the next
+   * FusedPasses passes, and the slabs of the result of each group of
+   * passes are exchanged through POSIX shared memory, which then
+   * holds the buffer of the output, without a copy. If a worker
+   * fails or is killed, the others are killed and an exception is
+   * thrown. Only used on Unix, when the whole image is requested and
+   * tiling is off. Default is 1, no worker process.
+   *
+   * The workers are started with fork(), which only copies the
+   * calling thread: if other threads of the process hold locks, of
+   * malloc or of an I/O library, a worker may deadlock. Only use
+   * worker processes from a process that has no other thread
+   * running, and before starting any. */
+  itkSetMacro(NumberOfProcesses, unsigned int);
+  itkGetConstReferenceMacro(NumberOfProcesses, unsigned int);
+
+  /** Sweep each pass with all the threads, which take chunks of
+   * neighbouring lines of about the same total length and steal
+   * chunks from each other when they run out. Balances the oblique
+   * directions, whose lines range from one pixel to the extent of
+   * the image. Also used in batch mode, instead of giving slabs of
+   * slices to the threads. Off by default. */
+  itkSetMacro(UseLineScheduler, bool);
+  itkGetConstReferenceMacro(UseLineScheduler, bool);
+  itkBooleanMacro(UseLineScheduler);
+
+  /** Allocate the output from the threads of the threaded sweeps,
+   * with the line scheduler or in batch mode, each thread touching
+   * first a slab of the image, so that on a NUMA machine the pages
+   * are spread over the nodes of the threads instead of all on the
+   * node of the allocating thread. In batch mode along a slice axis
+   * each thread sweeps its own slab, and its accesses stay on its
+   * node. Otherwise the line sweeps cross the slabs and only the
+   * bandwidth is balanced between the nodes. A no-op on hosts with a
+   * single node. Off by default. */
+  itkSetMacro(UseFirstTouch, bool);
+  itkGetConstReferenceMacro(UseFirstTouch, bool);
+  itkBooleanMacro(UseFirstTouch);
+
+  /** Pin the threads of the threaded sweeps to a list of CPUs, e.g.
+   * "0-7,16-23": thread i runs on the i-th CPU of the list, modulo
+   * its length. Empty, the default, leaves the threads to the
+   * system. Only used on Linux. */
+  void SetCPUList(const std::string &list)
+  {
+    if (!m_Placement.SetCPUList(list))
+      {
+      itkExceptionMacro("Invalid CPU list: " << list);
+      }
+    this->Modified();
+  }
+  const std::string & GetCPUList() const
+  {
+    return m_Placement.GetCPUList();
+  }
+
+  /** Compute the kernels made of short lines along the axes and the
+   * diagonals, such as the boxes and Poly kernels of radius up to 3,
+   * pass by pass on whole rows of the image: the neighbours along a
+   * line are read from the rows they are in, and folded into the row
+   * of the output with the vector instructions of the processor, see
+   * AnchorSimd. The result is the same as with the anchor lines. Only
+   * used when the whole image is requested, without tiling, worker
+   * processes, line scheduler or batch mode. On by default. */
+  itkSetMacro(UseSmallKernels, bool);
+  itkGetConstReferenceMacro(UseSmallKernels, bool);
+  itkBooleanMacro(UseSmallKernels);
+
+  /** Keep the result of the last update and, on the next one, only
+   * recompute the part of the output affected by the dirty
+   * regions. The affected region grows by the reach of each pass of
+   * the decomposition, and is recomputed from the input with a halo
+   * of the same size. The output shares its buffer with the kept
+   * result, so it must not be modified in place further down the
+   * pipeline. A full update is done the first time, when the kernel,
+   * the input image or the requested region changes, or when the
+   * input has been modified without a dirty region. Off by
+   * default. */
+  itkSetMacro(IncrementalUpdate, bool);
+  itkGetConstReferenceMacro(IncrementalUpdate, bool);
+  itkBooleanMacro(IncrementalUpdate);
+
+  /** Approximate the result for large structuring elements. The
+   * image is shrunk by a factor, each pixel keeping the extremum of its
+   * block, the lines are swept in the shrunk image with lengths
+   * divided by the factor, and the result is expanded and swept at
+   * full resolution with the remaining lengths. The structuring
+   * element this amounts to depends on the position of the pixel in
+   * its block, and is within a bounded number of pixels, along every
+   * axis, of the kernel. The largest factor whose bound is at most
+   * MaximumError is used. Only used when the whole image is requested,
+   * not in batch mode, and not with IncrementalUpdate. Default is 0,
+   * for the exact result. */
+  itkSetMacro(MaximumError, unsigned int);
+  itkGetConstReferenceMacro(MaximumError, unsigned int);
+
+  /** The bound on the error of the last update, in pixels, and the
+   * factor by which the image was shrunk: 0 and 1 if the result is
+   * exact. */
+  itkGetConstReferenceMacro(ApproximationError, unsigned int);
+  itkGetConstReferenceMacro(ShrinkFactor, unsigned int);
+
+  /** Record a part of the input that has changed since the last
+   * update. Only used with IncrementalUpdate. If the input has
+   * changed and no dirty region is given, the whole output is
+   * recomputed. */
+  void AddDirtyRegion(const InputImageRegionType &region)
+  {
+    m_DirtyRegions.push_back(region);
+    this->Modified();
+  }
+  void ClearDirtyRegions()
+  {
+    m_DirtyRegions.clear();
+  }
 
 protected:
   AnchorErodeDilateImageFilter();
   ~AnchorErodeDilateImageFilter() {};
   void PrintSelf(std::ostream& os, Indent indent) const;
 
+  /** The input needs to be larger than the output by the reach of the
+   * lines of the decomposition. */
+  void GenerateInputRequestedRegion();
+
   /** Single-threaded version of GenerateData.  This filter delegates
    * to GrayscaleGeodesicErodeImageFilter. */
   void GenerateData();
 
+  /** Tiled version of the sweep, used when UseTiling is on */
+  void GenerateTiledData();
+
+  /** Update the previous result in the dirty regions */
+  void GenerateIncrementalData();
+
+  /** Keep the output for the next incremental update */
+  void KeepResult();
+
+  /** Batch mode sweep, each thread taking a slab of slices */
+  void GenerateSliceData();
+
+  /** Sweep with the line scheduler */
+  void GenerateScheduledData();
+
+  /** The passes of a small kernel, on whole rows */
+  void GenerateSmallKernelData();
+
+  /** A kernel that isn't decomposable, by its chords */
+  void GenerateChordData();
+
+#ifdef ANCHOR_ALGORITHM
+  /** Sweep a shrunk image when MaximumError allows it. Returns false,
+   * without computing anything, if no line would be shrunk. */
+  bool GenerateApproximateData();
+#endif
+
+#ifndef _WIN32
+  /** Slabs computed by worker processes */
+  void GenerateProcessData();
+#endif
+
+  /** The length of the line buffers, which is the sum of the sizes
+   * of the region. The Bresenham lines depend on it, so in batch mode
+   * it is the one of a slice. */
+  unsigned int GetBufferLength(const InputImageRegionType &region) const
+  {
+    unsigned int bufflength = 0;
+    for (unsigned i = 0; i<TImage::ImageDimension; i++)
+      {
+      if (!m_SliceMode || (i != m_SliceAxis))
+	{
+	bufflength += region.GetSize()[i];
+	}
+      }
+    return bufflength;
+  }
+
+  /** The lines of the kernel, or of the slice kernel in batch mode */
+  const typename KernelType::DecompType & GetDecomposition() const
+  {
+    if (m_SliceMode)
+      {
+      return m_SliceLines;
+      }
+    return m_Kernel.GetLines();
+  }
+
+  /** The period of line i of the decomposition, 1 unless it is a
+   * periodic line */
+  unsigned int GetPeriod(unsigned int i) const
+  {
+    if (m_SliceMode)
+      {
+      return (i < m_SlicePeriods.size()) ? m_SlicePeriods[i] : 1;
+      }
+    return m_Kernel.GetPeriod(i);
+  }
+
 
 private:
   AnchorErodeDilateImageFilter(const Self&); //purposely not implemented
@@ -79,13 +326,68 @@ private:
 
   TKernel m_Kernel;
   bool m_KernelSet;
+  bool m_SliceMode;
+  typename KernelType::DecompType m_SliceLines;
+  std::vector<unsigned int> m_SlicePeriods;
+  bool m_SliceDecomposable;
+  unsigned int m_SliceAxis;
+  bool m_UseTiling;
+  SizeType m_TileSize;
+  unsigned long m_TileBytes;
+  unsigned int m_FusedPasses;
+  unsigned int m_NumberOfProcesses;
+  bool m_UseLineScheduler;
+  bool m_UseFirstTouch;
+  AnchorThreadPlacement m_Placement;
+  bool m_UseSmallKernels;
+  bool m_IncrementalUpdate;
+  unsigned int m_MaximumError;
+  unsigned int m_ApproximationError;
+  unsigned int m_ShrinkFactor;
+  std::vector<InputImageRegionType> m_DirtyRegions;
+  InputImagePointer m_Previous;
+  const InputImageType * m_PreviousInput;
+  unsigned long m_PreviousInputTime;
   typedef BresenhamLine<TImage::ImageDimension> BresType;
+  typedef AnchorLinePass<TImage, BresType, typename KernelType::LType> PassType;
+
+  // the plan shared by the threads of the batch mode
+  struct SliceThreadStruct
+  {
+    Pointer Filter;
+    const std::vector<PassType> * Passes;
+    unsigned int Slices;
+  };
+  static ITK_THREAD_RETURN_TYPE SliceThreaderCallback( void *arg );
+  void ThreadedGenerateSliceData(const std::vector<PassType> &passes,
+				 const InputImageRegionType &slab, int threadId);
+
+  // the pass being swept by the threads of the line scheduler
+  typedef AnchorLineScheduler<TImage, BresType, typename KernelType::LType> SchedulerType;
+  struct LineThreadStruct
+  {
+    Pointer Filter;
+    const PassType * Pass;
+    unsigned int PassNumber;
+    unsigned int Passes;
+    SchedulerType * Scheduler;
+    InputImageConstPointer Input;
+  };
+  static ITK_THREAD_RETURN_TYPE LineThreaderCallback( void *arg );
 
 #ifdef ANCHOR_ALGORITHM
   // the class that operates on lines
   typedef AnchorErodeDilateLine<InputImagePixelType, TFunction1, TFunction2> AnchorLineType;
 
   AnchorLineType AnchorLine;
+
+  // sweep the lines over region, from input to output for the first
+  // one and in place for the others. Returns false if aborted.
+  bool sweepLines(InputImageConstPointer input,
+		  InputImagePointer output,
+		  const typename KernelType::DecompType &lines,
+		  const InputImageRegionType region,
+		  AnchorSweepMonitor &monitor);
 #endif
 
 } ; // end of class
@@ -94,7 +396,7 @@ private:
 } // end namespace itk
 
 
-#ifndef ITK_MANUAL_INSTANTIATION
+#if !defined(ITK_MANUAL_INSTANTIATION) && !defined(ANCHOR_MANUAL_INSTANTIATION)
 #include "itkAnchorErodeDilateImageFilter.txx"
 #endif
 
@@ -7,6 +7,19 @@
 //#include "itkNeighborhoodAlgorithm.h"
 
 #include "itkAnchorUtilities.h"
+#include "itkAnchorImportImageContainer.h"
+
+#ifndef _WIN32
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <pthread.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
 
 namespace itk {
 
@@ -15,6 +28,88 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
 ::AnchorErodeDilateImageFilter()
 {
   m_KernelSet = false;
+  m_UseTiling = false;
+  m_TileSize.Fill(0);
+  m_TileBytes = 256*1024;
+  m_FusedPasses = 0;
+  m_NumberOfProcesses = 1;
+  m_UseLineScheduler = false;
+  m_UseFirstTouch = false;
+  m_UseSmallKernels = true;
+  m_IncrementalUpdate = false;
+  m_MaximumError = 0;
+  m_ApproximationError = 0;
+  m_ShrinkFactor = 1;
+  m_PreviousInput = 0;
+  m_PreviousInputTime = 0;
+  m_SliceMode = false;
+  m_SliceDecomposable = false;
+  m_SliceAxis = 0;
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::SetSliceKernel( const SliceKernelType& kernel, unsigned int axis )
+{
+  if (axis >= TImage::ImageDimension)
+    {
+    itkExceptionMacro("Slicing axis " << axis << " is not a dimension of the image");
+    }
+  mkSliceLines(kernel.GetLines(), axis, m_SliceLines);
+  m_SlicePeriods = kernel.GetPeriods();
+  m_SliceDecomposable = kernel.GetDecomposable();
+  m_SliceAxis = axis;
+  m_SliceMode = true;
+  m_KernelSet = true;
+  m_Previous = 0;
+  this->Modified();
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImagePointer inputPtr = const_cast< TImage * >( this->GetInput() );
+  if ( !inputPtr )
+    {
+    return;
+    }
+
+  // the requested region is padded by the reach of all the lines
+  InputImageRegionType AllImage = inputPtr->GetLargestPossibleRegion();
+  unsigned int bufflength = this->GetBufferLength(AllImage);
+  SizeType Reach;
+  Reach.Fill(0);
+  typename KernelType::DecompType decomposition = this->GetDecomposition();
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    unsigned int SELength = getLinePixels<typename KernelType::LType>(decomposition[i]);
+    if (!(SELength%2))
+      ++SELength;
+    SizeType LineReach = getLineReach<TImage, BresType>(mkLineOffsets<BresType, typename KernelType::LType>(decomposition[i], this->GetPeriod(i), bufflength), 
+							 SELength);
+    for (unsigned j = 0; j<TImage::ImageDimension; j++)
+      {
+      Reach[j] += LineReach[j];
+      }
+    }
+  if (!m_SliceMode && !m_Kernel.GetDecomposable())
+    {
+    // the chords reach as far as the kernel
+    for (unsigned j = 0; j<TImage::ImageDimension; j++)
+      {
+      Reach[j] = m_Kernel.GetRadius(j);
+      }
+    }
+  InputImageRegionType inputRequestedRegion = inputPtr->GetRequestedRegion();
+  inputRequestedRegion.PadByRadius(Reach);
+  inputRequestedRegion.Crop(AllImage);
+  inputPtr->SetRequestedRegion(inputRequestedRegion);
 }
 
 template <class TImage, class TKernel, class TFunction1, class TFunction2>
@@ -24,7 +119,7 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
 {
 
   // check that we are using a decomposable kernel
-  if (!m_Kernel.GetDecomposable())
+  if (m_SliceMode && !m_SliceDecomposable)
     {
     itkExceptionMacro("Anchor morphology only works with decomposable structuring elements");
     }
@@ -35,6 +130,71 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
   // TFunction1 will be < for erosions
   // TFunction2 will be <=
 
+  m_ApproximationError = 0;
+  m_ShrinkFactor = 1;
+
+  if (!m_SliceMode && !m_Kernel.GetDecomposable())
+    {
+    // the dirty regions can't be grown by the lines
+    this->GenerateChordData();
+    m_Previous = 0;
+    m_PreviousInput = 0;
+    m_DirtyRegions.clear();
+    return;
+    }
+
+  if (m_IncrementalUpdate && m_Previous && 
+      (m_PreviousInput == this->GetInput()) &&
+      (m_Previous->GetBufferedRegion() == this->GetOutput()->GetRequestedRegion()) &&
+      (!m_DirtyRegions.empty() || (this->GetInput()->GetMTime() <= m_PreviousInputTime)))
+    {
+    this->GenerateIncrementalData();
+    return;
+    }
+#ifdef ANCHOR_ALGORITHM
+  if ((m_MaximumError > 0) && !m_SliceMode && !m_IncrementalUpdate &&
+      (this->GetOutput()->GetRequestedRegion() == this->GetOutput()->GetLargestPossibleRegion()) &&
+      this->GenerateApproximateData())
+    {
+    this->KeepResult();
+    return;
+    }
+#endif
+  // a part of the image is computed with the tiled sweep, which
+  // keeps the lines of the whole image
+  if (m_UseTiling || 
+      (this->GetOutput()->GetRequestedRegion() != this->GetOutput()->GetLargestPossibleRegion()))
+    {
+    this->GenerateTiledData();
+    this->KeepResult();
+    return;
+    }
+#ifndef _WIN32
+  if (m_NumberOfProcesses > 1)
+    {
+    this->GenerateProcessData();
+    this->KeepResult();
+    return;
+    }
+#endif
+  if (m_UseLineScheduler && (this->GetNumberOfThreads() > 1))
+    {
+    this->GenerateScheduledData();
+    this->KeepResult();
+    return;
+    }
+  if (m_SliceMode)
+    {
+    this->GenerateSliceData();
+    this->KeepResult();
+    return;
+    }
+  if (m_UseSmallKernels && isSmallKernel(m_Kernel.GetLines(), m_Kernel.GetPeriods()))
+    {
+    this->GenerateSmallKernelData();
+    this->KeepResult();
+    return;
+    }
 
   // the initial version will adopt the methodology of loading a line
   // at a time into a buffer vector, carrying out the opening or
@@ -50,11 +210,7 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
   // get the region size
   InputImageRegionType OReg = output->GetRequestedRegion();
   // maximum buffer length is sum of dimensions
-  unsigned int bufflength = 0;
-  for (unsigned i = 0; i<TImage::ImageDimension; i++)
-    {
-    bufflength += OReg.GetSize()[i];
-    }
+  unsigned int bufflength = this->GetBufferLength(OReg);
   
 #ifdef ANCHOR_ALGORITHM
   InputImagePixelType * buffer = new InputImagePixelType[bufflength];
@@ -65,16 +221,31 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
   InputImagePixelType * reverse = new InputImagePixelType[bufflength];
 #endif
   // iterate over all the structuring elements
-  typename KernelType::DecompType decomposition = m_Kernel.GetLines();
-  BresType BresLine;
+  typename KernelType::DecompType decomposition = this->GetDecomposition();
+#ifdef ANCHOR_ALGORITHM
+  // each pass covers the region once
+  AnchorSweepMonitor monitor(this, 0, (double)decomposition.size() * OReg.GetNumberOfPixels());
+#else
   ProgressReporter progress(this, 0, decomposition.size());
+#endif
 
   std::cout << decomposition.size() << " lines will be used" << std::endl;
 
+  if (decomposition.empty())
+    {
+    // a kernel of a single pixel
+    ImageRegionConstIterator<TImage> inIt(input, OReg);
+    ImageRegionIterator<TImage> outIt(output, OReg);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    }
+
   for (unsigned i = 0; i < decomposition.size(); i++)
     {
     typename KernelType::LType ThisLine = decomposition[i];
-    typename BresType::OffsetArray TheseOffsets = BresLine.buildLine(ThisLine, bufflength);
+    typename BresType::OffsetArray TheseOffsets = mkLineOffsets<BresType, typename KernelType::LType>(ThisLine, this->GetPeriod(i), bufflength);
     unsigned int SELength = getLinePixels<typename KernelType::LType>(ThisLine);
     // want lines to be odd
     if (!(SELength%2))
@@ -85,8 +256,15 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
     InputImageRegionType BigFace = mkEnlargedFace<InputImageType, typename KernelType::LType>(input, OReg, ThisLine);
 #ifdef ANCHOR_ALGORITHM
     AnchorLine.SetSize(SELength);
-    doFace<TImage, BresType, AnchorLineType, typename KernelType::LType>(input, output, ThisLine, AnchorLine, 
-									   TheseOffsets, inbuffer, buffer, OReg, BigFace);
+    AnchorLine.SetPeriod(this->GetPeriod(i));
+    if (!doFace<TImage, BresType, AnchorLineType, typename KernelType::LType>(input, output, ThisLine, AnchorLine, 
+									       TheseOffsets, inbuffer, buffer, OReg, BigFace,
+									       &monitor))
+      {
+      delete [] buffer;
+      delete [] inbuffer;
+      abortSweep<TImage>(this->GetInput(), output, OReg);
+      }
 #else
     doFace<TImage, BresType, TFunction1, typename KernelType::LType>(input, output, ThisLine,  
 								     TheseOffsets, SELength,
@@ -96,7 +274,9 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
 #endif
     // after the first pass the input will be taken from the output
     input = this->GetOutput();
+#ifndef ANCHOR_ALGORITHM
     progress.CompletedPixel();
+#endif
     }
 
 
@@ -108,8 +288,850 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
   delete [] forward;
   delete [] reverse;
 #endif
+  this->KeepResult();
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateTiledData()
+{
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+
+  InputImageRegionType OReg = output->GetRequestedRegion();
+  // the lines are those of a sweep of the whole image, even if only
+  // a part of it is requested
+  InputImageRegionType AllImage = output->GetLargestPossibleRegion();
+  unsigned int bufflength = this->GetBufferLength(AllImage);
+
+  // the lines, offsets and faces are shared by all the tiles
+  typedef AnchorLinePass<TImage, BresType, typename KernelType::LType> PassType;
+  std::vector<PassType> passes;
+  typename KernelType::DecompType decomposition = this->GetDecomposition();
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    passes.push_back(mkLinePass<TImage, BresType, typename KernelType::LType>(AllImage, decomposition[i], bufflength, this->GetPeriod(i)));
+    }
+  if (passes.empty())
+    {
+    ImageRegionConstIterator<TImage> inIt(input, OReg);
+    ImageRegionIterator<TImage> outIt(output, OReg);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    return;
+    }
+
+  unsigned int fused = m_FusedPasses;
+  if ((fused == 0) || (fused > passes.size()) || (OReg != AllImage))
+    {
+    // the intermediate results of a part of the image aren't
+    // available around it, so all passes are fused in that case
+    fused = passes.size();
+    }
+  unsigned int groups = (passes.size() + fused - 1)/fused;
+
+  // choose the tile size from the halo of the biggest group
+  SizeType Core = m_TileSize;
+  bool autoSize = false;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    if (Core[i] == 0) autoSize = true;
+    }
+  if (autoSize)
+    {
+    unsigned long MaxHalo = 0;
+    for (unsigned g = 0; g < groups; g++)
+      {
+      SizeType Halo;
+      Halo.Fill(0);
+      for (unsigned p = g * fused; (p < (g + 1) * fused) && (p < passes.size()); p++)
+	{
+	for (unsigned i = 0; i<TImage::ImageDimension; i++)
+	  {
+	  Halo[i] += passes[p].Reach[i];
+	  }
+	}
+      for (unsigned i = 0; i<TImage::ImageDimension; i++)
+	{
+	if (Halo[i] > MaxHalo) MaxHalo = Halo[i];
+	}
+      }
+    double Pixels = (double)m_TileBytes/(double)sizeof(InputImagePixelType);
+    long Edge = (long)pow(Pixels, 1.0/TImage::ImageDimension) - 2 * (long)MaxHalo;
+    if (Edge < 16) Edge = 16;
+    for (unsigned i = 0; i<TImage::ImageDimension; i++)
+      {
+      if (Core[i] == 0) Core[i] = Edge;
+      }
+    }
+
+  // list the tiles
+  std::vector<InputImageRegionType> tiles;
+  IndexType TStart = OReg.GetIndex();
+  for (;;)
+    {
+    InputImageRegionType Tile;
+    Tile.SetIndex(TStart);
+    Tile.SetSize(Core);
+    Tile.Crop(OReg);
+    tiles.push_back(Tile);
+    unsigned d = 0;
+    for (; d<TImage::ImageDimension; d++)
+      {
+      TStart[d] += Core[d];
+      if (TStart[d] < OReg.GetIndex()[d] + (long)OReg.GetSize()[d]) break;
+      TStart[d] = OReg.GetIndex()[d];
+      }
+    if (d == TImage::ImageDimension) break;
+    }
+
+  InputImagePixelType * buffer = new InputImagePixelType[bufflength];
+  InputImagePixelType * inbuffer = new InputImagePixelType[bufflength];
+  InputImagePointer tile = TImage::New();
+  // groups of passes can't be done in place, so alternate between
+  // the output and a scratch image, finishing in the output
+  InputImagePointer scratch;
+  if (groups > 1)
+    {
+    scratch = TImage::New();
+    scratch->SetRegions(OReg);
+    scratch->Allocate();
+    }
+
+  ProgressReporter progress(this, 0, groups * tiles.size());
+
+  for (unsigned g = 0; g < groups; g++)
+    {
+    unsigned first = g * fused;
+    unsigned last = first + fused - 1;
+    if (last >= passes.size()) last = passes.size() - 1;
+    InputImagePointer dest = ((groups - 1 - g) % 2) ? scratch : output;
+    for (unsigned t = 0; t < tiles.size(); t++)
+      {
+      if (this->GetAbortGenerateData())
+	{
+	delete [] buffer;
+	delete [] inbuffer;
+	abortSweep<TImage>(this->GetInput(), output, OReg);
+	}
+      doTile<TImage, BresType, AnchorLineType, typename KernelType::LType>(input, dest, tile, passes,
+									     first, last, AnchorLine,
+									     inbuffer, buffer, AllImage, tiles[t]);
+      progress.CompletedPixel();
+      }
+    input = dest.GetPointer();
+    }
+
+  delete [] buffer;
+  delete [] inbuffer;
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateChordData()
+{
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+  InputImageRegionType OReg = output->GetRequestedRegion();
+
+  // the kernel of a dilation is mirrored, as in the neighbourhood
+  // filters. TFunction1 prefers the larger values for a dilation.
+  TFunction1 compare;
+  bool reflect = compare(NumericTraits<InputImagePixelType>::max(),
+			 NumericTraits<InputImagePixelType>::NonpositiveMin());
+  AnchorChordPlan<TImage::ImageDimension> plan = mkChordPlan(m_Kernel, reflect);
+
+  AnchorSweepMonitor monitor(this, 0, OReg.GetNumberOfPixels());
+  if (!doChordPass<TImage, TFunction1>(input, output, plan, OReg, &monitor))
+    {
+    abortSweep<TImage>(this->GetInput(), output, OReg);
+    }
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateSmallKernelData()
+{
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+  InputImageRegionType OReg = output->GetRequestedRegion();
+
+  // the passes can't be done in place, so alternate between the
+  // output and a scratch image, finishing in the output
+  const typename KernelType::DecompType & decomposition = m_Kernel.GetLines();
+  unsigned int passes = decomposition.size();
+  InputImagePointer scratch;
+  if (passes > 1)
+    {
+    scratch = TImage::New();
+    scratch->SetRegions(OReg);
+    scratch->Allocate();
+    }
+
+  // each pass covers the region once
+  AnchorSweepMonitor monitor(this, 0, (double)passes * OReg.GetNumberOfPixels());
+  for (unsigned i = 0; i < passes; i++)
+    {
+    typename TImage::OffsetType step;
+    unsigned int radius;
+    getSmallLineStep(decomposition[i], this->GetPeriod(i), 3, step, radius);
+    InputImagePointer dest = ((passes - 1 - i) % 2) ? scratch : output;
+    if (!doSmallLinePass<TImage, TFunction1>(input, dest, step, radius, OReg, &monitor))
+      {
+      abortSweep<TImage>(this->GetInput(), output, OReg);
+      }
+    input = dest.GetPointer();
+    }
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateScheduledData()
+{
+  int threads = this->GetNumberOfThreads();
+  this->GetMultiThreader()->SetNumberOfThreads(threads);
+  threads = this->GetMultiThreader()->GetNumberOfThreads();
+  if (m_UseFirstTouch)
+    {
+    // slabs along the slowest axis only spread the pages over the
+    // nodes: the chunks of a thread aren't its slab, and lines along
+    // or diagonal to that axis cross all the slabs
+    allocateFirstTouch<TImage>(this->GetOutput(), TImage::ImageDimension - 1,
+			       this->GetMultiThreader(), m_Placement);
+    }
+  else
+    {
+    this->AllocateOutputs();
+    }
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+  unsigned int bufflength = this->GetBufferLength(AllImage);
+  std::vector<PassType> passes;
+  const typename KernelType::DecompType & decomposition = this->GetDecomposition();
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    passes.push_back(mkLinePass<TImage, BresType, typename KernelType::LType>(AllImage, decomposition[i], bufflength, this->GetPeriod(i)));
+    }
+  if (passes.empty())
+    {
+    ImageRegionConstIterator<TImage> inIt(input, AllImage);
+    ImageRegionIterator<TImage> outIt(output, AllImage);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    return;
+    }
+
+  // the lines of a pass are swept in place after the first pass, so
+  // all threads finish a pass before the next one starts
+  SchedulerType scheduler;
+  LineThreadStruct str;
+  str.Filter = this;
+  str.Scheduler = &scheduler;
+  for (unsigned i = 0; i < passes.size(); i++)
+    {
+    scheduler.Initialize(passes[i], AllImage, threads);
+    str.Pass = &(passes[i]);
+    str.PassNumber = i;
+    str.Passes = passes.size();
+    str.Input = input;
+    this->GetMultiThreader()->SetSingleMethod(this->LineThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+    if (this->GetAbortGenerateData())
+      {
+      abortSweep<TImage>(this->GetInput(), output, AllImage);
+      }
+    input = output.GetPointer();
+    }
+  this->UpdateProgress(1.0);
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+ITK_THREAD_RETURN_TYPE
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::LineThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+  LineThreadStruct * str = (LineThreadStruct *)(info->UserData);
+  int threadId = info->ThreadID;
+  const PassType & pass = *(str->Pass);
+  AnchorPinnedThread pin(str->Filter->m_Placement, threadId);
+
+  InputImagePointer output = str->Filter->GetOutput();
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+  unsigned int bufflength = str->Filter->GetBufferLength(AllImage);
+  // each thread needs its own line object and buffers
+  AnchorLineType ThreadLine;
+  ThreadLine.SetSize(pass.SELength);
+  ThreadLine.SetPeriod(pass.Period);
+  InputImagePixelType * buffer = new InputImagePixelType[bufflength];
+  InputImagePixelType * inbuffer = new InputImagePixelType[bufflength];
+  // thread 0 reports its share of the pass as the progress of the pass
+  AnchorSweepMonitor monitor(str->Filter, threadId,
+			     (double)AllImage.GetNumberOfPixels() / info->NumberOfThreads,
+			     (float)str->PassNumber / str->Passes, 1.0f / str->Passes);
+  typename SchedulerType::Chunk chunk;
+  while (str->Scheduler->Next(threadId, chunk))
+    {
+    if (!doFaceLines<TImage, BresType, AnchorLineType, typename KernelType::LType>(str->Input, output, pass.Line, ThreadLine,
+										  pass.LineOffsets, inbuffer, buffer, AllImage,
+										  pass.Face, chunk.First, chunk.Count,
+										  &monitor))
+      {
+      break;
+      }
+    }
+  delete [] buffer;
+  delete [] inbuffer;
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+#ifndef _WIN32
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateProcessData()
+{
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+  unsigned int bufflength = this->GetBufferLength(AllImage);
+
+  std::vector<PassType> passes;
+  typename KernelType::DecompType decomposition = this->GetDecomposition();
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    passes.push_back(mkLinePass<TImage, BresType, typename KernelType::LType>(AllImage, decomposition[i], bufflength, this->GetPeriod(i)));
+    }
+  unsigned int fused = m_FusedPasses;
+  if ((fused == 0) || (fused > passes.size()))
+    {
+    fused = passes.size();
+    }
+  unsigned int groups = passes.empty() ? 0 : (passes.size() + fused - 1)/fused;
+  if (passes.empty())
+    {
+    this->AllocateOutputs();
+    ImageRegionConstIterator<TImage> inIt(input, AllImage);
+    ImageRegionIterator<TImage> outIt(output, AllImage);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    return;
+    }
+
+  // the slabs are along the slowest axis
+  const unsigned int axis = TImage::ImageDimension - 1;
+  unsigned int procs = m_NumberOfProcesses;
+  if (procs > AllImage.GetSize()[axis])
+    {
+    procs = AllImage.GetSize()[axis];
+    }
+
+  // the shared segment holds the barrier of the workers, then the
+  // buffer of the output, where the workers write their slabs of the
+  // result of each group of passes. The workers read the input they
+  // inherit from this process, and keep their slab with its halo in a
+  // tile of their own.
+  const unsigned long pixels = AllImage.GetNumberOfPixels();
+  const size_t header = ((sizeof(pthread_barrier_t) + 63)/64) * 64;
+  const size_t length = header + pixels * sizeof(InputImagePixelType);
+  char name[64];
+  sprintf(name, "/anchorMorphology.%ld.%p", (long)getpid(), (void *)this);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+    {
+    itkExceptionMacro("Can't create the shared memory segment " << name);
+    }
+  // the mapping stays valid for this process and the workers forked
+  // from it
+  shm_unlink(name);
+  void * segment = MAP_FAILED;
+  if (ftruncate(fd, length) == 0)
+    {
+    segment = mmap(0, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+  close(fd);
+  if (segment == MAP_FAILED)
+    {
+    itkExceptionMacro("Can't map " << length << " bytes of shared memory");
+    }
+  // the segment is unmapped with the last reference to it, which the
+  // output keeps
+  AnchorMappedMemory::Pointer mapping = AnchorMappedMemory::New();
+  mapping->SetMapping(segment, length);
+  pthread_barrier_t * barrier = static_cast<pthread_barrier_t *>(segment);
+  pthread_barrierattr_t attr;
+  pthread_barrierattr_init(&attr);
+  pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_barrier_init(barrier, &attr, procs);
+  pthread_barrierattr_destroy(&attr);
+
+  typedef AnchorImportImageContainer<unsigned long, InputImagePixelType> SharedContainerType;
+  typename SharedContainerType::Pointer container = SharedContainerType::New();
+  container->SetImportPointer(reinterpret_cast<InputImagePixelType *>(static_cast<char *>(segment) + header),
+			      pixels, mapping);
+  output->SetBufferedRegion(AllImage);
+  output->SetPixelContainer(container);
+
+  ProgressReporter progress(this, 0, 1);
+  std::vector<pid_t> workers;
+  for (unsigned w = 0; w < procs; w++)
+    {
+    InputImageRegionType slab = AllImage;
+    unsigned long first = (AllImage.GetSize()[axis] * w)/procs;
+    unsigned long last = (AllImage.GetSize()[axis] * (w + 1))/procs;
+    slab.SetIndex(axis, AllImage.GetIndex()[axis] + first);
+    slab.SetSize(axis, last - first);
+
+    pid_t pid = fork();
+    if (pid == 0)
+      {
+      // the worker has its own tile and buffers, and waits for the
+      // others at each barrier even if it failed, so that they don't
+      // wait for ever
+      bool failed = false;
+      InputImagePointer tile = TImage::New();
+      InputImagePixelType * buffer = new InputImagePixelType[bufflength];
+      InputImagePixelType * inbuffer = new InputImagePixelType[bufflength];
+      for (unsigned g = 0; g < groups; g++)
+	{
+	unsigned first = g * fused;
+	unsigned last = first + fused - 1;
+	if (last >= passes.size()) last = passes.size() - 1;
+	InputImageConstPointer source = g ? InputImageConstPointer(output.GetPointer()) : input;
+	if (!failed)
+	  {
+	  try
+	    {
+	    // the result stays in the tile
+	    doTile<TImage, BresType, AnchorLineType, typename KernelType::LType>(source, tile, tile, passes,
+										   first, last, AnchorLine,
+										   inbuffer, buffer, AllImage, slab);
+	    }
+	  catch (...)
+	    {
+	    failed = true;
+	    }
+	  }
+	// the halos of the other slabs are only overwritten once all
+	// the workers have read them
+	if (g)
+	  {
+	  pthread_barrier_wait(barrier);
+	  }
+	if (!failed)
+	  {
+	  ImageRegionConstIterator<TImage> tileIt(tile, slab);
+	  ImageRegionIterator<TImage> outIt(output, slab);
+	  for (tileIt.GoToBegin(), outIt.GoToBegin(); !tileIt.IsAtEnd(); ++tileIt, ++outIt)
+	    {
+	    outIt.Set(tileIt.Get());
+	    }
+	  }
+	if (g + 1 < groups)
+	  {
+	  pthread_barrier_wait(barrier);
+	  }
+	}
+      _exit(failed ? 1 : 0);
+      }
+    if (pid < 0)
+      {
+      // the workers already started would wait for ever
+      for (unsigned k = 0; k < workers.size(); k++)
+	{
+	kill(workers[k], SIGKILL);
+	waitpid(workers[k], 0, 0);
+	}
+      // the barrier isn't destroyed, as destroying it waits for the
+      // workers killed in it
+      itkExceptionMacro("Can't start worker process " << w);
+      }
+    workers.push_back(pid);
+    }
+
+  // reap the workers in the order they end, polling only them so that
+  // the other children of the application are left alone. The others
+  // would wait for ever at the barrier for one that was killed or that
+  // failed outside the passes, so they are killed.
+  bool failed = false;
+  while (!workers.empty())
+    {
+    bool ended = false;
+    for (unsigned k = 0; k < workers.size(); )
+      {
+      int status;
+      pid_t pid = waitpid(workers[k], &status, WNOHANG);
+      if (pid == 0 || (pid < 0 && errno == EINTR))
+	{
+	k++;
+	continue;
+	}
+      ended = true;
+      workers.erase(workers.begin() + k);
+      if (!failed && (pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status)))
+	{
+	// the barrier isn't destroyed either, as destroying it waits
+	// for the workers killed in it
+	failed = true;
+	for (unsigned j = 0; j < workers.size(); j++)
+	  {
+	  kill(workers[j], SIGKILL);
+	  }
+	}
+      }
+    if (!ended)
+      {
+      usleep(1000);
+      }
+    }
+  if (failed)
+    {
+    itkExceptionMacro("A worker process failed");
+    }
+  progress.CompletedPixel();
+  pthread_barrier_destroy(barrier);
+}
+#endif
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateSliceData()
+{
+  InputImageRegionType OReg = this->GetOutput()->GetRequestedRegion();
+  unsigned int bufflength = this->GetBufferLength(OReg);
+  std::vector<PassType> passes;
+  const typename KernelType::DecompType & decomposition = this->GetDecomposition();
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    passes.push_back(mkLinePass<TImage, BresType, typename KernelType::LType>(OReg, decomposition[i], bufflength, this->GetPeriod(i)));
+    }
+
+  // slabs of slices are independent
+  SliceThreadStruct str;
+  str.Filter = this;
+  str.Passes = &passes;
+  str.Slices = OReg.GetSize()[m_SliceAxis];
+  int threads = this->GetNumberOfThreads();
+  if ((unsigned)threads > str.Slices)
+    {
+    threads = str.Slices;
+    }
+  this->GetMultiThreader()->SetNumberOfThreads(threads);
+  if (m_UseFirstTouch)
+    {
+    allocateFirstTouch<TImage>(this->GetOutput(), m_SliceAxis,
+			       this->GetMultiThreader(), m_Placement);
+    }
+  else
+    {
+    this->AllocateOutputs();
+    }
+  this->GetMultiThreader()->SetSingleMethod(this->SliceThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+  if (this->GetAbortGenerateData())
+    {
+    abortSweep<TImage>(this->GetInput(), this->GetOutput(), OReg);
+    }
 }
 
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+ITK_THREAD_RETURN_TYPE
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::SliceThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+  SliceThreadStruct * str = (SliceThreadStruct *)(info->UserData);
+  int threadId = info->ThreadID;
+  AnchorPinnedThread pin(str->Filter->m_Placement, threadId);
+
+  // the slab first touched by this thread with UseFirstTouch
+  InputImageRegionType Slab = getThreadSlab(str->Filter->GetOutput()->GetRequestedRegion(),
+					    str->Filter->m_SliceAxis, threadId, info->NumberOfThreads);
+  if (Slab.GetSize()[str->Filter->m_SliceAxis] > 0)
+    {
+    str->Filter->ThreadedGenerateSliceData(*(str->Passes), Slab, threadId);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::ThreadedGenerateSliceData(const std::vector<PassType> &passes,
+			    const InputImageRegionType &slab, int threadId)
+{
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+  unsigned int bufflength = this->GetBufferLength(slab);
+  // each thread needs its own line object and buffers
+  AnchorLineType ThreadLine;
+  InputImagePixelType * buffer = new InputImagePixelType[bufflength];
+  InputImagePixelType * inbuffer = new InputImagePixelType[bufflength];
+  AnchorSweepMonitor monitor(this, threadId, (double)passes.size() * slab.GetNumberOfPixels());
+  for (unsigned i = 0; i < passes.size(); i++)
+    {
+    // the slab has the extent of the image in the slices, so its face
+    // is the part of the face of the image in the slab
+    InputImageRegionType BigFace = mkEnlargedFace<InputImageType, typename KernelType::LType>(input, slab, passes[i].Line);
+    ThreadLine.SetSize(passes[i].SELength);
+    ThreadLine.SetPeriod(passes[i].Period);
+    if (!doFace<TImage, BresType, AnchorLineType, typename KernelType::LType>(input, output, passes[i].Line, ThreadLine, 
+									       passes[i].LineOffsets, inbuffer, buffer, slab, BigFace,
+									       &monitor))
+      {
+      break;
+      }
+    input = output.GetPointer();
+    }
+  delete [] buffer;
+  delete [] inbuffer;
+}
+
+#ifdef ANCHOR_ALGORITHM
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+bool
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateApproximateData()
+{
+  typedef typename KernelType::LType LType;
+  const typename KernelType::DecompType & decomposition = this->GetDecomposition();
+
+  // the largest factor within the error, as long as it shrinks a line
+  unsigned int factor = getShrinkFactor<LType>(decomposition, m_Kernel.GetPeriods(), m_MaximumError);
+  if (factor == 1)
+    {
+    return false;
+    }
+
+  typename KernelType::DecompType coarseLines, residualLines;
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    unsigned int SELength = getLinePixels<LType>(decomposition[i]);
+    if (!(SELength%2))
+      ++SELength;
+    LType coarse, residual;
+    unsigned int coarseLength, residualLength;
+    splitLine<LType>(decomposition[i], SELength, factor, coarse, coarseLength, residual, residualLength);
+    if (coarseLength > 1) coarseLines.push_back(coarse);
+    if (residualLength > 1) residualLines.push_back(residual);
+    }
+
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+
+  // the blocks keep the pixel that the erosion or dilation prefers
+  InputImagePointer small = TImage::New();
+  shrinkImage<TImage, TFunction1>(input, AllImage, factor, small);
+  InputImageRegionType SmallImage = small->GetBufferedRegion();
+  InputImagePointer smallOut = TImage::New();
+  smallOut->SetRegions(SmallImage);
+  smallOut->Allocate();
+
+  AnchorSweepMonitor monitor(this, 0, (double)coarseLines.size() * SmallImage.GetNumberOfPixels() +
+			     (double)residualLines.size() * AllImage.GetNumberOfPixels());
+  if (!this->sweepLines(small.GetPointer(), smallOut, coarseLines, SmallImage, monitor))
+    {
+    abortSweep<TImage>(this->GetInput(), output, AllImage);
+    }
+  expandImage<TImage>(smallOut.GetPointer(), output, AllImage, factor);
+  if (!this->sweepLines(output.GetPointer(), output, residualLines, AllImage, monitor))
+    {
+    abortSweep<TImage>(this->GetInput(), output, AllImage);
+    }
+  m_ShrinkFactor = factor;
+  m_ApproximationError = getShrinkError<LType>(decomposition, factor);
+  return true;
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+bool
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::sweepLines(InputImageConstPointer input,
+	     InputImagePointer output,
+	     const typename KernelType::DecompType &lines,
+	     const InputImageRegionType region,
+	     AnchorSweepMonitor &monitor)
+{
+  if (lines.empty())
+    {
+    if (input.GetPointer() != output.GetPointer())
+      {
+      ImageRegionConstIterator<TImage> inIt(input, region);
+      ImageRegionIterator<TImage> outIt(output, region);
+      for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+	{
+	outIt.Set(inIt.Get());
+	}
+      }
+    return true;
+    }
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += region.GetSize()[i];
+    }
+  InputImagePixelType * buffer = new InputImagePixelType[bufflength];
+  InputImagePixelType * inbuffer = new InputImagePixelType[bufflength];
+  BresType BresLine;
+  bool done = true;
+  for (unsigned i = 0; done && (i < lines.size()); i++)
+    {
+    typename KernelType::LType ThisLine = lines[i];
+    typename BresType::OffsetArray TheseOffsets = BresLine.buildLine(ThisLine, bufflength);
+    unsigned int SELength = getLinePixels<typename KernelType::LType>(ThisLine);
+    if (!(SELength%2))
+      ++SELength;
+    InputImageRegionType BigFace = mkEnlargedFace<InputImageType, typename KernelType::LType>(region, ThisLine);
+    AnchorLine.SetSize(SELength);
+    AnchorLine.SetPeriod(1);
+    done = doFace<TImage, BresType, AnchorLineType, typename KernelType::LType>(input, output, ThisLine, AnchorLine,
+									       TheseOffsets, inbuffer, buffer, region, BigFace,
+									       &monitor);
+    input = output.GetPointer();
+    }
+  delete [] buffer;
+  delete [] inbuffer;
+  return done;
+}
+#endif
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::KeepResult()
+{
+  m_DirtyRegions.clear();
+  if (!m_IncrementalUpdate)
+    {
+    m_Previous = 0;
+    m_PreviousInput = 0;
+    return;
+    }
+  // share the buffer of the output
+  m_Previous = TImage::New();
+  m_Previous->Graft(this->GetOutput());
+  m_PreviousInput = this->GetInput();
+  m_PreviousInputTime = this->GetInput()->GetMTime();
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateIncrementalData()
+{
+  // the output takes over the previous result, which is then updated
+  // in place
+  this->GraftOutput(m_Previous);
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+
+  InputImageRegionType OReg = output->GetRequestedRegion();
+  InputImageRegionType AllImage = output->GetLargestPossibleRegion();
+  unsigned int bufflength = this->GetBufferLength(AllImage);
+
+  typedef AnchorLinePass<TImage, BresType, typename KernelType::LType> PassType;
+  std::vector<PassType> passes;
+  typename KernelType::DecompType decomposition = this->GetDecomposition();
+  SizeType Reach;
+  Reach.Fill(0);
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    passes.push_back(mkLinePass<TImage, BresType, typename KernelType::LType>(AllImage, decomposition[i], bufflength, this->GetPeriod(i)));
+    for (unsigned j = 0; j<TImage::ImageDimension; j++)
+      {
+      Reach[j] += passes[i].Reach[j];
+      }
+    }
+
+  // a change in the input affects the output up to the total reach
+  // of the passes away. Merge the affected regions that overlap, so
+  // that no part of the output is computed twice.
+  std::list<InputImageRegionType> affected;
+  for (unsigned i = 0; i < m_DirtyRegions.size(); i++)
+    {
+    InputImageRegionType R = m_DirtyRegions[i];
+    R.PadByRadius(Reach);
+    if (!R.Crop(OReg)) continue;
+    bool merged = true;
+    while (merged)
+      {
+      merged = false;
+      typename std::list<InputImageRegionType>::iterator it;
+      for (it = affected.begin(); it != affected.end(); ++it)
+	{
+	InputImageRegionType Overlap = *it;
+	if (Overlap.Crop(R))
+	  {
+	  // replace both with the bounding box
+	  IndexType Start;
+	  SizeType Size;
+	  for (unsigned j = 0; j<TImage::ImageDimension; j++)
+	    {
+	    long Low = std::min(R.GetIndex()[j], it->GetIndex()[j]);
+	    long High = std::max(R.GetIndex()[j] + (long)R.GetSize()[j],
+				 it->GetIndex()[j] + (long)it->GetSize()[j]);
+	    Start[j] = Low;
+	    Size[j] = High - Low;
+	    }
+	  R.SetIndex(Start);
+	  R.SetSize(Size);
+	  affected.erase(it);
+	  merged = true;
+	  break;
+	  }
+	}
+      }
+    affected.push_back(R);
+    }
+
+  ProgressReporter progress(this, 0, affected.size());
+  InputImagePixelType * buffer = new InputImagePixelType[bufflength];
+  InputImagePixelType * inbuffer = new InputImagePixelType[bufflength];
+  InputImagePointer tile = TImage::New();
+  typename std::list<InputImageRegionType>::iterator it;
+  for (it = affected.begin(); it != affected.end(); ++it)
+    {
+    if (passes.empty())
+      {
+      ImageRegionConstIterator<TImage> inIt(input, *it);
+      ImageRegionIterator<TImage> outIt(output, *it);
+      for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+	{
+	outIt.Set(inIt.Get());
+	}
+      }
+    else
+      {
+      doTile<TImage, BresType, AnchorLineType, typename KernelType::LType>(input, output, tile, passes,
+									     0, passes.size() - 1, AnchorLine,
+									     inbuffer, buffer, AllImage, *it);
+      }
+    progress.CompletedPixel();
+    }
+  delete [] buffer;
+  delete [] inbuffer;
+  m_DirtyRegions.clear();
+  m_PreviousInputTime = input->GetMTime();
+}
 
 template<class TImage, class TKernel, class TFunction1, class TFunction2>
 void
@@ -117,6 +1139,23 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
 ::PrintSelf(std::ostream &os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "UseTiling: " << m_UseTiling << std::endl;
+  os << indent << "TileSize: " << m_TileSize << std::endl;
+  os << indent << "TileBytes: " << m_TileBytes << std::endl;
+  os << indent << "FusedPasses: " << m_FusedPasses << std::endl;
+  os << indent << "NumberOfProcesses: " << m_NumberOfProcesses << std::endl;
+  os << indent << "UseLineScheduler: " << m_UseLineScheduler << std::endl;
+  os << indent << "UseFirstTouch: " << m_UseFirstTouch << std::endl;
+  os << indent << "CPUList: " << m_Placement.GetCPUList() << std::endl;
+  os << indent << "UseSmallKernels: " << m_UseSmallKernels << std::endl;
+  os << indent << "IncrementalUpdate: " << m_IncrementalUpdate << std::endl;
+  os << indent << "MaximumError: " << m_MaximumError << std::endl;
+  os << indent << "ApproximationError: " << m_ApproximationError << std::endl;
+  os << indent << "ShrinkFactor: " << m_ShrinkFactor << std::endl;
+  if (m_SliceMode)
+    {
+    os << indent << "SliceAxis: " << m_SliceAxis << std::endl;
+    }
 }
 
 
@@ -26,6 +26,14 @@ public:
   {
     m_Size = size;
   }
+
+  // A periodic line has a pixel every period pixels of the line. It
+  // is swept as period interleaved lines of (size - 1) / period + 1
+  // pixels.
+  void SetPeriod(unsigned int period)
+  {
+    m_Period = period;
+  }
   //itkGetConstReferenceMacro(Size, unsigned int);
 
   //itkSetMacro(Direction, unsigned int);
@@ -33,11 +41,12 @@ public:
 
   void PrintSelf(std::ostream &os, Indent indent) const;
   AnchorErodeDilateLine();
-  ~AnchorErodeDilateLine() {delete m_Histo;};
+  ~AnchorErodeDilateLine() {delete m_Histo; delete [] m_SubBuffer; delete [] m_SubInBuffer;};
 
 
 private:
   unsigned int m_Size;
+  unsigned int m_Period;
   TFunction1 m_TF1;
   TFunction2 m_TF2;
 
@@ -47,6 +56,14 @@ private:
   typedef MorphologyHistogramVec<InputImagePixelType,TFunction1> VHistogram;
   typedef MorphologyHistogramMap<InputImagePixelType,TFunction1> MHistogram;
 
+  void doContiguousLine(InputImagePixelType * buffer, InputImagePixelType * inbuffer, 
+			unsigned bufflength);
+
+  // the interleaved lines of a periodic line, of m_SubLength pixels
+  InputImagePixelType * m_SubBuffer;
+  InputImagePixelType * m_SubInBuffer;
+  unsigned int m_SubLength;
+
   bool startLine(InputImagePixelType * buffer,
 		 InputImagePixelType * inbuffer,
 		 InputImagePixelType &Extreme,
@@ -86,7 +103,7 @@ private:
 } // end namespace itk
 
 
-#ifndef ITK_MANUAL_INSTANTIATION
+#if !defined(ITK_MANUAL_INSTANTIATION) && !defined(ANCHOR_MANUAL_INSTANTIATION)
 #include "itkAnchorErodeDilateLine.txx"
 #endif
 
@@ -10,6 +10,10 @@ AnchorErodeDilateLine<TInputPix, TFunction1, TFunction2>
 ::AnchorErodeDilateLine()
 {
   m_Size=2;
+  m_Period=1;
+  m_SubBuffer=0;
+  m_SubInBuffer=0;
+  m_SubLength=0;
   // create a histogram
   if (useVectorBasedHistogram())
     {
@@ -25,6 +29,45 @@ template <class TInputPix, class TFunction1, class TFunction2>
 void
 AnchorErodeDilateLine<TInputPix, TFunction1, TFunction2>
 ::doLine(InputImagePixelType * buffer, InputImagePixelType * inbuffer, unsigned bufflength)
+{
+  if (m_Period < 2)
+    {
+    doContiguousLine(buffer, inbuffer, bufflength);
+    return;
+    }
+  // the pixels of a periodic line only interact with the pixels a
+  // multiple of the period away, so each residue is an independent
+  // line with a shorter structuring element
+  unsigned int size = m_Size;
+  m_Size = (size - 1) / m_Period + 1;
+  if (m_SubLength < bufflength / m_Period + 1)
+    {
+    delete [] m_SubBuffer;
+    delete [] m_SubInBuffer;
+    m_SubLength = bufflength / m_Period + 1;
+    m_SubBuffer = new InputImagePixelType[m_SubLength];
+    m_SubInBuffer = new InputImagePixelType[m_SubLength];
+    }
+  for (unsigned r = 0; r < m_Period && r < bufflength; r++)
+    {
+    unsigned sublength = 0;
+    for (unsigned i = r; i < bufflength; i += m_Period)
+      {
+      m_SubInBuffer[sublength++] = inbuffer[i];
+      }
+    doContiguousLine(m_SubBuffer, m_SubInBuffer, sublength);
+    for (unsigned i = r, j = 0; i < bufflength; i += m_Period, j++)
+      {
+      buffer[i] = m_SubBuffer[j];
+      }
+    }
+  m_Size = size;
+}
+
+template <class TInputPix, class TFunction1, class TFunction2>
+void
+AnchorErodeDilateLine<TInputPix, TFunction1, TFunction2>
+::doContiguousLine(InputImagePixelType * buffer, InputImagePixelType * inbuffer, unsigned bufflength)
 {
   // TFunction1 will be < for erosions
   // TFunction2 will be <=
@@ -35,20 +78,25 @@ AnchorErodeDilateLine<TInputPix, TFunction1, TFunction2>
   // closing, and then copy the result to the output. Hopefully this
   // will improve cache performance when working along non raster
   // directions.
-  if (bufflength <= m_Size/2)
+  if ((bufflength <= m_Size) || (m_Size < 2))
     {
-    // No point doing anything fancy - just look for the extreme value
-    // This is important when operating near the corner of images with
-    // angled structuring elements 
-    InputImagePixelType Extreme = inbuffer[0];
-    for (unsigned i = 0;i < bufflength;i++) 
-      {
-      if (m_TF1(Extreme, inbuffer[i]))
-	Extreme = inbuffer[i];
-      }
-
-    for (unsigned i = 0;i < bufflength;i++) 
+    // No point doing anything fancy - the anchor algorithm assumes
+    // that the first structuring element fits in the line, so just
+    // look for the extreme value in each window. This is important
+    // when operating near the corner of images with angled
+    // structuring elements, and a single pixel element just copies
+    // the line
+    int middle = (int)m_Size/2;
+    for (int i = 0;i < (int)bufflength;i++) 
       {
+      int first = std::max(0, i - middle);
+      int last = std::min((int)bufflength - 1, i + middle);
+      InputImagePixelType Extreme = inbuffer[first];
+      for (int j = first + 1;j <= last;j++) 
+	{
+	if (m_TF1(inbuffer[j], Extreme))
+	  Extreme = inbuffer[j];
+	}
       buffer[i] = Extreme;
       }
     return;
@@ -265,8 +313,7 @@ AnchorErodeDilateLine<TInputPix, TFunction1, TFunction2>
     Extreme = histo.GetValue();
     buffer[outRightP] = Extreme;
     }
-  
-  
+  return(false);
 }
 
 template<class TInputPix, class TFunction1, class TFunction2>
@@ -275,6 +322,7 @@ AnchorErodeDilateLine<TInputPix, TFunction1, TFunction2>
 ::PrintSelf(std::ostream &os, Indent indent) const
 {
   os << indent << "Size: " << m_Size << std::endl;
+  os << indent << "Period: " << m_Period << std::endl;
 }
 
 
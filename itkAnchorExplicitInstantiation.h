@@ -0,0 +1,56 @@
+#ifndef __itkAnchorExplicitInstantiation_h
+#define __itkAnchorExplicitInstantiation_h
+
+#include "itkImage.h"
+#include "itkFlatStructuringElement.h"
+#include "itkAnchorErodeDilateLine.h"
+#include "itkAnchorOpenCloseLine.h"
+#include "itkAnchorErodeDilateImageFilter.h"
+#include "itkAnchorOpenCloseImageFilter.h"
+#include <functional>
+
+// Explicit instantiations built into the anchorMorphology library.
+//
+// A program linked with the library can define
+// ANCHOR_MANUAL_INSTANTIATION before including the anchor headers, so
+// that the erosion, dilation, opening and closing filters, their
+// line classes and the structuring elements aren't compiled again in
+// each of its translation units. The pixel type and dimension of the
+// images must then be among those instantiated by the library:
+// unsigned char, char, unsigned short, short, unsigned int, int,
+// float and double, in 2D and 3D.
+
+// the classes that only depend on the pixel type
+#define anchorInstantiateLinesMacro(T) \
+  template class itk::AnchorErodeDilateLine< T, std::less< T >, std::less_equal< T > >; \
+  template class itk::AnchorErodeDilateLine< T, std::greater< T >, std::greater_equal< T > >; \
+  template class itk::AnchorOpenCloseLine< T, std::less< T >, std::greater_equal< T >, std::less_equal< T > >; \
+  template class itk::AnchorOpenCloseLine< T, std::greater< T >, std::less_equal< T >, std::greater_equal< T > >
+
+// the filters, as used by AnchorErodeImageFilter,
+// AnchorDilateImageFilter, AnchorOpenImageFilter and
+// AnchorCloseImageFilter
+#define anchorInstantiateFiltersMacro(T, D) \
+  template class itk::AnchorErodeDilateImageFilter< itk::Image< T, D >, itk::FlatStructuringElement< D >, \
+						    std::less< T >, std::less_equal< T > >; \
+  template class itk::AnchorErodeDilateImageFilter< itk::Image< T, D >, itk::FlatStructuringElement< D >, \
+						    std::greater< T >, std::greater_equal< T > >; \
+  template class itk::AnchorOpenCloseImageFilter< itk::Image< T, D >, itk::FlatStructuringElement< D >, \
+						  std::less< T >, std::greater< T >, \
+						  std::less_equal< T >, std::greater_equal< T > >; \
+  template class itk::AnchorOpenCloseImageFilter< itk::Image< T, D >, itk::FlatStructuringElement< D >, \
+						  std::greater< T >, std::less< T >, \
+						  std::greater_equal< T >, std::less_equal< T > >
+
+#define anchorInstantiateDimensionMacro(D) \
+  template class itk::FlatStructuringElement< D >; \
+  anchorInstantiateFiltersMacro(unsigned char, D); \
+  anchorInstantiateFiltersMacro(char, D); \
+  anchorInstantiateFiltersMacro(unsigned short, D); \
+  anchorInstantiateFiltersMacro(short, D); \
+  anchorInstantiateFiltersMacro(unsigned int, D); \
+  anchorInstantiateFiltersMacro(int, D); \
+  anchorInstantiateFiltersMacro(float, D); \
+  anchorInstantiateFiltersMacro(double, D)
+
+#endif
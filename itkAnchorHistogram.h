@@ -138,7 +138,7 @@ public:
   ~MorphologyHistogramVec(){}
 
   void Reset(){
-    std::fill(&(m_Vec[0]), &(m_Vec[m_Size-1]),0);
+    std::fill(m_Vec.begin(), m_Vec.end(), 0);
     m_CurrentValue = m_InitVal;
   }
   
@@ -167,6 +167,13 @@ public:
 				  NumericTraits< TInputPixel >::NonpositiveMin() )] == 0 )
       {
       m_CurrentValue += m_Direction;
+      if (static_cast<unsigned int>(m_CurrentValue - 
+				    NumericTraits< TInputPixel >::NonpositiveMin()) >= m_Size)
+	{
+	// the histogram is empty
+	m_CurrentValue = m_InitVal;
+	break;
+	}
       }
   }
  
@@ -177,5 +184,225 @@ public:
 
 };
 
+// histograms that return the pixel of a given rank among the pixels
+// they hold, rather than the extremum, for the rank filters. The rank
+// is a fraction: 0 gives the smallest pixel, 1 the largest and 0.5 the
+// median. A cursor on the current value and the number of pixels
+// below it are kept, so that sliding a window along a line moves the
+// cursor by a few values at a time.
+template <class TInputPixel>
+class MorphologyRankHistogram : public MorphologyHistogram<TInputPixel>
+{
+public:
+  MorphologyRankHistogram() 
+  {
+    m_Rank = 0.5;
+    m_Entries = 0;
+  }
+  virtual ~MorphologyRankHistogram(){}
+
+  void SetRank(float rank)
+  {
+    m_Rank = rank;
+  }
+
+protected:
+  // the position, in ascending order, of the pixel to return
+  unsigned long GetTarget() const
+  {
+    return (unsigned long)(m_Rank * (m_Entries - 1));
+  }
+
+  float m_Rank;
+  unsigned long m_Entries;
+};
+
+template <class TInputPixel>
+class MorphologyRankHistogramMap : public MorphologyRankHistogram<TInputPixel>
+{
+private:
+  typedef typename std::map< TInputPixel, unsigned long > MapType;
+  
+  MapType m_Map;
+  // the current value, and the number of pixels below it
+  typename MapType::iterator m_Cursor;
+  unsigned long m_Below;
+
+public:
+  MorphologyRankHistogramMap() 
+  {
+    m_Cursor = m_Map.end();
+    m_Below = 0;
+  }
+  ~MorphologyRankHistogramMap(){}
+
+  void Reset()
+  {
+    m_Map.clear();
+    m_Cursor = m_Map.end();
+    m_Below = 0;
+    this->m_Entries = 0;
+  }
+  
+  void AddBoundary()
+  {
+    AddPixel(this->m_Boundary);
+  }
+
+  void RemoveBoundary()
+  {
+    RemovePixel(this->m_Boundary);
+  }
+  
+  void AddPixel(const TInputPixel &p)
+  {
+    // inserting doesn't move the cursor
+    m_Map[ p ]++;
+    ++this->m_Entries;
+    if ((m_Cursor != m_Map.end()) && (p < m_Cursor->first))
+      {
+      ++m_Below;
+      }
+  }
+
+  void RemovePixel(const TInputPixel &p)
+  {
+    typename MapType::iterator mapIt = m_Map.find( p );
+    mapIt->second--;
+    --this->m_Entries;
+    if (this->m_Entries == 0)
+      {
+      Reset();
+      return;
+      }
+    if ((m_Cursor != m_Map.end()) && (p < m_Cursor->first))
+      {
+      --m_Below;
+      }
+    // the value under the cursor is kept with a null count, so that
+    // the cursor stays valid
+    if ((mapIt->second == 0) && (mapIt != m_Cursor))
+      {
+      m_Map.erase( mapIt );
+      }
+  }
+ 
+  TInputPixel GetValue()
+  {
+    if (m_Cursor == m_Map.end())
+      {
+      m_Cursor = m_Map.begin();
+      m_Below = 0;
+      }
+    unsigned long target = this->GetTarget();
+    while (m_Below > target)
+      {
+      typename MapType::iterator left = m_Cursor;
+      --m_Cursor;
+      m_Below -= m_Cursor->second;
+      EraseEmpty(left);
+      }
+    while (m_Below + m_Cursor->second <= target)
+      {
+      typename MapType::iterator left = m_Cursor;
+      m_Below += m_Cursor->second;
+      ++m_Cursor;
+      EraseEmpty(left);
+      }
+    return m_Cursor->first;
+  }
+
+private:
+  // a value kept under the cursor with a null count by RemovePixel is
+  // dropped once the cursor has moved off it
+  void EraseEmpty(typename MapType::iterator it)
+  {
+    if (it->second == 0)
+      {
+      m_Map.erase( it );
+      }
+  }
+
+};
+
+template <class TInputPixel>
+class MorphologyRankHistogramVec : public MorphologyRankHistogram<TInputPixel>
+{
+private:
+  typedef typename std::vector<unsigned long> VecType;
+  
+  VecType m_Vec;
+  unsigned int m_Size;
+  // the bin of the current value, and the number of pixels below it
+  unsigned int m_Cursor;
+  unsigned long m_Below;
+
+public:
+  MorphologyRankHistogramVec() 
+  {
+    m_Size = static_cast<unsigned int>( NumericTraits< TInputPixel >::max() - 
+					NumericTraits< TInputPixel >::NonpositiveMin() + 1 );
+    m_Vec.resize(m_Size, 0 );
+    m_Cursor = 0;
+    m_Below = 0;
+  }
+  ~MorphologyRankHistogramVec(){}
+
+  void Reset(){
+    std::fill(m_Vec.begin(), m_Vec.end(), 0);
+    m_Cursor = 0;
+    m_Below = 0;
+    this->m_Entries = 0;
+  }
+  
+  void AddBoundary()
+  {
+    AddPixel(this->m_Boundary);
+  }
+
+  void RemoveBoundary(){
+    RemovePixel(this->m_Boundary);
+  }
+  
+  void AddPixel(const TInputPixel &p)
+  {
+    unsigned int bin = static_cast<unsigned int>(p - NumericTraits< TInputPixel >::NonpositiveMin());
+    m_Vec[ bin ]++;
+    ++this->m_Entries;
+    if (bin < m_Cursor)
+      {
+      ++m_Below;
+      }
+  }
+
+  void RemovePixel(const TInputPixel &p)
+  {
+    unsigned int bin = static_cast<unsigned int>(p - NumericTraits< TInputPixel >::NonpositiveMin());
+    m_Vec[ bin ]--;
+    --this->m_Entries;
+    if (bin < m_Cursor)
+      {
+      --m_Below;
+      }
+  }
+ 
+  TInputPixel GetValue()
+  { 
+    unsigned long target = this->GetTarget();
+    while (m_Below > target)
+      {
+      --m_Cursor;
+      m_Below -= m_Vec[m_Cursor];
+      }
+    while (m_Below + m_Vec[m_Cursor] <= target)
+      {
+      m_Below += m_Vec[m_Cursor];
+      ++m_Cursor;
+      }
+    return static_cast<TInputPixel>(m_Cursor + NumericTraits< TInputPixel >::NonpositiveMin());
+  }
+
+};
+
 } // end namespace itk
 #endif
@@ -0,0 +1,124 @@
+#ifndef __itkAnchorImportImageContainer_h
+#define __itkAnchorImportImageContainer_h
+
+#include "itkImportImageContainer.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace itk {
+
+/**
+ * \class AnchorImportImageContainer
+ * \brief a pixel container importing memory owned by another object,
+ * which it keeps alive.
+ *
+ * An image over a part of a larger buffer, or over memory that isn't
+ * released with delete, uses an import container that doesn't manage
+ * its memory. This one also holds a reference to the owner of the
+ * memory, so that the image stays valid for as long as it is used,
+ * whatever happens to the object it came from.
+**/
+template <typename TElementIdentifier, typename TElement>
+class ITK_EXPORT AnchorImportImageContainer
+  : public ImportImageContainer<TElementIdentifier, TElement>
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorImportImageContainer                         Self;
+  typedef ImportImageContainer<TElementIdentifier, TElement> Superclass;
+  typedef SmartPointer<Self>                                 Pointer;
+  typedef SmartPointer<const Self>                           ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorImportImageContainer, ImportImageContainer);
+
+  /** Import size elements at ptr, which belong to owner */
+  void SetImportPointer(TElement *ptr, TElementIdentifier size,
+			const LightObject * owner)
+  {
+    m_Owner = owner;
+    Superclass::SetImportPointer(ptr, size, false);
+  }
+
+  const LightObject * GetOwner() const
+  {
+    return m_Owner.GetPointer();
+  }
+
+protected:
+  AnchorImportImageContainer() {}
+  // the superclass doesn't release the memory, which goes with the
+  // last reference to its owner
+  ~AnchorImportImageContainer() {}
+
+private:
+  AnchorImportImageContainer(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  LightObject::ConstPointer m_Owner;
+};
+
+#ifndef _WIN32
+/**
+ * \class AnchorMappedMemory
+ * \brief a mapping made with mmap, such as a POSIX shared memory
+ * segment, unmapped with the last reference to it. Used as the owner
+ * of an AnchorImportImageContainer, it lets an image live in the
+ * mapping.
+**/
+class AnchorMappedMemory : public LightObject
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorMappedMemory        Self;
+  typedef LightObject               Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorMappedMemory, LightObject);
+
+  /** Take over the mapping of length bytes at address */
+  void SetMapping(void * address, size_t length)
+  {
+    m_Address = address;
+    m_Length = length;
+  }
+  void * GetAddress() const
+  {
+    return m_Address;
+  }
+
+protected:
+  AnchorMappedMemory()
+  {
+    m_Address = 0;
+    m_Length = 0;
+  }
+  ~AnchorMappedMemory()
+  {
+    if (m_Address)
+      {
+      munmap(m_Address, m_Length);
+      }
+  }
+
+private:
+  AnchorMappedMemory(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  void * m_Address;
+  size_t m_Length;
+};
+#endif
+
+} // end namespace itk
+
+#endif
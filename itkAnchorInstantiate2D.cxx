@@ -0,0 +1,14 @@
+// explicit instantiations of the anchor filters for 2D images, and of
+// the line classes
+#include "itkAnchorExplicitInstantiation.h"
+
+anchorInstantiateDimensionMacro(2);
+
+anchorInstantiateLinesMacro(unsigned char);
+anchorInstantiateLinesMacro(char);
+anchorInstantiateLinesMacro(unsigned short);
+anchorInstantiateLinesMacro(short);
+anchorInstantiateLinesMacro(unsigned int);
+anchorInstantiateLinesMacro(int);
+anchorInstantiateLinesMacro(float);
+anchorInstantiateLinesMacro(double);
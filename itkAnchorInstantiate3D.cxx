@@ -0,0 +1,4 @@
+// explicit instantiations of the anchor filters for 3D images
+#include "itkAnchorExplicitInstantiation.h"
+
+anchorInstantiateDimensionMacro(3);
@@ -0,0 +1,553 @@
+#ifndef __itkAnchorJobQueue_h
+#define __itkAnchorJobQueue_h
+
+#include "itkObject.h"
+#include "itkProcessObject.h"
+#include "itkCommand.h"
+#include "itkEventObject.h"
+#include "itkMultiThreader.h"
+#include "itkMutexLock.h"
+#include "itkConditionVariable.h"
+#include <list>
+#include <vector>
+#include <string>
+#include <exception>
+#include <algorithm>
+
+namespace itk {
+
+class AnchorJobQueue;
+
+/**
+ * \class AnchorJob
+ * \brief the handle of the update of a filter submitted to an
+ * AnchorJobQueue.
+ *
+ * Wait blocks until the job has finished, so that the job is the
+ * future of the output of the filter. Cancel removes a job that
+ * hasn't started from the queue, and sets the abort flag of the
+ * filter of a running one, which the sweeps of the anchor filters
+ * check every few thousand pixels. The flag is set again at each
+ * progress event of the filter, as the pipeline clears it when the
+ * update starts.
+ *
+ * A job invokes an EndEvent when it finishes, whatever its status,
+ * from the worker thread that ran it, or from the thread that
+ * cancelled it if it hadn't started.
+**/
+class AnchorJob : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorJob                 Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorJob, Object);
+
+  typedef enum { QUEUED = 0, RUNNING, DONE, FAILED, CANCELLED } StatusType;
+
+  StatusType GetStatus()
+  {
+    m_Mutex.Lock();
+    StatusType status = m_Status;
+    m_Mutex.Unlock();
+    return status;
+  }
+
+  bool IsFinished()
+  {
+    StatusType status = this->GetStatus();
+    return (status != QUEUED) && (status != RUNNING);
+  }
+
+  /** Block until the job has finished. Returns true if the filter
+   * was updated, false if it failed or was cancelled. */
+  bool Wait()
+  {
+    m_Mutex.Lock();
+    while ((m_Status == QUEUED) || (m_Status == RUNNING))
+      {
+      m_DoneCondition->Wait(&m_Mutex);
+      }
+    bool done = (m_Status == DONE);
+    m_Mutex.Unlock();
+    return done;
+  }
+
+  /** Cancel the job. A running filter stops at its next check of the
+   * abort flag, and the job is then CANCELLED, unless the update ends
+   * first. The queue must still exist. */
+  void Cancel();
+
+  /** The description of the exception of a FAILED job */
+  std::string GetErrorMessage()
+  {
+    m_Mutex.Lock();
+    std::string message = m_ErrorMessage;
+    m_Mutex.Unlock();
+    return message;
+  }
+
+  ProcessObject * GetFilter() const
+  {
+    return m_Filter;
+  }
+
+  int GetPriority() const
+  {
+    return m_Priority;
+  }
+
+  /** True once Cancel has been called */
+  bool IsCancelRequested()
+  {
+    m_Mutex.Lock();
+    bool cancelled = m_CancelRequested;
+    m_Mutex.Unlock();
+    return cancelled;
+  }
+
+  /** The threads reserved for the filter, which are its number of
+   * threads within the maximum of the queue */
+  unsigned int GetNumberOfThreads() const
+  {
+    return m_NumberOfThreads;
+  }
+
+protected:
+  AnchorJob()
+  {
+    m_Queue = 0;
+    m_Priority = 0;
+    m_NumberOfThreads = 1;
+    m_Status = QUEUED;
+    m_CancelRequested = false;
+    m_DoneCondition = ConditionVariable::New();
+  }
+  ~AnchorJob() {}
+
+private:
+  AnchorJob(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  friend class AnchorJobQueue;
+  itkNewMacro(Self);
+
+  // sets the abort flag of the filter of a cancelled job
+  class CancelCommand : public Command
+  {
+  public:
+    typedef CancelCommand Self;
+    typedef SmartPointer<Self> Pointer;
+    itkNewMacro(Self);
+    void Execute(Object * caller, const EventObject &)
+    {
+      if (m_Job->IsCancelRequested())
+	{
+	static_cast<ProcessObject *>(caller)->AbortGenerateDataOn();
+	}
+    }
+    void Execute(const Object *, const EventObject &) {}
+    AnchorJob * m_Job;
+  protected:
+    CancelCommand() { m_Job = 0; }
+  };
+
+  // update the filter - called by a worker thread
+  void Run()
+  {
+    m_Mutex.Lock();
+    if (m_CancelRequested)
+      {
+      m_Mutex.Unlock();
+      this->Finish(CANCELLED, "");
+      return;
+      }
+    m_Status = RUNNING;
+    m_Mutex.Unlock();
+
+    CancelCommand::Pointer command = CancelCommand::New();
+    command->m_Job = this;
+    unsigned long tag = m_Filter->AddObserver(ProgressEvent(), command);
+    StatusType status = DONE;
+    std::string message;
+    try
+      {
+      m_Filter->Update();
+      if (m_Filter->GetAbortGenerateData())
+	{
+	status = CANCELLED;
+	}
+      }
+    catch (ProcessAborted &)
+      {
+      status = CANCELLED;
+      }
+    catch (ExceptionObject &e)
+      {
+      status = FAILED;
+      message = e.GetDescription();
+      }
+    catch (std::exception &e)
+      {
+      status = FAILED;
+      message = e.what();
+      }
+    catch (...)
+      {
+      status = FAILED;
+      message = "Unknown exception";
+      }
+    m_Filter->RemoveObserver(tag);
+    this->Finish(status, message);
+  }
+
+  void Finish(StatusType status, const std::string &message)
+  {
+    m_Mutex.Lock();
+    m_Status = status;
+    m_ErrorMessage = message;
+    m_DoneCondition->Broadcast();
+    m_Mutex.Unlock();
+    this->InvokeEvent(EndEvent());
+  }
+
+  AnchorJobQueue * m_Queue;
+  ProcessObject::Pointer m_Filter;
+  int m_Priority;
+  unsigned int m_NumberOfThreads;
+  StatusType m_Status;
+  bool m_CancelRequested;
+  std::string m_ErrorMessage;
+  SimpleMutexLock m_Mutex;
+  ConditionVariable::Pointer m_DoneCondition;
+};
+
+/**
+ * \class AnchorJobQueue
+ * \brief updates filters asynchronously on a bounded pool of worker
+ * threads, for callers that must not block, such as the handlers of
+ * a service.
+ *
+ * Submit queues the update of a filter and returns its AnchorJob
+ * straight away. The jobs are started by decreasing priority, and in
+ * the order of submission for the same priority. Each job reserves
+ * the number of threads of its filter, and a job only starts when
+ * its threads fit, with those of the running jobs, in
+ * MaximumNumberOfThreads. A filter with more threads than the
+ * maximum is set to the maximum. Multithreaded filters then don't
+ * oversubscribe the processors however many jobs are submitted, and
+ * the job at the head of the queue waits for enough threads rather
+ * than being overtaken by smaller ones.
+ *
+ * The jobs must be independent: the pipelines of two jobs must not
+ * share a filter or an input image, as the pipeline isn't thread
+ * safe and each update sets the requested region of its inputs. Jobs
+ * reading the same image can each be given an image grafted from it,
+ * which shares its pixels but not its regions. The destructor
+ * cancels the queued and the running jobs and waits for the workers
+ * to stop.
+**/
+class AnchorJobQueue : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorJobQueue            Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorJobQueue, Object);
+
+  /** The queue used by UpdateAsync, created on first use */
+  static Pointer GetGlobalQueue()
+  {
+    static Pointer queue = Self::New();
+    return queue;
+  }
+
+  /** The number of worker threads, which are started by the first
+   * Submit. Default is the number of processors. */
+  itkSetMacro(NumberOfWorkers, unsigned int);
+  itkGetConstMacro(NumberOfWorkers, unsigned int);
+
+  /** The number of threads the running filters may use
+   * together. Default is the number of processors. */
+  void SetMaximumNumberOfThreads(unsigned int threads)
+  {
+    m_Mutex.Lock();
+    m_MaximumNumberOfThreads = threads > 0 ? threads : 1;
+    m_WorkCondition->Broadcast();
+    m_Mutex.Unlock();
+    this->Modified();
+  }
+  itkGetConstMacro(MaximumNumberOfThreads, unsigned int);
+
+  /** The number of jobs that may wait in the queue, 0 for no
+   * limit. Submit returns a null pointer when the queue is
+   * full. Default is 0. */
+  itkSetMacro(MaximumQueueLength, unsigned long);
+  itkGetConstMacro(MaximumQueueLength, unsigned long);
+
+  /** Queue the update of filter. observer, if given, is added to the
+   * job for its EndEvent before it is queued. Returns a null pointer
+   * if the queue is full. */
+  AnchorJob::Pointer Submit(ProcessObject * filter, int priority = 0, Command * observer = 0)
+  {
+    AnchorJob::Pointer job = AnchorJob::New();
+    job->m_Filter = filter;
+    job->m_Priority = priority;
+    job->m_Queue = this;
+    if (observer)
+      {
+      job->AddObserver(EndEvent(), observer);
+      }
+    m_Mutex.Lock();
+    if (m_Stop || ((m_MaximumQueueLength > 0) && (m_Queue.size() >= m_MaximumQueueLength)))
+      {
+      m_Mutex.Unlock();
+      return 0;
+      }
+    job->m_NumberOfThreads = filter->GetNumberOfThreads() > 0 ? filter->GetNumberOfThreads() : 1;
+    this->ClampThreads(job);
+    // after the jobs of the same or a higher priority
+    std::list<AnchorJob::Pointer>::iterator pos = m_Queue.begin();
+    while ((pos != m_Queue.end()) && ((*pos)->m_Priority >= priority))
+      {
+      ++pos;
+      }
+    m_Queue.insert(pos, job);
+    while (m_Workers.size() < m_NumberOfWorkers)
+      {
+      m_Workers.push_back(m_Threader->SpawnThread(WorkerCallback, this));
+      }
+    m_WorkCondition->Broadcast();
+    m_Mutex.Unlock();
+    return job;
+  }
+
+  /** Block until no job is queued or running */
+  void WaitForAll()
+  {
+    m_Mutex.Lock();
+    while (!m_Queue.empty() || !m_Running.empty())
+      {
+      m_IdleCondition->Wait(&m_Mutex);
+      }
+    m_Mutex.Unlock();
+  }
+
+  unsigned long GetNumberOfQueuedJobs()
+  {
+    m_Mutex.Lock();
+    unsigned long jobs = m_Queue.size();
+    m_Mutex.Unlock();
+    return jobs;
+  }
+
+  unsigned long GetNumberOfRunningJobs()
+  {
+    m_Mutex.Lock();
+    unsigned long jobs = m_Running.size();
+    m_Mutex.Unlock();
+    return jobs;
+  }
+
+  /** The threads reserved by the running jobs */
+  unsigned int GetNumberOfThreadsInUse()
+  {
+    m_Mutex.Lock();
+    unsigned int threads = m_ThreadsInUse;
+    m_Mutex.Unlock();
+    return threads;
+  }
+
+protected:
+  AnchorJobQueue()
+  {
+    unsigned int processors = MultiThreader::GetGlobalDefaultNumberOfThreads();
+    m_NumberOfWorkers = processors;
+    m_MaximumNumberOfThreads = processors;
+    m_MaximumQueueLength = 0;
+    m_ThreadsInUse = 0;
+    m_Stop = false;
+    m_WorkCondition = ConditionVariable::New();
+    m_IdleCondition = ConditionVariable::New();
+    m_Threader = MultiThreader::New();
+  }
+
+  ~AnchorJobQueue()
+  {
+    m_Mutex.Lock();
+    m_Stop = true;
+    std::list<AnchorJob::Pointer> queued;
+    queued.swap(m_Queue);
+    std::list<AnchorJob::Pointer> running = m_Running;
+    m_WorkCondition->Broadcast();
+    m_Mutex.Unlock();
+    for (std::list<AnchorJob::Pointer>::iterator it = running.begin(); it != running.end(); ++it)
+      {
+      (*it)->Cancel();
+      }
+    for (std::list<AnchorJob::Pointer>::iterator it = queued.begin(); it != queued.end(); ++it)
+      {
+      (*it)->m_Mutex.Lock();
+      (*it)->m_Queue = 0;
+      (*it)->m_CancelRequested = true;
+      (*it)->m_Mutex.Unlock();
+      (*it)->Finish(AnchorJob::CANCELLED, "");
+      }
+    for (unsigned i = 0; i < m_Workers.size(); i++)
+      {
+      m_Threader->TerminateThread(m_Workers[i]);
+      }
+  }
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+  {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "NumberOfWorkers: " << m_NumberOfWorkers << std::endl;
+    os << indent << "MaximumNumberOfThreads: " << m_MaximumNumberOfThreads << std::endl;
+    os << indent << "MaximumQueueLength: " << m_MaximumQueueLength << std::endl;
+  }
+
+private:
+  AnchorJobQueue(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  friend class AnchorJob;
+
+  // take a job out of the queue before it starts. Returns false if a
+  // worker already has it.
+  bool Remove(AnchorJob * job)
+  {
+    m_Mutex.Lock();
+    for (std::list<AnchorJob::Pointer>::iterator it = m_Queue.begin(); it != m_Queue.end(); ++it)
+      {
+      if (it->GetPointer() == job)
+	{
+	m_Queue.erase(it);
+	if (m_Queue.empty() && m_Running.empty())
+	  {
+	  m_IdleCondition->Broadcast();
+	  }
+	m_Mutex.Unlock();
+	return true;
+	}
+      }
+    m_Mutex.Unlock();
+    return false;
+  }
+
+  // keep the threads of a job, and of its filter, within the maximum,
+  // which may have been lowered since the job was queued - called
+  // with the lock held
+  void ClampThreads(AnchorJob * job)
+  {
+    if (job->m_NumberOfThreads > m_MaximumNumberOfThreads)
+      {
+      job->m_NumberOfThreads = m_MaximumNumberOfThreads;
+      }
+    if ((unsigned int)job->m_Filter->GetNumberOfThreads() > job->m_NumberOfThreads)
+      {
+      job->m_Filter->SetNumberOfThreads(job->m_NumberOfThreads);
+      }
+  }
+
+  static ITK_THREAD_RETURN_TYPE WorkerCallback(void *arg)
+  {
+    MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+    Self * queue = (Self *)(info->UserData);
+
+    queue->m_Mutex.Lock();
+    for (;;)
+      {
+      // the job at the head waits until its threads are free
+      while (!queue->m_Stop &&
+	     (queue->m_Queue.empty() ||
+	      (queue->m_ThreadsInUse +
+	       std::min(queue->m_Queue.front()->m_NumberOfThreads, queue->m_MaximumNumberOfThreads) >
+	       queue->m_MaximumNumberOfThreads)))
+	{
+	queue->m_WorkCondition->Wait(&queue->m_Mutex);
+	}
+      if (queue->m_Stop) break;
+      AnchorJob::Pointer job = queue->m_Queue.front();
+      queue->m_Queue.pop_front();
+      job->m_Mutex.Lock();
+      job->m_Queue = 0;
+      job->m_Mutex.Unlock();
+      queue->ClampThreads(job);
+      queue->m_ThreadsInUse += job->m_NumberOfThreads;
+      queue->m_Running.push_back(job);
+      queue->m_Mutex.Unlock();
+      job->Run();
+      queue->m_Mutex.Lock();
+      queue->m_ThreadsInUse -= job->m_NumberOfThreads;
+      queue->m_Running.remove(job);
+      queue->m_WorkCondition->Broadcast();
+      if (queue->m_Queue.empty() && queue->m_Running.empty())
+	{
+	queue->m_IdleCondition->Broadcast();
+	}
+      }
+    queue->m_Mutex.Unlock();
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  unsigned int m_NumberOfWorkers;
+  unsigned int m_MaximumNumberOfThreads;
+  unsigned long m_MaximumQueueLength;
+  unsigned int m_ThreadsInUse;
+  bool m_Stop;
+  std::list<AnchorJob::Pointer> m_Queue;
+  std::list<AnchorJob::Pointer> m_Running;
+  std::vector<int> m_Workers;
+
+  SimpleMutexLock m_Mutex;
+  ConditionVariable::Pointer m_WorkCondition;
+  ConditionVariable::Pointer m_IdleCondition;
+  MultiThreader::Pointer m_Threader;
+};
+
+inline void
+AnchorJob
+::Cancel()
+{
+  m_Mutex.Lock();
+  m_CancelRequested = true;
+  StatusType status = m_Status;
+  AnchorJobQueue * queue = m_Queue;
+  if (status == RUNNING)
+    {
+    m_Filter->AbortGenerateDataOn();
+    }
+  m_Mutex.Unlock();
+  // a job that a worker has already taken is cancelled when it runs
+  if ((status == QUEUED) && queue && queue->Remove(this))
+    {
+    m_Mutex.Lock();
+    m_Queue = 0;
+    m_Mutex.Unlock();
+    this->Finish(CANCELLED, "");
+    }
+}
+
+/** Update filter on the global queue, see AnchorJobQueue. Returns
+ * the job, or a null pointer if the queue is full. */
+inline AnchorJob::Pointer
+UpdateAsync(ProcessObject * filter, int priority = 0, Command * observer = 0)
+{
+  return AnchorJobQueue::GetGlobalQueue()->Submit(filter, priority, observer);
+}
+
+} // end namespace itk
+
+#endif
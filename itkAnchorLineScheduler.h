@@ -0,0 +1,111 @@
+#ifndef __itkAnchorLineScheduler_h
+#define __itkAnchorLineScheduler_h
+
+#include "itkMutexLock.h"
+#include "itkAnchorUtilities.h"
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class AnchorLineScheduler
+ * \brief hands out the lines of one pass to threads in chunks of
+ * similar work.
+ *
+ * The lines of an oblique direction have very different lengths: a
+ * pixel or two near the corners of the image and its full extent in
+ * the middle. The start pixels of the face of a pass are split, in
+ * raster order, into chunks of about the same total line length, so
+ * that neighbouring lines stay together. Each thread gets a
+ * contiguous run of chunks of the same total length in its own
+ * deque, takes them from the front, and when it runs out steals
+ * chunks from the back of the deques of the other threads.
+ *
+ * Initialize and Next must not be called concurrently, but Next can
+ * be called by all the threads at the same time.
+**/
+template <class TImage, class TBres, class TLine>
+class AnchorLineScheduler
+{
+public:
+  typedef AnchorLinePass<TImage, TBres, TLine> PassType;
+  typedef typename TImage::RegionType RegionType;
+
+  /** Consecutive start pixels of the face, the first being at
+   * position First in raster order */
+  struct Chunk
+  {
+    unsigned long First;
+    unsigned long Count;
+    unsigned long Weight;
+  };
+
+  AnchorLineScheduler();
+  ~AnchorLineScheduler();
+
+  /** The number of chunks made for each thread, so that a thread
+   * that finishes early has something to steal. Default is 8. */
+  void SetChunksPerThread(unsigned int chunks)
+  {
+    m_ChunksPerThread = chunks > 0 ? chunks : 1;
+  }
+  unsigned int GetChunksPerThread() const
+  {
+    return m_ChunksPerThread;
+  }
+
+  /** Make the chunks of the lines of pass across AllImage, and deal
+   * them to threads. */
+  void Initialize(const PassType &pass, const RegionType AllImage, unsigned int threads);
+
+  /** Make the chunks of a list of items of the given weights, such
+   * as the regions of an AnchorRegionBatch, and deal them to
+   * threads. First and Count of the chunks are then positions in the
+   * list. */
+  void Initialize(const std::vector<unsigned int> &weights, unsigned int threads);
+
+  /** Get the next chunk of threadId. Returns false when all the
+   * chunks have been handed out. */
+  bool Next(unsigned int threadId, Chunk &chunk);
+
+  unsigned long GetNumberOfChunks() const
+  {
+    return m_Chunks.size();
+  }
+  unsigned long GetTotalWeight() const
+  {
+    return m_TotalWeight;
+  }
+
+  /** The chunks taken from another thread since Initialize */
+  unsigned long GetNumberOfSteals();
+
+private:
+  AnchorLineScheduler(const AnchorLineScheduler&); //purposely not implemented
+  void operator=(const AnchorLineScheduler&); //purposely not implemented
+
+  // the chunks of a thread are those from Front to Back. Padded so
+  // that the deques of different threads don't share a cache line
+  struct Deque
+  {
+    SimpleMutexLock Lock;
+    unsigned long Front;
+    unsigned long Back;
+    unsigned long Steals;
+    char Pad[64];
+  };
+
+  std::vector<Chunk> m_Chunks;
+  Deque * m_Deques;
+  unsigned int m_Threads;
+  unsigned int m_ChunksPerThread;
+  unsigned long m_TotalWeight;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorLineScheduler.txx"
+#endif
+
+#endif
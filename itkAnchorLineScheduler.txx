@@ -0,0 +1,173 @@
+#ifndef __itkAnchorLineScheduler_txx
+#define __itkAnchorLineScheduler_txx
+
+#include "itkAnchorLineScheduler.h"
+
+namespace itk {
+
+template <class TImage, class TBres, class TLine>
+AnchorLineScheduler<TImage, TBres, TLine>
+::AnchorLineScheduler()
+{
+  m_Deques = 0;
+  m_Threads = 0;
+  m_ChunksPerThread = 8;
+  m_TotalWeight = 0;
+}
+
+template <class TImage, class TBres, class TLine>
+AnchorLineScheduler<TImage, TBres, TLine>
+::~AnchorLineScheduler()
+{
+  delete [] m_Deques;
+}
+
+template <class TImage, class TBres, class TLine>
+void
+AnchorLineScheduler<TImage, TBres, TLine>
+::Initialize(const PassType &pass, const RegionType AllImage, unsigned int threads)
+{
+  // the weight of a start pixel is the length of its line, plus one
+  // for the cost of finding that there is no line
+  const RegionType face = pass.Face;
+  const unsigned long pixels = face.GetNumberOfPixels();
+  std::vector<unsigned int> weights(pixels);
+  TLine NormLine = pass.Line;
+  NormLine.Normalize();
+  float tol = 1.0/pass.LineOffsets.size();
+  typename TImage::IndexType Ind = face.GetIndex();
+  for (unsigned long p = 0; p < pixels; p++)
+    {
+    unsigned start, end;
+    weights[p] = 1;
+    if (computeStartEnd<TImage, TBres, TLine>(Ind, NormLine, tol, pass.LineOffsets, AllImage, start, end))
+      {
+      weights[p] += end - start + 1;
+      }
+    for (unsigned d = 0; d < TImage::ImageDimension; d++)
+      {
+      if (++Ind[d] < face.GetIndex()[d] + (long)face.GetSize()[d]) break;
+      Ind[d] = face.GetIndex()[d];
+      }
+    }
+  this->Initialize(weights, threads);
+}
+
+template <class TImage, class TBres, class TLine>
+void
+AnchorLineScheduler<TImage, TBres, TLine>
+::Initialize(const std::vector<unsigned int> &weights, unsigned int threads)
+{
+  if (threads == 0)
+    {
+    threads = 1;
+    }
+  const unsigned long pixels = weights.size();
+  m_TotalWeight = 0;
+  for (unsigned long p = 0; p < pixels; p++)
+    {
+    m_TotalWeight += weights[p];
+    }
+
+  // cut the raster order into chunks of about the same weight
+  const unsigned long target = m_TotalWeight / (threads * m_ChunksPerThread) + 1;
+  m_Chunks.clear();
+  Chunk C;
+  C.First = 0;
+  C.Count = 0;
+  C.Weight = 0;
+  for (unsigned long p = 0; p < pixels; p++)
+    {
+    C.Count++;
+    C.Weight += weights[p];
+    if (C.Weight >= target)
+      {
+      m_Chunks.push_back(C);
+      C.First = p + 1;
+      C.Count = 0;
+      C.Weight = 0;
+      }
+    }
+  if (C.Count)
+    {
+    m_Chunks.push_back(C);
+    }
+
+  // deal contiguous runs of chunks of the same weight
+  if (threads != m_Threads)
+    {
+    delete [] m_Deques;
+    m_Deques = new Deque[threads];
+    m_Threads = threads;
+    }
+  unsigned long done = 0;
+  unsigned long c = 0;
+  for (unsigned int t = 0; t < m_Threads; t++)
+    {
+    m_Deques[t].Front = c;
+    m_Deques[t].Steals = 0;
+    // the chunks whose middle falls in the share of this thread
+    while ((c < m_Chunks.size()) &&
+	   ((done + m_Chunks[c].Weight/2) * m_Threads < m_TotalWeight * (t + 1)))
+      {
+      done += m_Chunks[c].Weight;
+      c++;
+      }
+    m_Deques[t].Back = c;
+    }
+  m_Deques[m_Threads - 1].Back = m_Chunks.size();
+}
+
+template <class TImage, class TBres, class TLine>
+bool
+AnchorLineScheduler<TImage, TBres, TLine>
+::Next(unsigned int threadId, Chunk &chunk)
+{
+  // own chunks first, in order
+  Deque & own = m_Deques[threadId];
+  own.Lock.Lock();
+  if (own.Front < own.Back)
+    {
+    chunk = m_Chunks[own.Front++];
+    own.Lock.Unlock();
+    return true;
+    }
+  own.Lock.Unlock();
+  // then the last chunk of the next thread that has some left, far
+  // from the ones it is working on
+  for (unsigned int k = 1; k < m_Threads; k++)
+    {
+    Deque & victim = m_Deques[(threadId + k) % m_Threads];
+    victim.Lock.Lock();
+    if (victim.Front < victim.Back)
+      {
+      chunk = m_Chunks[--victim.Back];
+      victim.Lock.Unlock();
+      own.Lock.Lock();
+      own.Steals++;
+      own.Lock.Unlock();
+      return true;
+      }
+    victim.Lock.Unlock();
+    }
+  return false;
+}
+
+template <class TImage, class TBres, class TLine>
+unsigned long
+AnchorLineScheduler<TImage, TBres, TLine>
+::GetNumberOfSteals()
+{
+  unsigned long steals = 0;
+  for (unsigned int t = 0; t < m_Threads; t++)
+    {
+    m_Deques[t].Lock.Lock();
+    steals += m_Deques[t].Steals;
+    m_Deques[t].Lock.Unlock();
+    }
+  return steals;
+}
+
+} // namespace itk
+
+#endif
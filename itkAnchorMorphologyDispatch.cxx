@@ -0,0 +1,152 @@
+// the filters are instantiated by the other sources of the library
+#define ANCHOR_MANUAL_INSTANTIATION
+
+#include "itkAnchorMorphologyDispatch.h"
+#include "itkImage.h"
+#include "itkFlatStructuringElement.h"
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+
+namespace itk {
+
+// tries the types in the same order for CanRun and Run
+#define anchorDispatchMacro(action) \
+  action(unsigned char, 2) action(unsigned char, 3) \
+  action(char, 2) action(char, 3) \
+  action(unsigned short, 2) action(unsigned short, 3) \
+  action(short, 2) action(short, 3) \
+  action(unsigned int, 2) action(unsigned int, 3) \
+  action(int, 2) action(int, 3) \
+  action(float, 2) action(float, 3) \
+  action(double, 2) action(double, 3)
+
+AnchorMorphologyDispatch
+::AnchorMorphologyDispatch()
+{
+  m_Operation = ERODE;
+  m_Radius = RadiusType(1, 1);
+  m_Lines = 0;
+  m_NumberOfThreads = 0;
+}
+
+void
+AnchorMorphologyDispatch
+::SetRadius(const RadiusType &radius)
+{
+  if (radius.empty())
+    {
+    itkExceptionMacro("Empty radius");
+    }
+  if (m_Radius != radius)
+    {
+    m_Radius = radius;
+    this->Modified();
+    }
+}
+
+bool
+AnchorMorphologyDispatch
+::CanRun(const DataObject * image)
+{
+#define anchorCanRunMacro(T, D) \
+  if (dynamic_cast<const Image< T, D > *>(image)) return true;
+  anchorDispatchMacro(anchorCanRunMacro)
+#undef anchorCanRunMacro
+  return false;
+}
+
+DataObject::Pointer
+AnchorMorphologyDispatch
+::Run(const DataObject * image)
+{
+  if (!image)
+    {
+    itkExceptionMacro("No image");
+    }
+#define anchorRunMacro(T, D) \
+  if (const Image< T, D > * typed = dynamic_cast<const Image< T, D > *>(image)) \
+    { \
+    return this->RunImage(typed); \
+    }
+  anchorDispatchMacro(anchorRunMacro)
+#undef anchorRunMacro
+  itkExceptionMacro("Unsupported image type " << image->GetNameOfClass());
+}
+
+template <class TImage>
+DataObject::Pointer
+AnchorMorphologyDispatch
+::RunImage(const TImage * image)
+{
+  typedef FlatStructuringElement<TImage::ImageDimension> KernelType;
+  typename KernelType::RadiusType Rad;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    Rad[i] = m_Radius[i < m_Radius.size() ? i : m_Radius.size() - 1];
+    }
+  KernelType K = m_Lines ? KernelType::Poly(Rad, m_Lines) : KernelType::Box(Rad);
+
+  typedef ImageToImageFilter<TImage, TImage> FilterType;
+  typename FilterType::Pointer filter;
+  switch (m_Operation)
+    {
+    case ERODE:
+      {
+      typename AnchorErodeImageFilter<TImage, KernelType>::Pointer erode = AnchorErodeImageFilter<TImage, KernelType>::New();
+      erode->SetKernel(K);
+      filter = erode.GetPointer();
+      break;
+      }
+    case DILATE:
+      {
+      typename AnchorDilateImageFilter<TImage, KernelType>::Pointer dilate = AnchorDilateImageFilter<TImage, KernelType>::New();
+      dilate->SetKernel(K);
+      filter = dilate.GetPointer();
+      break;
+      }
+    case OPEN:
+      {
+      typename AnchorOpenImageFilter<TImage, KernelType>::Pointer open = AnchorOpenImageFilter<TImage, KernelType>::New();
+      open->SetKernel(K);
+      filter = open.GetPointer();
+      break;
+      }
+    default:
+      {
+      typename AnchorCloseImageFilter<TImage, KernelType>::Pointer close = AnchorCloseImageFilter<TImage, KernelType>::New();
+      close->SetKernel(K);
+      filter = close.GetPointer();
+      break;
+      }
+    }
+  filter->SetInput(image);
+  if (m_NumberOfThreads > 0)
+    {
+    filter->SetNumberOfThreads(m_NumberOfThreads);
+    }
+  filter->Update();
+  typename TImage::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  DataObject::Pointer output = result.GetPointer();
+  return output;
+}
+
+void
+AnchorMorphologyDispatch
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Operation: " << m_Operation << std::endl;
+  os << indent << "Radius:";
+  for (unsigned i = 0; i < m_Radius.size(); i++)
+    {
+    os << " " << m_Radius[i];
+    }
+  os << std::endl;
+  os << indent << "Lines: " << m_Lines << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+}
+
+} // end namespace itk
@@ -0,0 +1,96 @@
+#ifndef __itkAnchorMorphologyDispatch_h
+#define __itkAnchorMorphologyDispatch_h
+
+#include "itkObject.h"
+#include "itkDataObject.h"
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class AnchorMorphologyDispatch
+ * \brief anchor erosions, dilations, openings and closings of images
+ * whose pixel type and dimension are only known at run time.
+ *
+ * Run takes any image, for instance through a pointer to its
+ * ImageBase, finds its type among those instantiated by the
+ * anchorMorphology library, builds the kernel of that dimension and
+ * runs the matching filter. The supported images are the scalar
+ * images of unsigned char, char, unsigned short, short, unsigned
+ * int, int, float and double pixels, in 2D and 3D.
+ *
+ * This class is compiled in the anchorMorphology library, so the
+ * programs using it don't instantiate any of the filters.
+**/
+class ITK_EXPORT AnchorMorphologyDispatch : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorMorphologyDispatch Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer<Self>       Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorMorphologyDispatch, Object);
+
+  typedef enum {ERODE, DILATE, OPEN, CLOSE} OperationType;
+  typedef std::vector<unsigned long> RadiusType;
+
+  /** The operation done by Run. Default is ERODE. */
+  itkSetMacro(Operation, OperationType);
+  itkGetConstMacro(Operation, OperationType);
+
+  /** The radius of the kernel in each dimension. The last value is
+   * used for the dimensions it doesn't give. Default is 1. */
+  void SetRadius(const RadiusType &radius);
+  void SetRadius(unsigned long radius)
+  {
+    this->SetRadius(RadiusType(1, radius));
+  }
+  const RadiusType & GetRadius() const
+  {
+    return m_Radius;
+  }
+
+  /** The number of lines of a polygonal kernel, or 0, the default,
+   * for a box. */
+  itkSetMacro(Lines, unsigned int);
+  itkGetConstMacro(Lines, unsigned int);
+
+  /** The number of threads of the filter, 0 for its default */
+  itkSetMacro(NumberOfThreads, int);
+  itkGetConstMacro(NumberOfThreads, int);
+
+  /** Whether Run supports the type of image */
+  static bool CanRun(const DataObject * image);
+
+  /** Compute the operation on image. The result is a new image of
+   * the same type. Throws if the type of image isn't supported. */
+  DataObject::Pointer Run(const DataObject * image);
+
+protected:
+  AnchorMorphologyDispatch();
+  ~AnchorMorphologyDispatch() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+private:
+  AnchorMorphologyDispatch(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  template <class TImage>
+  DataObject::Pointer RunImage(const TImage * image);
+
+  OperationType m_Operation;
+  RadiusType m_Radius;
+  unsigned int m_Lines;
+  int m_NumberOfThreads;
+
+} ; // end of class
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef __itkAnchorMorphologyExpression_h
+#define __itkAnchorMorphologyExpression_h
+
+#include "itkAnchorUtilities.h"
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class AnchorMorphologyExpression
+ * \brief a chain of erosions, dilations, openings and closings by
+ * decomposable structuring elements, compiled to a short list of
+ * line passes.
+ *
+ * The operations are chained as in
+ *
+ *   expr.Close(k1).Open(k1).Close(k2).Open(k2);
+ *
+ * and each one is expanded to the erosions and dilations by the lines
+ * of its kernel. Compile then shortens the list:
+ *
+ * - consecutive passes of the same type commute, so the passes of a
+ * run of erosions, or of dilations, along the same direction and with
+ * the same period are merged: lines of a and b pixels make one line
+ * of a + b - 1 pixels.
+ *
+ * - where a run of erosions is followed by a run of dilations along a
+ * common direction, the last erosion and the first dilation along it
+ * are done as one opening by a line, as in
+ * AnchorOpenCloseImageFilter, and a dilation followed by an erosion as
+ * a closing. If the lengths differ, the longer pass keeps the
+ * remainder.
+ *
+ * An alternating sequential filter of n steps by a box goes from 4n
+ * passes per dimension to about 2n + 1. The compiled passes are run by
+ * AnchorMorphologyExpressionImageFilter.
+**/
+template<class TKernel>
+class AnchorMorphologyExpression
+{
+public:
+  typedef AnchorMorphologyExpression Self;
+  typedef TKernel KernelType;
+  typedef typename KernelType::LType LineType;
+
+  typedef enum {ErodePass, DilatePass, OpenPass, ClosePass} PassKindType;
+
+  /** A pass by a line, whose number of pixels, made odd, is Length */
+  typedef struct {
+    PassKindType Kind;
+    LineType Line;
+    unsigned int Period;
+    unsigned int Length;
+  } PassType;
+  typedef std::vector<PassType> PassListType;
+
+  AnchorMorphologyExpression()
+  {
+    m_Operations = 0;
+    m_Decomposable = true;
+  }
+
+  /** Append an operation by kernel. A kernel of a single pixel adds
+   * no pass. */
+  Self & Erode(const KernelType &kernel)
+  {
+    this->AddPasses(kernel, ErodePass);
+    return *this;
+  }
+  Self & Dilate(const KernelType &kernel)
+  {
+    this->AddPasses(kernel, DilatePass);
+    return *this;
+  }
+  Self & Open(const KernelType &kernel)
+  {
+    this->AddPasses(kernel, ErodePass);
+    this->AddPasses(kernel, DilatePass);
+    --m_Operations;
+    return *this;
+  }
+  Self & Close(const KernelType &kernel)
+  {
+    this->AddPasses(kernel, DilatePass);
+    this->AddPasses(kernel, ErodePass);
+    --m_Operations;
+    return *this;
+  }
+
+  void Clear()
+  {
+    m_Passes.clear();
+    m_Operations = 0;
+    m_Decomposable = true;
+  }
+
+  unsigned int GetNumberOfOperations() const
+  {
+    return m_Operations;
+  }
+
+  /** False if one of the kernels isn't decomposable */
+  bool GetDecomposable() const
+  {
+    return m_Decomposable;
+  }
+
+  /** The erosions and dilations by the lines of the kernels, in the
+   * order of the operations, before compilation */
+  const PassListType & GetLinePasses() const
+  {
+    return m_Passes;
+  }
+
+  /** The merged passes, in the order they must be run */
+  PassListType Compile() const;
+
+private:
+  PassListType m_Passes;
+  unsigned int m_Operations;
+  bool m_Decomposable;
+
+  void AddPasses(const KernelType &kernel, PassKindType kind);
+
+  // a direction of a run of erosions or of dilations, and the number
+  // of points of its line, which is (Length - 1) / Period + 1
+  typedef struct {
+    LineType Line;
+    unsigned int Period;
+    unsigned int Points;
+  } EntryType;
+  typedef std::vector<EntryType> RunType;
+
+  static bool SameDirection(const EntryType &a, const EntryType &b);
+
+  static PassType MakePass(const EntryType &entry, PassKindType kind);
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorMorphologyExpression.txx"
+#endif
+
+#endif
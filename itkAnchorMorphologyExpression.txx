@@ -0,0 +1,181 @@
+#ifndef __itkAnchorMorphologyExpression_txx
+#define __itkAnchorMorphologyExpression_txx
+
+#include "itkAnchorMorphologyExpression.h"
+#include <math.h>
+#include <algorithm>
+
+namespace itk {
+
+template <class TKernel>
+void
+AnchorMorphologyExpression<TKernel>
+::AddPasses(const KernelType &kernel, PassKindType kind)
+{
+  ++m_Operations;
+  if (!kernel.GetDecomposable())
+    {
+    m_Decomposable = false;
+    return;
+    }
+  const typename KernelType::DecompType &lines = kernel.GetLines();
+  for (unsigned i = 0; i < lines.size(); i++)
+    {
+    PassType pass;
+    pass.Kind = kind;
+    pass.Line = lines[i];
+    pass.Period = kernel.GetPeriod(i);
+    pass.Length = getLinePixels<LineType>(lines[i]);
+    // want lines to be odd
+    if (!(pass.Length%2))
+      ++pass.Length;
+    m_Passes.push_back(pass);
+    }
+}
+
+template <class TKernel>
+bool
+AnchorMorphologyExpression<TKernel>
+::SameDirection(const EntryType &a, const EntryType &b)
+{
+  if (a.Period != b.Period)
+    {
+    return false;
+    }
+  // the Bresenham lines only depend on the direction, so the lines
+  // of opposite directions, which may be drawn differently, are kept
+  // apart
+  LineType na = a.Line;
+  LineType nb = b.Line;
+  na.Normalize();
+  nb.Normalize();
+  for (unsigned i = 0; i < LineType::Dimension; i++)
+    {
+    if (fabs(na[i] - nb[i]) > 1e-4)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+template <class TKernel>
+typename AnchorMorphologyExpression<TKernel>::PassType
+AnchorMorphologyExpression<TKernel>
+::MakePass(const EntryType &entry, PassKindType kind)
+{
+  PassType pass;
+  pass.Kind = kind;
+  pass.Period = entry.Period;
+  pass.Length = (entry.Points - 1) * entry.Period + 1;
+  if (!(pass.Length%2))
+    ++pass.Length;
+  // scale the line to the length, see getLinePixels
+  float longest = 0.0;
+  for (unsigned i = 0; i < LineType::Dimension; i++)
+    {
+    if (fabs(entry.Line[i]) > longest) longest = fabs(entry.Line[i]);
+    }
+  pass.Line = entry.Line * (pass.Length / longest);
+  return pass;
+}
+
+template <class TKernel>
+typename AnchorMorphologyExpression<TKernel>::PassListType
+AnchorMorphologyExpression<TKernel>
+::Compile() const
+{
+  // split the passes into runs of erosions and of dilations, merging
+  // the lines of a run along the same direction
+  std::vector<RunType> runs;
+  std::vector<PassKindType> kinds;
+  for (unsigned p = 0; p < m_Passes.size(); p++)
+    {
+    EntryType entry;
+    entry.Line = m_Passes[p].Line;
+    entry.Period = m_Passes[p].Period;
+    entry.Points = (m_Passes[p].Length - 1) / entry.Period + 1;
+    if (entry.Points < 2)
+      {
+      // a single pixel doesn't change anything
+      continue;
+      }
+    if (runs.empty() || (kinds.back() != m_Passes[p].Kind))
+      {
+      runs.push_back(RunType());
+      kinds.push_back(m_Passes[p].Kind);
+      }
+    RunType &run = runs.back();
+    unsigned i = 0;
+    for (; i < run.size(); i++)
+      {
+      if (SameDirection(run[i], entry))
+	{
+	run[i].Points += entry.Points - 1;
+	break;
+	}
+      }
+    if (i == run.size())
+      {
+      run.push_back(entry);
+      }
+    }
+
+  PassListType compiled;
+  bool headFused = false;
+  for (unsigned r = 0; r < runs.size(); r++)
+    {
+    RunType &run = runs[r];
+    // look for a direction shared with the next run, preferring the
+    // last line of this one as AnchorOpenCloseImageFilter does
+    int fused = -1, partner = -1;
+    if (r + 1 < runs.size())
+      {
+      for (int i = (int)run.size() - 1; (i >= 0) && (fused < 0); --i)
+	{
+	for (unsigned j = 0; (run[i].Points > 1) && (j < runs[r + 1].size()); j++)
+	  {
+	  if (SameDirection(run[i], runs[r + 1][j]))
+	    {
+	    fused = i;
+	    partner = j;
+	    break;
+	    }
+	  }
+	}
+      }
+    EntryType opening;
+    if (fused >= 0)
+      {
+      // a line of a points is a line of a - m + 1 points followed by
+      // one of m points
+      EntryType &next = runs[r + 1][partner];
+      opening = run[fused];
+      opening.Points = std::min(run[fused].Points, next.Points);
+      run[fused].Points -= opening.Points - 1;
+      next.Points -= opening.Points - 1;
+      }
+    // after an opening, the lines of the run are swept in the reverse
+    // order, as in AnchorOpenCloseImageFilter, so that an erosion
+    // followed by a dilation by the same kernel gives the same result
+    // as AnchorOpenImageFilter
+    for (unsigned i = 0; i < run.size(); i++)
+      {
+      const EntryType &entry = headFused ? run[run.size() - 1 - i] : run[i];
+      if (entry.Points > 1)
+	{
+	compiled.push_back(MakePass(entry, kinds[r]));
+	}
+      }
+    if (fused >= 0)
+      {
+      compiled.push_back(MakePass(opening, (kinds[r] == ErodePass) ? OpenPass : ClosePass));
+      }
+    headFused = (fused >= 0);
+    }
+  return compiled;
+}
+
+} // end namespace itk
+
+#endif
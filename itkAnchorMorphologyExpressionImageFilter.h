@@ -0,0 +1,129 @@
+#ifndef __itkAnchorMorphologyExpressionImageFilter_h
+#define __itkAnchorMorphologyExpressionImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkAnchorSweepMonitor.h"
+#include "itkAnchorErodeDilateLine.h"
+#include "itkAnchorOpenCloseLine.h"
+#include "itkBresenhamLine.h"
+#include "itkAnchorUtilities.h"
+#include "itkAnchorMorphologyExpression.h"
+#include <functional>
+
+namespace itk {
+
+/**
+ * \class AnchorMorphologyExpressionImageFilter
+ * \brief run a chain of erosions, dilations, openings and closings,
+ * described by an AnchorMorphologyExpression, as one list of line
+ * passes.
+ *
+ * A chain of the anchor filters, such as an alternating sequential
+ * filter, replays the whole decomposition of each kernel, and each
+ * filter of the chain allocates its own output. The expression is
+ * compiled instead to a shorter list of passes (see
+ * AnchorMorphologyExpression), the first of which goes from the input
+ * to the output and the others are done in place in the output, with
+ * a single pair of line buffers.
+ *
+ * The result is the one of the chain of filters, except that the
+ * openings and closings by lines that the compiled expression does
+ * directly may be placed differently than in the filters.
+**/
+template<class TImage, class TKernel>
+class ITK_EXPORT AnchorMorphologyExpressionImageFilter :
+    public ImageToImageFilter<TImage, TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorMorphologyExpressionImageFilter Self;
+  typedef ImageToImageFilter<TImage, TImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TKernel KernelType;
+  typedef AnchorMorphologyExpression<TKernel> ExpressionType;
+
+  typedef TImage InputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorMorphologyExpressionImageFilter,
+               ImageToImageFilter);
+
+  void SetExpression(const ExpressionType &expression)
+  {
+    m_Expression = expression;
+    this->Modified();
+  }
+  const ExpressionType & GetExpression() const
+  {
+    return m_Expression;
+  }
+
+  /** The number of passes of the last update, after compilation */
+  itkGetConstReferenceMacro(NumberOfPasses, unsigned int);
+
+protected:
+  AnchorMorphologyExpressionImageFilter();
+  ~AnchorMorphologyExpressionImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** The lines cross the whole image */
+  void EnlargeOutputRequestedRegion(DataObject *output);
+
+  void GenerateData();
+
+private:
+  AnchorMorphologyExpressionImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  ExpressionType m_Expression;
+  unsigned int m_NumberOfPasses;
+
+  typedef BresenhamLine<TImage::ImageDimension> BresType;
+  typedef typename KernelType::LType LineType;
+  typedef AnchorLinePass<TImage, BresType, LineType> LinePassType;
+
+  typedef std::less<InputImagePixelType> LessThan;
+  typedef std::greater<InputImagePixelType> GreaterThan;
+  typedef std::less_equal<InputImagePixelType> LessEqual;
+  typedef std::greater_equal<InputImagePixelType> GreaterEqual;
+
+  // the classes that operate on lines, as in AnchorErodeImageFilter,
+  // AnchorDilateImageFilter, AnchorOpenImageFilter and
+  // AnchorCloseImageFilter
+  typedef AnchorErodeDilateLine<InputImagePixelType, LessThan, LessEqual> AnchorLineErodeType;
+  typedef AnchorErodeDilateLine<InputImagePixelType, GreaterThan, GreaterEqual> AnchorLineDilateType;
+  typedef AnchorOpenCloseLine<InputImagePixelType, LessThan, GreaterEqual, LessEqual> AnchorLineOpenType;
+  typedef AnchorOpenCloseLine<InputImagePixelType, GreaterThan, LessEqual, GreaterEqual> AnchorLineCloseType;
+
+  AnchorLineErodeType AnchorLineErode;
+  AnchorLineDilateType AnchorLineDilate;
+  AnchorLineOpenType AnchorLineOpen;
+  AnchorLineCloseType AnchorLineClose;
+} ; // end of class
+
+
+} // end namespace itk
+
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorMorphologyExpressionImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef __itkAnchorMorphologyExpressionImageFilter_txx
+#define __itkAnchorMorphologyExpressionImageFilter_txx
+
+#include "itkAnchorMorphologyExpressionImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+namespace itk {
+
+template <class TImage, class TKernel>
+AnchorMorphologyExpressionImageFilter<TImage, TKernel>
+::AnchorMorphologyExpressionImageFilter()
+{
+  m_NumberOfPasses = 0;
+}
+
+template <class TImage, class TKernel>
+void
+AnchorMorphologyExpressionImageFilter<TImage, TKernel>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorMorphologyExpressionImageFilter<TImage, TKernel>
+::GenerateData()
+{
+  if (!m_Expression.GetDecomposable())
+    {
+    itkExceptionMacro("Anchor morphology only works with decomposable structuring elements");
+    }
+
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+
+  typename ExpressionType::PassListType passes = m_Expression.Compile();
+  m_NumberOfPasses = passes.size();
+  if (passes.empty())
+    {
+    // nothing but kernels of a single pixel
+    ImageRegionConstIterator<TImage> inIt(input, AllImage);
+    ImageRegionIterator<TImage> outIt(output, AllImage);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    return;
+    }
+
+  // maximum buffer length is sum of dimensions
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+  // the buffers are shared by all the passes
+  InputImagePixelType * inbuffer = new InputImagePixelType[bufflength];
+  InputImagePixelType * outbuffer = new InputImagePixelType[bufflength];
+
+  // each pass covers the image once
+  AnchorSweepMonitor monitor(this, 0, (double)passes.size() * AllImage.GetNumberOfPixels());
+
+  for (unsigned i = 0; i < passes.size(); i++)
+    {
+    LinePassType pass = mkLinePass<TImage, BresType, LineType>(AllImage, passes[i].Line,
+							       bufflength, passes[i].Period);
+    bool done = true;
+    switch (passes[i].Kind)
+      {
+      case ExpressionType::ErodePass:
+	AnchorLineErode.SetSize(pass.SELength);
+	AnchorLineErode.SetPeriod(pass.Period);
+	done = doFace<TImage, BresType, AnchorLineErodeType, LineType>(input, output, pass.Line, AnchorLineErode,
+								       pass.LineOffsets, inbuffer, outbuffer,
+								       AllImage, pass.Face, &monitor);
+	break;
+      case ExpressionType::DilatePass:
+	AnchorLineDilate.SetSize(pass.SELength);
+	AnchorLineDilate.SetPeriod(pass.Period);
+	done = doFace<TImage, BresType, AnchorLineDilateType, LineType>(input, output, pass.Line, AnchorLineDilate,
+									pass.LineOffsets, inbuffer, outbuffer,
+									AllImage, pass.Face, &monitor);
+	break;
+      case ExpressionType::OpenPass:
+	AnchorLineOpen.SetSize(pass.SELength);
+	AnchorLineOpen.SetPeriod(pass.Period);
+	done = doOpenFace<TImage, BresType, AnchorLineOpenType, LineType>(input, output, pass.Line, AnchorLineOpen,
+									  pass.LineOffsets, outbuffer,
+									  AllImage, pass.Face, &monitor);
+	break;
+      case ExpressionType::ClosePass:
+	AnchorLineClose.SetSize(pass.SELength);
+	AnchorLineClose.SetPeriod(pass.Period);
+	done = doOpenFace<TImage, BresType, AnchorLineCloseType, LineType>(input, output, pass.Line, AnchorLineClose,
+									   pass.LineOffsets, outbuffer,
+									   AllImage, pass.Face, &monitor);
+	break;
+      }
+    if (!done)
+      {
+      delete [] inbuffer;
+      delete [] outbuffer;
+      abortSweep<TImage>(this->GetInput(), output, AllImage);
+      }
+    // after the first pass the input will be taken from the output
+    input = this->GetOutput();
+    }
+
+  delete [] inbuffer;
+  delete [] outbuffer;
+}
+
+template <class TImage, class TKernel>
+void
+AnchorMorphologyExpressionImageFilter<TImage, TKernel>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Operations: " << m_Expression.GetNumberOfOperations() << std::endl;
+  os << indent << "LinePasses: " << m_Expression.GetLinePasses().size() << std::endl;
+  os << indent << "NumberOfPasses: " << m_NumberOfPasses << std::endl;
+}
+
+} // end namespace itk
+
+#endif
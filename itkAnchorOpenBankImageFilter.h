@@ -0,0 +1,43 @@
+#ifndef __itkAnchorOpenBankImageFilter_h
+#define __itkAnchorOpenBankImageFilter_h
+
+#include "itkAnchorOpenCloseBankImageFilter.h"
+#include "itkImage.h"
+
+namespace itk {
+
+// the largest of the openings by lines at several orientations
+template<class TImage, class TOrientationImage = Image<unsigned short, TImage::ImageDimension> >
+class  ITK_EXPORT AnchorOpenBankImageFilter :
+    public AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, std::less<typename TImage::PixelType>, std::greater<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType> >
+
+{
+public:
+  typedef AnchorOpenBankImageFilter Self;
+  typedef AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, std::less<typename TImage::PixelType>, std::greater<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType> > Superclass;
+
+  typedef SmartPointer<Self>   Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  virtual ~AnchorOpenBankImageFilter() {}
+protected:
+  AnchorOpenBankImageFilter(){}
+  void PrintSelf(std::ostream& os, Indent indent) const
+  {
+    os << indent << "Anchor opening bank: " << std::endl;
+  }
+
+private:
+  
+  AnchorOpenBankImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+
+} // namespace itk
+
+#endif
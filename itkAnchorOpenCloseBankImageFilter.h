@@ -0,0 +1,188 @@
+#ifndef __itkAnchorOpenCloseBankImageFilter_h
+#define __itkAnchorOpenCloseBankImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkAnchorSweepMonitor.h"
+#include "itkAnchorOpenCloseLine.h"
+#include "itkBresenhamLine.h"
+#include "itkAnchorUtilities.h"
+#include "itkAnchorLineScheduler.h"
+#include "itkAnchorThreadPlacement.h"
+#include "itkMultiThreader.h"
+#include "itkVector.h"
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class AnchorOpenCloseBankImageFilter
+ * \brief openings or closings by lines at many orientations, keeping
+ * the extremum over the orientations at each pixel.
+ *
+ * Enhances thin structures such as vessels or fibres: a pixel keeps
+ * the largest of its openings by lines of Length pixels at each of
+ * the Angles, so that a structure survives if a line fits in it at
+ * one orientation. The lines of an orientation are swept with all the
+ * threads, like with the line scheduler of
+ * AnchorErodeDilateImageFilter, and each line is folded into the
+ * output as soon as it is computed, so no image is kept per
+ * orientation and the memory used doesn't depend on their number.
+ *
+ * The orientation, the index in Angles of the orientation that gave
+ * the value of a pixel, is the second output when
+ * ComputeOrientation is on. The first orientation wins a tie.
+ *
+ * The comparisons are those of AnchorOpenCloseImageFilter, and
+ * GreaterThan decides which line result is kept: the largest opening
+ * or the smallest closing.
+**/
+template<class TImage, class TOrientationImage,
+	 class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+class ITK_EXPORT AnchorOpenCloseBankImageFilter :
+    public ImageToImageFilter<TImage, TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorOpenCloseBankImageFilter Self;
+  typedef ImageToImageFilter<TImage, TImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  typedef TImage InputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef TOrientationImage OrientationImageType;
+  typedef typename OrientationImageType::PixelType OrientationPixelType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  /** The lines, in the format of FlatStructuringElement */
+  typedef Vector<float, itkGetStaticConstMacro(InputImageDimension)> LineType;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorOpenCloseBankImageFilter,
+               ImageToImageFilter);
+
+  /** The orientations of the lines, in radians from the first axis
+   * towards the second one. The lines are in the plane of these two
+   * axes, so in 3D every slice is processed with lines in the slice. */
+  void SetAngles(const std::vector<double> &angles)
+  {
+    m_Angles = angles;
+    this->Modified();
+  }
+  const std::vector<double> & GetAngles() const
+  {
+    return m_Angles;
+  }
+
+  /** Set count orientations evenly spread over half a turn */
+  void SetNumberOfAngles(unsigned int count);
+
+  /** The number of pixels of the lines, made odd if it isn't.
+   * Default is 15. */
+  itkSetMacro(Length, unsigned int);
+  itkGetConstReferenceMacro(Length, unsigned int);
+
+  /** Compute the orientation image, the second output. Off by
+   * default. */
+  itkSetMacro(ComputeOrientation, bool);
+  itkGetConstReferenceMacro(ComputeOrientation, bool);
+  itkBooleanMacro(ComputeOrientation);
+
+  /** Allocate the outputs from the threads of the sweep, as in
+   * AnchorErodeDilateImageFilter. Off by default. */
+  itkSetMacro(UseFirstTouch, bool);
+  itkGetConstReferenceMacro(UseFirstTouch, bool);
+  itkBooleanMacro(UseFirstTouch);
+
+  /** Pin the threads to a list of CPUs, as in
+   * AnchorErodeDilateImageFilter. */
+  void SetCPUList(const std::string &list)
+  {
+    if (!m_Placement.SetCPUList(list))
+      {
+      itkExceptionMacro("Invalid CPU list: " << list);
+      }
+    this->Modified();
+  }
+  const std::string & GetCPUList() const
+  {
+    return m_Placement.GetCPUList();
+  }
+
+  /** The line used for orientation i. The opening by
+   * FlatStructuringElement::Line of it gives the same result. */
+  LineType GetLine(unsigned int i) const;
+
+  /** The index of the orientation kept for each pixel. */
+  OrientationImageType * GetOrientationOutput();
+
+protected:
+  AnchorOpenCloseBankImageFilter();
+  ~AnchorOpenCloseBankImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** The orientation image has the geometry of the input */
+  void GenerateOutputInformation();
+
+  /** The whole image is computed, as the lines cross it */
+  void EnlargeOutputRequestedRegion(DataObject *);
+
+  /** Every orientation is swept with all the threads */
+  void GenerateData();
+
+private:
+  AnchorOpenCloseBankImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::vector<double> m_Angles;
+  unsigned int m_Length;
+  bool m_ComputeOrientation;
+  bool m_UseFirstTouch;
+  AnchorThreadPlacement m_Placement;
+
+  typedef BresenhamLine<TImage::ImageDimension> BresType;
+  typedef AnchorLinePass<TImage, BresType, LineType> PassType;
+  typedef AnchorLineScheduler<TImage, BresType, LineType> SchedulerType;
+  typedef AnchorOpenCloseLine<InputImagePixelType, LessThan, GreaterEqual, LessEqual> AnchorLineOpenType;
+
+  // the orientation being swept by the threads
+  struct BankThreadStruct
+  {
+    Pointer Filter;
+    const PassType * Pass;
+    unsigned int Orientation;
+    SchedulerType * Scheduler;
+  };
+  static ITK_THREAD_RETURN_TYPE BankThreaderCallback( void *arg );
+
+  // sweep count lines of the face from the one at position first, and
+  // fold them into the output. Returns false if aborted.
+  bool foldFaceLines(const PassType &pass,
+		     unsigned int orientation,
+		     AnchorLineOpenType &AnchorLine,
+		     InputImagePixelType * buffer,
+		     unsigned long first,
+		     unsigned long count,
+		     AnchorSweepMonitor &monitor);
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorOpenCloseBankImageFilter.txx"
+#endif
+
+#endif
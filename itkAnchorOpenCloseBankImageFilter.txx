@@ -0,0 +1,282 @@
+#ifndef __itkAnchorOpenCloseBankImageFilter_txx
+#define __itkAnchorOpenCloseBankImageFilter_txx
+
+#include "itkAnchorOpenCloseBankImageFilter.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace itk {
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::AnchorOpenCloseBankImageFilter()
+{
+  m_Length = 15;
+  m_ComputeOrientation = false;
+  m_UseFirstTouch = false;
+  this->SetNumberOfRequiredOutputs(2);
+  this->SetNthOutput(1, OrientationImageType::New().GetPointer());
+}
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::SetNumberOfAngles(unsigned int count)
+{
+  m_Angles.clear();
+  for (unsigned i = 0; i < count; i++)
+    {
+    m_Angles.push_back(M_PI * i / count);
+    }
+  this->Modified();
+}
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+typename AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>::LineType
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GetLine(unsigned int i) const
+{
+  LineType line;
+  line.Fill(0);
+  if ((i >= m_Angles.size()) || (TImage::ImageDimension < 2))
+    {
+    return line;
+    }
+  float c = cos(m_Angles[i]);
+  float s = sin(m_Angles[i]);
+  // the lines along the axes must have no component across them
+  if (fabs(c) < 1e-6) c = 0;
+  if (fabs(s) < 1e-6) s = 0;
+  // the number of pixels of a line is its largest coordinate
+  unsigned int length = m_Length | 1;
+  float scale = length / std::max(fabs(c), fabs(s));
+  line[0] = c * scale;
+  line[1] = s * scale;
+  return line;
+}
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+typename AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>::OrientationImageType *
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GetOrientationOutput()
+{
+  return dynamic_cast<OrientationImageType *>(this->ProcessObject::GetOutput(1));
+}
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+  OrientationImageType * orientation = this->GetOrientationOutput();
+  if (orientation && this->GetInput())
+    {
+    orientation->CopyInformation(this->GetInput());
+    }
+}
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  // the lines cross the whole image
+  this->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GenerateData()
+{
+  if (m_Angles.empty())
+    {
+    itkExceptionMacro("No angles set");
+    }
+
+  int threads = this->GetNumberOfThreads();
+  this->GetMultiThreader()->SetNumberOfThreads(threads);
+  threads = this->GetMultiThreader()->GetNumberOfThreads();
+  InputImagePointer output = this->GetOutput();
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+  OrientationImageType * orientation = this->GetOrientationOutput();
+  if (m_UseFirstTouch)
+    {
+    // slabs along the slowest axis only spread the pages over the
+    // nodes: the chunks of a thread aren't its slab, and lines along
+    // or diagonal to that axis cross all the slabs
+    allocateFirstTouch<TImage>(output, TImage::ImageDimension - 1,
+			       this->GetMultiThreader(), m_Placement);
+    }
+  else
+    {
+    this->AllocateOutputs();
+    }
+  if (m_ComputeOrientation)
+    {
+    orientation->SetRequestedRegion(AllImage);
+    if (m_UseFirstTouch)
+      {
+      allocateFirstTouch<OrientationImageType>(orientation, TImage::ImageDimension - 1,
+					       this->GetMultiThreader(), m_Placement);
+      }
+    else
+      {
+      orientation->SetBufferedRegion(AllImage);
+      orientation->Allocate();
+      }
+    }
+
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+
+  // the lines of an orientation don't overlap, so the threads can
+  // fold them into the output without locking, but all the threads
+  // finish an orientation before the next one starts
+  SchedulerType scheduler;
+  BankThreadStruct str;
+  str.Filter = this;
+  str.Scheduler = &scheduler;
+  for (unsigned i = 0; i < m_Angles.size(); i++)
+    {
+    PassType pass = mkLinePass<TImage, BresType, LineType>(AllImage, this->GetLine(i), bufflength);
+    scheduler.Initialize(pass, AllImage, threads);
+    str.Pass = &pass;
+    str.Orientation = i;
+    this->GetMultiThreader()->SetSingleMethod(this->BankThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+    if (this->GetAbortGenerateData())
+      {
+      abortSweep<TImage>(this->GetInput(), output, AllImage);
+      }
+    }
+  this->UpdateProgress(1.0);
+}
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+ITK_THREAD_RETURN_TYPE
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::BankThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+  BankThreadStruct * str = (BankThreadStruct *)(info->UserData);
+  int threadId = info->ThreadID;
+  const PassType & pass = *(str->Pass);
+  AnchorPinnedThread pin(str->Filter->m_Placement, threadId);
+
+  InputImageRegionType AllImage = str->Filter->GetOutput()->GetRequestedRegion();
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+  // each thread needs its own line object and buffer
+  AnchorLineOpenType ThreadLine;
+  ThreadLine.SetSize(pass.SELength);
+  InputImagePixelType * buffer = new InputImagePixelType[bufflength];
+  // thread 0 reports its share of the orientation as its progress
+  unsigned int orientations = str->Filter->m_Angles.size();
+  AnchorSweepMonitor monitor(str->Filter, threadId,
+			     (double)AllImage.GetNumberOfPixels() / info->NumberOfThreads,
+			     (float)str->Orientation / orientations, 1.0f / orientations);
+  typename SchedulerType::Chunk chunk;
+  while (str->Scheduler->Next(threadId, chunk))
+    {
+    if (!str->Filter->foldFaceLines(pass, str->Orientation, ThreadLine, buffer,
+				    chunk.First, chunk.Count, monitor))
+      {
+      break;
+      }
+    }
+  delete [] buffer;
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+bool
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::foldFaceLines(const PassType &pass,
+		unsigned int orientation,
+		AnchorLineOpenType &AnchorLine,
+		InputImagePixelType * buffer,
+		unsigned long first,
+		unsigned long count,
+		AnchorSweepMonitor &monitor)
+{
+  InputImageConstPointer input = this->GetInput();
+  InputImagePointer output = this->GetOutput();
+  OrientationImageType * orientationImage = m_ComputeOrientation ? this->GetOrientationOutput() : 0;
+  const InputImageRegionType AllImage = output->GetRequestedRegion();
+  GreaterThan compare;
+
+  typename TImage::IndexType Ind = pass.Face.GetIndex();
+  const typename TImage::SizeType FSz = pass.Face.GetSize();
+  unsigned long pos = first;
+  for (unsigned d = 0; d < TImage::ImageDimension; d++)
+    {
+    Ind[d] += pos % FSz[d];
+    pos /= FSz[d];
+    }
+  LineType NormLine = pass.Line;
+  NormLine.Normalize();
+  // set a generous tolerance
+  float tol = 1.0/pass.LineOffsets.size();
+  for (unsigned long l = 0; l < count; l++)
+    {
+    unsigned start, end, len;
+    if (fillLineBuffer<TImage, BresType, LineType>(input, Ind, NormLine, tol, pass.LineOffsets,
+						   AllImage, buffer, start, end))
+      {
+      len = end - start + 1;
+      AnchorLine.doLine(buffer, len);
+      // the first orientation initializes the output
+      for (unsigned i = 0; i < len; i++)
+	{
+	typename TImage::IndexType Pix = Ind + pass.LineOffsets[start + i];
+	if ((orientation == 0) || compare(buffer[i], output->GetPixel(Pix)))
+	  {
+	  output->SetPixel(Pix, buffer[i]);
+	  if (orientationImage)
+	    {
+	    orientationImage->SetPixel(Pix, (OrientationPixelType)orientation);
+	    }
+	  }
+	}
+      if (!monitor.Completed(len))
+	{
+	return false;
+	}
+      }
+    // next start pixel in raster order
+    for (unsigned d = 0; d < TImage::ImageDimension; d++)
+      {
+      if (++Ind[d] < pass.Face.GetIndex()[d] + (long)FSz[d]) break;
+      Ind[d] = pass.Face.GetIndex()[d];
+      }
+    }
+  return true;
+}
+
+template <class TImage, class TOrientationImage, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseBankImageFilter<TImage, TOrientationImage, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Length: " << m_Length << std::endl;
+  os << indent << "Angles: " << m_Angles.size() << std::endl;
+  os << indent << "ComputeOrientation: " << m_ComputeOrientation << std::endl;
+  os << indent << "UseFirstTouch: " << m_UseFirstTouch << std::endl;
+  os << indent << "CPUList: " << m_Placement.GetCPUList() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
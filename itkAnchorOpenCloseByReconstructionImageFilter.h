@@ -0,0 +1,209 @@
+#ifndef __itkAnchorOpenCloseByReconstructionImageFilter_h
+#define __itkAnchorOpenCloseByReconstructionImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkAnchorSweepMonitor.h"
+#include "itkAnchorErodeDilateLine.h"
+#include "itkBresenhamLine.h"
+#include "itkAnchorUtilities.h"
+#include "itkAnchorLineScheduler.h"
+#include "itkMultiThreader.h"
+#include <deque>
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class AnchorOpenCloseByReconstructionImageFilter
+ * \brief openings and closings by reconstruction: the erosion of the
+ * image by the kernel is the marker, which is reconstructed by
+ * dilation under the image. A closing reconstructs the dilation by
+ * erosion above the image.
+ *
+ * The erosion is swept with the anchor lines straight into the
+ * output, which is then reconstructed in place with the hybrid
+ * algorithm of Vincent: a raster and an anti-raster scan, which
+ * propagate the marker through most of the image, followed by a
+ * FIFO queue of the pixels that may still propagate, seeded by the
+ * anti-raster scan. No other image is allocated.
+ *
+ * With several threads, the erosion is swept with the line
+ * scheduler, and the image is split into slabs along its slowest
+ * axis for the reconstruction. Each thread scans and propagates in
+ * its slab only, then the values that can cross the borders of the
+ * slabs are pushed into the queues of the neighbouring slabs, and
+ * the threads propagate again, until nothing crosses a border.
+ *
+ * The comparisons are named for an opening, as in
+ * AnchorOpenCloseImageFilter. Use AnchorOpeningByReconstructionImageFilter
+ * and AnchorClosingByReconstructionImageFilter rather than this class.
+**/
+template<class TImage, class TKernel, 
+	 class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+class ITK_EXPORT AnchorOpenCloseByReconstructionImageFilter :
+    public ImageToImageFilter<TImage, TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorOpenCloseByReconstructionImageFilter Self;
+  typedef ImageToImageFilter<TImage, TImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Kernel typedef. */
+  typedef TKernel KernelType;
+
+  typedef TImage InputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename TImage::IndexType         IndexType;
+  typedef typename TImage::SizeType          SizeType;
+  typedef typename TImage::OffsetType        OffsetType;
+  typedef typename OffsetType::OffsetValueType OffsetValueType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorOpenCloseByReconstructionImageFilter,
+               ImageToImageFilter);
+
+  void SetKernel( const KernelType& kernel )
+  {
+    m_Kernel=kernel;
+    m_KernelSet = true;
+    this->Modified();
+  }
+
+  /** Reconstruct through the faces, edges and corners of the pixels,
+   * rather than through the faces only. Off by default. */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstReferenceMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+  /** The number of times the threads propagated in their slabs
+   * during the last update, 1 with a single thread. */
+  itkGetConstReferenceMacro(NumberOfRounds, unsigned int);
+
+protected:
+  AnchorOpenCloseByReconstructionImageFilter();
+  ~AnchorOpenCloseByReconstructionImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** The reconstruction may reach across the whole image. */
+  void GenerateInputRequestedRegion();
+  void EnlargeOutputRequestedRegion(DataObject *output);
+
+  void GenerateData();
+
+private:
+  AnchorOpenCloseByReconstructionImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  typedef BresenhamLine<itkGetStaticConstMacro(InputImageDimension)> BresType;
+  typedef AnchorLinePass<TImage, BresType, typename KernelType::LType> PassType;
+  typedef AnchorLineScheduler<TImage, BresType, typename KernelType::LType> SchedulerType;
+  typedef AnchorErodeDilateLine<InputImagePixelType, LessThan, LessEqual> AnchorLineErodeType;
+  typedef std::deque<OffsetValueType> QueueType;
+
+  // the pass of the erosion being swept by the threads
+  struct MarkerThreadStruct
+  {
+    Pointer Filter;
+    const PassType * Pass;
+    unsigned int PassNumber;
+    unsigned int Passes;
+    SchedulerType * Scheduler;
+    InputImageConstPointer Input;
+  };
+  static ITK_THREAD_RETURN_TYPE MarkerThreaderCallback( void *arg );
+
+  // the slabs of the reconstruction, one per thread, with their
+  // queues. The first round scans the slabs before propagating.
+  struct ReconstructionThreadStruct
+  {
+    Pointer Filter;
+    std::vector<InputImageRegionType> Slabs;
+    std::vector<QueueType> Queues;
+    bool Scan;
+  };
+  static ITK_THREAD_RETURN_TYPE ReconstructionThreaderCallback( void *arg );
+
+  // erode the input into the output. Returns false if aborted.
+  bool GenerateMarker(int threads);
+
+  // the raster and anti-raster scans of slab, which queue the pixels
+  // that may still propagate
+  void scanSlab(const InputImageRegionType &slab, QueueType &queue);
+
+  // propagate the pixels of queue in slab
+  void propagateSlab(const InputImageRegionType &slab, QueueType &queue);
+
+  // push the values that can cross from one slab to the next one into
+  // the queues of the slabs they reach. Returns the number of pushes.
+  unsigned long crossSlabs(ReconstructionThreadStruct &str, unsigned int axis);
+
+  // the neighbours, their offsets in the buffer, and those before
+  // the centre in raster order
+  void mkNeighbours();
+  bool inside(const IndexType &index, const OffsetType &offset,
+	      const InputImageRegionType &region) const
+  {
+    for (unsigned d = 0; d < TImage::ImageDimension; d++)
+      {
+      long i = index[d] + offset[d];
+      if ((i < region.GetIndex()[d]) || 
+	  (i >= region.GetIndex()[d] + (long)region.GetSize()[d]))
+	{
+	return false;
+	}
+      }
+    return true;
+  }
+  // the pixel and all its neighbours are in region
+  bool interior(const IndexType &index, const InputImageRegionType &region) const
+  {
+    for (unsigned d = 0; d < TImage::ImageDimension; d++)
+      {
+      if ((index[d] <= region.GetIndex()[d]) || 
+	  (index[d] >= region.GetIndex()[d] + (long)region.GetSize()[d] - 1))
+	{
+	return false;
+	}
+      }
+    return true;
+  }
+
+  KernelType m_Kernel;
+  bool m_KernelSet;
+  bool m_FullyConnected;
+  unsigned int m_NumberOfRounds;
+
+  std::vector<OffsetType> m_Neighbours;
+  std::vector<OffsetValueType> m_NeighbourOffsets;
+  std::vector<bool> m_Before;
+  // the marker, reconstructed in place, and the mask
+  InputImagePixelType * m_Marker;
+  const InputImagePixelType * m_Mask;
+
+  LessThan m_LessThan;
+  GreaterThan m_GreaterThan;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorOpenCloseByReconstructionImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,433 @@
+#ifndef __itkAnchorOpenCloseByReconstructionImageFilter_txx
+#define __itkAnchorOpenCloseByReconstructionImageFilter_txx
+
+#include "itkAnchorOpenCloseByReconstructionImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+namespace itk {
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::AnchorOpenCloseByReconstructionImageFilter()
+{
+  m_KernelSet = false;
+  m_FullyConnected = false;
+  m_NumberOfRounds = 0;
+  m_Marker = 0;
+  m_Mask = 0;
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImagePointer inputPtr = const_cast< TImage * >( this->GetInput() );
+  if ( inputPtr )
+    {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GenerateData()
+{
+  // check that we are using a decomposable kernel
+  if (!m_Kernel.GetDecomposable())
+    {
+    itkExceptionMacro("Anchor morphology only works with decomposable structuring elements");
+    }
+  if (!m_KernelSet)
+    {
+    itkExceptionMacro("No kernel set");
+    }
+
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+  if (input->GetBufferedRegion() != output->GetBufferedRegion())
+    {
+    itkExceptionMacro("The input must be buffered over the whole image");
+    }
+
+  int threads = this->GetNumberOfThreads();
+  this->GetMultiThreader()->SetNumberOfThreads(threads);
+  threads = this->GetMultiThreader()->GetNumberOfThreads();
+  if (!this->GenerateMarker(threads))
+    {
+    abortSweep<TImage>(input, output, AllImage);
+    }
+
+  m_Marker = output->GetBufferPointer();
+  m_Mask = input->GetBufferPointer();
+  this->mkNeighbours();
+
+  // one slab per thread along the slowest axis, with at least a plane
+  const unsigned int axis = TImage::ImageDimension - 1;
+  unsigned long planes = AllImage.GetSize()[axis];
+  if ((unsigned long)threads > planes)
+    {
+    threads = planes;
+    }
+  ReconstructionThreadStruct str;
+  str.Filter = this;
+  for (int t = 0; t < threads; t++)
+    {
+    InputImageRegionType slab = AllImage;
+    unsigned long first = (planes * t) / threads;
+    unsigned long last = (planes * (t + 1)) / threads;
+    slab.SetIndex(axis, AllImage.GetIndex()[axis] + first);
+    slab.SetSize(axis, last - first);
+    str.Slabs.push_back(slab);
+    }
+  str.Queues.resize(threads);
+  str.Scan = true;
+
+  this->GetMultiThreader()->SetNumberOfThreads(threads);
+  m_NumberOfRounds = 0;
+  for (;;)
+    {
+    this->GetMultiThreader()->SetSingleMethod(this->ReconstructionThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+    ++m_NumberOfRounds;
+    str.Scan = false;
+    if (this->GetAbortGenerateData())
+      {
+      abortSweep<TImage>(input, output, AllImage);
+      }
+    if (this->crossSlabs(str, axis) == 0)
+      {
+      break;
+      }
+    }
+  this->UpdateProgress(1.0);
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+bool
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GenerateMarker(int threads)
+{
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+
+  std::vector<PassType> passes;
+  const typename KernelType::DecompType & decomposition = m_Kernel.GetLines();
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    passes.push_back(mkLinePass<TImage, BresType, typename KernelType::LType>(AllImage, decomposition[i], bufflength, m_Kernel.GetPeriod(i)));
+    }
+  if (passes.empty())
+    {
+    // a kernel of a single pixel, whose opening is the image
+    ImageRegionConstIterator<TImage> inIt(input, AllImage);
+    ImageRegionIterator<TImage> outIt(output, AllImage);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    return true;
+    }
+
+  // the lines of a pass are swept in place after the first pass, so
+  // all threads finish a pass before the next one starts
+  SchedulerType scheduler;
+  MarkerThreadStruct str;
+  str.Filter = this;
+  str.Scheduler = &scheduler;
+  for (unsigned i = 0; i < passes.size(); i++)
+    {
+    scheduler.Initialize(passes[i], AllImage, threads);
+    str.Pass = &(passes[i]);
+    str.PassNumber = i;
+    str.Passes = passes.size();
+    str.Input = input;
+    this->GetMultiThreader()->SetSingleMethod(this->MarkerThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+    if (this->GetAbortGenerateData())
+      {
+      return false;
+      }
+    input = output.GetPointer();
+    }
+  return true;
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+ITK_THREAD_RETURN_TYPE
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::MarkerThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+  MarkerThreadStruct * str = (MarkerThreadStruct *)(info->UserData);
+  int threadId = info->ThreadID;
+  const PassType & pass = *(str->Pass);
+
+  InputImagePointer output = str->Filter->GetOutput();
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+  // each thread needs its own line object and buffers
+  AnchorLineErodeType ThreadLine;
+  ThreadLine.SetSize(pass.SELength);
+  ThreadLine.SetPeriod(pass.Period);
+  InputImagePixelType * buffer = new InputImagePixelType[bufflength];
+  InputImagePixelType * inbuffer = new InputImagePixelType[bufflength];
+  // the erosion is the first half of the progress
+  AnchorSweepMonitor monitor(str->Filter, threadId,
+			     (double)AllImage.GetNumberOfPixels() / info->NumberOfThreads,
+			     0.5f * str->PassNumber / str->Passes, 0.5f / str->Passes);
+  typename SchedulerType::Chunk chunk;
+  while (str->Scheduler->Next(threadId, chunk))
+    {
+    if (!doFaceLines<TImage, BresType, AnchorLineErodeType, typename KernelType::LType>(str->Input, output, pass.Line, ThreadLine,
+											pass.LineOffsets, inbuffer, buffer, AllImage,
+											pass.Face, chunk.First, chunk.Count,
+											&monitor))
+      {
+      break;
+      }
+    }
+  delete [] buffer;
+  delete [] inbuffer;
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::mkNeighbours()
+{
+  m_Neighbours.clear();
+  m_NeighbourOffsets.clear();
+  m_Before.clear();
+  const typename TImage::OffsetValueType * table = this->GetOutput()->GetOffsetTable();
+  // all the offsets in {-1, 0, 1}^dim but the centre
+  unsigned long count = 1;
+  for (unsigned d = 0; d < TImage::ImageDimension; d++)
+    {
+    count *= 3;
+    }
+  for (unsigned long n = 0; n < count; n++)
+    {
+    OffsetType offset;
+    unsigned long rest = n;
+    unsigned int nonzero = 0;
+    OffsetValueType linear = 0;
+    for (unsigned d = 0; d < TImage::ImageDimension; d++)
+      {
+      offset[d] = (long)(rest % 3) - 1;
+      rest /= 3;
+      if (offset[d] != 0) ++nonzero;
+      linear += offset[d] * table[d];
+      }
+    if ((nonzero == 0) || (!m_FullyConnected && (nonzero > 1)))
+      {
+      continue;
+      }
+    m_Neighbours.push_back(offset);
+    m_NeighbourOffsets.push_back(linear);
+    m_Before.push_back(linear < 0);
+    }
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+ITK_THREAD_RETURN_TYPE
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::ReconstructionThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+  ReconstructionThreadStruct * str = (ReconstructionThreadStruct *)(info->UserData);
+  int threadId = info->ThreadID;
+  if (str->Scan)
+    {
+    str->Filter->scanSlab(str->Slabs[threadId], str->Queues[threadId]);
+    }
+  str->Filter->propagateSlab(str->Slabs[threadId], str->Queues[threadId]);
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::scanSlab(const InputImageRegionType &slab, QueueType &queue)
+{
+  InputImagePointer output = this->GetOutput();
+  const unsigned int neighbours = m_Neighbours.size();
+  if (slab.GetNumberOfPixels() == 0)
+    {
+    return;
+    }
+
+  // raster scan: the largest of the pixel and of the neighbours
+  // before it, under the mask
+  ImageRegionIteratorWithIndex<TImage> it(output, slab);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    const IndexType & index = it.GetIndex();
+    OffsetValueType p = output->ComputeOffset(index);
+    bool all = this->interior(index, slab);
+    InputImagePixelType v = m_Marker[p];
+    for (unsigned n = 0; n < neighbours; n++)
+      {
+      if (m_Before[n] && (all || this->inside(index, m_Neighbours[n], slab)))
+	{
+	InputImagePixelType q = m_Marker[p + m_NeighbourOffsets[n]];
+	if (m_GreaterThan(q, v)) v = q;
+	}
+      }
+    m_Marker[p] = m_LessThan(m_Mask[p], v) ? m_Mask[p] : v;
+    }
+
+  // anti-raster scan with the neighbours after the pixel, queueing
+  // the pixels that can still raise one of them
+  it.GoToReverseBegin();
+  while (!it.IsAtReverseEnd())
+    {
+    const IndexType & index = it.GetIndex();
+    OffsetValueType p = output->ComputeOffset(index);
+    bool all = this->interior(index, slab);
+    InputImagePixelType v = m_Marker[p];
+    for (unsigned n = 0; n < neighbours; n++)
+      {
+      if (!m_Before[n] && (all || this->inside(index, m_Neighbours[n], slab)))
+	{
+	InputImagePixelType q = m_Marker[p + m_NeighbourOffsets[n]];
+	if (m_GreaterThan(q, v)) v = q;
+	}
+      }
+    if (m_LessThan(m_Mask[p], v)) v = m_Mask[p];
+    m_Marker[p] = v;
+    for (unsigned n = 0; n < neighbours; n++)
+      {
+      if (!m_Before[n] && (all || this->inside(index, m_Neighbours[n], slab)))
+	{
+	OffsetValueType q = p + m_NeighbourOffsets[n];
+	if (m_LessThan(m_Marker[q], v) && m_LessThan(m_Marker[q], m_Mask[q]))
+	  {
+	  queue.push_back(p);
+	  break;
+	  }
+	}
+      }
+    --it;
+    }
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::propagateSlab(const InputImageRegionType &slab, QueueType &queue)
+{
+  InputImagePointer output = this->GetOutput();
+  const unsigned int neighbours = m_Neighbours.size();
+  while (!queue.empty())
+    {
+    OffsetValueType p = queue.front();
+    queue.pop_front();
+    IndexType index = output->ComputeIndex(p);
+    bool all = this->interior(index, slab);
+    InputImagePixelType v = m_Marker[p];
+    for (unsigned n = 0; n < neighbours; n++)
+      {
+      if (all || this->inside(index, m_Neighbours[n], slab))
+	{
+	OffsetValueType q = p + m_NeighbourOffsets[n];
+	if (m_LessThan(m_Marker[q], v) && (m_Marker[q] != m_Mask[q]))
+	  {
+	  m_Marker[q] = m_LessThan(m_Mask[q], v) ? m_Mask[q] : v;
+	  queue.push_back(q);
+	  }
+	}
+      }
+    }
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+unsigned long
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::crossSlabs(ReconstructionThreadStruct &str, unsigned int axis)
+{
+  InputImagePointer output = this->GetOutput();
+  InputImageRegionType AllImage = output->GetRequestedRegion();
+  const unsigned int neighbours = m_Neighbours.size();
+  unsigned long pushes = 0;
+  for (unsigned s = 0; s + 1 < str.Slabs.size(); s++)
+    {
+    // the last plane of slab s and the first one of slab s + 1 reach
+    // across the border between them
+    for (unsigned side = 0; side < 2; side++)
+      {
+      const InputImageRegionType & from = str.Slabs[s + side];
+      const InputImageRegionType & to = str.Slabs[s + 1 - side];
+      QueueType & queue = str.Queues[s + 1 - side];
+      InputImageRegionType plane = from;
+      if (side == 0)
+	{
+	plane.SetIndex(axis, from.GetIndex()[axis] + from.GetSize()[axis] - 1);
+	}
+      plane.SetSize(axis, 1);
+      ImageRegionIteratorWithIndex<TImage> it(output, plane);
+      for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+	{
+	const IndexType & index = it.GetIndex();
+	OffsetValueType p = output->ComputeOffset(index);
+	InputImagePixelType v = m_Marker[p];
+	for (unsigned n = 0; n < neighbours; n++)
+	  {
+	  if (this->inside(index, m_Neighbours[n], to))
+	    {
+	    OffsetValueType q = p + m_NeighbourOffsets[n];
+	    if (m_LessThan(m_Marker[q], v) && (m_Marker[q] != m_Mask[q]))
+	      {
+	      m_Marker[q] = m_LessThan(m_Mask[q], v) ? m_Mask[q] : v;
+	      queue.push_back(q);
+	      ++pushes;
+	      }
+	    }
+	  }
+	}
+      }
+    }
+  return pushes;
+}
+
+template<class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "KernelSet: " << m_KernelSet << std::endl;
+  os << indent << "FullyConnected: " << m_FullyConnected << std::endl;
+  os << indent << "NumberOfRounds: " << m_NumberOfRounds << std::endl;
+}
+
+} // end namespace itk
+
+#endif
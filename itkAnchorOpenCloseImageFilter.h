@@ -3,9 +3,14 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkProgressReporter.h"
+#include "itkAnchorSweepMonitor.h"
 #include "itkAnchorOpenCloseLine.h"
 #include "itkAnchorErodeDilateLine.h"
 #include "itkBresenhamLine.h"
+#include "itkFlatStructuringElement.h"
+#include "itkAnchorErodeDilateImageFilter.h"
+#include "itkAnchorSmallKernel.h"
+#include "itkAnchorChordTable.h"
 
 namespace itk {
 
@@ -30,6 +35,10 @@ namespace itk {
  * in more complex template parameters because the appropriate
  * comparison operations need to be passed in. The less
  *
+ * Kernels that aren't decomposable, such as Ball, are computed
+ * exactly as an erosion followed by a dilation by their chords, see
+ * doChordPass, except in batch mode.
+ *
 **/
 template<class TImage, class TKernel, 
 	 class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
@@ -73,8 +82,42 @@ public:
   {
     m_Kernel=kernel;
     m_KernelSet = true;
+    m_SliceMode = false;
   }
 
+  /** Kernel of one dimension less than the image, for batch mode */
+  typedef FlatStructuringElement<itkGetStaticConstMacro(InputImageDimension) - 1> SliceKernelType;
+
+  /** Batch mode: apply a kernel of one dimension less than the image
+   * to every slice perpendicular to axis. The lines are swept
+   * directly in the image. Replaces the kernel given to SetKernel. */
+  void SetSliceKernel( const SliceKernelType& kernel, unsigned int axis );
+
+  /** Approximate the erosion and the dilation on a shrunk image, see
+   * AnchorErodeDilateImageFilter. The opening or closing is then done
+   * as an erosion followed by a dilation, each within MaximumError
+   * pixels of the kernel. The exact result is computed when no
+   * factor within MaximumError shrinks the lines. Not used in batch
+   * mode. Default is 0, for the exact result. */
+  itkSetMacro(MaximumError, unsigned int);
+  itkGetConstReferenceMacro(MaximumError, unsigned int);
+
+  /** The bound on the error of the last update, in pixels, and the
+   * factor by which the image was shrunk: 0 and 1 if the result is
+   * exact. */
+  itkGetConstReferenceMacro(ApproximationError, unsigned int);
+  itkGetConstReferenceMacro(ShrinkFactor, unsigned int);
+
+  /** Compute the small boxes, of radius up to 3, as erosions and
+   * dilations on whole rows, see AnchorErodeDilateImageFilter. Only
+   * the kernels whose lines are along the axes and shorter than the
+   * image qualify, as the opening by such a line is then the erosion
+   * followed by the dilation. Not used in batch mode. On by
+   * default. */
+  itkSetMacro(UseSmallKernels, bool);
+  itkGetConstReferenceMacro(UseSmallKernels, bool);
+  itkBooleanMacro(UseSmallKernels);
+
 protected:
   AnchorOpenCloseImageFilter();
   ~AnchorOpenCloseImageFilter() {};
@@ -84,6 +127,18 @@ protected:
    * to GrayscaleGeodesicErodeImageFilter. */
   void GenerateData();
 
+  /** The erosion and the dilation, approximated when MaximumError
+   * allows it */
+  void GenerateApproximateData();
+
+  /** The erosion and the dilation of a small kernel on whole
+   * rows. Returns false, without computing anything, if the kernel
+   * doesn't qualify. */
+  bool GenerateSmallKernelData();
+
+  /** The erosion and the dilation of a kernel that isn't
+   * decomposable, by its chords */
+  void GenerateChordData();
 
 private:
   AnchorOpenCloseImageFilter(const Self&); //purposely not implemented
@@ -91,8 +146,28 @@ private:
 
   TKernel m_Kernel;
   bool m_KernelSet;
+  bool m_SliceMode;
+  typename KernelType::DecompType m_SliceLines;
+  std::vector<unsigned int> m_SlicePeriods;
+  bool m_SliceDecomposable;
+  unsigned int m_SliceAxis;
+  unsigned int m_MaximumError;
+  unsigned int m_ApproximationError;
+  unsigned int m_ShrinkFactor;
+  bool m_UseSmallKernels;
   typedef BresenhamLine<TImage::ImageDimension> BresType;
 
+  // the period of line i of the kernel, or of the slice kernel in
+  // batch mode
+  unsigned int GetPeriod(unsigned int i) const
+  {
+    if (m_SliceMode)
+      {
+      return (i < m_SlicePeriods.size()) ? m_SlicePeriods[i] : 1;
+      }
+    return m_Kernel.GetPeriod(i);
+  }
+
   // the class that operates on lines -- does the opening in one
   // operation. The classes following are named on the assumption that
   // we are doing an opening
@@ -110,13 +185,15 @@ private:
   AnchorLineErodeType AnchorLineErode;
   AnchorLineDilateType AnchorLineDilate;
 
-  void doFaceOpen(InputImageConstPointer input,
+  // returns false if the filter was asked to abort
+  bool doFaceOpen(InputImageConstPointer input,
 		  InputImagePointer output,
 		  typename KernelType::LType line,
-		  const typename BresType::OffsetArray LineOffsets,
+		  const typename BresType::OffsetArray &LineOffsets,
 		  InputImagePixelType * outbuffer,	      
 		  const InputImageRegionType AllImage, 
-		  const InputImageRegionType face);
+		  const InputImageRegionType face,
+		  AnchorSweepMonitor &monitor);
 
 
 } ; // end of class
@@ -125,7 +202,7 @@ private:
 } // end namespace itk
 
 
-#ifndef ITK_MANUAL_INSTANTIATION
+#if !defined(ITK_MANUAL_INSTANTIATION) && !defined(ANCHOR_MANUAL_INSTANTIATION)
 #include "itkAnchorOpenCloseImageFilter.txx"
 #endif
 
@@ -4,6 +4,7 @@
 #include "itkAnchorOpenCloseImageFilter.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
 #include "itkAnchorUtilities.h"
 
 namespace itk {
@@ -13,6 +14,57 @@ AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, Gr
 ::AnchorOpenCloseImageFilter()
 {
   m_KernelSet = false;
+  m_SliceMode = false;
+  m_SliceDecomposable = false;
+  m_SliceAxis = 0;
+  m_MaximumError = 0;
+  m_ApproximationError = 0;
+  m_ShrinkFactor = 1;
+  m_UseSmallKernels = true;
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::SetSliceKernel( const SliceKernelType& kernel, unsigned int axis )
+{
+  if (axis >= TImage::ImageDimension)
+    {
+    itkExceptionMacro("Slicing axis " << axis << " is not a dimension of the image");
+    }
+  mkSliceLines(kernel.GetLines(), axis, m_SliceLines);
+  m_SlicePeriods = kernel.GetPeriods();
+  m_SliceDecomposable = kernel.GetDecomposable();
+  m_SliceAxis = axis;
+  m_SliceMode = true;
+  m_KernelSet = true;
+  this->Modified();
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GenerateApproximateData()
+{
+  // named for an opening, as the line classes
+  typedef AnchorErodeDilateImageFilter<TImage, TKernel, LessThan, LessEqual> ErodeType;
+  typedef AnchorErodeDilateImageFilter<TImage, TKernel, GreaterThan, GreaterEqual> DilateType;
+  typename ErodeType::Pointer erode = ErodeType::New();
+  typename DilateType::Pointer dilate = DilateType::New();
+  erode->SetInput(this->GetInput());
+  erode->SetKernel(m_Kernel);
+  erode->SetMaximumError(m_MaximumError);
+  erode->SetNumberOfThreads(this->GetNumberOfThreads());
+  dilate->SetInput(erode->GetOutput());
+  dilate->SetKernel(m_Kernel);
+  dilate->SetMaximumError(m_MaximumError);
+  dilate->SetNumberOfThreads(this->GetNumberOfThreads());
+  dilate->GraftOutput(this->GetOutput());
+  dilate->Update();
+  this->GraftOutput(dilate->GetOutput());
+  m_ApproximationError = std::max(erode->GetApproximationError(), dilate->GetApproximationError());
+  m_ShrinkFactor = std::max(erode->GetShrinkFactor(), dilate->GetShrinkFactor());
+  this->UpdateProgress(1.0);
 }
 
 template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
@@ -22,7 +74,7 @@ AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, Gr
 {
 
   // check that we are using a decomposable kernel
-  if (!m_Kernel.GetDecomposable())
+  if (m_SliceMode && !m_SliceDecomposable)
     {
     itkExceptionMacro("Anchor morphology only works with decomposable structuring elements");
     }
@@ -30,8 +82,26 @@ AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, Gr
     {
     itkExceptionMacro("No kernel set");
     }
+  m_ApproximationError = 0;
+  m_ShrinkFactor = 1;
+  if (!m_SliceMode && !m_Kernel.GetDecomposable())
+    {
+    this->GenerateChordData();
+    return;
+    }
+  // without shrinking, the approximation would only lose the opening
+  // along the last line at the edges of the image
+  if ((m_MaximumError > 0) && !m_SliceMode &&
+      (getShrinkFactor<typename KernelType::LType>(m_Kernel.GetLines(), m_Kernel.GetPeriods(), m_MaximumError) > 1))
+    {
+    this->GenerateApproximateData();
+    return;
+    }
+  if (m_UseSmallKernels && !m_SliceMode && this->GenerateSmallKernelData())
+    {
+    return;
+    }
 
-  
   // Allocate the output
   this->AllocateOutputs();
   InputImagePointer output = this->GetOutput();
@@ -39,11 +109,15 @@ AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, Gr
   
   // get the region size
   InputImageRegionType OReg = output->GetRequestedRegion();
-  // maximum buffer length is sum of dimensions
+  // maximum buffer length is sum of dimensions, except the slicing
+  // axis in batch mode, so that the lines are those of a slice
   unsigned int bufflength = 0;
   for (unsigned i = 0; i<TImage::ImageDimension; i++)
     {
-    bufflength += OReg.GetSize()[i];
+    if (!m_SliceMode || (i != m_SliceAxis))
+      {
+      bufflength += OReg.GetSize()[i];
+      }
     }
 
   //unsigned linecount = OReg.GetNumberOfPixels()/bufflength;
@@ -52,75 +126,101 @@ AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, Gr
   InputImagePixelType * outbuffer = new InputImagePixelType[bufflength];
 
   // iterate over all the structuring elements
-  typename KernelType::DecompType decomposition = m_Kernel.GetLines();
-  BresType BresLine;
-  ProgressReporter progress(this, 0, decomposition.size()*2);
+  typename KernelType::DecompType decomposition = m_SliceMode ? m_SliceLines : m_Kernel.GetLines();
+  if (decomposition.empty())
+    {
+    // a kernel of a single pixel
+    ImageRegionConstIterator<TImage> inIt(input, OReg);
+    ImageRegionIterator<TImage> outIt(output, OReg);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    delete [] inbuffer;
+    delete [] outbuffer;
+    return;
+    }
+  // each erosion and dilation covers the region once, and the
+  // opening in the middle counts twice
+  AnchorSweepMonitor monitor(this, 0, 2.0 * decomposition.size() * OReg.GetNumberOfPixels());
 
   // first stage -- all of the erosions if we are doing an opening
   for (unsigned i = 0; i < decomposition.size() - 1; i++)
     {
     typename KernelType::LType ThisLine = decomposition[i];
-    typename BresType::OffsetArray TheseOffsets = BresLine.buildLine(ThisLine, bufflength);
+    typename BresType::OffsetArray TheseOffsets = mkLineOffsets<BresType, typename KernelType::LType>(ThisLine, this->GetPeriod(i), bufflength);
     unsigned int SELength = getLinePixels<typename KernelType::LType>(ThisLine);
     // want lines to be odd
     if (!(SELength%2))
       ++SELength;
     AnchorLineErode.SetSize(SELength);
+    AnchorLineErode.SetPeriod(this->GetPeriod(i));
 
     InputImageRegionType BigFace = mkEnlargedFace<InputImageType, typename KernelType::LType>(input, OReg, ThisLine);
-    doFace<TImage, BresType, 
-      AnchorLineErodeType, 
-      typename KernelType::LType>(input, output, ThisLine, AnchorLineErode, 
-				  TheseOffsets, inbuffer, outbuffer, OReg, BigFace);
-    
+    if (!doFace<TImage, BresType, 
+	AnchorLineErodeType, 
+	typename KernelType::LType>(input, output, ThisLine, AnchorLineErode, 
+				    TheseOffsets, inbuffer, outbuffer, OReg, BigFace,
+				    &monitor))
+      {
+      delete [] inbuffer;
+      delete [] outbuffer;
+      abortSweep<TImage>(this->GetInput(), output, OReg);
+      }
 
     // after the first pass the input will be taken from the output
     input = this->GetOutput();
-    progress.CompletedPixel();
     }
   // now do the opening in the middle of the chain
   {
   unsigned i = decomposition.size() - 1;
   typename KernelType::LType ThisLine = decomposition[i];
-  typename BresType::OffsetArray TheseOffsets = BresLine.buildLine(ThisLine, bufflength);
+  typename BresType::OffsetArray TheseOffsets = mkLineOffsets<BresType, typename KernelType::LType>(ThisLine, this->GetPeriod(i), bufflength);
   unsigned int SELength = getLinePixels<typename KernelType::LType>(ThisLine);
   // want lines to be odd
   if (!(SELength%2))
     ++SELength;
 
   AnchorLineOpen.SetSize(SELength);
+  AnchorLineOpen.SetPeriod(this->GetPeriod(i));
   InputImageRegionType BigFace = mkEnlargedFace<InputImageType, typename KernelType::LType>(input, OReg, ThisLine);
 
   // Now figure out which faces of the image we should be starting
   // from with this line
-  doFaceOpen(input, output, ThisLine,
-	     TheseOffsets, outbuffer, 
-	     OReg, BigFace);
-  // equivalent to two passes
-  progress.CompletedPixel();
-  progress.CompletedPixel();  
+  if (!doFaceOpen(input, output, ThisLine,
+		  TheseOffsets, outbuffer, 
+		  OReg, BigFace, monitor))
+    {
+    delete [] inbuffer;
+    delete [] outbuffer;
+    abortSweep<TImage>(this->GetInput(), output, OReg);
+    }
   }
 
   // Now for the rest of the dilations -- note that i needs to be signed
   for (int i = decomposition.size() - 2; i >= 0; --i)
     {
     typename KernelType::LType ThisLine = decomposition[i];
-    typename BresType::OffsetArray TheseOffsets = BresLine.buildLine(ThisLine, bufflength);
+    typename BresType::OffsetArray TheseOffsets = mkLineOffsets<BresType, typename KernelType::LType>(ThisLine, this->GetPeriod(i), bufflength);
     unsigned int SELength = getLinePixels<typename KernelType::LType>(ThisLine);
     // want lines to be odd
     if (!(SELength%2))
       ++SELength;
   
     AnchorLineDilate.SetSize(SELength);
+    AnchorLineDilate.SetPeriod(this->GetPeriod(i));
 
     InputImageRegionType BigFace = mkEnlargedFace<InputImageType, typename KernelType::LType>(input, OReg, ThisLine);
-    doFace<TImage, BresType, 
-      AnchorLineDilateType, 
-      typename KernelType::LType>(input, output, ThisLine, AnchorLineDilate, 
-				  TheseOffsets, inbuffer, outbuffer, OReg, BigFace);
-
-    
-    progress.CompletedPixel();
+    if (!doFace<TImage, BresType, 
+	AnchorLineDilateType, 
+	typename KernelType::LType>(input, output, ThisLine, AnchorLineDilate, 
+				    TheseOffsets, inbuffer, outbuffer, OReg, BigFace,
+				    &monitor))
+      {
+      delete [] inbuffer;
+      delete [] outbuffer;
+      abortSweep<TImage>(this->GetInput(), output, OReg);
+      }
     }
 
   delete [] inbuffer;
@@ -128,15 +228,16 @@ AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, Gr
 }
 
 template<class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
-void
+bool
 AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
 ::doFaceOpen(InputImageConstPointer input,
 	     InputImagePointer output,
 	     typename KernelType::LType line,
-	     typename BresType::OffsetArray LineOffsets,
+	     const typename BresType::OffsetArray &LineOffsets,
 	     InputImagePixelType * outbuffer,	      
 	     const InputImageRegionType AllImage, 
-	     const InputImageRegionType face)
+	     const InputImageRegionType face,
+	     AnchorSweepMonitor &monitor)
 {
   // iterate over the face
   typedef ImageRegionConstIteratorWithIndex<InputImageType> ItType;
@@ -158,9 +259,128 @@ AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, Gr
       len = end - start + 1;
       AnchorLineOpen.doLine(outbuffer,len);
       copyLineToImage<TImage, BresType>(output, Ind, LineOffsets, outbuffer, start, end);
+      if (!monitor.Completed(2 * len))
+	{
+	return false;
+	}
       }
     ++it;
     }
+  return true;
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+void
+AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GenerateChordData()
+{
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+  InputImageRegionType OReg = output->GetRequestedRegion();
+
+  // the first pass covers the reach of the second one, in the part
+  // of the image that is available
+  InputImageRegionType SReg = OReg;
+  SReg.PadByRadius(m_Kernel.GetRadius());
+  SReg.Crop(input->GetBufferedRegion());
+  InputImagePointer scratch = TImage::New();
+  scratch->SetRegions(SReg);
+  scratch->Allocate();
+
+  // the kernel of the dilation is mirrored, as in the neighbourhood
+  // filters, so that the result is an opening or a closing whatever
+  // the shape of the kernel
+  LessThan first;
+  GreaterThan second;
+  const InputImagePixelType high = NumericTraits<InputImagePixelType>::max();
+  const InputImagePixelType low = NumericTraits<InputImagePixelType>::NonpositiveMin();
+  AnchorChordPlan<TImage::ImageDimension> firstPlan = mkChordPlan(m_Kernel, first(high, low));
+  AnchorChordPlan<TImage::ImageDimension> secondPlan = mkChordPlan(m_Kernel, second(high, low));
+
+  AnchorSweepMonitor monitor(this, 0, (double)SReg.GetNumberOfPixels() + OReg.GetNumberOfPixels());
+  if (!doChordPass<TImage, LessThan>(input, scratch, firstPlan, SReg, &monitor) ||
+      !doChordPass<TImage, GreaterThan>(scratch, output, secondPlan, OReg, &monitor))
+    {
+    abortSweep<TImage>(this->GetInput(), output, OReg);
+    }
+}
+
+template <class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
+bool
+AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, GreaterEqual>
+::GenerateSmallKernelData()
+{
+  const typename KernelType::DecompType & decomposition = m_Kernel.GetLines();
+  if (!isSmallKernel(decomposition, m_Kernel.GetPeriods()) || !isAxisKernel(decomposition))
+    {
+    return false;
+    }
+  // a line that covers the whole image is opened to the extremum of
+  // the line, which the erosion and the dilation don't give
+  InputImageRegionType OReg = this->GetOutput()->GetRequestedRegion();
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    typename TImage::OffsetType step;
+    unsigned int radius;
+    getSmallLineStep(decomposition[i], this->GetPeriod(i), 3, step, radius);
+    for (unsigned d = 0; d < TImage::ImageDimension; d++)
+      {
+      if (step[d] && (OReg.GetSize()[d] <= 2 * radius + 1))
+	{
+	return false;
+	}
+      }
+    }
+
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+
+  // the same chain as the anchor lines, Ex Ey Oz Dy Dx, with the
+  // opening in the middle done as an erosion and a dilation whose
+  // ends are then corrected. The passes alternate between the output
+  // and a scratch image, finishing in the output.
+  unsigned int lines = decomposition.size();
+  unsigned int passes = 2 * lines;
+  InputImagePointer scratch = TImage::New();
+  scratch->SetRegions(OReg);
+  scratch->Allocate();
+  std::vector<InputImagePixelType> ends;
+  AnchorSweepMonitor monitor(this, 0, (double)passes * OReg.GetNumberOfPixels());
+  for (unsigned p = 0; p < passes; p++)
+    {
+    unsigned i = (p < lines) ? p : passes - 1 - p;
+    typename TImage::OffsetType step;
+    unsigned int radius;
+    getSmallLineStep(decomposition[i], this->GetPeriod(i), 3, step, radius);
+    unsigned int axis = 0;
+    while (!step[axis]) ++axis;
+    InputImagePointer dest = ((passes - 1 - p) % 2) ? scratch : output;
+    bool done = true;
+    if (p < lines)
+      {
+      if (p == lines - 1)
+	{
+	getSmallLineEnds<TImage, LessThan>(input, axis, radius, OReg, ends);
+	}
+      done = doSmallLinePass<TImage, LessThan>(input, dest, step, radius, OReg, &monitor);
+      }
+    else
+      {
+      done = doSmallLinePass<TImage, GreaterThan>(input, dest, step, radius, OReg, &monitor);
+      if (done && (p == lines))
+	{
+	foldSmallLineEnds<TImage, GreaterThan>(dest, axis, radius, OReg, ends);
+	}
+      }
+    if (!done)
+      {
+      abortSweep<TImage>(this->GetInput(), output, OReg);
+      }
+    input = dest.GetPointer();
+    }
+  return true;
 }
 
 template<class TImage, class TKernel, class LessThan, class GreaterThan, class LessEqual, class GreaterEqual>
@@ -169,6 +389,8 @@ AnchorOpenCloseImageFilter<TImage, TKernel, LessThan, GreaterThan, LessEqual, Gr
 ::PrintSelf(std::ostream &os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumError: " << m_MaximumError << std::endl;
+  os << indent << "UseSmallKernels: " << m_UseSmallKernels << std::endl;
 }
 
 
@@ -24,7 +24,7 @@ public:
   /** Some convenient typedefs. */
   typedef TInputPix InputImagePixelType;
   AnchorOpenCloseLine();
-  ~AnchorOpenCloseLine() {delete m_Histo;};
+  ~AnchorOpenCloseLine() {delete m_Histo; delete [] m_SubBuffer;};
   void PrintSelf(std::ostream& os, Indent indent) const;
 
   /** Single-threaded version of GenerateData.  This filter delegates
@@ -36,8 +36,17 @@ public:
     m_Size = size;
   }
 
+  // A periodic line has a pixel every period pixels of the line. It
+  // is processed as period interleaved lines of (size - 1) / period
+  // + 1 pixels.
+  void SetPeriod(unsigned int period)
+  {
+    m_Period = period;
+  }
+
 private:
   unsigned int m_Size;
+  unsigned int m_Period;
   TFunction1 m_TF1;
   TFunction2 m_TF2;
 
@@ -45,6 +54,12 @@ private:
   typedef MorphologyHistogramVec<InputImagePixelType,THistogramCompare> VHistogram;
   typedef MorphologyHistogramMap<InputImagePixelType,THistogramCompare> MHistogram;
 
+  void doContiguousLine(InputImagePixelType * buffer, unsigned bufflength);
+
+  // the interleaved lines of a periodic line, of m_SubLength pixels
+  InputImagePixelType * m_SubBuffer;
+  unsigned int m_SubLength;
+
   bool startLine(InputImagePixelType * buffer,
 		 InputImagePixelType &Extreme,
 		 Histogram &histo,
@@ -75,7 +90,7 @@ private:
 } // end namespace itk
 
 
-#ifndef ITK_MANUAL_INSTANTIATION
+#if !defined(ITK_MANUAL_INSTANTIATION) && !defined(ANCHOR_MANUAL_INSTANTIATION)
 #include "itkAnchorOpenCloseLine.txx"
 #endif
 
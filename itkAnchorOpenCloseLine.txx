@@ -10,6 +10,9 @@ AnchorOpenCloseLine<TInputPix, THistogramCompare, TFunction1, TFunction2>
 ::AnchorOpenCloseLine()
 {
   m_Size=2;
+  m_Period=1;
+  m_SubBuffer=0;
+  m_SubLength=0;
   if (useVectorBasedHistogram())
     {
     m_Histo = new VHistogram;
@@ -24,6 +27,41 @@ template <class TInputPix, class THistogramCompare, class TFunction1, class TFun
 void
 AnchorOpenCloseLine<TInputPix, THistogramCompare, TFunction1, TFunction2>
 ::doLine(InputImagePixelType * buffer, unsigned bufflength)
+{
+  if (m_Period < 2)
+    {
+    doContiguousLine(buffer, bufflength);
+    return;
+    }
+  // each residue of a periodic line is an independent line
+  unsigned int size = m_Size;
+  m_Size = (size - 1) / m_Period + 1;
+  if (m_SubLength < bufflength / m_Period + 1)
+    {
+    delete [] m_SubBuffer;
+    m_SubLength = bufflength / m_Period + 1;
+    m_SubBuffer = new InputImagePixelType[m_SubLength];
+    }
+  for (unsigned r = 0; r < m_Period && r < bufflength; r++)
+    {
+    unsigned sublength = 0;
+    for (unsigned i = r; i < bufflength; i += m_Period)
+      {
+      m_SubBuffer[sublength++] = buffer[i];
+      }
+    doContiguousLine(m_SubBuffer, sublength);
+    for (unsigned i = r, j = 0; i < bufflength; i += m_Period, j++)
+      {
+      buffer[i] = m_SubBuffer[j];
+      }
+    }
+  m_Size = size;
+}
+
+template <class TInputPix, class THistogramCompare, class TFunction1, class TFunction2>
+void
+AnchorOpenCloseLine<TInputPix, THistogramCompare, TFunction1, TFunction2>
+::doContiguousLine(InputImagePixelType * buffer, unsigned bufflength)
 {
   // TFunction1 will be >= for openings
   // TFunction2 will be <=
@@ -35,6 +73,11 @@ AnchorOpenCloseLine<TInputPix, THistogramCompare, TFunction1, TFunction2>
   // closing, and then copy the result to the output. Hopefully this
   // will improve cache performance when working along non raster
   // directions.
+  if (m_Size < 2)
+    {
+    // a single pixel doesn't change anything
+    return;
+    }
   if (bufflength <= m_Size)
     {
     // No point doing anything fancy - just look for the extreme value
@@ -217,6 +260,7 @@ AnchorOpenCloseLine<TInputPix,  THistogramCompare, TFunction1, TFunction2>
 	}
       }
     }
+  return(false);
 }
 
 template<class TInputPix, class THistogramCompare, class TFunction1, class TFunction2>
@@ -225,6 +269,7 @@ AnchorOpenCloseLine<TInputPix, THistogramCompare, TFunction1, TFunction2>
 ::PrintSelf(std::ostream &os, Indent indent) const
 {
   os << indent << "Size: " << m_Size << std::endl;
+  os << indent << "Period: " << m_Period << std::endl;
 }
 
 
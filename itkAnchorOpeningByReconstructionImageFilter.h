@@ -0,0 +1,41 @@
+#ifndef __itkAnchorOpeningByReconstructionImageFilter_h
+#define __itkAnchorOpeningByReconstructionImageFilter_h
+
+#include "itkAnchorOpenCloseByReconstructionImageFilter.h"
+
+namespace itk {
+
+template<class TImage, class TKernel>
+class  ITK_EXPORT AnchorOpeningByReconstructionImageFilter :
+    public AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, std::less<typename TImage::PixelType>, std::greater<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType> >
+
+{
+public:
+  typedef AnchorOpeningByReconstructionImageFilter Self;
+  typedef AnchorOpenCloseByReconstructionImageFilter<TImage, TKernel, std::less<typename TImage::PixelType>, std::greater<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType> > Superclass;
+
+  typedef SmartPointer<Self>   Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  virtual ~AnchorOpeningByReconstructionImageFilter() {}
+protected:
+  AnchorOpeningByReconstructionImageFilter(){}
+  void PrintSelf(std::ostream& os, Indent indent) const
+  {
+    os << indent << "Anchor opening by reconstruction: " << std::endl;
+  }
+
+private:
+  
+  AnchorOpeningByReconstructionImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef __itkAnchorRankImageFilter_txx
+#define __itkAnchorRankImageFilter_txx
+
+#include "itkAnchorRankImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+namespace itk {
+
+template <class TImage, class TKernel>
+AnchorRankImageFilter<TImage, TKernel>
+::AnchorRankImageFilter()
+{
+  m_KernelSet = false;
+  m_Rank = 0.5;
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRankImageFilter<TImage, TKernel>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImagePointer inputPtr = const_cast< TImage * >( this->GetInput() );
+  if ( inputPtr )
+    {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRankImageFilter<TImage, TKernel>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRankImageFilter<TImage, TKernel>
+::GenerateData()
+{
+  // check that we are using a decomposable kernel
+  if (!m_Kernel.GetDecomposable())
+    {
+    itkExceptionMacro("Anchor morphology only works with decomposable structuring elements");
+    }
+  if (!m_KernelSet)
+    {
+    itkExceptionMacro("No kernel set");
+    }
+
+  // Allocate the output
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+
+  InputImageRegionType OReg = output->GetRequestedRegion();
+  // maximum buffer length is sum of dimensions
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += OReg.GetSize()[i];
+    }
+
+  typename KernelType::DecompType decomposition = m_Kernel.GetLines();
+  if (decomposition.empty())
+    {
+    // a kernel of a single pixel
+    ImageRegionConstIterator<TImage> inIt(input, OReg);
+    ImageRegionIterator<TImage> outIt(output, OReg);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    return;
+    }
+
+  InputImagePixelType * buffer = new InputImagePixelType[bufflength];
+  InputImagePixelType * inbuffer = new InputImagePixelType[bufflength];
+  AnchorLineType AnchorLine;
+  AnchorLine.SetRank(m_Rank);
+  // each pass covers the region once
+  AnchorSweepMonitor monitor(this, 0, (double)decomposition.size() * OReg.GetNumberOfPixels());
+
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    typename KernelType::LType ThisLine = decomposition[i];
+    typename BresType::OffsetArray TheseOffsets = mkLineOffsets<BresType, typename KernelType::LType>(ThisLine, m_Kernel.GetPeriod(i), bufflength);
+    unsigned int SELength = getLinePixels<typename KernelType::LType>(ThisLine);
+    // want lines to be odd
+    if (!(SELength%2))
+      ++SELength;
+    AnchorLine.SetSize(SELength);
+    AnchorLine.SetPeriod(m_Kernel.GetPeriod(i));
+
+    InputImageRegionType BigFace = mkEnlargedFace<InputImageType, typename KernelType::LType>(input, OReg, ThisLine);
+    if (!doFace<TImage, BresType, AnchorLineType, typename KernelType::LType>(input, output, ThisLine, AnchorLine, 
+									       TheseOffsets, inbuffer, buffer, OReg, BigFace,
+									       &monitor))
+      {
+      delete [] buffer;
+      delete [] inbuffer;
+      abortSweep<TImage>(this->GetInput(), output, OReg);
+      }
+    // after the first pass the input will be taken from the output
+    input = this->GetOutput();
+    }
+
+  delete [] buffer;
+  delete [] inbuffer;
+}
+
+template<class TImage, class TKernel>
+void
+AnchorRankImageFilter<TImage, TKernel>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "KernelSet: " << m_KernelSet << std::endl;
+  os << indent << "Rank: " << m_Rank << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef __itkAnchorRankLine_h
+#define __itkAnchorRankLine_h
+
+#include "itkAnchorHistogram.h"
+
+namespace itk {
+
+/** 
+ * \class AnchorRankLine
+ * \brief class to apply a rank operator along a line: each pixel
+ * gets the pixel of the given rank in the window of the structuring
+ * element centred on it. The window is clipped at the ends of the
+ * line. A sliding histogram is used, which holds a vector of counts
+ * for 8 and 16 bit pixels and a map for the other types.
+**/
+template<class TInputPix>
+class ITK_EXPORT AnchorRankLine
+{
+public:
+  /** Some convenient typedefs. */
+  typedef TInputPix InputImagePixelType;
+
+  void doLine(InputImagePixelType * buffer, InputImagePixelType * inbuffer, 
+	      unsigned bufflength);
+
+  void SetSize(unsigned int size)
+  {
+    m_Size = size;
+  }
+
+  // As for the erosions, a periodic line is swept as period
+  // interleaved lines
+  void SetPeriod(unsigned int period)
+  {
+    m_Period = period;
+  }
+
+  // 0 for the minimum, 1 for the maximum and 0.5 for the median
+  void SetRank(float rank)
+  {
+    m_Histo->SetRank(rank);
+  }
+
+  void PrintSelf(std::ostream &os, Indent indent) const;
+  AnchorRankLine();
+  ~AnchorRankLine() {delete m_Histo; delete [] m_SubBuffer; delete [] m_SubInBuffer;};
+
+private:
+  AnchorRankLine(const AnchorRankLine &); //purposely not implemented
+  void operator=(const AnchorRankLine &); //purposely not implemented
+
+  unsigned int m_Size;
+  unsigned int m_Period;
+
+  typedef MorphologyRankHistogram<InputImagePixelType> Histogram;
+  typedef MorphologyRankHistogramVec<InputImagePixelType> VHistogram;
+  typedef MorphologyRankHistogramMap<InputImagePixelType> MHistogram;
+
+  void doContiguousLine(InputImagePixelType * buffer, InputImagePixelType * inbuffer, 
+			unsigned bufflength);
+
+  InputImagePixelType * m_SubBuffer;
+  InputImagePixelType * m_SubInBuffer;
+  unsigned int m_SubLength;
+
+  bool useVectorBasedHistogram()
+  {
+    // a vector of counts is small enough for 8 and 16 bit pixels
+    return typeid(InputImagePixelType) == typeid(unsigned char)
+        || typeid(InputImagePixelType) == typeid(signed char)
+        || typeid(InputImagePixelType) == typeid(unsigned short)
+        || typeid(InputImagePixelType) == typeid(signed short);
+    }
+
+  Histogram * m_Histo;
+
+} ; // end of class
+
+
+} // end namespace itk
+
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorRankLine.txx"
+#endif
+
+#endif
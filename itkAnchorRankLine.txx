@@ -0,0 +1,118 @@
+#ifndef __itkAnchorRankLine_txx
+#define __itkAnchorRankLine_txx
+
+#include "itkAnchorRankLine.h"
+
+namespace itk {
+
+template <class TInputPix>
+AnchorRankLine<TInputPix>
+::AnchorRankLine()
+{
+  m_Size=2;
+  m_Period=1;
+  m_SubBuffer=0;
+  m_SubInBuffer=0;
+  m_SubLength=0;
+  // create a histogram
+  if (useVectorBasedHistogram())
+    {
+    m_Histo = new VHistogram;
+    } 
+  else
+    {
+    m_Histo = new MHistogram;
+    }
+  // each line empties the histogram when it is done, so this is the
+  // only reset, which matters for the 65536 counts of 16 bit pixels
+  m_Histo->Reset();
+}
+
+template <class TInputPix>
+void
+AnchorRankLine<TInputPix>
+::doLine(InputImagePixelType * buffer, InputImagePixelType * inbuffer, unsigned bufflength)
+{
+  if (m_Period < 2)
+    {
+    doContiguousLine(buffer, inbuffer, bufflength);
+    return;
+    }
+  // the pixels of a periodic line only interact with the pixels a
+  // multiple of the period away
+  unsigned int size = m_Size;
+  m_Size = (size - 1) / m_Period + 1;
+  if (m_SubLength < bufflength / m_Period + 1)
+    {
+    delete [] m_SubBuffer;
+    delete [] m_SubInBuffer;
+    m_SubLength = bufflength / m_Period + 1;
+    m_SubBuffer = new InputImagePixelType[m_SubLength];
+    m_SubInBuffer = new InputImagePixelType[m_SubLength];
+    }
+  for (unsigned r = 0; r < m_Period && r < bufflength; r++)
+    {
+    unsigned sublength = 0;
+    for (unsigned i = r; i < bufflength; i += m_Period)
+      {
+      m_SubInBuffer[sublength++] = inbuffer[i];
+      }
+    doContiguousLine(m_SubBuffer, m_SubInBuffer, sublength);
+    for (unsigned i = r, j = 0; i < bufflength; i += m_Period, j++)
+      {
+      buffer[i] = m_SubBuffer[j];
+      }
+    }
+  m_Size = size;
+}
+
+template <class TInputPix>
+void
+AnchorRankLine<TInputPix>
+::doContiguousLine(InputImagePixelType * buffer, InputImagePixelType * inbuffer, unsigned bufflength)
+{
+  int middle = (int)m_Size/2;
+  int length = (int)bufflength;
+
+  // the window of pixel i is [i - middle, i + middle], clipped to
+  // the line. inLeftP and inRightP are the pixels it holds.
+  int inLeftP = 0;
+  int inRightP = std::min(middle, length - 1);
+  for (int i = inLeftP; i <= inRightP; i++)
+    {
+    m_Histo->AddPixel(inbuffer[i]);
+    }
+  for (int i = 0; i < length; i++)
+    {
+    buffer[i] = m_Histo->GetValue();
+    if (i + middle + 1 < length)
+      {
+      ++inRightP;
+      m_Histo->AddPixel(inbuffer[inRightP]);
+      }
+    if (i - middle >= 0)
+      {
+      m_Histo->RemovePixel(inbuffer[inLeftP]);
+      ++inLeftP;
+      }
+    }
+  // leave the histogram empty for the next line
+  for (int i = inLeftP; i <= inRightP; i++)
+    {
+    m_Histo->RemovePixel(inbuffer[i]);
+    }
+}
+
+template<class TInputPix>
+void
+AnchorRankLine<TInputPix>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  os << indent << "Size: " << m_Size << std::endl;
+  os << indent << "Period: " << m_Period << std::endl;
+}
+
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef __itkAnchorRegionBatch_h
+#define __itkAnchorRegionBatch_h
+
+#include "itkObject.h"
+#include "itkMultiThreader.h"
+#include "itkAnchorErodeDilateLine.h"
+#include "itkAnchorOpenCloseLine.h"
+#include "itkAnchorUtilities.h"
+#include "itkAnchorLineScheduler.h"
+#include "itkAnchorChordTable.h"
+#include "itkAnchorImportImageContainer.h"
+#include "itkBresenhamLine.h"
+#include <vector>
+#include <functional>
+
+namespace itk {
+
+/**
+ * \class AnchorRegionBatch
+ * \brief computes a morphological operation over many small regions
+ * of one large image, such as the crops around the detections of a
+ * slide.
+ *
+ * A filter per region spends more time in its construction, the
+ * allocation of its output and the decomposition of its kernel than
+ * on the pixels. Here the lines of the kernel, their offsets and
+ * faces, are computed once for all the regions, and each region is
+ * computed from the input with the smallest halo its passes need, as
+ * the tiles of AnchorTileCache are, so that it is identical to the
+ * same part of the operation applied to the whole image. Kernels
+ * that aren't decomposable are computed by their chords. The regions
+ * are shared between threads by an AnchorLineScheduler, weighted by
+ * their size with their halo, and each thread reuses its own line
+ * objects, buffers and intermediate images for all its regions.
+ *
+ * Openings and closings are those of AnchorOpenImageFilter and
+ * AnchorCloseImageFilter, with an opening along the last line between
+ * the erosions and the dilations, or an erosion and a dilation by the
+ * chords.
+ *
+ * The results are written, in the order of the regions, into a
+ * single packed buffer, where each region is stored as an image of
+ * its size would be, or into an image per region when PackedOutput
+ * is off. A new Compute invalidates the pointer returned by
+ * GetBufferPointer and the offsets of the previous one. The images
+ * returned by GetOutput keep their buffer alive and are never
+ * overwritten: the buffer is only reused while none of them is
+ * held.
+ *
+ * The regions must be inside the largest possible region of the
+ * input, which must be buffered over the region needed by each of
+ * them, and must not change during Compute.
+**/
+template<class TImage, class TKernel>
+class ITK_EXPORT AnchorRegionBatch : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorRegionBatch         Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorRegionBatch, Object);
+
+  typedef TKernel KernelType;
+  typedef TImage ImageType;
+  typedef typename ImageType::Pointer         ImagePointer;
+  typedef typename ImageType::ConstPointer    ImageConstPointer;
+  typedef typename ImageType::RegionType      RegionType;
+  typedef typename ImageType::PixelType       PixelType;
+  typedef typename ImageType::IndexType       IndexType;
+  typedef typename ImageType::SizeType        SizeType;
+  typedef std::vector<RegionType>             RegionListType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  typedef enum { ERODE = 0, DILATE, OPEN, CLOSE } OperationType;
+
+  /** The image the regions are computed from */
+  void SetInput(const ImageType *input);
+  const ImageType * GetInput() const
+  {
+    return m_Input;
+  }
+
+  /** The kernel shared by all the regions */
+  void SetKernel(const KernelType &kernel);
+  itkGetConstReferenceMacro(Kernel, KernelType);
+
+  /** The operation. Default is ERODE. */
+  itkSetMacro(Operation, OperationType);
+  itkGetConstMacro(Operation, OperationType);
+
+  /** The regions to compute */
+  void SetRegions(const RegionListType &regions);
+  const RegionListType & GetRegions() const
+  {
+    return m_Regions;
+  }
+  void AddRegion(const RegionType &region);
+  void ClearRegions();
+  unsigned long GetNumberOfRegions() const
+  {
+    return m_Regions.size();
+  }
+
+  /** Write the results into a single buffer rather than into an
+   * image per region. On by default. */
+  itkSetMacro(PackedOutput, bool);
+  itkGetConstReferenceMacro(PackedOutput, bool);
+  itkBooleanMacro(PackedOutput);
+
+  /** The number of threads. Default is the global default of
+   * MultiThreader. */
+  itkSetMacro(NumberOfThreads, int);
+  itkGetConstMacro(NumberOfThreads, int);
+
+  /** The region of the input needed by region i */
+  RegionType GetNeededRegion(unsigned long i);
+
+  /** Compute the operation over all the regions */
+  void Compute();
+
+  /** The packed results: region i starts at GetBufferOffset(i) and
+   * is stored in the order of its pixels in an image. The pointer is
+   * valid until the next Compute. */
+  PixelType * GetBufferPointer()
+  {
+    return m_Buffer ? m_Buffer->GetBufferPointer() : 0;
+  }
+  unsigned long GetBufferOffset(unsigned long i) const
+  {
+    return m_Offsets[i];
+  }
+  unsigned long GetBufferSize() const
+  {
+    return m_Offsets.empty() ? 0 : m_Offsets.back();
+  }
+
+  /** The result of region i. The buffered region of the image is
+   * region i and its largest possible region is that of the
+   * input. With PackedOutput, the image uses the packed buffer, and
+   * holds a reference to it. */
+  ImagePointer GetOutput(unsigned long i);
+
+protected:
+  AnchorRegionBatch();
+  ~AnchorRegionBatch() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+private:
+  AnchorRegionBatch(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  typedef BresenhamLine<TImage::ImageDimension> BresType;
+  typedef typename KernelType::LType LineType;
+  typedef AnchorLinePass<TImage, BresType, LineType> PassType;
+  typedef std::vector<PassType> PlanType;
+  typedef AnchorChordPlan<TImage::ImageDimension> ChordPlanType;
+  typedef AnchorLineScheduler<TImage, BresType, LineType> SchedulerType;
+  typedef AnchorImportImageContainer<unsigned long, PixelType> OutputContainerType;
+
+  typedef AnchorErodeDilateLine<PixelType, std::less<PixelType>, std::less_equal<PixelType> > ErodeLineType;
+  typedef AnchorErodeDilateLine<PixelType, std::greater<PixelType>, std::greater_equal<PixelType> > DilateLineType;
+  typedef AnchorOpenCloseLine<PixelType, std::less<PixelType>, std::greater_equal<PixelType>, std::less_equal<PixelType> > OpenLineType;
+  typedef AnchorOpenCloseLine<PixelType, std::greater<PixelType>, std::less_equal<PixelType>, std::greater_equal<PixelType> > CloseLineType;
+
+  // the lines, or the chords, of the kernel, if they aren't up to date
+  void MakePlan();
+
+  // the reach of the operation around a region, or of its first
+  // erosion or dilation with firstPass
+  SizeType GetHalo(bool firstPass = false) const;
+
+  // what each thread reuses from one region to the next
+  struct ThreadBuffers
+  {
+    ErodeLineType ErodeLine;
+    DilateLineType DilateLine;
+    OpenLineType OpenLine;
+    CloseLineType CloseLine;
+    PixelType * InBuffer;
+    PixelType * OutBuffer;
+    ImagePointer Tile;
+    ImagePointer Middle;
+    ImagePointer View;
+    typename TImage::PixelContainerPointer ViewContainer;
+  };
+
+  // compute region i into its part of the packed buffer or its image
+  void ComputeRegion(unsigned long i, ThreadBuffers &buffers);
+
+  struct BatchThreadStruct
+  {
+    Self * Batch;
+    SchedulerType * Scheduler;
+  };
+  static ITK_THREAD_RETURN_TYPE BatchThreaderCallback(void *arg);
+
+  ImageConstPointer m_Input;
+  KernelType m_Kernel;
+  OperationType m_Operation;
+  RegionListType m_Regions;
+  bool m_PackedOutput;
+  int m_NumberOfThreads;
+
+  bool m_PlanValid;
+  RegionType m_PlanImage;
+  PlanType m_Plan;
+  ChordPlanType m_ErodeChords;
+  ChordPlanType m_DilateChords;
+  unsigned int m_BufferLength;
+
+  typename TImage::PixelContainerPointer m_Buffer;
+  std::vector<unsigned long> m_Offsets;
+  std::vector<ImagePointer> m_Outputs;
+  MultiThreader::Pointer m_Threader;
+
+} ; // end of class
+
+
+} // end namespace itk
+
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorRegionBatch.txx"
+#endif
+
+#endif
@@ -0,0 +1,411 @@
+#ifndef __itkAnchorRegionBatch_txx
+#define __itkAnchorRegionBatch_txx
+
+#include "itkAnchorRegionBatch.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+namespace itk {
+
+template <class TImage, class TKernel>
+AnchorRegionBatch<TImage, TKernel>
+::AnchorRegionBatch()
+{
+  m_Operation = ERODE;
+  m_PackedOutput = true;
+  m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+  m_PlanValid = false;
+  m_BufferLength = 0;
+  m_Threader = MultiThreader::New();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRegionBatch<TImage, TKernel>
+::SetInput(const ImageType *input)
+{
+  m_Input = input;
+  this->Modified();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRegionBatch<TImage, TKernel>
+::SetKernel(const KernelType &kernel)
+{
+  m_Kernel = kernel;
+  m_PlanValid = false;
+  this->Modified();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRegionBatch<TImage, TKernel>
+::SetRegions(const RegionListType &regions)
+{
+  m_Regions = regions;
+  this->Modified();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRegionBatch<TImage, TKernel>
+::AddRegion(const RegionType &region)
+{
+  m_Regions.push_back(region);
+  this->Modified();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRegionBatch<TImage, TKernel>
+::ClearRegions()
+{
+  m_Regions.clear();
+  this->Modified();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRegionBatch<TImage, TKernel>
+::MakePlan()
+{
+  // the lines are those of a sweep of the whole input, so they only
+  // change with the kernel and the size of the input
+  RegionType AllImage = m_Input->GetLargestPossibleRegion();
+  if (m_PlanValid && (AllImage == m_PlanImage))
+    {
+    return;
+    }
+  m_BufferLength = 0;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    m_BufferLength += AllImage.GetSize()[i];
+    }
+  m_Plan.clear();
+  if (m_Kernel.GetDecomposable())
+    {
+    const typename KernelType::DecompType &lines = m_Kernel.GetLines();
+    for (unsigned i = 0; i < lines.size(); i++)
+      {
+      m_Plan.push_back(mkLinePass<TImage, BresType, LineType>(AllImage, lines[i], m_BufferLength, m_Kernel.GetPeriod(i)));
+      }
+    }
+  else
+    {
+    // the dilations use the mirrored kernel, as the filters do
+    m_ErodeChords = mkChordPlan(m_Kernel, false);
+    m_DilateChords = mkChordPlan(m_Kernel, true);
+    }
+  m_PlanImage = AllImage;
+  m_PlanValid = true;
+}
+
+template <class TImage, class TKernel>
+typename AnchorRegionBatch<TImage, TKernel>::SizeType
+AnchorRegionBatch<TImage, TKernel>
+::GetHalo(bool firstPass) const
+{
+  const bool twoPasses = !firstPass && ((m_Operation == OPEN) || (m_Operation == CLOSE));
+  SizeType Halo;
+  Halo.Fill(0);
+  if (!m_Kernel.GetDecomposable())
+    {
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      Halo[i] = (twoPasses ? 2 : 1) * m_Kernel.GetRadius(i);
+      }
+    return Halo;
+    }
+  if (twoPasses)
+    {
+    return getOpenTileHalo<TImage, BresType, LineType>(m_Plan);
+    }
+  for (unsigned p = 0; p < m_Plan.size(); p++)
+    {
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      Halo[i] += m_Plan[p].Reach[i];
+      }
+    }
+  return Halo;
+}
+
+template <class TImage, class TKernel>
+typename AnchorRegionBatch<TImage, TKernel>::RegionType
+AnchorRegionBatch<TImage, TKernel>
+::GetNeededRegion(unsigned long i)
+{
+  if (!m_Input)
+    {
+    itkExceptionMacro("No input set");
+    }
+  if (i >= m_Regions.size())
+    {
+    itkExceptionMacro("There is no region " << i);
+    }
+  this->MakePlan();
+  RegionType Needed = m_Regions[i];
+  Needed.PadByRadius(this->GetHalo());
+  Needed.Crop(m_PlanImage);
+  return Needed;
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRegionBatch<TImage, TKernel>
+::Compute()
+{
+  if (!m_Input)
+    {
+    itkExceptionMacro("No input set");
+    }
+  this->MakePlan();
+
+  // where each region goes in the packed buffer, and its weight for
+  // the scheduler, which is the size of the tile it is computed in
+  const unsigned long regions = m_Regions.size();
+  std::vector<unsigned int> weights(regions);
+  m_Offsets.resize(regions + 1);
+  m_Offsets[0] = 0;
+  for (unsigned long i = 0; i < regions; i++)
+    {
+    const unsigned long pixels = m_Regions[i].GetNumberOfPixels();
+    m_Offsets[i + 1] = m_Offsets[i] + pixels;
+    weights[i] = 1;
+    if (!pixels)
+      {
+      continue;
+      }
+    if (!m_PlanImage.IsInside(m_Regions[i]))
+      {
+      itkExceptionMacro("Region " << i << " is outside the image");
+      }
+    RegionType Needed = this->GetNeededRegion(i);
+    if (!m_Input->GetBufferedRegion().IsInside(Needed))
+      {
+      itkExceptionMacro("The input isn't buffered over the region needed by region " << i);
+      }
+    weights[i] += Needed.GetNumberOfPixels();
+    }
+
+  m_Outputs.clear();
+  if (m_PackedOutput)
+    {
+    // the buffer only grows, so that a batch of the same size doesn't
+    // allocate, and isn't reused while outputs of the previous batch
+    // hold it
+    if (!m_Buffer || (m_Buffer->Size() < m_Offsets[regions])
+	|| (m_Buffer->GetReferenceCount() > 1))
+      {
+      m_Buffer = TImage::PixelContainer::New();
+      m_Buffer->Reserve(m_Offsets[regions]);
+      }
+    }
+  else
+    {
+    m_Outputs.resize(regions);
+    }
+  if (!regions)
+    {
+    return;
+    }
+
+  m_Threader->SetNumberOfThreads(m_NumberOfThreads > 0 ? m_NumberOfThreads : 1);
+  SchedulerType scheduler;
+  scheduler.Initialize(weights, m_Threader->GetNumberOfThreads());
+  BatchThreadStruct str;
+  str.Batch = this;
+  str.Scheduler = &scheduler;
+  m_Threader->SetSingleMethod(this->BatchThreaderCallback, &str);
+  m_Threader->SingleMethodExecute();
+}
+
+template <class TImage, class TKernel>
+ITK_THREAD_RETURN_TYPE
+AnchorRegionBatch<TImage, TKernel>
+::BatchThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+  BatchThreadStruct * str = (BatchThreadStruct *)(info->UserData);
+  int threadId = info->ThreadID;
+  Self * batch = str->Batch;
+
+  // each thread needs its own line objects, buffers and images, which
+  // are reused for all its regions
+  ThreadBuffers buffers;
+  buffers.InBuffer = new PixelType[batch->m_BufferLength];
+  buffers.OutBuffer = new PixelType[batch->m_BufferLength];
+  buffers.Tile = TImage::New();
+  buffers.Middle = TImage::New();
+  buffers.View = TImage::New();
+  buffers.ViewContainer = TImage::PixelContainer::New();
+  typename SchedulerType::Chunk chunk;
+  while (str->Scheduler->Next(threadId, chunk))
+    {
+    for (unsigned long i = chunk.First; i < chunk.First + chunk.Count; i++)
+      {
+      batch->ComputeRegion(i, buffers);
+      }
+    }
+  delete [] buffers.InBuffer;
+  delete [] buffers.OutBuffer;
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRegionBatch<TImage, TKernel>
+::ComputeRegion(unsigned long i, ThreadBuffers &buffers)
+{
+  const RegionType Core = m_Regions[i];
+  const unsigned long pixels = Core.GetNumberOfPixels();
+  if (!pixels)
+    {
+    return;
+    }
+  const RegionType AllImage = m_PlanImage;
+
+  // the result goes straight to its place in the packed buffer, through
+  // an image of the thread that uses that part of the buffer
+  ImagePointer dest;
+  if (m_PackedOutput)
+    {
+    buffers.ViewContainer->SetImportPointer(m_Buffer->GetBufferPointer() + m_Offsets[i], pixels, false);
+    buffers.View->SetRegions(Core);
+    buffers.View->SetPixelContainer(buffers.ViewContainer);
+    dest = buffers.View;
+    }
+  else
+    {
+    dest = TImage::New();
+    dest->SetRegions(Core);
+    dest->SetLargestPossibleRegion(AllImage);
+    dest->Allocate();
+    m_Outputs[i] = dest;
+    }
+
+  ImageConstPointer input = m_Input;
+  const bool twoPasses = (m_Operation == OPEN) || (m_Operation == CLOSE);
+  const bool erodeFirst = (m_Operation == ERODE) || (m_Operation == OPEN);
+
+  if (!m_Kernel.GetDecomposable())
+    {
+    // the second operation needs the first one over the region and
+    // its halo
+    RegionType Middle = Core;
+    Middle.PadByRadius(this->GetHalo(true));
+    Middle.Crop(AllImage);
+    ImageConstPointer middleIn = buffers.Middle.GetPointer();
+    if (twoPasses)
+      {
+      buffers.Middle->SetRegions(Middle);
+      buffers.Middle->Allocate();
+      }
+    if (twoPasses && erodeFirst)
+      {
+      doChordPass<TImage, std::less<PixelType> >(input, buffers.Middle, m_ErodeChords, Middle);
+      doChordPass<TImage, std::greater<PixelType> >(middleIn, dest, m_DilateChords, Core);
+      }
+    else if (twoPasses)
+      {
+      doChordPass<TImage, std::greater<PixelType> >(input, buffers.Middle, m_DilateChords, Middle);
+      doChordPass<TImage, std::less<PixelType> >(middleIn, dest, m_ErodeChords, Core);
+      }
+    else if (erodeFirst)
+      {
+      doChordPass<TImage, std::less<PixelType> >(input, dest, m_ErodeChords, Core);
+      }
+    else
+      {
+      doChordPass<TImage, std::greater<PixelType> >(input, dest, m_DilateChords, Core);
+      }
+    return;
+    }
+
+  if (m_Plan.empty())
+    {
+    ImageRegionConstIterator<TImage> inIt(input, Core);
+    ImageRegionIterator<TImage> outIt(dest, Core);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    return;
+    }
+
+  unsigned last = m_Plan.size() - 1;
+  if (twoPasses && erodeFirst)
+    {
+    doOpenTile<TImage, BresType, ErodeLineType, OpenLineType, DilateLineType, LineType>(input, dest, buffers.Tile, m_Plan,
+											  buffers.ErodeLine, buffers.OpenLine, buffers.DilateLine,
+											  buffers.InBuffer, buffers.OutBuffer,
+											  AllImage, Core);
+    }
+  else if (twoPasses)
+    {
+    doOpenTile<TImage, BresType, DilateLineType, CloseLineType, ErodeLineType, LineType>(input, dest, buffers.Tile, m_Plan,
+											   buffers.DilateLine, buffers.CloseLine, buffers.ErodeLine,
+											   buffers.InBuffer, buffers.OutBuffer,
+											   AllImage, Core);
+    }
+  else if (erodeFirst)
+    {
+    doTile<TImage, BresType, ErodeLineType, LineType>(input, dest, buffers.Tile, m_Plan, 0, last,
+						      buffers.ErodeLine, buffers.InBuffer, buffers.OutBuffer,
+						      AllImage, Core);
+    }
+  else
+    {
+    doTile<TImage, BresType, DilateLineType, LineType>(input, dest, buffers.Tile, m_Plan, 0, last,
+						       buffers.DilateLine, buffers.InBuffer, buffers.OutBuffer,
+						       AllImage, Core);
+    }
+}
+
+template <class TImage, class TKernel>
+typename AnchorRegionBatch<TImage, TKernel>::ImagePointer
+AnchorRegionBatch<TImage, TKernel>
+::GetOutput(unsigned long i)
+{
+  if ((i >= m_Regions.size()) || (m_Offsets.size() != m_Regions.size() + 1))
+    {
+    itkExceptionMacro("Region " << i << " hasn't been computed");
+    }
+  if (!m_PackedOutput)
+    {
+    if (i >= m_Outputs.size())
+      {
+      itkExceptionMacro("Region " << i << " hasn't been computed");
+      }
+    return m_Outputs[i];
+    }
+  if (!m_Buffer)
+    {
+    itkExceptionMacro("Region " << i << " hasn't been computed");
+    }
+  ImagePointer image = TImage::New();
+  image->SetRegions(m_Regions[i]);
+  image->SetLargestPossibleRegion(m_PlanImage);
+  typename OutputContainerType::Pointer container = OutputContainerType::New();
+  container->SetImportPointer(m_Buffer->GetBufferPointer() + m_Offsets[i],
+			      m_Regions[i].GetNumberOfPixels(), m_Buffer);
+  image->SetPixelContainer(container);
+  return image;
+}
+
+template <class TImage, class TKernel>
+void
+AnchorRegionBatch<TImage, TKernel>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Operation: " << m_Operation << std::endl;
+  os << indent << "NumberOfRegions: " << m_Regions.size() << std::endl;
+  os << indent << "PackedOutput: " << m_PackedOutput << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef __itkAnchorSmallKernel_h
+#define __itkAnchorSmallKernel_h
+
+#include "itkImage.h"
+#include <vector>
+#include <functional>
+
+// the row kernels are compiled for SSE2 and AVX2 with the target
+// attribute, whatever the flags of the build, and chosen at run time
+#if (defined(__x86_64__) || defined(__i386__)) && \
+  (defined(__clang__) || \
+   (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))))
+#define ANCHOR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace itk {
+
+class AnchorSweepMonitor;
+
+#ifdef ANCHOR_SIMD_X86
+// the row kernels: out[i] = in[i] where in[i] compare out[i], by
+// vectors of width pixels and then one pixel at a time. The min and
+// max instructions keep their second operand on ties, as the scalar
+// loop does.
+#define anchorSimdRowMacro(name, isa, T, V, loadu, storeu, op, width, compare) \
+  inline __attribute__((target(isa))) void name(T * out, const T * in, unsigned long n) \
+  { \
+    unsigned long i = 0; \
+    for (; i + width <= n; i += width) \
+      { \
+      V a = loadu((const V *)(in + i)); \
+      V b = loadu((const V *)(out + i)); \
+      storeu((V *)(out + i), op(a, b)); \
+      } \
+    for (; i < n; i++) \
+      { \
+      if (in[i] compare out[i]) out[i] = in[i]; \
+      } \
+  }
+
+// SSE2 only compares signed shorts, so the unsigned ones are shifted
+// by 0x8000 around the comparison
+inline __attribute__((target("sse2"))) __m128i anchorMinEpu16SSE2(__m128i a, __m128i b)
+{
+  const __m128i shift = _mm_set1_epi16((short)0x8000);
+  return _mm_xor_si128(_mm_min_epi16(_mm_xor_si128(a, shift), _mm_xor_si128(b, shift)), shift);
+}
+inline __attribute__((target("sse2"))) __m128i anchorMaxEpu16SSE2(__m128i a, __m128i b)
+{
+  const __m128i shift = _mm_set1_epi16((short)0x8000);
+  return _mm_xor_si128(_mm_max_epi16(_mm_xor_si128(a, shift), _mm_xor_si128(b, shift)), shift);
+}
+// the float loads and stores take float pointers
+inline __attribute__((target("sse2"))) __m128 anchorLoadPsSSE2(const __m128 * p)
+{
+  return _mm_loadu_ps((const float *)p);
+}
+inline __attribute__((target("sse2"))) void anchorStorePsSSE2(__m128 * p, __m128 v)
+{
+  _mm_storeu_ps((float *)p, v);
+}
+inline __attribute__((target("avx2"))) __m256 anchorLoadPsAVX2(const __m256 * p)
+{
+  return _mm256_loadu_ps((const float *)p);
+}
+inline __attribute__((target("avx2"))) void anchorStorePsAVX2(__m256 * p, __m256 v)
+{
+  _mm256_storeu_ps((float *)p, v);
+}
+
+anchorSimdRowMacro(anchorMinRowSSE2, "sse2", unsigned char, __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_min_epu8, 16, <)
+anchorSimdRowMacro(anchorMaxRowSSE2, "sse2", unsigned char, __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_max_epu8, 16, >)
+anchorSimdRowMacro(anchorMinRowSSE2, "sse2", short, __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_min_epi16, 8, <)
+anchorSimdRowMacro(anchorMaxRowSSE2, "sse2", short, __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_max_epi16, 8, >)
+anchorSimdRowMacro(anchorMinRowSSE2, "sse2", unsigned short, __m128i, _mm_loadu_si128, _mm_storeu_si128, anchorMinEpu16SSE2, 8, <)
+anchorSimdRowMacro(anchorMaxRowSSE2, "sse2", unsigned short, __m128i, _mm_loadu_si128, _mm_storeu_si128, anchorMaxEpu16SSE2, 8, >)
+anchorSimdRowMacro(anchorMinRowSSE2, "sse2", float, __m128, anchorLoadPsSSE2, anchorStorePsSSE2, _mm_min_ps, 4, <)
+anchorSimdRowMacro(anchorMaxRowSSE2, "sse2", float, __m128, anchorLoadPsSSE2, anchorStorePsSSE2, _mm_max_ps, 4, >)
+
+anchorSimdRowMacro(anchorMinRowAVX2, "avx2", unsigned char, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_min_epu8, 32, <)
+anchorSimdRowMacro(anchorMaxRowAVX2, "avx2", unsigned char, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_max_epu8, 32, >)
+anchorSimdRowMacro(anchorMinRowAVX2, "avx2", short, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_min_epi16, 16, <)
+anchorSimdRowMacro(anchorMaxRowAVX2, "avx2", short, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_max_epi16, 16, >)
+anchorSimdRowMacro(anchorMinRowAVX2, "avx2", unsigned short, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_min_epu16, 16, <)
+anchorSimdRowMacro(anchorMaxRowAVX2, "avx2", unsigned short, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_max_epu16, 16, >)
+anchorSimdRowMacro(anchorMinRowAVX2, "avx2", float, __m256, anchorLoadPsAVX2, anchorStorePsAVX2, _mm256_min_ps, 8, <)
+anchorSimdRowMacro(anchorMaxRowAVX2, "avx2", float, __m256, anchorLoadPsAVX2, anchorStorePsAVX2, _mm256_max_ps, 8, >)
+
+#undef anchorSimdRowMacro
+#endif
+
+/**
+ * \class AnchorSimd
+ * \brief the vector instructions used by the small kernel path, and
+ * the row kernels that fold a row of pixels into another one.
+ *
+ * MinRow sets out[i] to in[i] where in[i] < out[i], and MaxRow where
+ * in[i] > out[i], which is how the erosions and the dilations pick
+ * their extremum. unsigned char, short, unsigned short and float are
+ * vectorized, with SSE2 or AVX2 depending on what the processor
+ * supports. They return false, doing nothing, for the other types and
+ * on processors without SSE2, which use the scalar loop of
+ * AnchorRowFold.
+**/
+class AnchorSimd
+{
+public:
+  typedef enum {Scalar = 0, SSE2 = 1, AVX2 = 2} LevelType;
+
+  /** The best level the processor supports, detected once */
+  static int GetSupportedLevel()
+  {
+    static int supported = DetectLevel();
+    return supported;
+  }
+
+  /** The level in use, the supported one unless SetLevel lowered
+   * it */
+  static int GetLevel()
+  {
+    return CurrentLevel();
+  }
+
+  /** Use a lower level, e.g. to compare the results or the timings
+   * of the levels. Clamped to the supported level. */
+  static void SetLevel(int level)
+  {
+    if (level > GetSupportedLevel()) level = GetSupportedLevel();
+    if (level < Scalar) level = Scalar;
+    CurrentLevel() = level;
+  }
+
+  static const char * GetLevelName(int level)
+  {
+    switch (level)
+      {
+      case SSE2: return "SSE2";
+      case AVX2: return "AVX2";
+      default: return "scalar";
+      }
+  }
+
+  template <class TPixel>
+  static bool MinRow(TPixel *, const TPixel *, unsigned long)
+  {
+    return false;
+  }
+  template <class TPixel>
+  static bool MaxRow(TPixel *, const TPixel *, unsigned long)
+  {
+    return false;
+  }
+
+#ifdef ANCHOR_SIMD_X86
+#define anchorSimdDispatchMacro(name, kernel, T) \
+  static bool name(T * out, const T * in, unsigned long n) \
+  { \
+    switch (GetLevel()) \
+      { \
+      case AVX2: kernel##AVX2(out, in, n); return true; \
+      case SSE2: kernel##SSE2(out, in, n); return true; \
+      default: return false; \
+      } \
+  }
+  anchorSimdDispatchMacro(MinRow, anchorMinRow, unsigned char)
+  anchorSimdDispatchMacro(MaxRow, anchorMaxRow, unsigned char)
+  anchorSimdDispatchMacro(MinRow, anchorMinRow, short)
+  anchorSimdDispatchMacro(MaxRow, anchorMaxRow, short)
+  anchorSimdDispatchMacro(MinRow, anchorMinRow, unsigned short)
+  anchorSimdDispatchMacro(MaxRow, anchorMaxRow, unsigned short)
+  anchorSimdDispatchMacro(MinRow, anchorMinRow, float)
+  anchorSimdDispatchMacro(MaxRow, anchorMaxRow, float)
+#undef anchorSimdDispatchMacro
+#endif
+
+private:
+  static int & CurrentLevel()
+  {
+    static int level = GetSupportedLevel();
+    return level;
+  }
+
+  static int DetectLevel()
+  {
+#ifdef ANCHOR_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      {
+      return AVX2;
+      }
+    if (__builtin_cpu_supports("sse2"))
+      {
+      return SSE2;
+      }
+#endif
+    return Scalar;
+  }
+};
+
+/**
+ * \class AnchorRowFold
+ * \brief fold a row into another with the comparison of an erosion
+ * or a dilation: out[i] takes in[i] where TFunction(in[i], out[i]).
+ * The comparisons of std::less and std::greater on the types of
+ * AnchorSimd are vectorized.
+**/
+template <class TPixel, class TFunction>
+struct AnchorRowFold
+{
+  static void Apply(TPixel * out, const TPixel * in, unsigned long n)
+  {
+    TFunction compare;
+    for (unsigned long i = 0; i < n; i++)
+      {
+      if (compare(in[i], out[i])) out[i] = in[i];
+      }
+  }
+};
+
+template <class TPixel>
+struct AnchorRowFold<TPixel, std::less<TPixel> >
+{
+  static void Apply(TPixel * out, const TPixel * in, unsigned long n)
+  {
+    if (!AnchorSimd::MinRow(out, in, n))
+      {
+      for (unsigned long i = 0; i < n; i++)
+	{
+	if (in[i] < out[i]) out[i] = in[i];
+	}
+      }
+  }
+};
+
+template <class TPixel>
+struct AnchorRowFold<TPixel, std::greater<TPixel> >
+{
+  static void Apply(TPixel * out, const TPixel * in, unsigned long n)
+  {
+    if (!AnchorSimd::MaxRow(out, in, n))
+      {
+      for (unsigned long i = 0; i < n; i++)
+	{
+	if (in[i] > out[i]) out[i] = in[i];
+	}
+      }
+  }
+};
+
+/** The step and the radius of a line along an axis or a diagonal,
+ * such as the lines of Box and of the small Poly kernels, whose
+ * pixels are at the same offsets from the centre everywhere in the
+ * image. Returns false for the other lines, for periodic lines and
+ * for lines longer than 2 * maxRadius + 1 pixels. */
+template <class TLine, class TOffset>
+bool getSmallLineStep(const TLine &line, const unsigned int period,
+		      const unsigned int maxRadius,
+		      TOffset &step, unsigned int &radius);
+
+/** True if all the lines are small lines, see getSmallLineStep, and
+ * there is at least one. The default radius covers the 3x3, 5x5, 7x7
+ * and 3x3x3 boxes, for which the setup of the anchor lines costs more
+ * than the sweep itself. */
+template <class TLine>
+bool isSmallKernel(const std::vector<TLine> &lines,
+		   const std::vector<unsigned int> &periods,
+		   const unsigned int maxRadius = 3);
+
+/** True if the lines are all along the axes, for which
+ * getSmallLineEnds and foldSmallLineEnds give the openings of
+ * AnchorOpenCloseLine. */
+template <class TLine>
+bool isAxisKernel(const std::vector<TLine> &lines);
+
+/** One pass of an erosion or a dilation by a small line: each pixel
+ * of output, over region, takes the extremum of the pixels of input
+ * at k * step from it, for |k| <= radius, that are in the region. The
+ * neighbours come from rows of the input, found by their offset,
+ * without gathering the pixels of the line, and are folded into the
+ * row of the output with AnchorRowFold. input and output must be
+ * different images, buffered over region. If a monitor is given, it
+ * is told about every row, and the pass stops and returns false when
+ * the filter has been asked to abort. */
+template <class TImage, class TFunction>
+bool doSmallLinePass(const TImage * input, TImage * output,
+		     const typename TImage::OffsetType &step,
+		     const unsigned int radius,
+		     const typename TImage::RegionType &region,
+		     AnchorSweepMonitor * monitor = 0);
+
+/** AnchorOpenCloseLine lets the line of an opening reach past the
+ * ends of the image, so that, on a line longer than 2 * radius + 1,
+ * the pixel c < radius pixels from an end is at least the extremum,
+ * by TFunction, of the c + 1 pixels of input up to that end. The
+ * erosion followed by the dilation only gives the opening away from
+ * the ends. getSmallLineEnds keeps these extrema for the lines along
+ * axis, and foldSmallLineEnds folds them into the dilation, with the
+ * opposite comparison. */
+template <class TImage, class TFunction>
+void getSmallLineEnds(const TImage * input, const unsigned int axis,
+		      const unsigned int radius,
+		      const typename TImage::RegionType &region,
+		      std::vector<typename TImage::PixelType> &ends);
+
+template <class TImage, class TFunction>
+void foldSmallLineEnds(TImage * output, const unsigned int axis,
+		       const unsigned int radius,
+		       const typename TImage::RegionType &region,
+		       const std::vector<typename TImage::PixelType> &ends);
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorSmallKernel.txx"
+#endif
+
+#endif
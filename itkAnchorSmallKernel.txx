@@ -0,0 +1,286 @@
+#ifndef __itkAnchorSmallKernel_txx
+#define __itkAnchorSmallKernel_txx
+
+#include "itkAnchorSmallKernel.h"
+#include "itkAnchorUtilities.h"
+#include "itkAnchorSweepMonitor.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include <algorithm>
+#include <math.h>
+
+namespace itk {
+
+template <class TLine, class TOffset>
+bool getSmallLineStep(const TLine &line, const unsigned int period,
+		      const unsigned int maxRadius,
+		      TOffset &step, unsigned int &radius)
+{
+  if (period > 1)
+    {
+    return false;
+    }
+  float largest = 0.0;
+  for (unsigned i = 0; i < TLine::Dimension; i++)
+    {
+    if (fabs(line[i]) > largest) largest = fabs(line[i]);
+    }
+  if (largest == 0.0)
+    {
+    return false;
+    }
+  // the Bresenham lines along the axes and the diagonals are the
+  // same wherever they start
+  for (unsigned i = 0; i < TLine::Dimension; i++)
+    {
+    float c = line[i] / largest;
+    if (fabs(c) < 0.001)
+      {
+      step[i] = 0;
+      }
+    else if (fabs(c) > 0.999)
+      {
+      step[i] = (c > 0) ? 1 : -1;
+      }
+    else
+      {
+      return false;
+      }
+    }
+  unsigned int SELength = getLinePixels<TLine>(line);
+  // want lines to be odd
+  if (!(SELength%2))
+    ++SELength;
+  radius = SELength / 2;
+  return radius <= maxRadius;
+}
+
+template <class TLine>
+bool isSmallKernel(const std::vector<TLine> &lines,
+		   const std::vector<unsigned int> &periods,
+		   const unsigned int maxRadius)
+{
+  if (lines.empty())
+    {
+    return false;
+    }
+  for (unsigned i = 0; i < lines.size(); i++)
+    {
+    Offset<TLine::Dimension> step;
+    unsigned int radius;
+    unsigned int period = (i < periods.size()) ? periods[i] : 1;
+    if (!getSmallLineStep(lines[i], period, maxRadius, step, radius))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+template <class TLine>
+bool isAxisKernel(const std::vector<TLine> &lines)
+{
+  for (unsigned i = 0; i < lines.size(); i++)
+    {
+    unsigned int axes = 0;
+    for (unsigned j = 0; j < TLine::Dimension; j++)
+      {
+      if (lines[i][j] != 0) ++axes;
+      }
+    if (axes != 1)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+template <class TImage, class TFunction>
+bool doSmallLinePass(const TImage * input, TImage * output,
+		     const typename TImage::OffsetType &step,
+		     const unsigned int radius,
+		     const typename TImage::RegionType &region,
+		     AnchorSweepMonitor * monitor)
+{
+  typedef typename TImage::PixelType PixelType;
+  typedef typename TImage::IndexType IndexType;
+  const long width = region.GetSize()[0];
+  const PixelType * inBuffer = input->GetBufferPointer();
+  PixelType * outBuffer = output->GetBufferPointer();
+
+  // iterate over the first pixel of each row
+  typename TImage::RegionType rows = region;
+  rows.SetSize(0, 1);
+  ImageRegionConstIteratorWithIndex<TImage> it(input, rows);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    const IndexType Ind = it.GetIndex();
+    PixelType * out = outBuffer + output->ComputeOffset(Ind);
+    const PixelType * centre = inBuffer + input->ComputeOffset(Ind);
+    std::copy(centre, centre + width, out);
+    for (int k = -(int)radius; k <= (int)radius; k++)
+      {
+      if (k == 0)
+	{
+	continue;
+	}
+      // the row of the neighbours at k steps, if it is in the region
+      IndexType Neighbour = Ind;
+      bool inside = true;
+      for (unsigned d = 1; d < TImage::ImageDimension; d++)
+	{
+	Neighbour[d] += k * step[d];
+	if ((Neighbour[d] < region.GetIndex()[d]) ||
+	    (Neighbour[d] >= region.GetIndex()[d] + (long)region.GetSize()[d]))
+	  {
+	  inside = false;
+	  }
+	}
+      if (!inside)
+	{
+	continue;
+	}
+      // and the part of the row whose neighbours are in the region
+      long shift = k * step[0];
+      long first = std::max(0L, -shift);
+      long last = std::min(width, width - shift);
+      if (last <= first)
+	{
+	continue;
+	}
+      const PixelType * in = inBuffer + input->ComputeOffset(Neighbour) + shift;
+      AnchorRowFold<PixelType, TFunction>::Apply(out + first, in + first, last - first);
+      }
+    if (monitor && !monitor->Completed(width))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+template <class TImage, class TFunction>
+void getSmallLineEnds(const TImage * input, const unsigned int axis,
+		      const unsigned int radius,
+		      const typename TImage::RegionType &region,
+		      std::vector<typename TImage::PixelType> &ends)
+{
+  typedef typename TImage::PixelType PixelType;
+  typedef typename TImage::IndexType IndexType;
+  const long width = region.GetSize()[0];
+  const long length = region.GetSize()[axis];
+  const PixelType * inBuffer = input->GetBufferPointer();
+  TFunction compare;
+
+  typename TImage::RegionType face = region;
+  face.SetSize(axis, 1);
+  const unsigned long facePixels = face.GetNumberOfPixels();
+  // the extrema of the c + 1 first pixels are at c * facePixels, and
+  // those of the c + 1 last pixels at (radius + c) * facePixels
+  ends.resize(2 * radius * facePixels);
+  const unsigned long back = radius * facePixels;
+  typename TImage::RegionType rows = face;
+  rows.SetSize(0, 1);
+  ImageRegionConstIteratorWithIndex<TImage> it(input, rows);
+  unsigned long pos = 0;
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    const IndexType Ind = it.GetIndex();
+    if (axis == 0)
+      {
+      // the lines are the rows
+      const PixelType * row = inBuffer + input->ComputeOffset(Ind);
+      PixelType first = row[0];
+      PixelType last = row[length - 1];
+      for (long c = 0; c < (long)radius; c++)
+	{
+	if (compare(row[c], first)) first = row[c];
+	if (compare(row[length - 1 - c], last)) last = row[length - 1 - c];
+	ends[c * facePixels + pos] = first;
+	ends[back + c * facePixels + pos] = last;
+	}
+      ++pos;
+      continue;
+      }
+    // the rows of the first and the last slices across the axis
+    for (long c = 0; c < (long)radius; c++)
+      {
+      IndexType Front = Ind;
+      IndexType Back = Ind;
+      Front[axis] += c;
+      Back[axis] += length - 1 - c;
+      const PixelType * frontRow = inBuffer + input->ComputeOffset(Front);
+      const PixelType * backRow = inBuffer + input->ComputeOffset(Back);
+      PixelType * first = &(ends[c * facePixels + pos]);
+      PixelType * last = &(ends[back + c * facePixels + pos]);
+      if (c == 0)
+	{
+	std::copy(frontRow, frontRow + width, first);
+	std::copy(backRow, backRow + width, last);
+	}
+      else
+	{
+	std::copy(first - facePixels, first - facePixels + width, first);
+	std::copy(last - facePixels, last - facePixels + width, last);
+	AnchorRowFold<PixelType, TFunction>::Apply(first, frontRow, width);
+	AnchorRowFold<PixelType, TFunction>::Apply(last, backRow, width);
+	}
+      }
+    pos += width;
+    }
+}
+
+template <class TImage, class TFunction>
+void foldSmallLineEnds(TImage * output, const unsigned int axis,
+		       const unsigned int radius,
+		       const typename TImage::RegionType &region,
+		       const std::vector<typename TImage::PixelType> &ends)
+{
+  typedef typename TImage::PixelType PixelType;
+  typedef typename TImage::IndexType IndexType;
+  const long width = region.GetSize()[0];
+  const long length = region.GetSize()[axis];
+  PixelType * outBuffer = output->GetBufferPointer();
+  TFunction compare;
+
+  typename TImage::RegionType face = region;
+  face.SetSize(axis, 1);
+  const unsigned long facePixels = face.GetNumberOfPixels();
+  const unsigned long back = radius * facePixels;
+  typename TImage::RegionType rows = face;
+  rows.SetSize(0, 1);
+  ImageRegionConstIteratorWithIndex<TImage> it(output, rows);
+  unsigned long pos = 0;
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    const IndexType Ind = it.GetIndex();
+    if (axis == 0)
+      {
+      PixelType * row = outBuffer + output->ComputeOffset(Ind);
+      for (long c = 0; c < (long)radius; c++)
+	{
+	const PixelType first = ends[c * facePixels + pos];
+	const PixelType last = ends[back + c * facePixels + pos];
+	if (compare(first, row[c])) row[c] = first;
+	if (compare(last, row[length - 1 - c])) row[length - 1 - c] = last;
+	}
+      ++pos;
+      continue;
+      }
+    for (long c = 0; c < (long)radius; c++)
+      {
+      IndexType Front = Ind;
+      IndexType Back = Ind;
+      Front[axis] += c;
+      Back[axis] += length - 1 - c;
+      AnchorRowFold<PixelType, TFunction>::Apply(outBuffer + output->ComputeOffset(Front),
+						 &(ends[c * facePixels + pos]), width);
+      AnchorRowFold<PixelType, TFunction>::Apply(outBuffer + output->ComputeOffset(Back),
+						 &(ends[back + c * facePixels + pos]), width);
+      }
+    pos += width;
+    }
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef __itkAnchorStreamingDilate_h
+#define __itkAnchorStreamingDilate_h
+
+#include "itkAnchorStreamingErodeDilate.h"
+
+namespace itk {
+
+template<class TImage, class TKernel>
+class  ITK_EXPORT AnchorStreamingDilate :
+    public AnchorStreamingErodeDilate<TImage, TKernel, std::greater<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType> >
+
+{
+public:
+  typedef AnchorStreamingDilate Self;
+  typedef AnchorStreamingErodeDilate<TImage, TKernel, std::greater<typename TImage::PixelType>, std::greater_equal<typename TImage::PixelType> > Superclass;
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorStreamingDilate, 
+               AnchorStreamingErodeDilate);
+
+  typedef SmartPointer<Self>   Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  virtual ~AnchorStreamingDilate() {}
+protected:
+  AnchorStreamingDilate(){}
+  void PrintSelf(std::ostream& os, Indent indent) const
+  {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Streaming anchor dilation" << std::endl;
+  }
+
+private:
+  
+  AnchorStreamingDilate(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+
+} // namespace itk
+
+#endif
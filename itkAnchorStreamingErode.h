@@ -0,0 +1,46 @@
+#ifndef __itkAnchorStreamingErode_h
+#define __itkAnchorStreamingErode_h
+
+#include "itkAnchorStreamingErodeDilate.h"
+
+namespace itk {
+
+template<class TImage, class TKernel>
+class  ITK_EXPORT AnchorStreamingErode :
+    public AnchorStreamingErodeDilate<TImage, TKernel, std::less<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType> >
+
+{
+public:
+  typedef AnchorStreamingErode Self;
+  typedef AnchorStreamingErodeDilate<TImage, TKernel, std::less<typename TImage::PixelType>, std::less_equal<typename TImage::PixelType> > Superclass;
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorStreamingErode, 
+               AnchorStreamingErodeDilate);
+
+  typedef SmartPointer<Self>   Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  virtual ~AnchorStreamingErode() {}
+protected:
+  AnchorStreamingErode(){}
+  void PrintSelf(std::ostream& os, Indent indent) const
+  {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Streaming anchor erosion" << std::endl;
+  }
+
+private:
+  
+  AnchorStreamingErode(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef __itkAnchorStreamingErodeDilate_h
+#define __itkAnchorStreamingErodeDilate_h
+
+#include "itkObject.h"
+#include "itkAnchorErodeDilateImageFilter.h"
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class AnchorStreamingErodeDilate
+ * \brief erosions and dilations over space and the last frames of a
+ * stream of images.
+ *
+ * Each frame pushed is first eroded or dilated by the spatial kernel,
+ * using the anchor filter, and kept in a ring buffer of the last
+ * NumberOfFrames results. The result of a push is the extreme, for
+ * each pixel, of the frames in the ring, which is the erosion or
+ * dilation by the product of the spatial kernel and a line of
+ * NumberOfFrames pixels along time, ending at the new frame.
+ *
+ * The temporal line is computed with a monotonic wedge per pixel: the
+ * frames that can still become the extreme are kept in order, so a
+ * push costs O(1) amortized per pixel whatever the number of
+ * frames. The wedges hold the slots of the frames in the ring, in
+ * the smallest type that can index it. Only the spatial passes of the
+ * new frame are computed, straight into its slot of the ring.
+ *
+ * Before NumberOfFrames frames have been pushed, the result is
+ * computed from the frames available, as at the border of an
+ * image. Without a kernel, only the temporal part is done.
+ *
+ * Should be instantiated with the same functions as
+ * AnchorErodeDilateImageFilter, or through AnchorStreamingErode and
+ * AnchorStreamingDilate.
+**/
+template<class TImage, class TKernel,
+	 class TFunction1, class TFunction2>
+class ITK_EXPORT AnchorStreamingErodeDilate : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorStreamingErodeDilate Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer<Self>         Pointer;
+  typedef SmartPointer<const Self>   ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorStreamingErodeDilate, Object);
+
+  typedef TKernel KernelType;
+  typedef TImage ImageType;
+  typedef typename ImageType::Pointer         ImagePointer;
+  typedef typename ImageType::ConstPointer    ImageConstPointer;
+  typedef typename ImageType::RegionType      RegionType;
+  typedef typename ImageType::PixelType       PixelType;
+
+  typedef AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2> SpatialFilterType;
+
+  /** The spatial structuring element. Clears the frames pushed so
+   * far, which were computed with the previous one. */
+  void SetKernel( const KernelType& kernel )
+  {
+    m_Spatial->SetKernel(kernel);
+    m_KernelSet = true;
+    this->Reset();
+    this->Modified();
+  }
+
+  /** The number of frames, including the new one, that the result
+   * is computed from. Clears the frames pushed so far. Default is 1. */
+  void SetNumberOfFrames(unsigned int frames);
+  itkGetConstMacro(NumberOfFrames, unsigned int);
+
+  /** The number of frames pushed since the last reset */
+  itkGetConstMacro(FrameCount, unsigned long);
+
+  /** Add a frame to the stream and return the result ending with
+   * it. All the frames must have the same buffered region. The
+   * returned image is new for each push. */
+  ImagePointer PushFrame(const ImageType *frame);
+
+  /** Forget the frames pushed so far */
+  void Reset();
+
+protected:
+  AnchorStreamingErodeDilate();
+  ~AnchorStreamingErodeDilate() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+private:
+  AnchorStreamingErodeDilate(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  typename SpatialFilterType::Pointer m_Spatial;
+  bool m_KernelSet;
+  unsigned int m_NumberOfFrames;
+  unsigned long m_FrameCount;
+  RegionType m_Region;
+
+  // update the wedge of every pixel with the frame in slot, and write
+  // the extremes to out
+  template <class TSlot>
+  void PushWedges(TSlot * wedges, const std::vector<const PixelType *> &buffers,
+		  unsigned int slot, PixelType * out);
+
+  // the last spatial results, frame f being in m_Frames[f % m_NumberOfFrames]
+  std::vector<ImagePointer> m_Frames;
+
+  // for each pixel, the start and the size of its wedge followed by a
+  // ring of m_NumberOfFrames slots of m_Frames, oldest first, all of
+  // m_SlotSize bytes
+  std::vector<unsigned char> m_Wedges;
+  unsigned int m_SlotSize;
+
+  TFunction1 m_TF1;
+
+} ; // end of class
+
+
+} // end namespace itk
+
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorStreamingErodeDilate.txx"
+#endif
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef __itkAnchorStreamingErodeDilate_txx
+#define __itkAnchorStreamingErodeDilate_txx
+
+#include "itkAnchorStreamingErodeDilate.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+namespace itk {
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+AnchorStreamingErodeDilate<TImage, TKernel, TFunction1, TFunction2>
+::AnchorStreamingErodeDilate()
+{
+  m_Spatial = SpatialFilterType::New();
+  m_KernelSet = false;
+  m_NumberOfFrames = 1;
+  m_FrameCount = 0;
+  m_SlotSize = 1;
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorStreamingErodeDilate<TImage, TKernel, TFunction1, TFunction2>
+::SetNumberOfFrames(unsigned int frames)
+{
+  if (frames < 1)
+    {
+    frames = 1;
+    }
+  if (frames != m_NumberOfFrames)
+    {
+    m_NumberOfFrames = frames;
+    this->Reset();
+    this->Modified();
+    }
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorStreamingErodeDilate<TImage, TKernel, TFunction1, TFunction2>
+::Reset()
+{
+  m_FrameCount = 0;
+  m_Frames.clear();
+  m_Wedges.clear();
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+typename AnchorStreamingErodeDilate<TImage, TKernel, TFunction1, TFunction2>::ImagePointer
+AnchorStreamingErodeDilate<TImage, TKernel, TFunction1, TFunction2>
+::PushFrame(const ImageType *frame)
+{
+  if (!frame)
+    {
+    itkExceptionMacro("No frame");
+    }
+  const unsigned int T = m_NumberOfFrames;
+  if (m_FrameCount == 0)
+    {
+    m_Region = frame->GetBufferedRegion();
+    m_Frames.assign(T, ImagePointer());
+    // the start and the size of a wedge go up to T
+    m_SlotSize = (T <= 0xff) ? 1 : ((T <= 0xffff) ? 2 : 4);
+    m_Wedges.assign(m_Region.GetNumberOfPixels() * (T + 2) * m_SlotSize, 0);
+    }
+  else if (frame->GetBufferedRegion() != m_Region)
+    {
+    itkExceptionMacro("Frame region " << frame->GetBufferedRegion() << " differs from the region of the stream " << m_Region);
+    }
+
+  // the new frame takes the place of the one leaving the window
+  const unsigned int slot = m_FrameCount % T;
+  ImagePointer current = m_Frames[slot];
+  if (!current)
+    {
+    current = ImageType::New();
+    current->SetRegions(m_Region);
+    current->Allocate();
+    m_Frames[slot] = current;
+    }
+  current->CopyInformation(frame);
+  if (m_KernelSet)
+    {
+    // the spatial result is written in the slot. The frame may be the
+    // same image as before, with new contents.
+    m_Spatial->SetInput(frame);
+    m_Spatial->GraftOutput(current);
+    m_Spatial->Modified();
+    m_Spatial->Update();
+    current->Graft(m_Spatial->GetOutput());
+    }
+  else
+    {
+    // the caller may reuse the frame
+    ImageRegionConstIterator<ImageType> inIt(frame, m_Region);
+    ImageRegionIterator<ImageType> curIt(current, m_Region);
+    for (inIt.GoToBegin(), curIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++curIt)
+      {
+      curIt.Set(inIt.Get());
+      }
+    }
+
+  ImagePointer result = ImageType::New();
+  result->CopyInformation(frame);
+  result->SetRegions(m_Region);
+  result->Allocate();
+
+  std::vector<const PixelType *> buffers(T);
+  for (unsigned f = 0; f < T; f++)
+    {
+    buffers[f] = m_Frames[f] ? m_Frames[f]->GetBufferPointer() : 0;
+    }
+  switch (m_SlotSize)
+    {
+    case 1:
+      this->PushWedges((unsigned char *)&(m_Wedges[0]), buffers, slot, result->GetBufferPointer());
+      break;
+    case 2:
+      this->PushWedges((unsigned short *)&(m_Wedges[0]), buffers, slot, result->GetBufferPointer());
+      break;
+    default:
+      this->PushWedges((unsigned int *)&(m_Wedges[0]), buffers, slot, result->GetBufferPointer());
+    }
+  ++m_FrameCount;
+  return result;
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+template <class TSlot>
+void
+AnchorStreamingErodeDilate<TImage, TKernel, TFunction1, TFunction2>
+::PushWedges(TSlot * wedges, const std::vector<const PixelType *> &buffers,
+	     unsigned int slot, PixelType * out)
+{
+  const unsigned int T = m_NumberOfFrames;
+  const PixelType * newest = buffers[slot];
+  const unsigned long pixels = m_Region.GetNumberOfPixels();
+  for (unsigned long p = 0; p < pixels; p++, wedges += T + 2)
+    {
+    unsigned int start = wedges[0];
+    unsigned int size = wedges[1];
+    TSlot * ring = wedges + 2;
+    // the frame leaving the window is the only one in the slot of the
+    // new frame - frames are pushed one at a time, and the oldest is
+    // at the start
+    if (size && (ring[start] == slot))
+      {
+      start = (start + 1) % T;
+      --size;
+      }
+    // frames that are not more extreme than the new one can't be the
+    // extreme of any later window
+    const PixelType v = newest[p];
+    while (size)
+      {
+      unsigned int last = ring[(start + size - 1) % T];
+      if (m_TF1(buffers[last][p], v))
+	{
+	break;
+	}
+      --size;
+      }
+    ring[(start + size) % T] = slot;
+    ++size;
+    out[p] = buffers[ring[start]][p];
+    wedges[0] = start;
+    wedges[1] = size;
+    }
+}
+
+template<class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorStreamingErodeDilate<TImage, TKernel, TFunction1, TFunction2>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfFrames: " << m_NumberOfFrames << std::endl;
+  os << indent << "FrameCount: " << m_FrameCount << std::endl;
+  os << indent << "KernelSet: " << m_KernelSet << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef __itkAnchorStridedMorphology_h
+#define __itkAnchorStridedMorphology_h
+
+#include "itkObject.h"
+#include "itkImage.h"
+#include "itkAnchorErodeDilateLine.h"
+#include "itkAnchorOpenCloseLine.h"
+#include "itkBresenhamLine.h"
+#include "itkAnchorUtilities.h"
+#include "itkFlatStructuringElement.h"
+#include <functional>
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class AnchorStridedMorphology
+ * \brief anchor erosions, dilations, openings and closings of raw
+ * buffers.
+ *
+ * A low level entry point for callers that already own the pixels,
+ * like NumPy arrays, which may be views with any strides. The buffer
+ * is described by its size and by the stride, in bytes, of each
+ * dimension, dimension 0 being the one of the lines of an ITK
+ * image. Strides may be negative. The lines are gathered from and
+ * scattered to the buffers with the strides, without making an image.
+ *
+ * The output may be the input buffer, for an in place computation,
+ * or another buffer of the same size with its own strides. The
+ * results are the same as with the anchor image filters. A kernel
+ * without lines, such as a box of radius 0, copies the input.
+**/
+template<class TPixel, unsigned int VDimension>
+class ITK_EXPORT AnchorStridedMorphology : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorStridedMorphology  Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer<Self>       Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorStridedMorphology, Object);
+
+  itkStaticConstMacro(ImageDimension, unsigned int, VDimension);
+
+  typedef TPixel PixelType;
+  typedef FlatStructuringElement<VDimension> KernelType;
+  typedef Size<VDimension>   SizeType;
+  typedef Offset<VDimension> StrideType;
+
+  typedef enum {ERODE, DILATE, OPEN, CLOSE} OperationType;
+
+  void SetKernel( const KernelType& kernel )
+  {
+    m_Kernel=kernel;
+    m_KernelSet = true;
+    this->Modified();
+  }
+
+  /** The operation done by Run. Default is ERODE. */
+  itkSetMacro(Operation, OperationType);
+  itkGetConstMacro(Operation, OperationType);
+
+  /** Compute the operation on the buffer of the given size starting
+   * at input, and write the result to output. The strides are in
+   * bytes. */
+  void Run(const PixelType * input, const StrideType &inputStrides,
+	   PixelType * output, const StrideType &outputStrides,
+	   const SizeType &size);
+
+protected:
+  AnchorStridedMorphology();
+  ~AnchorStridedMorphology() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+private:
+  AnchorStridedMorphology(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  // only used for its types, by the utilities
+  typedef Image<PixelType, VDimension> ImageType;
+  typedef typename ImageType::RegionType RegionType;
+  typedef typename ImageType::IndexType IndexType;
+  typedef BresenhamLine<VDimension> BresType;
+  typedef typename KernelType::LType LineType;
+
+  typedef AnchorErodeDilateLine<PixelType, std::less<PixelType>, std::less_equal<PixelType> > ErodeLineType;
+  typedef AnchorErodeDilateLine<PixelType, std::greater<PixelType>, std::greater_equal<PixelType> > DilateLineType;
+  typedef AnchorOpenCloseLine<PixelType, std::less<PixelType>, std::greater_equal<PixelType>, std::less_equal<PixelType> > OpenLineType;
+  typedef AnchorOpenCloseLine<PixelType, std::greater<PixelType>, std::less_equal<PixelType>, std::greater_equal<PixelType> > CloseLineType;
+
+  // sweep one line of the decomposition from source to output, then
+  // make the output the source of the next pass
+  template <class TAnchor>
+  void doStridedPass(TAnchor &AnchorLine, const LineType line,
+		     const unsigned int period,
+		     const RegionType AllImage, unsigned int bufflength,
+		     PixelType * inbuffer, PixelType * outbuffer,
+		     const char * &source, StrideType &sourceStrides,
+		     char * output, const StrideType &outputStrides);
+
+  // the anchor lines don't all have the same interface
+  template <class TFunction1, class TFunction2>
+  PixelType * doLine(AnchorErodeDilateLine<PixelType, TFunction1, TFunction2> &AnchorLine,
+		     PixelType * inbuffer, PixelType * outbuffer, unsigned len)
+  {
+    AnchorLine.doLine(outbuffer, inbuffer, len);
+    return outbuffer;
+  }
+  template <class THistogramCompare, class TFunction1, class TFunction2>
+  PixelType * doLine(AnchorOpenCloseLine<PixelType, THistogramCompare, TFunction1, TFunction2> &AnchorLine,
+		     PixelType * inbuffer, PixelType *, unsigned len)
+  {
+    AnchorLine.doLine(inbuffer, len);
+    return inbuffer;
+  }
+
+  KernelType m_Kernel;
+  bool m_KernelSet;
+  OperationType m_Operation;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorStridedMorphology.txx"
+#endif
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef __itkAnchorStridedMorphology_txx
+#define __itkAnchorStridedMorphology_txx
+
+#include "itkAnchorStridedMorphology.h"
+
+namespace itk {
+
+template <class TPixel, unsigned int VDimension>
+AnchorStridedMorphology<TPixel, VDimension>
+::AnchorStridedMorphology()
+{
+  m_KernelSet = false;
+  m_Operation = ERODE;
+}
+
+template <class TPixel, unsigned int VDimension>
+void
+AnchorStridedMorphology<TPixel, VDimension>
+::Run(const PixelType * input, const StrideType &inputStrides,
+      PixelType * output, const StrideType &outputStrides,
+      const SizeType &size)
+{
+  if (!m_KernelSet)
+    {
+    itkExceptionMacro("No kernel set");
+    }
+  if (!m_Kernel.GetDecomposable())
+    {
+    itkExceptionMacro("Anchor morphology only works with decomposable structuring elements");
+    }
+  if (!input || !output)
+    {
+    itkExceptionMacro("No buffer");
+    }
+
+  RegionType AllImage;
+  AllImage.SetSize(size);
+  if (AllImage.GetNumberOfPixels() == 0)
+    {
+    return;
+    }
+  // maximum buffer length is sum of dimensions
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<VDimension; i++)
+    {
+    bufflength += size[i];
+    }
+  const char * source = reinterpret_cast<const char *>(input);
+  StrideType sourceStrides = inputStrides;
+  char * dest = reinterpret_cast<char *>(output);
+
+  typename KernelType::DecompType decomposition = m_Kernel.GetLines();
+  if (decomposition.empty())
+    {
+    // the kernel is a single pixel
+    if ((source == dest) && (inputStrides == outputStrides))
+      {
+      return;
+      }
+    IndexType Ind = AllImage.GetIndex();
+    const unsigned long pixels = AllImage.GetNumberOfPixels();
+    for (unsigned long p = 0; p < pixels; p++)
+      {
+      long sourceStart = 0, outputStart = 0;
+      for (unsigned d = 0; d < VDimension; d++)
+	{
+	sourceStart += Ind[d] * inputStrides[d];
+	outputStart += Ind[d] * outputStrides[d];
+	}
+      *reinterpret_cast<PixelType *>(dest + outputStart) = *reinterpret_cast<const PixelType *>(source + sourceStart);
+      for (unsigned d = 0; d < VDimension; d++)
+	{
+	if (++Ind[d] < (long)size[d])
+	  {
+	  break;
+	  }
+	Ind[d] = 0;
+	}
+      }
+    return;
+    }
+  std::vector<PixelType> inbuffer(bufflength);
+  std::vector<PixelType> outbuffer(bufflength);
+  PixelType * in = &(inbuffer[0]);
+  PixelType * out = &(outbuffer[0]);
+
+  ErodeLineType ErodeLine;
+  DilateLineType DilateLine;
+  const int last = (int)decomposition.size() - 1;
+  switch (m_Operation)
+    {
+    case ERODE:
+      for (int i = 0; i <= last; i++)
+	{
+	doStridedPass(ErodeLine, decomposition[i], m_Kernel.GetPeriod(i), AllImage, bufflength, in, out, source, sourceStrides, dest, outputStrides);
+	}
+      break;
+    case DILATE:
+      for (int i = 0; i <= last; i++)
+	{
+	doStridedPass(DilateLine, decomposition[i], m_Kernel.GetPeriod(i), AllImage, bufflength, in, out, source, sourceStrides, dest, outputStrides);
+	}
+      break;
+    case OPEN:
+      {
+      // the same chain as AnchorOpenCloseImageFilter
+      OpenLineType OpenLine;
+      for (int i = 0; i < last; i++)
+	{
+	doStridedPass(ErodeLine, decomposition[i], m_Kernel.GetPeriod(i), AllImage, bufflength, in, out, source, sourceStrides, dest, outputStrides);
+	}
+      doStridedPass(OpenLine, decomposition[last], m_Kernel.GetPeriod(last), AllImage, bufflength, in, out, source, sourceStrides, dest, outputStrides);
+      for (int i = last - 1; i >= 0; --i)
+	{
+	doStridedPass(DilateLine, decomposition[i], m_Kernel.GetPeriod(i), AllImage, bufflength, in, out, source, sourceStrides, dest, outputStrides);
+	}
+      }
+      break;
+    case CLOSE:
+      {
+      CloseLineType CloseLine;
+      for (int i = 0; i < last; i++)
+	{
+	doStridedPass(DilateLine, decomposition[i], m_Kernel.GetPeriod(i), AllImage, bufflength, in, out, source, sourceStrides, dest, outputStrides);
+	}
+      doStridedPass(CloseLine, decomposition[last], m_Kernel.GetPeriod(last), AllImage, bufflength, in, out, source, sourceStrides, dest, outputStrides);
+      for (int i = last - 1; i >= 0; --i)
+	{
+	doStridedPass(ErodeLine, decomposition[i], m_Kernel.GetPeriod(i), AllImage, bufflength, in, out, source, sourceStrides, dest, outputStrides);
+	}
+      }
+      break;
+    }
+}
+
+template <class TPixel, unsigned int VDimension>
+template <class TAnchor>
+void
+AnchorStridedMorphology<TPixel, VDimension>
+::doStridedPass(TAnchor &AnchorLine, const LineType line,
+		const unsigned int period,
+		const RegionType AllImage, unsigned int bufflength,
+		PixelType * inbuffer, PixelType * outbuffer,
+		const char * &source, StrideType &sourceStrides,
+		char * output, const StrideType &outputStrides)
+{
+  typename BresType::OffsetArray LineOffsets = mkLineOffsets<BresType, LineType>(line, period, bufflength);
+  unsigned int SELength = getLinePixels<LineType>(line);
+  // want lines to be odd
+  if (!(SELength%2))
+    ++SELength;
+  AnchorLine.SetSize(SELength);
+  AnchorLine.SetPeriod(period);
+
+  // the byte offsets of the line in both buffers
+  std::vector<long> sourceOffsets(LineOffsets.size());
+  std::vector<long> outputOffsets(LineOffsets.size());
+  for (unsigned k = 0; k < LineOffsets.size(); k++)
+    {
+    sourceOffsets[k] = 0;
+    outputOffsets[k] = 0;
+    for (unsigned d = 0; d < VDimension; d++)
+      {
+      sourceOffsets[k] += LineOffsets[k][d] * sourceStrides[d];
+      outputOffsets[k] += LineOffsets[k][d] * outputStrides[d];
+      }
+    }
+
+  RegionType face = mkEnlargedFace<ImageType, LineType>(AllImage, line);
+  LineType NormLine = line;
+  NormLine.Normalize();
+  // set a generous tolerance
+  float tol = 1.0/LineOffsets.size();
+
+  // iterate over the face
+  IndexType Ind = face.GetIndex();
+  unsigned long facePixels = face.GetNumberOfPixels();
+  for (unsigned long p = 0; p < facePixels; p++)
+    {
+    unsigned start, end;
+    if (computeStartEnd<ImageType, BresType, LineType>(Ind, NormLine, tol, LineOffsets,
+						       AllImage, start, end))
+      {
+      long sourceStart = 0, outputStart = 0;
+      for (unsigned d = 0; d < VDimension; d++)
+	{
+	sourceStart += Ind[d] * sourceStrides[d];
+	outputStart += Ind[d] * outputStrides[d];
+	}
+      unsigned len = end - start + 1;
+      for (unsigned i = 0; i < len; i++)
+	{
+	inbuffer[i] = *reinterpret_cast<const PixelType *>(source + sourceStart + sourceOffsets[start + i]);
+	}
+      PixelType * result = this->doLine(AnchorLine, inbuffer, outbuffer, len);
+      for (unsigned i = 0; i < len; i++)
+	{
+	*reinterpret_cast<PixelType *>(output + outputStart + outputOffsets[start + i]) = result[i];
+	}
+      }
+    // next index of the face
+    for (unsigned d = 0; d < VDimension; d++)
+      {
+      if (++Ind[d] < face.GetIndex()[d] + (long)face.GetSize()[d])
+	{
+	break;
+	}
+      Ind[d] = face.GetIndex()[d];
+      }
+    }
+  // after the first pass the input will be taken from the output
+  source = output;
+  sourceStrides = outputStrides;
+}
+
+template<class TPixel, unsigned int VDimension>
+void
+AnchorStridedMorphology<TPixel, VDimension>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Operation: " << m_Operation << std::endl;
+  os << indent << "KernelSet: " << m_KernelSet << std::endl;
+}
+
+} // end namespace itk
+
+#endif
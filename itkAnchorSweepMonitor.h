@@ -0,0 +1,105 @@
+#ifndef __itkAnchorSweepMonitor_h
+#define __itkAnchorSweepMonitor_h
+
+#include "itkProcessObject.h"
+
+namespace itk {
+
+/**
+ * \class AnchorSweepMonitor
+ * \brief progress reports and abort checks during the sweep of a
+ * face.
+ *
+ * The sweeps count the pixels of the lines they compute. Every
+ * PixelsPerCheck pixels, which is a few microseconds of work,
+ * the monitor checks whether the filter was asked to abort and, in
+ * thread 0 only, updates the progress of the filter if it moved by at
+ * least a thousandth. Reporting once per pass is too coarse for the
+ * few passes of a large 3D image.
+**/
+class AnchorSweepMonitor
+{
+public:
+  /** Report the progress of filter from start to start + weight over
+   * the given number of pixels. */
+  AnchorSweepMonitor(ProcessObject * filter, int threadId, double pixels,
+		     float start = 0.0f, float weight = 1.0f)
+  {
+    m_Filter = filter;
+    m_ThreadId = threadId;
+    m_Total = pixels > 0 ? pixels : 1;
+    m_Done = 0;
+    m_Pending = 0;
+    m_Start = start;
+    m_Weight = weight;
+    m_Reported = start;
+    m_Aborted = false;
+  }
+
+  /** The progress reaches the end when the sweep wasn't aborted */
+  ~AnchorSweepMonitor()
+  {
+    if ((m_ThreadId == 0) && !m_Aborted)
+      {
+      m_Filter->UpdateProgress(m_Start + m_Weight);
+      }
+  }
+
+  /** Count the pixels of a line. Returns false if the filter has been
+   * asked to abort. */
+  bool Completed(unsigned long pixels)
+  {
+    m_Pending += pixels;
+    if (m_Pending < PixelsPerCheck)
+      {
+      return !m_Aborted;
+      }
+    return this->Check();
+  }
+
+  /** Check now */
+  bool Check()
+  {
+    m_Done += m_Pending;
+    m_Pending = 0;
+    if (m_Filter->GetAbortGenerateData())
+      {
+      m_Aborted = true;
+      return false;
+      }
+    if (m_ThreadId == 0)
+      {
+      double done = m_Done < m_Total ? m_Done : m_Total;
+      float p = m_Start + m_Weight * (float)(done / m_Total);
+      if (p - m_Reported >= 0.001f)
+	{
+	m_Filter->UpdateProgress(p);
+	m_Reported = p;
+	}
+      }
+    return true;
+  }
+
+  bool GetAborted() const
+  {
+    return m_Aborted;
+  }
+
+  itkStaticConstMacro(PixelsPerCheck, unsigned long, 4096);
+
+private:
+  typedef AnchorSweepMonitor Self;
+  ProcessObject * m_Filter;
+  int m_ThreadId;
+  double m_Total;
+  double m_Done;
+  unsigned long m_Pending;
+  float m_Start;
+  float m_Weight;
+  float m_Reported;
+  bool m_Aborted;
+};
+
+} // namespace itk
+
+#endif
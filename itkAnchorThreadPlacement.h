@@ -0,0 +1,227 @@
+#ifndef __itkAnchorThreadPlacement_h
+#define __itkAnchorThreadPlacement_h
+
+#include "itkMultiThreader.h"
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+namespace itk {
+
+/**
+ * \class AnchorThreadPlacement
+ * \brief where the threads of a sweep run and where the pages of
+ * the images they sweep are placed, for NUMA machines.
+ *
+ * Linux puts a page on the node of the thread that touches it
+ * first. An output allocated and filled by one thread is all on one
+ * node, and the threads of the other nodes pay remote accesses for
+ * every pixel of their lines. allocateFirstTouch lets each thread
+ * of the sweep touch first a slab of the image along an axis. The
+ * accesses of a thread stay on its node when it sweeps that slab, as
+ * in the batches of slices; lines crossing the slabs still reach the
+ * other nodes, but the load is spread over all of them.
+ *
+ * The threads can also be pinned to a list of CPUs, given as for
+ * taskset, e.g. "0-7,16-23": thread i runs on the i-th CPU of the
+ * list, modulo its length. Pinning keeps a thread on the node of its
+ * pages.
+ *
+ * Both are no-ops where they can't help: first touch on hosts with a
+ * single node, and pinning on other systems than Linux.
+**/
+class AnchorThreadPlacement
+{
+public:
+  AnchorThreadPlacement() {}
+
+  /** Parse a list of CPUs such as "0-7,16-23". Returns false, and
+   * leaves the threads unpinned, if the list can't be parsed. An
+   * empty list unpins them. */
+  bool SetCPUList(const std::string &list)
+  {
+    m_CPUList = list;
+    m_CPUs.clear();
+    if (!list.empty() && (list[list.size() - 1] == ','))
+      {
+      return false;
+      }
+    std::string::size_type pos = 0;
+    while (pos < list.size())
+      {
+      std::string::size_type comma = list.find(',', pos);
+      if (comma == std::string::npos)
+	{
+	comma = list.size();
+	}
+      std::string range = list.substr(pos, comma - pos);
+      std::string::size_type dash = range.find('-');
+      char * end;
+      long first = strtol(range.c_str(), &end, 10);
+      long last = first;
+      if ((end == range.c_str()) || 
+	  ((dash == std::string::npos) && (*end != 0)))
+	{
+	m_CPUs.clear();
+	return false;
+	}
+      if (dash != std::string::npos)
+	{
+	const char * second = range.c_str() + dash + 1;
+	last = strtol(second, &end, 10);
+	if ((end == second) || (*end != 0))
+	  {
+	  m_CPUs.clear();
+	  return false;
+	  }
+	}
+      if ((first < 0) || (last < first))
+	{
+	m_CPUs.clear();
+	return false;
+	}
+      for (long c = first; c <= last; c++)
+	{
+	m_CPUs.push_back((int)c);
+	}
+      pos = comma + 1;
+      }
+    return true;
+  }
+  const std::string & GetCPUList() const
+  {
+    return m_CPUList;
+  }
+  const std::vector<int> & GetCPUs() const
+  {
+    return m_CPUs;
+  }
+
+  /** The number of NUMA nodes of the host, 1 if it can't be told. A
+   * positive value given to SetNumberOfNodes is returned instead, so
+   * that the placement can be tested on a host with a single node. */
+  static unsigned int GetNumberOfNodes()
+  {
+    if (NodesOverride() > 0)
+      {
+      return NodesOverride();
+      }
+    unsigned int nodes = 0;
+#if defined(__linux__)
+    DIR * dir = opendir("/sys/devices/system/node");
+    if (dir)
+      {
+      struct dirent * entry;
+      while ((entry = readdir(dir)) != 0)
+	{
+	if ((strncmp(entry->d_name, "node", 4) == 0) &&
+	    (entry->d_name[4] >= '0') && (entry->d_name[4] <= '9'))
+	  {
+	  ++nodes;
+	  }
+	}
+      closedir(dir);
+      }
+#endif
+    return nodes > 0 ? nodes : 1;
+  }
+  static void SetNumberOfNodes(unsigned int nodes)
+  {
+    NodesOverride() = nodes;
+  }
+
+private:
+  static unsigned int & NodesOverride()
+  {
+    static unsigned int nodes = 0;
+    return nodes;
+  }
+
+  std::string m_CPUList;
+  std::vector<int> m_CPUs;
+};
+
+/**
+ * \class AnchorPinnedThread
+ * \brief pins the calling thread to its CPU of a placement for its
+ * lifetime. The affinity the thread had is given back on
+ * destruction, as thread 0 of a MultiThreader is the caller's own
+ * thread.
+**/
+class AnchorPinnedThread
+{
+public:
+  AnchorPinnedThread(const AnchorThreadPlacement &placement, int threadId)
+  {
+    m_Pinned = false;
+#if defined(__linux__)
+    const std::vector<int> & cpus = placement.GetCPUs();
+    if (cpus.empty() || (cpus[threadId % cpus.size()] >= CPU_SETSIZE))
+      {
+      return;
+      }
+    if (sched_getaffinity(0, sizeof(m_Saved), &m_Saved) != 0)
+      {
+      return;
+      }
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpus[threadId % cpus.size()], &mask);
+    // a CPU that isn't online is ignored
+    m_Pinned = (sched_setaffinity(0, sizeof(mask), &mask) == 0);
+#endif
+  }
+
+  ~AnchorPinnedThread()
+  {
+#if defined(__linux__)
+    if (m_Pinned)
+      {
+      sched_setaffinity(0, sizeof(m_Saved), &m_Saved);
+      }
+#endif
+  }
+
+  bool GetPinned() const
+  {
+    return m_Pinned;
+  }
+
+private:
+  AnchorPinnedThread(const AnchorPinnedThread&); //purposely not implemented
+  void operator=(const AnchorPinnedThread&); //purposely not implemented
+
+  bool m_Pinned;
+#if defined(__linux__)
+  cpu_set_t m_Saved;
+#endif
+};
+
+// The slab of region along axis swept by thread threadId of threads,
+// which is the part of the image it touches first.
+template <class TRegion>
+TRegion getThreadSlab(const TRegion region, const unsigned int axis,
+		      const unsigned int threadId, const unsigned int threads);
+
+// Set the buffered region of image to its requested region and
+// allocate it. With more than one NUMA node, the buffer is a new one,
+// whose pages are first touched by the threads of threader, each
+// writing zeros in its slab along axis while running on its CPU of
+// placement. Otherwise it is a plain Allocate.
+template <class TImage>
+void allocateFirstTouch(TImage * image, const unsigned int axis,
+			MultiThreader * threader,
+			const AnchorThreadPlacement &placement);
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorThreadPlacement.txx"
+#endif
+
+#endif
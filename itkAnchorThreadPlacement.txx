@@ -0,0 +1,81 @@
+#ifndef __itkAnchorThreadPlacement_txx
+#define __itkAnchorThreadPlacement_txx
+
+#include "itkAnchorThreadPlacement.h"
+#include "itkImageRegionIterator.h"
+#include "itkNumericTraits.h"
+
+namespace itk {
+
+template <class TRegion>
+TRegion getThreadSlab(const TRegion region, const unsigned int axis,
+		      const unsigned int threadId, const unsigned int threads)
+{
+  // the split of the slices between the threads of the batch mode
+  TRegion slab = region;
+  unsigned long slices = region.GetSize()[axis];
+  unsigned long first = (slices * threadId) / threads;
+  unsigned long last = (slices * (threadId + 1)) / threads;
+  slab.SetIndex(axis, region.GetIndex()[axis] + first);
+  slab.SetSize(axis, last - first);
+  return slab;
+}
+
+template <class TImage>
+struct AnchorFirstTouchStruct
+{
+  TImage * Image;
+  unsigned int Axis;
+  const AnchorThreadPlacement * Placement;
+};
+
+template <class TImage>
+ITK_THREAD_RETURN_TYPE
+anchorFirstTouchCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+  AnchorFirstTouchStruct<TImage> * str = (AnchorFirstTouchStruct<TImage> *)(info->UserData);
+  AnchorPinnedThread pin(*(str->Placement), info->ThreadID);
+  typename TImage::RegionType slab = getThreadSlab(str->Image->GetBufferedRegion(), str->Axis,
+						   info->ThreadID, info->NumberOfThreads);
+  if (slab.GetNumberOfPixels() == 0)
+    {
+    return ITK_THREAD_RETURN_VALUE;
+    }
+  ImageRegionIterator<TImage> it(str->Image, slab);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    it.Set(NumericTraits<typename TImage::PixelType>::Zero);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TImage>
+void allocateFirstTouch(TImage * image, const unsigned int axis,
+			MultiThreader * threader,
+			const AnchorThreadPlacement &placement)
+{
+  image->SetBufferedRegion(image->GetRequestedRegion());
+  if ((AnchorThreadPlacement::GetNumberOfNodes() < 2) || (threader->GetNumberOfThreads() < 2))
+    {
+    image->Allocate();
+    return;
+    }
+  // a new array isn't touched by new, and a large one is fresh pages
+  // from the system, so the threads are the first to touch it
+  unsigned long pixels = image->GetBufferedRegion().GetNumberOfPixels();
+  typename TImage::PixelContainerPointer container = TImage::PixelContainer::New();
+  container->SetImportPointer(new typename TImage::PixelType[pixels], pixels, true);
+  image->SetPixelContainer(container);
+
+  AnchorFirstTouchStruct<TImage> str;
+  str.Image = image;
+  str.Axis = axis;
+  str.Placement = &placement;
+  threader->SetSingleMethod(anchorFirstTouchCallback<TImage>, &str);
+  threader->SingleMethodExecute();
+}
+
+} // namespace itk
+
+#endif
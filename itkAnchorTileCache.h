@@ -0,0 +1,201 @@
+#ifndef __itkAnchorTileCache_h
+#define __itkAnchorTileCache_h
+
+#include "itkObject.h"
+#include "itkMultiThreader.h"
+#include "itkMutexLock.h"
+#include "itkConditionVariable.h"
+#include "itkAnchorErodeDilateLine.h"
+#include "itkAnchorOpenCloseLine.h"
+#include "itkAnchorUtilities.h"
+#include "itkBresenhamLine.h"
+#include <map>
+#include <set>
+#include <list>
+#include <deque>
+#include <vector>
+#include <functional>
+
+namespace itk {
+
+/**
+ * \class AnchorTileCache
+ * \brief computes fixed size tiles of a morphological operation on
+ * demand and keeps the most recently used ones.
+ *
+ * Meant for viewers that only display a part of a large image. A
+ * tile is computed from the input with a halo equal to the reach of
+ * the lines of the decomposition of the kernel, so it is identical
+ * to the same part of the operation applied to the whole
+ * image. Tiles are kept in a cache of bounded size, keyed by tile
+ * index, operation and kernel, and the least recently used tile is
+ * dropped when it is full. When prefetching is on, the neighbours of
+ * a requested tile are computed by a background thread.
+ *
+ * Openings and closings are computed as AnchorOpenImageFilter and
+ * AnchorCloseImageFilter do, with an opening (or a closing) along the
+ * last line between the erosions and the dilations, so that they
+ * match these filters at the edges of the image too.
+ *
+ * The input must be buffered over the region needed by the tiles,
+ * and must not change while the cache is in use. Call SetInput again
+ * after changing it.
+**/
+template<class TImage, class TKernel>
+class ITK_EXPORT AnchorTileCache : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorTileCache           Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorTileCache, Object);
+
+  typedef TKernel KernelType;
+  typedef TImage ImageType;
+  typedef typename ImageType::Pointer         ImagePointer;
+  typedef typename ImageType::ConstPointer    ImageConstPointer;
+  typedef typename ImageType::RegionType      RegionType;
+  typedef typename ImageType::PixelType       PixelType;
+  typedef typename ImageType::IndexType       IndexType;
+  typedef typename ImageType::SizeType        SizeType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  typedef enum { ERODE = 0, DILATE, OPEN, CLOSE } OperationType;
+
+  /** The image the tiles are computed from. Clears the cache. */
+  void SetInput(const ImageType *input);
+
+  /** The size of the tiles. Default is 256 in every dimension. Clears
+   * the cache. */
+  void SetTileSize(const SizeType &size);
+  itkGetConstReferenceMacro(TileSize, SizeType);
+
+  /** The maximum number of tiles kept. Default is 64. */
+  itkSetMacro(MaximumNumberOfTiles, unsigned long);
+  itkGetConstReferenceMacro(MaximumNumberOfTiles, unsigned long);
+
+  /** Compute the neighbours of the requested tiles in a background
+   * thread. On by default. */
+  itkSetMacro(Prefetch, bool);
+  itkGetConstReferenceMacro(Prefetch, bool);
+  itkBooleanMacro(Prefetch);
+
+  /** The number of tiles that have been computed, including the
+   * prefetched ones */
+  itkGetConstMacro(NumberOfComputedTiles, unsigned long);
+
+  /** The region of the image covered by a tile */
+  RegionType GetTileRegion(const IndexType &tile) const;
+
+  /** The tile containing a pixel */
+  IndexType GetTileIndex(const IndexType &pixel) const;
+
+  /** Returns a tile of the result of the operation, computing it if
+   * it isn't in the cache. The buffered region of the returned image
+   * is the region of the tile, and its largest possible region is
+   * that of the input. */
+  ImageConstPointer GetTile(const IndexType &tile,
+			    const KernelType &kernel,
+			    OperationType operation);
+
+  /** The number of tiles currently in the cache */
+  unsigned long GetNumberOfCachedTiles();
+
+  /** Drop all the tiles and pending prefetches */
+  void ClearCache();
+
+protected:
+  AnchorTileCache();
+  ~AnchorTileCache();
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+private:
+  AnchorTileCache(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  typedef BresenhamLine<TImage::ImageDimension> BresType;
+  typedef typename KernelType::LType LineType;
+  typedef AnchorLinePass<TImage, BresType, LineType> PassType;
+  typedef std::vector<PassType> PlanType;
+  // the kernel is identified by its lines
+  typedef std::vector<float> SignatureType;
+
+  typedef AnchorErodeDilateLine<PixelType, std::less<PixelType>, std::less_equal<PixelType> > ErodeLineType;
+  typedef AnchorErodeDilateLine<PixelType, std::greater<PixelType>, std::greater_equal<PixelType> > DilateLineType;
+  typedef AnchorOpenCloseLine<PixelType, std::less<PixelType>, std::greater_equal<PixelType>, std::less_equal<PixelType> > OpenLineType;
+  typedef AnchorOpenCloseLine<PixelType, std::greater<PixelType>, std::less_equal<PixelType>, std::greater_equal<PixelType> > CloseLineType;
+
+  class KeyType
+  {
+  public:
+    IndexType Tile;
+    int Operation;
+    SignatureType Signature;
+    bool operator<(const KeyType &other) const;
+  };
+
+  typedef std::list<KeyType> LRUListType;
+  class EntryType
+  {
+  public:
+    ImagePointer Image;
+    typename LRUListType::iterator Position;
+  };
+  typedef std::map<KeyType, EntryType> TileMapType;
+  typedef std::map<SignatureType, PlanType> PlanMapType;
+
+  // compute a tile - called without the lock
+  ImagePointer ComputeTile(const KeyType &key, const PlanType &plan) const;
+
+  // the region of the input needed by a tile
+  RegionType GetNeededRegion(const KeyType &key, const PlanType &plan) const;
+
+  // the following are called with the lock held
+  const PlanType & GetPlan(const KernelType &kernel, SignatureType &signature);
+  void InsertTile(const KeyType &key, ImagePointer image);
+  void QueueNeighbours(const KeyType &key);
+  void StopPrefetch();
+
+  static ITK_THREAD_RETURN_TYPE PrefetchCallback(void *arg);
+
+  ImageConstPointer m_Input;
+  SizeType m_TileSize;
+  unsigned long m_MaximumNumberOfTiles;
+  bool m_Prefetch;
+  unsigned long m_NumberOfComputedTiles;
+
+  TileMapType m_Tiles;
+  LRUListType m_LRU;
+  PlanMapType m_Plans;
+  std::set<KeyType> m_Pending;
+  std::deque<KeyType> m_Queue;
+
+  SimpleMutexLock m_Mutex;
+  ConditionVariable::Pointer m_WorkCondition;
+  ConditionVariable::Pointer m_DoneCondition;
+  MultiThreader::Pointer m_Threader;
+  int m_ThreadID;
+  bool m_Stop;
+
+} ; // end of class
+
+
+} // end namespace itk
+
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorTileCache.txx"
+#endif
+
+#endif
+
+
@@ -0,0 +1,483 @@
+#ifndef __itkAnchorTileCache_txx
+#define __itkAnchorTileCache_txx
+
+#include "itkAnchorTileCache.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+namespace itk {
+
+template <class TImage, class TKernel>
+bool
+AnchorTileCache<TImage, TKernel>::KeyType
+::operator<(const KeyType &other) const
+{
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    if (Tile[i] != other.Tile[i]) return Tile[i] < other.Tile[i];
+    }
+  if (Operation != other.Operation) return Operation < other.Operation;
+  return Signature < other.Signature;
+}
+
+template <class TImage, class TKernel>
+AnchorTileCache<TImage, TKernel>
+::AnchorTileCache()
+{
+  m_TileSize.Fill(256);
+  m_MaximumNumberOfTiles = 64;
+  m_Prefetch = true;
+  m_NumberOfComputedTiles = 0;
+  m_WorkCondition = ConditionVariable::New();
+  m_DoneCondition = ConditionVariable::New();
+  m_Threader = MultiThreader::New();
+  m_ThreadID = -1;
+  m_Stop = false;
+}
+
+template <class TImage, class TKernel>
+AnchorTileCache<TImage, TKernel>
+::~AnchorTileCache()
+{
+  m_Mutex.Lock();
+  this->StopPrefetch();
+  m_Mutex.Unlock();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorTileCache<TImage, TKernel>
+::StopPrefetch()
+{
+  // the lock is held on entry
+  m_Queue.clear();
+  if (m_ThreadID >= 0)
+    {
+    m_Stop = true;
+    m_WorkCondition->Broadcast();
+    m_Mutex.Unlock();
+    m_Threader->TerminateThread(m_ThreadID);
+    m_Mutex.Lock();
+    m_ThreadID = -1;
+    m_Stop = false;
+    }
+  // wait for the tiles being computed by the caller threads
+  while (!m_Pending.empty())
+    {
+    m_DoneCondition->Wait(&m_Mutex);
+    }
+}
+
+template <class TImage, class TKernel>
+void
+AnchorTileCache<TImage, TKernel>
+::SetInput(const ImageType *input)
+{
+  m_Mutex.Lock();
+  this->StopPrefetch();
+  m_Tiles.clear();
+  m_LRU.clear();
+  m_Plans.clear();
+  m_Input = input;
+  m_Mutex.Unlock();
+  this->Modified();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorTileCache<TImage, TKernel>
+::SetTileSize(const SizeType &size)
+{
+  if (size == m_TileSize)
+    {
+    return;
+    }
+  // the cached tiles, and those being prefetched, have the old
+  // geometry
+  m_Mutex.Lock();
+  this->StopPrefetch();
+  m_Tiles.clear();
+  m_LRU.clear();
+  m_TileSize = size;
+  m_Mutex.Unlock();
+  this->Modified();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorTileCache<TImage, TKernel>
+::ClearCache()
+{
+  m_Mutex.Lock();
+  this->StopPrefetch();
+  m_Tiles.clear();
+  m_LRU.clear();
+  m_Mutex.Unlock();
+}
+
+template <class TImage, class TKernel>
+unsigned long
+AnchorTileCache<TImage, TKernel>
+::GetNumberOfCachedTiles()
+{
+  m_Mutex.Lock();
+  unsigned long result = m_Tiles.size();
+  m_Mutex.Unlock();
+  return result;
+}
+
+template <class TImage, class TKernel>
+typename AnchorTileCache<TImage, TKernel>::RegionType
+AnchorTileCache<TImage, TKernel>
+::GetTileRegion(const IndexType &tile) const
+{
+  RegionType AllImage = m_Input->GetLargestPossibleRegion();
+  IndexType Start;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    Start[i] = AllImage.GetIndex()[i] + tile[i] * (long)m_TileSize[i];
+    }
+  RegionType Region;
+  Region.SetIndex(Start);
+  Region.SetSize(m_TileSize);
+  if (!Region.Crop(AllImage))
+    {
+    SizeType Empty;
+    Empty.Fill(0);
+    Region.SetSize(Empty);
+    }
+  return Region;
+}
+
+template <class TImage, class TKernel>
+typename AnchorTileCache<TImage, TKernel>::IndexType
+AnchorTileCache<TImage, TKernel>
+::GetTileIndex(const IndexType &pixel) const
+{
+  RegionType AllImage = m_Input->GetLargestPossibleRegion();
+  IndexType Tile;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    long P = pixel[i] - AllImage.GetIndex()[i];
+    long T = (long)m_TileSize[i];
+    // round towards minus infinity
+    Tile[i] = (P >= 0) ? P / T : -((-P + T - 1) / T);
+    }
+  return Tile;
+}
+
+template <class TImage, class TKernel>
+const typename AnchorTileCache<TImage, TKernel>::PlanType &
+AnchorTileCache<TImage, TKernel>
+::GetPlan(const KernelType &kernel, SignatureType &signature)
+{
+  const typename KernelType::DecompType &lines = kernel.GetLines();
+  signature.clear();
+  for (unsigned i = 0; i < lines.size(); i++)
+    {
+    for (unsigned j = 0; j < TImage::ImageDimension; j++)
+      {
+      signature.push_back(lines[i][j]);
+      }
+    signature.push_back(kernel.GetPeriod(i));
+    }
+  typename PlanMapType::iterator it = m_Plans.find(signature);
+  if (it != m_Plans.end())
+    {
+    return it->second;
+    }
+  // the lines are those of a sweep of the whole input
+  RegionType AllImage = m_Input->GetLargestPossibleRegion();
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+  PlanType &plan = m_Plans[signature];
+  for (unsigned i = 0; i < lines.size(); i++)
+    {
+    plan.push_back(mkLinePass<TImage, BresType, LineType>(AllImage, lines[i], bufflength, kernel.GetPeriod(i)));
+    }
+  return plan;
+}
+
+template <class TImage, class TKernel>
+typename AnchorTileCache<TImage, TKernel>::RegionType
+AnchorTileCache<TImage, TKernel>
+::GetNeededRegion(const KeyType &key, const PlanType &plan) const
+{
+  SizeType Halo;
+  if ((key.Operation == OPEN) || (key.Operation == CLOSE))
+    {
+    Halo = getOpenTileHalo<TImage, BresType, LineType>(plan);
+    }
+  else
+    {
+    Halo.Fill(0);
+    for (unsigned p = 0; p < plan.size(); p++)
+      {
+      for (unsigned i = 0; i < TImage::ImageDimension; i++)
+	{
+	Halo[i] += plan[p].Reach[i];
+	}
+      }
+    }
+  RegionType Needed = this->GetTileRegion(key.Tile);
+  Needed.PadByRadius(Halo);
+  Needed.Crop(m_Input->GetLargestPossibleRegion());
+  return Needed;
+}
+
+template <class TImage, class TKernel>
+typename AnchorTileCache<TImage, TKernel>::ImagePointer
+AnchorTileCache<TImage, TKernel>
+::ComputeTile(const KeyType &key, const PlanType &plan) const
+{
+  RegionType AllImage = m_Input->GetLargestPossibleRegion();
+  RegionType Core = this->GetTileRegion(key.Tile);
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+
+  ImagePointer result = TImage::New();
+  result->SetRegions(Core);
+  result->SetLargestPossibleRegion(AllImage);
+  result->Allocate();
+
+  if (plan.empty())
+    {
+    ImageRegionConstIterator<TImage> inIt(m_Input, Core);
+    ImageRegionIterator<TImage> outIt(result, Core);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    return result;
+    }
+
+  // the line classes aren't shared, so that tiles can be computed in
+  // several threads
+  ErodeLineType ErodeLine;
+  DilateLineType DilateLine;
+  PixelType * inbuffer = new PixelType[bufflength];
+  PixelType * outbuffer = new PixelType[bufflength];
+  ImagePointer tile = TImage::New();
+  unsigned last = plan.size() - 1;
+
+  if ((key.Operation == ERODE) || (key.Operation == DILATE))
+    {
+    if (key.Operation == ERODE)
+      {
+      doTile<TImage, BresType, ErodeLineType, LineType>(m_Input, result, tile, plan, 0, last,
+							ErodeLine, inbuffer, outbuffer, AllImage, Core);
+      }
+    else
+      {
+      doTile<TImage, BresType, DilateLineType, LineType>(m_Input, result, tile, plan, 0, last,
+							 DilateLine, inbuffer, outbuffer, AllImage, Core);
+      }
+    }
+  else if (key.Operation == OPEN)
+    {
+    OpenLineType OpenLine;
+    doOpenTile<TImage, BresType, ErodeLineType, OpenLineType, DilateLineType, LineType>(m_Input, result, tile, plan,
+											  ErodeLine, OpenLine, DilateLine,
+											  inbuffer, outbuffer, AllImage, Core);
+    }
+  else
+    {
+    CloseLineType CloseLine;
+    doOpenTile<TImage, BresType, DilateLineType, CloseLineType, ErodeLineType, LineType>(m_Input, result, tile, plan,
+											   DilateLine, CloseLine, ErodeLine,
+											   inbuffer, outbuffer, AllImage, Core);
+    }
+  delete [] inbuffer;
+  delete [] outbuffer;
+  return result;
+}
+
+template <class TImage, class TKernel>
+void
+AnchorTileCache<TImage, TKernel>
+::InsertTile(const KeyType &key, ImagePointer image)
+{
+  ++m_NumberOfComputedTiles;
+  m_LRU.push_front(key);
+  EntryType &entry = m_Tiles[key];
+  entry.Image = image;
+  entry.Position = m_LRU.begin();
+  // drop the least recently used tiles
+  while (m_Tiles.size() > m_MaximumNumberOfTiles)
+    {
+    m_Tiles.erase(m_LRU.back());
+    m_LRU.pop_back();
+    }
+}
+
+template <class TImage, class TKernel>
+void
+AnchorTileCache<TImage, TKernel>
+::QueueNeighbours(const KeyType &key)
+{
+  // the 3^D - 1 neighbours of the tile
+  unsigned count = 1;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    count *= 3;
+    }
+  for (unsigned n = 0; n < count; n++)
+    {
+    KeyType neighbour = key;
+    unsigned code = n;
+    bool centre = true;
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      int step = (int)(code % 3) - 1;
+      code /= 3;
+      neighbour.Tile[i] += step;
+      if (step) centre = false;
+      }
+    if (centre) continue;
+    if (this->GetTileRegion(neighbour.Tile).GetNumberOfPixels() == 0) continue;
+    if (m_Tiles.find(neighbour) != m_Tiles.end()) continue;
+    if (m_Pending.find(neighbour) != m_Pending.end()) continue;
+    m_Queue.push_back(neighbour);
+    }
+  // the most recent requests are served first, so drop the oldest
+  // ones when the view moves quickly
+  while (m_Queue.size() > 4 * count)
+    {
+    m_Queue.pop_front();
+    }
+  if (m_ThreadID < 0)
+    {
+    m_ThreadID = m_Threader->SpawnThread(PrefetchCallback, this);
+    }
+  m_WorkCondition->Signal();
+}
+
+template <class TImage, class TKernel>
+ITK_THREAD_RETURN_TYPE
+AnchorTileCache<TImage, TKernel>
+::PrefetchCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+  Self * cache = (Self *)(info->UserData);
+
+  cache->m_Mutex.Lock();
+  for (;;)
+    {
+    while (!cache->m_Stop && cache->m_Queue.empty())
+      {
+      cache->m_WorkCondition->Wait(&cache->m_Mutex);
+      }
+    if (cache->m_Stop) break;
+    KeyType key = cache->m_Queue.back();
+    cache->m_Queue.pop_back();
+    if ((cache->m_Tiles.find(key) != cache->m_Tiles.end()) ||
+	(cache->m_Pending.find(key) != cache->m_Pending.end()))
+      {
+      continue;
+      }
+    // the plans are only removed when this thread has stopped
+    const PlanType &plan = cache->m_Plans[key.Signature];
+    if (!cache->m_Input->GetBufferedRegion().IsInside(cache->GetNeededRegion(key, plan)))
+      {
+      continue;
+      }
+    cache->m_Pending.insert(key);
+    cache->m_Mutex.Unlock();
+    ImagePointer image = cache->ComputeTile(key, plan);
+    cache->m_Mutex.Lock();
+    cache->m_Pending.erase(key);
+    cache->InsertTile(key, image);
+    cache->m_DoneCondition->Broadcast();
+    }
+  cache->m_Mutex.Unlock();
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TImage, class TKernel>
+typename AnchorTileCache<TImage, TKernel>::ImageConstPointer
+AnchorTileCache<TImage, TKernel>
+::GetTile(const IndexType &tile,
+	  const KernelType &kernel,
+	  OperationType operation)
+{
+  if (!m_Input)
+    {
+    itkExceptionMacro("No input set");
+    }
+  if (!kernel.GetDecomposable())
+    {
+    itkExceptionMacro("Anchor morphology only works with decomposable structuring elements");
+    }
+  if (this->GetTileRegion(tile).GetNumberOfPixels() == 0)
+    {
+    itkExceptionMacro("Tile " << tile << " is outside the image");
+    }
+
+  KeyType key;
+  key.Tile = tile;
+  key.Operation = operation;
+  ImagePointer result;
+
+  m_Mutex.Lock();
+  const PlanType &plan = this->GetPlan(kernel, key.Signature);
+  if (!m_Input->GetBufferedRegion().IsInside(this->GetNeededRegion(key, plan)))
+    {
+    m_Mutex.Unlock();
+    itkExceptionMacro("The input isn't buffered over the region needed by tile " << tile);
+    }
+  for (;;)
+    {
+    typename TileMapType::iterator it = m_Tiles.find(key);
+    if (it != m_Tiles.end())
+      {
+      // move to the front of the list
+      m_LRU.erase(it->second.Position);
+      m_LRU.push_front(key);
+      it->second.Position = m_LRU.begin();
+      result = it->second.Image;
+      break;
+      }
+    if (m_Pending.find(key) != m_Pending.end())
+      {
+      // being computed by another thread
+      m_DoneCondition->Wait(&m_Mutex);
+      continue;
+      }
+    m_Pending.insert(key);
+    m_Mutex.Unlock();
+    result = this->ComputeTile(key, plan);
+    m_Mutex.Lock();
+    m_Pending.erase(key);
+    this->InsertTile(key, result);
+    m_DoneCondition->Broadcast();
+    break;
+    }
+  if (m_Prefetch)
+    {
+    this->QueueNeighbours(key);
+    }
+  m_Mutex.Unlock();
+  return result.GetPointer();
+}
+
+template <class TImage, class TKernel>
+void
+AnchorTileCache<TImage, TKernel>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "TileSize: " << m_TileSize << std::endl;
+  os << indent << "MaximumNumberOfTiles: " << m_MaximumNumberOfTiles << std::endl;
+  os << indent << "Prefetch: " << m_Prefetch << std::endl;
+  os << indent << "NumberOfComputedTiles: " << m_NumberOfComputedTiles << std::endl;
+}
+
+} // end namespace itk
+
+#endif
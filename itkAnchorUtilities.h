@@ -2,11 +2,14 @@
 #define __itkAnchorUtilities_h
 
 #include <list>
+#include <vector>
 
 #define ANCHOR_ALGORITHM
 
 namespace itk {
 
+class AnchorSweepMonitor;
+
 /**
  * \class AnchorUtilities 
  * \brief functionality in common for anchor openings/closings and
@@ -25,7 +28,7 @@ int fillLineBuffer(typename TImage::ConstPointer input,
 		   const typename TImage::IndexType StartIndex,
 		   const TLine line,
 		   const float tol,
-		   const typename TBres::OffsetArray LineOffsets,
+		   const typename TBres::OffsetArray &LineOffsets,
 		   const typename TImage::RegionType AllImage, 
 		   typename TImage::PixelType * inbuffer,
 		   unsigned &start,
@@ -36,7 +39,7 @@ int fillLineBuffer(typename TImage::ConstPointer input,
 		   const typename TImage::IndexType StartIndex,
 		   const TLine line,  // unit vector
 		   const float tol,
-		   const typename TBres::OffsetArray LineOffsets,
+		   const typename TBres::OffsetArray &LineOffsets,
 		   const typename TImage::RegionType AllImage,
 		   const unsigned int KernLen,
 		   typename TImage::PixelType * pixbuffer,
@@ -48,7 +51,7 @@ template <class TImage, class TBres, class TLine>
 int computeStartEnd(const typename TImage::IndexType StartIndex,
 		    const TLine line,
 		    const float tol,
-		    const typename TBres::OffsetArray LineOffsets,
+		    const typename TBres::OffsetArray &LineOffsets,
 		    const typename TImage::RegionType AllImage, 
 		    unsigned &start,
 		    unsigned &end);
@@ -56,7 +59,7 @@ int computeStartEnd(const typename TImage::IndexType StartIndex,
 template <class TImage, class TBres>
 void fillLineBuffer(typename TImage::ConstPointer input,
 		    const typename TImage::IndexType StartIndex,
-		    const typename TBres::OffsetArray LineOffsets,
+		    const typename TBres::OffsetArray &LineOffsets,
 		    const typename TImage::RegionType AllImage, 
 		    typename TImage::PixelType * inbuffer,
 		    unsigned &len);
@@ -65,28 +68,50 @@ void fillLineBuffer(typename TImage::ConstPointer input,
 template <class TImage, class TBres>
 void copyLineToImage(const typename TImage::Pointer output,
 		     const typename TImage::IndexType StartIndex,
-		     const typename TBres::OffsetArray LineOffsets,
+		     const typename TBres::OffsetArray &LineOffsets,
 		     const typename TImage::PixelType * outbuffer,
 		     const unsigned start,
 		     const unsigned end);
 
 #ifdef ANCHOR_ALGORITHM
+// Sweep the lines starting from every pixel of the face. If a
+// monitor is given, it is told about every line, and the sweep stops
+// and returns false when the filter has been asked to abort.
 template <class TImage, class TBres, class TAnchor, class TLine>
-void doFace(typename TImage::ConstPointer input,
+bool doFace(typename TImage::ConstPointer input,
 	    typename TImage::Pointer output,
 	    TLine line,
 	    TAnchor &AnchorLine,
-	    const typename TBres::OffsetArray LineOffsets,
+	    const typename TBres::OffsetArray &LineOffsets,
 	    typename TImage::PixelType * inbuffer,
 	    typename TImage::PixelType * outbuffer,	      
 	    const typename TImage::RegionType AllImage, 
-	    const typename TImage::RegionType face);
+	    const typename TImage::RegionType face,
+	    AnchorSweepMonitor * monitor = 0);
+
+// Same as doFace, but only for count consecutive start pixels of the
+// face, in raster order from the one at position first. Runs of
+// lines can be swept concurrently, as the lines of a face don't
+// overlap.
+template <class TImage, class TBres, class TAnchor, class TLine>
+bool doFaceLines(typename TImage::ConstPointer input,
+		 typename TImage::Pointer output,
+		 TLine line,
+		 TAnchor &AnchorLine,
+		 const typename TBres::OffsetArray &LineOffsets,
+		 typename TImage::PixelType * inbuffer,
+		 typename TImage::PixelType * outbuffer,
+		 const typename TImage::RegionType AllImage,
+		 const typename TImage::RegionType face,
+		 const unsigned long first,
+		 const unsigned long count,
+		 AnchorSweepMonitor * monitor = 0);
 #else
 template <class TImage, class TBres, class TFunction, class TLine>
 void doFace(typename TImage::ConstPointer input,
 	    typename TImage::Pointer output,
 	    TLine line,
-	    const typename TBres::OffsetArray LineOffsets,
+	    const typename TBres::OffsetArray &LineOffsets,
 	    const unsigned int KernLen,
 	    typename TImage::PixelType * pixbuffer,
 	    typename TImage::PixelType * fExtBuffer,	      
@@ -115,11 +140,202 @@ mkEnlargedFace(const typename TInputImage::ConstPointer input,
 	       const typename TInputImage::RegionType AllImage,
 	       const TLine line);
 
+// Same as above, but only the geometry of the region is needed. The
+// face is chosen among the faces of AllImage rather than the faces
+// of the buffered region of an image, so this version can be used
+// when the buffer is larger than the region being swept.
+template <class TInputImage, class TLine>
+typename TInputImage::RegionType
+mkEnlargedFace(const typename TInputImage::RegionType AllImage,
+	       const TLine line);
+
 // figure out the correction factor for length->pixel count based on
 // line angle
 template <class TLine>
 unsigned int getLinePixels(const TLine line);
 
+// The offsets of the Bresenham line of a line of a decomposition. A
+// periodic line, whose period is above 1, is built from its integer
+// step, so that it goes exactly through the pixels of the structuring
+// element and has the same shape everywhere in the image.
+template <class TBres, class TLine>
+typename TBres::OffsetArray
+mkLineOffsets(const TLine line,
+	      const unsigned int period,
+	      const unsigned int bufflength);
+
+// The number of pixels, in each dimension, that a line structuring
+// element of SELength pixels reaches on either side of its centre.
+// This is the halo needed around a region to compute that region
+// exactly with a single pass.
+template <class TImage, class TBres>
+typename TImage::SizeType
+getLineReach(const typename TBres::OffsetArray &LineOffsets,
+	     const unsigned int SELength);
+
+// Returns the part of an enlarged face containing the start pixels of
+// the lines that can cross region. The sub face keeps the position of
+// the lines of the original face, so sweeping it gives exactly the
+// same Bresenham lines as sweeping the whole face. Returns false if
+// no line crosses the region.
+template <class TRegion, class TLine>
+bool mkSubFace(const TRegion face,
+	       const TRegion region,
+	       const TLine line,
+	       TRegion &subFace);
+
+/**
+ * \class AnchorLinePass
+ * \brief everything needed to sweep one line of a decomposition
+ * across an image. It is computed once per line, so that it can be
+ * shared between all the tiles of an image.
+**/
+template <class TImage, class TBres, class TLine>
+class AnchorLinePass
+{
+public:
+  TLine Line;
+  typename TBres::OffsetArray LineOffsets;
+  unsigned int SELength;
+  unsigned int Period;
+  typename TImage::RegionType Face;
+  typename TImage::SizeType Reach;
+};
+
+template <class TImage, class TBres, class TLine>
+AnchorLinePass<TImage, TBres, TLine>
+mkLinePass(const typename TImage::RegionType AllImage,
+	   const TLine line,
+	   const unsigned int bufflength,
+	   const unsigned int period = 1);
+
+// Leave the output of an aborted sweep in a defined state, a copy of
+// the input over region, and throw ProcessAborted.
+template <class TImage>
+void abortSweep(typename TImage::ConstPointer input,
+		typename TImage::Pointer output,
+		const typename TImage::RegionType region);
+
+// Apply passes [first, last] of a decomposition to the core region of
+// an image. The input is copied, with a halo big enough for the
+// passes, into the tile image, the passes are applied in place to the
+// tile and the core is copied to the output. The lines of each pass
+// are clipped to the part of the tile that is still valid after the
+// previous pass, so the core of the tile is identical to what a sweep
+// of the whole of AllImage produces. Returns false, leaving the core
+// of the output as it was, if the monitor saw an abort.
+template <class TImage, class TBres, class TAnchor, class TLine>
+bool doTile(typename TImage::ConstPointer input,
+	    typename TImage::Pointer output,
+	    typename TImage::Pointer tile,
+	    const std::vector< AnchorLinePass<TImage, TBres, TLine> > &passes,
+	    const unsigned first,
+	    const unsigned last,
+	    TAnchor &AnchorLine,
+	    typename TImage::PixelType * inbuffer,
+	    typename TImage::PixelType * outbuffer,
+	    const typename TImage::RegionType AllImage,
+	    const typename TImage::RegionType core,
+	    AnchorSweepMonitor * monitor = 0);
+
+// Sweep the lines of an opening or closing of a line, whose class
+// works in place on a single buffer, starting from every pixel of the
+// face. The monitor is used as in doFace.
+template <class TImage, class TBres, class TAnchor, class TLine>
+bool doOpenFace(typename TImage::ConstPointer input,
+		typename TImage::Pointer output,
+		TLine line,
+		TAnchor &AnchorLine,
+		const typename TBres::OffsetArray &LineOffsets,
+		typename TImage::PixelType * buffer,
+		const typename TImage::RegionType AllImage,
+		const typename TImage::RegionType face,
+		AnchorSweepMonitor * monitor = 0);
+
+// Apply the chain of an opening (or a closing) by a decomposition to
+// the core region of an image, as AnchorOpenCloseImageFilter does:
+// the erosions along all the lines but the last one, an opening along
+// the last line and the dilations in the reverse order. The classes
+// are named for an opening, and are swapped for a closing. As in
+// doTile, the input is copied into the tile with a halo big enough
+// for all the passes, so the core is identical to what the filter
+// produces on the whole of AllImage.
+template <class TImage, class TBres, class TErode, class TOpen, class TDilate, class TLine>
+void doOpenTile(typename TImage::ConstPointer input,
+		typename TImage::Pointer output,
+		typename TImage::Pointer tile,
+		const std::vector< AnchorLinePass<TImage, TBres, TLine> > &passes,
+		TErode &ErodeLine,
+		TOpen &OpenLine,
+		TDilate &DilateLine,
+		typename TImage::PixelType * inbuffer,
+		typename TImage::PixelType * outbuffer,
+		const typename TImage::RegionType AllImage,
+		const typename TImage::RegionType core);
+
+// The halo of doOpenTile: the opening along a line reaches twice as
+// far as the erosion, and the other lines are swept twice.
+template <class TImage, class TBres, class TLine>
+typename TImage::SizeType
+getOpenTileHalo(const std::vector< AnchorLinePass<TImage, TBres, TLine> > &passes);
+
+// Turn the lines of a kernel of one dimension less than the image
+// into lines of the image that don't move along axis. Sweeping them
+// processes every slice perpendicular to axis independently.
+template <class TSliceLines, class TLines>
+void mkSliceLines(const TSliceLines &sliceLines,
+		  const unsigned axis,
+		  TLines &lines);
+
+// Split a line of SELength pixels for an image shrunk by factor. The
+// coarse line, of coarseLength pixels, is swept in the shrunk image
+// and the residual line, of residualLength pixels, at full
+// resolution. The residual line is at least factor pixels long, so
+// that the two cover the line without gaps. A line too short to be
+// split is all residual, and coarseLength is then 1.
+template <class TLine>
+void splitLine(const TLine line,
+	       const unsigned int SELength,
+	       const unsigned int factor,
+	       TLine &coarse,
+	       unsigned int &coarseLength,
+	       TLine &residual,
+	       unsigned int &residualLength);
+
+// A bound, in pixels along any axis, on the distance between the
+// kernel made of lines and the one swept by the split lines: the
+// blocks add factor - 1, and the Bresenham lines that aren't along an
+// axis or a diagonal differ at the two scales.
+template <class TLine>
+unsigned int getShrinkError(const std::vector<TLine> &lines,
+			    const unsigned int factor);
+
+// The largest factor whose error is at most maximumError and which
+// shrinks at least one line, or 1 if the lines shouldn't be shrunk,
+// which is also the case for periodic lines.
+template <class TLine>
+unsigned int getShrinkFactor(const std::vector<TLine> &lines,
+			     const std::vector<unsigned int> &periods,
+			     const unsigned int maximumError);
+
+// Shrink region of input by factor into output, which has a region
+// starting at 0 of size region/factor rounded up. Each pixel of the
+// output is the one of its block of the input that TFunction prefers,
+// the minimum for std::less.
+template <class TImage, class TFunction>
+void shrinkImage(typename TImage::ConstPointer input,
+		 const typename TImage::RegionType region,
+		 const unsigned int factor,
+		 typename TImage::Pointer output);
+
+// The inverse of shrinkImage: every pixel of region of output takes
+// the value of the pixel of input made from its block.
+template <class TImage>
+void expandImage(typename TImage::ConstPointer input,
+		 typename TImage::Pointer output,
+		 const typename TImage::RegionType region,
+		 const unsigned int factor);
+
 } // namespace itk
 
 #ifndef ITK_MANUAL_INSTANTIATION
@@ -4,7 +4,10 @@
 #include "itkAnchorUtilities.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
 #include "itkNeighborhoodAlgorithm.h"
+#include "itkAnchorSweepMonitor.h"
 
 namespace itk {
 
@@ -63,7 +66,7 @@ template <class TImage, class TBres, class TLine>
 int computeStartEnd(const typename TImage::IndexType StartIndex,
 		    const TLine line,
 		    const float tol,
-		    const typename TBres::OffsetArray LineOffsets,
+		    const typename TBres::OffsetArray &LineOffsets,
 		    const typename TImage::RegionType AllImage, 
 		    unsigned &start,
 		    unsigned &end)
@@ -132,7 +135,7 @@ int computeStartEnd(const typename TImage::IndexType StartIndex,
     if (Tnear - Tfar < 10)
       {
 //      std::cout << "Searching " << Tnear << " " << Tfar << std::endl;
-      for (unsigned i = ePos; i<= sPos; i++)
+      for (unsigned i = ePos; (i <= (unsigned)sPos) && (i < LineOffsets.size()); i++)
 	{
 	if (AllImage.IsInside(StartIndex + LineOffsets[i]))
 	  {
@@ -146,8 +149,9 @@ int computeStartEnd(const typename TImage::IndexType StartIndex,
       {
 //      std::cout << "Found intersection after all" << std::endl;
       sPos = ePos = inside;
-      while (AllImage.IsInside(StartIndex + LineOffsets[ePos + 1])) ++ePos;
-      while (AllImage.IsInside(StartIndex + LineOffsets[sPos - 1])) --sPos;
+      while ((ePos + 1 < (int)LineOffsets.size()) &&
+	     AllImage.IsInside(StartIndex + LineOffsets[ePos + 1])) ++ePos;
+      while ((sPos > 0) && AllImage.IsInside(StartIndex + LineOffsets[sPos - 1])) --sPos;
       start = sPos;
       end = ePos;
       }
@@ -165,7 +169,7 @@ int computeStartEnd(const typename TImage::IndexType StartIndex,
       {
       for (;;)
 	{
-	if (!AllImage.IsInside(StartIndex + LineOffsets[sPos - 1])) break;
+	if ((sPos == 0) || !AllImage.IsInside(StartIndex + LineOffsets[sPos - 1])) break;
 	else --sPos;
 	}
       }
@@ -174,15 +178,21 @@ int computeStartEnd(const typename TImage::IndexType StartIndex,
       for(;;)
 	{
 	++sPos;
-	if (!AllImage.IsInside(StartIndex + LineOffsets[sPos])) ++sPos;
-	else break;
+	if (sPos >= (int)LineOffsets.size())
+	  {
+	  // the line only grazes the region
+	  start=end=0;
+	  return(0);
+	  }
+	if (AllImage.IsInside(StartIndex + LineOffsets[sPos])) break;
 	}
       }
     if (AllImage.IsInside(StartIndex + LineOffsets[ePos]))
       {
       for(;;)
 	{
-	if (!AllImage.IsInside(StartIndex + LineOffsets[ePos + 1])) break;
+	if ((ePos + 1 >= (int)LineOffsets.size()) ||
+	    !AllImage.IsInside(StartIndex + LineOffsets[ePos + 1])) break;
 	else ++ePos;
 	}
       }
@@ -191,8 +201,13 @@ int computeStartEnd(const typename TImage::IndexType StartIndex,
       for (;;)
 	{
 	--ePos;
-	if (!AllImage.IsInside(StartIndex + LineOffsets[ePos])) --ePos;
-	else break;
+	if (ePos < sPos)
+	  {
+	  // the line only grazes the region
+	  start=end=0;
+	  return(0);
+	  }
+	if (AllImage.IsInside(StartIndex + LineOffsets[ePos])) break;
 	}
       }
     }
@@ -208,7 +223,7 @@ int fillLineBuffer(typename TImage::ConstPointer input,
 		   const typename TImage::IndexType StartIndex,
 		   const TLine line,  // unit vector
 		   const float tol,
-		   const typename TBres::OffsetArray LineOffsets,
+		   const typename TBres::OffsetArray &LineOffsets,
 		   const typename TImage::RegionType AllImage, 
 		   typename TImage::PixelType * inbuffer,
 		   unsigned &start,
@@ -261,7 +276,7 @@ int fillLineBuffer(typename TImage::ConstPointer input,
 		   const typename TImage::IndexType StartIndex,
 		   const TLine line,  // unit vector
 		   const float tol,
-		   const typename TBres::OffsetArray LineOffsets,
+		   const typename TBres::OffsetArray &LineOffsets,
 		   const typename TImage::RegionType AllImage,
 		   const unsigned int KernLen,
 		   typename TImage::PixelType * pixbuffer,
@@ -337,7 +352,7 @@ int fillLineBuffer(typename TImage::ConstPointer input,
 template <class TImage, class TBres>
 void copyLineToImage(const typename TImage::Pointer output,
 		     const typename TImage::IndexType StartIndex,
-		     const typename TBres::OffsetArray LineOffsets,
+		     const typename TBres::OffsetArray &LineOffsets,
 		     const typename TImage::PixelType * outbuffer,
 		     const unsigned start,
 		     const unsigned end)
@@ -357,15 +372,16 @@ void copyLineToImage(const typename TImage::Pointer output,
 #ifdef ANCHOR_ALGORITHM
 
 template <class TImage, class TBres, class TAnchor, class TLine>
-void doFace(typename TImage::ConstPointer input,
+bool doFace(typename TImage::ConstPointer input,
 	    typename TImage::Pointer output,
 	    TLine line,
 	    TAnchor &AnchorLine,
-	    const typename TBres::OffsetArray LineOffsets,
+	    const typename TBres::OffsetArray &LineOffsets,
 	    typename TImage::PixelType * inbuffer,
 	    typename TImage::PixelType * outbuffer,	      
 	    const typename TImage::RegionType AllImage, 
-	    const typename TImage::RegionType face)
+	    const typename TImage::RegionType face,
+	    AnchorSweepMonitor * monitor)
 {
   // iterate over the face
   typedef ImageRegionConstIteratorWithIndex<TImage> ItType;
@@ -390,10 +406,64 @@ void doFace(typename TImage::ConstPointer input,
       // test the decomposition
       copyLineToImage<TImage, TBres>(output, Ind, LineOffsets, inbuffer, start, end);
 #endif
+      if (monitor && !monitor->Completed(len))
+	{
+	return false;
+	}
       }
     ++it;
     }
+  return true;
+}
 
+template <class TImage, class TBres, class TAnchor, class TLine>
+bool doFaceLines(typename TImage::ConstPointer input,
+		 typename TImage::Pointer output,
+		 TLine line,
+		 TAnchor &AnchorLine,
+		 const typename TBres::OffsetArray &LineOffsets,
+		 typename TImage::PixelType * inbuffer,
+		 typename TImage::PixelType * outbuffer,
+		 const typename TImage::RegionType AllImage,
+		 const typename TImage::RegionType face,
+		 const unsigned long first,
+		 const unsigned long count,
+		 AnchorSweepMonitor * monitor)
+{
+  typename TImage::IndexType Ind = face.GetIndex();
+  const typename TImage::SizeType FSz = face.GetSize();
+  unsigned long pos = first;
+  for (unsigned d = 0; d < TImage::ImageDimension; d++)
+    {
+    Ind[d] += pos % FSz[d];
+    pos /= FSz[d];
+    }
+  TLine NormLine = line;
+  NormLine.Normalize();
+  // set a generous tolerance
+  float tol = 1.0/LineOffsets.size();
+  for (unsigned long l = 0; l < count; l++)
+    {
+    unsigned start, end, len;
+    if (fillLineBuffer<TImage, TBres, TLine>(input, Ind, NormLine, tol, LineOffsets, 
+					     AllImage, inbuffer, start, end))
+      {
+      len = end - start + 1;
+      AnchorLine.doLine(outbuffer, inbuffer, len);
+      copyLineToImage<TImage, TBres>(output, Ind, LineOffsets, outbuffer, start, end);
+      if (monitor && !monitor->Completed(len))
+	{
+	return false;
+	}
+      }
+    // next start pixel in raster order
+    for (unsigned d = 0; d < TImage::ImageDimension; d++)
+      {
+      if (++Ind[d] < face.GetIndex()[d] + (long)FSz[d]) break;
+      Ind[d] = face.GetIndex()[d];
+      }
+    }
+  return true;
 }
 
 #else
@@ -401,7 +471,7 @@ template <class TImage, class TBres, class TFunction, class TLine>
 void doFace(typename TImage::ConstPointer input,
 	    typename TImage::Pointer output,
 	    TLine line,
-	    const typename TBres::OffsetArray LineOffsets,
+	    const typename TBres::OffsetArray &LineOffsets,
 	    const unsigned int KernLen,
 	    typename TImage::PixelType * pixbuffer,
 	    typename TImage::PixelType * fExtBuffer,	      
@@ -552,21 +622,19 @@ mkEnlargedFace(const typename TInputImage::ConstPointer input,
 	       const typename TInputImage::RegionType AllImage,
 	       const TLine line)
 {
-  // use the face calculator to produce a face list
-  typedef itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<TInputImage>
-FaceCalculatorType;
-  FaceCalculatorType faceCalculator;
-  typename TInputImage::SizeType radius;
-  radius.Fill(1);
-  typename FaceCalculatorType::FaceListType faceList;
-  faceList = faceCalculator(input, AllImage, radius);
-  typename FaceCalculatorType::FaceListType::iterator fit;
-  fit = faceList.begin();
+  // the faces only depend on the region being swept
+  return mkEnlargedFace<TInputImage, TLine>(AllImage, line);
+}
+
+template <class TInputImage, class TLine>
+typename TInputImage::RegionType
+mkEnlargedFace(const typename TInputImage::RegionType AllImage,
+	       const TLine line)
+{
   typename TInputImage::RegionType RelevantRegion;
   bool foundFace = false;
   float MaxComp = NumericTraits<float>::NonpositiveMin();
   unsigned DomDir;
-  ++fit;
 //  std::cout << "------------" << std::endl;
   // figure out the dominant direction of the line
   for (unsigned i = 0;i< TInputImage::RegionType::ImageDimension;i++) 
@@ -577,43 +645,28 @@ FaceCalculatorType;
       DomDir = i;
       }
     }
-  for (;fit != faceList.end();++fit) 
+  // The face perpendicular to the dominant direction is within 45
+  // degrees of the line. Use the side of the region from which the
+  // line goes inside. The face is one pixel thick.
+  RelevantRegion = AllImage;
+  RelevantRegion.SetSize(DomDir, 1);
+  if (line[DomDir] > 0.000001)
     {
-    // check whether this face is suitable for parallel sweeping - i.e
-    // whether the line is within 45 degrees of the perpendicular
-    // Figure out the perpendicular using the region size
-    unsigned FaceDir;
-    for (unsigned i = 0;i< TInputImage::RegionType::ImageDimension;i++) 
-      {
-      if (fit->GetSize()[i] == 1) FaceDir = i;
-      }
-    if (FaceDir == DomDir) // within 1 degree 
-      {
-      // now check whether the line goes inside the image from this face
-      if ( needToDoFace<typename TInputImage::RegionType, TLine>(AllImage, *fit, line) ) 
-	{
-//	std::cout << "Using face: " << *fit << line << std::endl;
-	RelevantRegion = *fit;
-	foundFace = true;
-	break;
-	}
-      }
+    foundFace = true;
+    }
+  else if (line[DomDir] < -0.000001)
+    {
+    typename TInputImage::IndexType HighStart = AllImage.GetIndex();
+    HighStart[DomDir] += AllImage.GetSize()[DomDir] - 1;
+    RelevantRegion.SetIndex(HighStart);
+    foundFace = true;
     }
   if (foundFace) 
     {
     // enlarge the region so that sweeping the line across it will
     // cause all pixels to be visited.
     // find the dimension not within the face
-    unsigned NonFaceDim;
-    
-    for (unsigned i = 0; i < TInputImage::RegionType::ImageDimension;i++) 
-      {
-      if (RelevantRegion.GetSize()[i] == 1)
-	{
-	NonFaceDim=i;
-	break;
-	}
-      }
+    unsigned NonFaceDim = DomDir;
 
     // figure out how much extra each other dimension needs to be extended
     typename TInputImage::SizeType NewSize = RelevantRegion.GetSize();
@@ -733,6 +786,553 @@ unsigned int getLinePixels(const TLine line)
   return (int)(N + 0.5);
 }
 
+template <class TBres, class TLine>
+typename TBres::OffsetArray
+mkLineOffsets(const TLine line,
+	      const unsigned int period,
+	      const unsigned int bufflength)
+{
+  TBres BresLine;
+  if (period < 2)
+    {
+    return BresLine.buildLine(line, bufflength);
+    }
+  // the line is its step scaled so that its largest coordinate is
+  // the number of pixels
+  float largest = 0;
+  for (unsigned i = 0; i < TLine::Dimension; i++)
+    {
+    if (fabs(line[i]) > largest) largest = fabs(line[i]);
+    }
+  typename TBres::OffsetType Step;
+  for (unsigned i = 0; i < TLine::Dimension; i++)
+    {
+    Step[i] = (long)floor(line[i] * period / largest + 0.5);
+    }
+  return BresLine.buildLine(Step, bufflength);
+}
+
+template <class TImage, class TBres>
+typename TImage::SizeType
+getLineReach(const typename TBres::OffsetArray &LineOffsets,
+	     const unsigned int SELength)
+{
+  // the offset between two pixels of a line that are k apart depends
+  // on where the pair starts. The lines are monotonic, so look at the
+  // pixels half a structuring element apart everywhere along the line.
+  typename TImage::SizeType Reach;
+  Reach.Fill(0);
+  unsigned HalfLen = SELength/2;
+  if (HalfLen >= LineOffsets.size()) HalfLen = LineOffsets.size() - 1;
+  for (unsigned k = 0; k + HalfLen < LineOffsets.size(); k++)
+    {
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      unsigned long D = (unsigned long)abs(LineOffsets[k + HalfLen][i] - LineOffsets[k][i]);
+      if (D > Reach[i]) Reach[i] = D;
+      }
+    }
+  return Reach;
+}
+
+template <class TRegion, class TLine>
+bool mkSubFace(const TRegion face,
+	       const TRegion region,
+	       const TLine line,
+	       TRegion &subFace)
+{
+  // the face is perpendicular to the dominant direction of the line
+  float MaxComp = NumericTraits<float>::NonpositiveMin();
+  unsigned DomDir = 0;
+  for (unsigned i = 0; i < TRegion::ImageDimension; i++) 
+    {
+    if (fabs(line[i]) > MaxComp)
+      {
+      MaxComp = fabs(line[i]);
+      DomDir = i;
+      }
+    }
+  // project the corners of the region on to the face along the line
+  // and take the bounding box. Bresenham lines never stray more than
+  // a pixel from the continuous line, so a small margin is enough.
+  typename TRegion::IndexType RStart = region.GetIndex();
+  typename TRegion::SizeType RSize = region.GetSize();
+  long FacePos = face.GetIndex()[DomDir];
+  typename TRegion::IndexType Low, High;
+  Low.Fill(NumericTraits<long>::max());
+  High.Fill(NumericTraits<long>::NonpositiveMin());
+  for (unsigned c = 0; c < (1u << TRegion::ImageDimension); c++)
+    {
+    typename TRegion::IndexType Corner;
+    for (unsigned i = 0; i < TRegion::ImageDimension; i++)
+      {
+      Corner[i] = RStart[i];
+      if (c & (1u << i)) Corner[i] += RSize[i] - 1;
+      }
+    float T = (float)(Corner[DomDir] - FacePos)/line[DomDir];
+    for (unsigned i = 0; i < TRegion::ImageDimension; i++)
+      {
+      long P;
+      if (i == DomDir)
+	{
+	P = FacePos;
+	}
+      else
+	{
+	P = (long)floor(Corner[i] - T * line[i] + 0.5);
+	}
+      if (P < Low[i]) Low[i] = P;
+      if (P > High[i]) High[i] = P;
+      }
+    }
+  typename TRegion::SizeType SubSize;
+  for (unsigned i = 0; i < TRegion::ImageDimension; i++)
+    {
+    if (i != DomDir)
+      {
+      Low[i] -= 2;
+      High[i] += 2;
+      }
+    SubSize[i] = High[i] - Low[i] + 1;
+    }
+  subFace.SetIndex(Low);
+  subFace.SetSize(SubSize);
+  return subFace.Crop(face);
+}
+
+template <class TImage, class TBres, class TLine>
+AnchorLinePass<TImage, TBres, TLine>
+mkLinePass(const typename TImage::RegionType AllImage,
+	   const TLine line,
+	   const unsigned int bufflength,
+	   const unsigned int period)
+{
+  AnchorLinePass<TImage, TBres, TLine> Pass;
+  Pass.Line = line;
+  Pass.LineOffsets = mkLineOffsets<TBres, TLine>(line, period, bufflength);
+  Pass.Period = period;
+  Pass.SELength = getLinePixels<TLine>(line);
+  // want lines to be odd
+  if (!(Pass.SELength%2))
+    ++Pass.SELength;
+  Pass.Face = mkEnlargedFace<TImage, TLine>(AllImage, line);
+  Pass.Reach = getLineReach<TImage, TBres>(Pass.LineOffsets, Pass.SELength);
+  return Pass;
+}
+
+template <class TImage>
+void abortSweep(typename TImage::ConstPointer input,
+		typename TImage::Pointer output,
+		const typename TImage::RegionType region)
+{
+  ImageRegionConstIterator<TImage> inIt(input, region);
+  ImageRegionIterator<TImage> outIt(output, region);
+  for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+    {
+    outIt.Set(inIt.Get());
+    }
+  throw ProcessAborted(__FILE__, __LINE__);
+}
+
+template <class TImage, class TBres, class TAnchor, class TLine>
+bool doTile(typename TImage::ConstPointer input,
+	    typename TImage::Pointer output,
+	    typename TImage::Pointer tile,
+	    const std::vector< AnchorLinePass<TImage, TBres, TLine> > &passes,
+	    const unsigned first,
+	    const unsigned last,
+	    TAnchor &AnchorLine,
+	    typename TImage::PixelType * inbuffer,
+	    typename TImage::PixelType * outbuffer,
+	    const typename TImage::RegionType AllImage,
+	    const typename TImage::RegionType core,
+	    AnchorSweepMonitor * monitor)
+{
+  typedef typename TImage::RegionType RegionType;
+  typedef typename TImage::SizeType SizeType;
+  // the halo is the sum of the reaches of the passes
+  SizeType Halo;
+  Halo.Fill(0);
+  for (unsigned p = first; p <= last; p++)
+    {
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      Halo[i] += passes[p].Reach[i];
+      }
+    }
+  RegionType Valid = core;
+  Valid.PadByRadius(Halo);
+  Valid.Crop(AllImage);
+
+  tile->SetRegions(Valid);
+  tile->Allocate();
+  ImageRegionConstIterator<TImage> inIt(input, Valid);
+  ImageRegionIterator<TImage> tileIt(tile, Valid);
+  for (inIt.GoToBegin(), tileIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++tileIt)
+    {
+    tileIt.Set(inIt.Get());
+    }
+
+  typename TImage::ConstPointer tileIn = tile.GetPointer();
+  for (unsigned p = first; p <= last; p++)
+    {
+    const AnchorLinePass<TImage, TBres, TLine> &Pass = passes[p];
+    RegionType SubFace;
+    if (mkSubFace<RegionType, TLine>(Pass.Face, Valid, Pass.Line, SubFace))
+      {
+      AnchorLine.SetSize(Pass.SELength);
+      AnchorLine.SetPeriod(Pass.Period);
+      if (!doFace<TImage, TBres, TAnchor, TLine>(tileIn, tile, Pass.Line, AnchorLine,
+						 Pass.LineOffsets, inbuffer, outbuffer,
+						 Valid, SubFace, monitor))
+	{
+	return false;
+	}
+      }
+    // only the part at least the reach of this pass away from the
+    // edge of the tile is still exact
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      Halo[i] -= Pass.Reach[i];
+      }
+    Valid = core;
+    Valid.PadByRadius(Halo);
+    Valid.Crop(AllImage);
+    }
+
+  ImageRegionConstIterator<TImage> coreIt(tile, core);
+  ImageRegionIterator<TImage> outIt(output, core);
+  for (coreIt.GoToBegin(), outIt.GoToBegin(); !coreIt.IsAtEnd(); ++coreIt, ++outIt)
+    {
+    outIt.Set(coreIt.Get());
+    }
+  return true;
+}
+
+template <class TImage, class TBres, class TAnchor, class TLine>
+bool doOpenFace(typename TImage::ConstPointer input,
+		typename TImage::Pointer output,
+		TLine line,
+		TAnchor &AnchorLine,
+		const typename TBres::OffsetArray &LineOffsets,
+		typename TImage::PixelType * buffer,
+		const typename TImage::RegionType AllImage,
+		const typename TImage::RegionType face,
+		AnchorSweepMonitor * monitor)
+{
+  typedef ImageRegionConstIteratorWithIndex<TImage> ItType;
+  ItType it(input, face);
+  TLine NormLine = line;
+  NormLine.Normalize();
+  // set a generous tolerance
+  float tol = 1.0/LineOffsets.size();
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    typename TImage::IndexType Ind = it.GetIndex();
+    unsigned start, end;
+    if (fillLineBuffer<TImage, TBres, TLine>(input, Ind, NormLine, tol, LineOffsets,
+					     AllImage, buffer, start, end))
+      {
+      AnchorLine.doLine(buffer, end - start + 1);
+      copyLineToImage<TImage, TBres>(output, Ind, LineOffsets, buffer, start, end);
+      if (monitor && !monitor->Completed(end - start + 1))
+	{
+	return false;
+	}
+      }
+    }
+  return true;
+}
+
+template <class TImage, class TBres, class TLine>
+typename TImage::SizeType
+getOpenTileHalo(const std::vector< AnchorLinePass<TImage, TBres, TLine> > &passes)
+{
+  typename TImage::SizeType Halo;
+  Halo.Fill(0);
+  for (unsigned p = 0; p < passes.size(); p++)
+    {
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      Halo[i] += 2 * passes[p].Reach[i];
+      }
+    }
+  return Halo;
+}
+
+template <class TImage, class TBres, class TErode, class TOpen, class TDilate, class TLine>
+void doOpenTile(typename TImage::ConstPointer input,
+		typename TImage::Pointer output,
+		typename TImage::Pointer tile,
+		const std::vector< AnchorLinePass<TImage, TBres, TLine> > &passes,
+		TErode &ErodeLine,
+		TOpen &OpenLine,
+		TDilate &DilateLine,
+		typename TImage::PixelType * inbuffer,
+		typename TImage::PixelType * outbuffer,
+		const typename TImage::RegionType AllImage,
+		const typename TImage::RegionType core)
+{
+  typedef typename TImage::RegionType RegionType;
+  typedef typename TImage::SizeType SizeType;
+  SizeType Halo = getOpenTileHalo<TImage, TBres, TLine>(passes);
+  RegionType Valid = core;
+  Valid.PadByRadius(Halo);
+  Valid.Crop(AllImage);
+
+  tile->SetRegions(Valid);
+  tile->Allocate();
+  ImageRegionConstIterator<TImage> inIt(input, Valid);
+  ImageRegionIterator<TImage> tileIt(tile, Valid);
+  for (inIt.GoToBegin(), tileIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++tileIt)
+    {
+    tileIt.Set(inIt.Get());
+    }
+
+  // Ex Ey Oz Dy Dx
+  typename TImage::ConstPointer tileIn = tile.GetPointer();
+  const unsigned last = passes.size() - 1;
+  for (unsigned step = 0; step <= 2 * last; step++)
+    {
+    const unsigned p = (step <= last) ? step : 2 * last - step;
+    const AnchorLinePass<TImage, TBres, TLine> &Pass = passes[p];
+    RegionType SubFace;
+    if (mkSubFace<RegionType, TLine>(Pass.Face, Valid, Pass.Line, SubFace))
+      {
+      if (step < last)
+	{
+	ErodeLine.SetSize(Pass.SELength);
+	ErodeLine.SetPeriod(Pass.Period);
+	doFace<TImage, TBres, TErode, TLine>(tileIn, tile, Pass.Line, ErodeLine,
+					     Pass.LineOffsets, inbuffer, outbuffer,
+					     Valid, SubFace);
+	}
+      else if (step == last)
+	{
+	OpenLine.SetSize(Pass.SELength);
+	OpenLine.SetPeriod(Pass.Period);
+	doOpenFace<TImage, TBres, TOpen, TLine>(tileIn, tile, Pass.Line, OpenLine,
+						Pass.LineOffsets, outbuffer, Valid, SubFace);
+	}
+      else
+	{
+	DilateLine.SetSize(Pass.SELength);
+	DilateLine.SetPeriod(Pass.Period);
+	doFace<TImage, TBres, TDilate, TLine>(tileIn, tile, Pass.Line, DilateLine,
+					      Pass.LineOffsets, inbuffer, outbuffer,
+					      Valid, SubFace);
+	}
+      }
+    // the edge of the tile spoils the opening up to a whole line away
+    const unsigned scale = (step == last) ? 2 : 1;
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      Halo[i] -= scale * Pass.Reach[i];
+      }
+    Valid = core;
+    Valid.PadByRadius(Halo);
+    Valid.Crop(AllImage);
+    }
+
+  ImageRegionConstIterator<TImage> coreIt(tile, core);
+  ImageRegionIterator<TImage> outIt(output, core);
+  for (coreIt.GoToBegin(), outIt.GoToBegin(); !coreIt.IsAtEnd(); ++coreIt, ++outIt)
+    {
+    outIt.Set(coreIt.Get());
+    }
+}
+
+template <class TSliceLines, class TLines>
+void mkSliceLines(const TSliceLines &sliceLines,
+		  const unsigned axis,
+		  TLines &lines)
+{
+  typedef typename TLines::value_type LineType;
+  lines.clear();
+  for (unsigned i = 0; i < sliceLines.size(); i++)
+    {
+    LineType L;
+    unsigned k = 0;
+    for (unsigned j = 0; j < LineType::Dimension; j++)
+      {
+      if (j == axis)
+	{
+	L[j] = 0;
+	}
+      else
+	{
+	L[j] = sliceLines[i][k++];
+	}
+      }
+    lines.push_back(L);
+    }
+}
+
+template <class TLine>
+void splitLine(const TLine line,
+	       const unsigned int SELength,
+	       const unsigned int factor,
+	       TLine &coarse,
+	       unsigned int &coarseLength,
+	       TLine &residual,
+	       unsigned int &residualLength)
+{
+  // a half line of h pixels is hc blocks of factor pixels and hr
+  // pixels, with hr at least half a block
+  unsigned int h = SELength / 2;
+  unsigned int hc = 0;
+  if (h >= factor / 2 + factor)
+    {
+    hc = (h - factor / 2) / factor;
+    }
+  unsigned int hr = h - hc * factor;
+  coarseLength = 2 * hc + 1;
+  residualLength = 2 * hr + 1;
+
+  // scale the line to the lengths, see getLinePixels
+  float longest = 0.0;
+  for (unsigned int i = 0; i < TLine::Dimension; i++)
+    {
+    if (fabs(line[i]) > longest) longest = fabs(line[i]);
+    }
+  coarse = line * (coarseLength / longest);
+  residual = line * (residualLength / longest);
+}
+
+template <class TLine>
+unsigned int getShrinkError(const std::vector<TLine> &lines,
+			    const unsigned int factor)
+{
+  unsigned int error = factor - 1;
+  for (unsigned int i = 0; i < lines.size(); i++)
+    {
+    // the lines along the axes and the diagonals are the same
+    // wherever they start, and at both scales
+    float longest = 0.0;
+    for (unsigned int j = 0; j < TLine::Dimension; j++)
+      {
+      if (fabs(lines[i][j]) > longest) longest = fabs(lines[i][j]);
+      }
+    bool oblique = false;
+    for (unsigned int j = 0; j < TLine::Dimension; j++)
+      {
+      float c = fabs(lines[i][j]) / longest;
+      if ((c > 0.001) && (c < 0.999)) oblique = true;
+      }
+    if (!oblique) continue;
+    // the others depend on where they start, which changes when the
+    // passes are reordered, and are rounded at the coarse scale
+    unsigned int SELength = getLinePixels<TLine>(lines[i]);
+    if (!(SELength%2))
+      ++SELength;
+    TLine coarse, residual;
+    unsigned int coarseLength, residualLength;
+    splitLine(lines[i], SELength, factor, coarse, coarseLength, residual, residualLength);
+    error += (coarseLength > 1) ? factor / 2 + 2 : 1;
+    }
+  return error;
+}
+
+template <class TLine>
+unsigned int getShrinkFactor(const std::vector<TLine> &lines,
+			     const std::vector<unsigned int> &periods,
+			     const unsigned int maximumError)
+{
+  // the pixels of a periodic line don't survive the shrinking
+  for (unsigned i = 0; i < lines.size(); i++)
+    {
+    if ((i < periods.size()) && (periods[i] > 1))
+      {
+      return 1;
+      }
+    }
+  unsigned int factor = 1;
+  for (unsigned int f = 2; getShrinkError<TLine>(lines, f) <= maximumError; f++)
+    {
+    bool shrunk = false;
+    for (unsigned i = 0; i < lines.size(); i++)
+      {
+      unsigned int SELength = getLinePixels<TLine>(lines[i]);
+      if (!(SELength%2))
+	++SELength;
+      TLine coarse, residual;
+      unsigned int coarseLength, residualLength;
+      splitLine<TLine>(lines[i], SELength, f, coarse, coarseLength, residual, residualLength);
+      if (coarseLength > 1) shrunk = true;
+      }
+    if (!shrunk) break;
+    factor = f;
+    }
+  return factor;
+}
+
+template <class TImage, class TFunction>
+void shrinkImage(typename TImage::ConstPointer input,
+		 const typename TImage::RegionType region,
+		 const unsigned int factor,
+		 typename TImage::Pointer output)
+{
+  typedef typename TImage::IndexType IndexType;
+  typename TImage::RegionType small;
+  typename TImage::SizeType size;
+  IndexType start;
+  start.Fill(0);
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    size[i] = (region.GetSize()[i] + factor - 1) / factor;
+    }
+  small.SetIndex(start);
+  small.SetSize(size);
+  output->SetRegions(small);
+  output->Allocate();
+
+  // start from the first pixel of every block
+  ImageRegionIteratorWithIndex<TImage> outIt(output, small);
+  for (outIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt)
+    {
+    IndexType Idx = outIt.GetIndex();
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      Idx[i] = region.GetIndex()[i] + Idx[i] * factor;
+      }
+    outIt.Set(input->GetPixel(Idx));
+    }
+  TFunction compare;
+  ImageRegionConstIteratorWithIndex<TImage> inIt(input, region);
+  for (inIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt)
+    {
+    IndexType Idx = inIt.GetIndex();
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      Idx[i] = (Idx[i] - region.GetIndex()[i]) / factor;
+      }
+    typename TImage::PixelType V = inIt.Get();
+    if (compare(V, output->GetPixel(Idx)))
+      {
+      output->SetPixel(Idx, V);
+      }
+    }
+}
+
+template <class TImage>
+void expandImage(typename TImage::ConstPointer input,
+		 typename TImage::Pointer output,
+		 const typename TImage::RegionType region,
+		 const unsigned int factor)
+{
+  typedef typename TImage::IndexType IndexType;
+  ImageRegionIteratorWithIndex<TImage> outIt(output, region);
+  for (outIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt)
+    {
+    IndexType Idx = outIt.GetIndex();
+    for (unsigned i = 0; i < TImage::ImageDimension; i++)
+      {
+      Idx[i] = (Idx[i] - region.GetIndex()[i]) / factor;
+      }
+    outIt.Set(input->GetPixel(Idx));
+    }
+}
+
 } // namespace itk
 
 #endif
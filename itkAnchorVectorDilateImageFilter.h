@@ -0,0 +1,45 @@
+#ifndef __itkAnchorVectorDilateImageFilter_h
+#define __itkAnchorVectorDilateImageFilter_h
+
+#include "itkAnchorVectorErodeDilateImageFilter.h"
+
+namespace itk {
+
+template<class TImage, class TKernel>
+class  ITK_EXPORT AnchorVectorDilateImageFilter :
+    public AnchorVectorErodeDilateImageFilter<TImage, TKernel, std::greater<typename TImage::PixelType::ValueType>, std::greater_equal<typename TImage::PixelType::ValueType> >
+
+{
+public:
+  typedef AnchorVectorDilateImageFilter Self;
+  typedef AnchorVectorErodeDilateImageFilter<TImage, TKernel, std::greater<typename TImage::PixelType::ValueType>, std::greater_equal<typename TImage::PixelType::ValueType> > Superclass;
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorVectorDilateImageFilter, 
+               AnchorVectorErodeDilateImageFilter);
+
+  typedef SmartPointer<Self>   Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  virtual ~AnchorVectorDilateImageFilter() {}
+protected:
+  AnchorVectorDilateImageFilter(){}
+  void PrintSelf(std::ostream& os, Indent indent) const
+  {
+    os << indent << "Anchor vector dilation: " << std::endl;
+  }
+
+private:
+  
+  AnchorVectorDilateImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef __itkAnchorVectorErodeDilateImageFilter_h
+#define __itkAnchorVectorErodeDilateImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkMultiThreader.h"
+#include "itkAnchorSweepMonitor.h"
+#include "itkAnchorErodeDilateLine.h"
+#include "itkBresenhamLine.h"
+#include "itkAnchorUtilities.h"
+#include "itkAnchorLineScheduler.h"
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class AnchorVectorErodeDilateImageFilter
+ * \brief marginal erosions and dilations of multi-component images,
+ * such as Image<Vector<...>>, Image<RGBPixel<...>> or VectorImage,
+ * using anchor methods.
+ *
+ * Each component is eroded or dilated on its own, as if the channels
+ * were split, filtered and composed again, but the lines are only
+ * traversed once: the pixels of a line are gathered into a
+ * channel-planar buffer, each channel is processed by the anchor line
+ * and the result is scattered back. The line offsets and the faces
+ * are computed once for all the channels, and the lines of each pass
+ * are shared between the threads by an AnchorLineScheduler, as in
+ * AnchorErodeDilateImageFilter.
+ *
+ * The output requested region is padded by the reach of all the
+ * lines, which is enough for the requested part to be identical to
+ * the same part of a sweep of the whole image, and only that part of
+ * the input is read.
+ *
+ * TFunction1 and TFunction2 compare components, not pixels. Use
+ * AnchorVectorErodeImageFilter and AnchorVectorDilateImageFilter
+ * rather than this class.
+**/
+template<class TImage, class TKernel,
+	 class TFunction1, class TFunction2>
+class ITK_EXPORT AnchorVectorErodeDilateImageFilter :
+    public ImageToImageFilter<TImage, TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef AnchorVectorErodeDilateImageFilter Self;
+  typedef ImageToImageFilter<TImage, TImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  /** Kernel typedef. */
+  typedef TKernel KernelType;
+
+  typedef TImage InputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename InputImagePixelType::ValueType  ComponentType;
+  typedef typename TImage::IndexType         IndexType;
+  typedef typename TImage::SizeType          SizeType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorVectorErodeDilateImageFilter,
+               ImageToImageFilter);
+
+  void SetKernel( const KernelType& kernel )
+  {
+    m_Kernel=kernel;
+    m_KernelSet = true;
+    this->Modified();
+  }
+
+protected:
+  AnchorVectorErodeDilateImageFilter();
+  ~AnchorVectorErodeDilateImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** The output has as many components as the input. */
+  void GenerateOutputInformation();
+
+  /** The requested region is padded by the reach of all the lines. */
+  void EnlargeOutputRequestedRegion(DataObject *output);
+
+  /** The lines of each pass are shared among the threads. */
+  void GenerateData();
+
+private:
+  AnchorVectorErodeDilateImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  typedef BresenhamLine<itkGetStaticConstMacro(InputImageDimension)> BresType;
+
+  // the anchor line works on one channel at a time
+  typedef AnchorErodeDilateLine<ComponentType, TFunction1, TFunction2> AnchorLineType;
+
+  typedef AnchorLinePass<TImage, BresType, typename KernelType::LType> PassType;
+  typedef AnchorLineScheduler<TImage, BresType, typename KernelType::LType> SchedulerType;
+
+  // what the threads of a pass share
+  struct LineThreadStruct
+  {
+    Pointer Filter;
+    const PassType * Pass;
+    unsigned int PassNumber;
+    unsigned int Passes;
+    SchedulerType * Scheduler;
+    InputImageConstPointer Input;
+  };
+  static ITK_THREAD_RETURN_TYPE LineThreaderCallback( void *arg );
+
+  // sweep count consecutive start pixels of the face of pass, in
+  // raster order from the one at position first, as doFaceLines
+  // does. Returns false if the filter has been asked to abort.
+  bool doVectorFaceLines(InputImageConstPointer input,
+			 InputImagePointer output,
+			 const PassType &pass,
+			 AnchorLineType &AnchorLine,
+			 const InputImageRegionType AllImage,
+			 const unsigned int channels,
+			 const unsigned int stride,
+			 ComponentType * inbuffer,
+			 ComponentType * buffer,
+			 const unsigned long first,
+			 const unsigned long count,
+			 AnchorSweepMonitor &monitor);
+
+  // gather the pixels of the line starting at StartIndex into the
+  // channel-planar buffer, channel c at c * stride
+  int fillVectorLineBuffer(InputImageConstPointer input,
+			   const IndexType StartIndex,
+			   const typename KernelType::LType line,
+			   const float tol,
+			   const typename BresType::OffsetArray &LineOffsets,
+			   const InputImageRegionType AllImage,
+			   const unsigned int channels,
+			   const unsigned int stride,
+			   ComponentType * inbuffer,
+			   unsigned &start,
+			   unsigned &end);
+
+  void copyVectorLineToImage(InputImagePointer output,
+			     const IndexType StartIndex,
+			     const typename BresType::OffsetArray &LineOffsets,
+			     const unsigned int channels,
+			     const unsigned int stride,
+			     const ComponentType * outbuffer,
+			     const unsigned start,
+			     const unsigned end);
+
+  KernelType m_Kernel;
+  bool m_KernelSet;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAnchorVectorErodeDilateImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef __itkAnchorVectorErodeDilateImageFilter_txx
+#define __itkAnchorVectorErodeDilateImageFilter_txx
+
+#include "itkAnchorVectorErodeDilateImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+namespace itk {
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+AnchorVectorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::AnchorVectorErodeDilateImageFilter()
+{
+  m_KernelSet = false;
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorVectorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+  InputImageConstPointer input = this->GetInput();
+  if (input)
+    {
+    // a VectorImage doesn't get its length from CopyInformation
+    this->GetOutput()->SetNumberOfComponentsPerPixel(input->GetNumberOfComponentsPerPixel());
+    }
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorVectorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  // the lines clipped by the edges of the requested region spoil the
+  // result up to their reach, pass after pass, so the region is
+  // padded by the reach of all the lines. The input is requested over
+  // the same region.
+  InputImagePointer output = this->GetOutput();
+  InputImageRegionType AllImage = output->GetLargestPossibleRegion();
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+  SizeType Halo;
+  Halo.Fill(0);
+  typename KernelType::DecompType decomposition = m_Kernel.GetLines();
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    PassType pass = mkLinePass<TImage, BresType, typename KernelType::LType>(AllImage, decomposition[i], bufflength, m_Kernel.GetPeriod(i));
+    for (unsigned j = 0; j<TImage::ImageDimension; j++)
+      {
+      Halo[j] += pass.Reach[j];
+      }
+    }
+  InputImageRegionType Padded = output->GetRequestedRegion();
+  Padded.PadByRadius(Halo);
+  Padded.Crop(AllImage);
+  output->SetRequestedRegion(Padded);
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorVectorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::GenerateData()
+{
+  // check that we are using a decomposable kernel
+  if (!m_Kernel.GetDecomposable())
+    {
+    itkExceptionMacro("Anchor morphology only works with decomposable structuring elements");
+    }
+  if (!m_KernelSet)
+    {
+    itkExceptionMacro("No kernel set");
+    }
+
+  int threads = this->GetNumberOfThreads();
+  this->GetMultiThreader()->SetNumberOfThreads(threads);
+  threads = this->GetMultiThreader()->GetNumberOfThreads();
+
+  // Allocate the output
+  this->AllocateOutputs();
+  InputImagePointer output = this->GetOutput();
+  InputImageConstPointer input = this->GetInput();
+
+  InputImageRegionType OReg = output->GetRequestedRegion();
+  // the lines are those of a sweep of the whole image, even if only
+  // a part of it is requested
+  InputImageRegionType AllImage = output->GetLargestPossibleRegion();
+  // maximum buffer length is sum of dimensions
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+  // the faces of the passes only keep the lines that cross the
+  // requested region
+  std::vector<PassType> passes;
+  typename KernelType::DecompType decomposition = m_Kernel.GetLines();
+  for (unsigned i = 0; i < decomposition.size(); i++)
+    {
+    PassType pass = mkLinePass<TImage, BresType, typename KernelType::LType>(AllImage, decomposition[i], bufflength, m_Kernel.GetPeriod(i));
+    if (mkSubFace<InputImageRegionType, typename KernelType::LType>(pass.Face, OReg, pass.Line, pass.Face))
+      {
+      passes.push_back(pass);
+      }
+    }
+  if (passes.empty())
+    {
+    ImageRegionConstIterator<TImage> inIt(input, OReg);
+    ImageRegionIterator<TImage> outIt(output, OReg);
+    for (inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt)
+      {
+      outIt.Set(inIt.Get());
+      }
+    return;
+    }
+
+  // the lines of a pass are swept in place after the first pass, so
+  // all threads finish a pass before the next one starts
+  SchedulerType scheduler;
+  LineThreadStruct str;
+  str.Filter = this;
+  str.Scheduler = &scheduler;
+  for (unsigned i = 0; i < passes.size(); i++)
+    {
+    scheduler.Initialize(passes[i], OReg, threads);
+    str.Pass = &(passes[i]);
+    str.PassNumber = i;
+    str.Passes = passes.size();
+    str.Input = input;
+    this->GetMultiThreader()->SetSingleMethod(this->LineThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+    if (this->GetAbortGenerateData())
+      {
+      abortSweep<TImage>(this->GetInput(), output, OReg);
+      }
+    // after the first pass the input will be taken from the output
+    input = output.GetPointer();
+    }
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+ITK_THREAD_RETURN_TYPE
+AnchorVectorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::LineThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct * info = (MultiThreader::ThreadInfoStruct *)(arg);
+  LineThreadStruct * str = (LineThreadStruct *)(info->UserData);
+  int threadId = info->ThreadID;
+  const PassType & pass = *(str->Pass);
+
+  InputImagePointer output = str->Filter->GetOutput();
+  InputImageRegionType OReg = output->GetRequestedRegion();
+  InputImageRegionType AllImage = output->GetLargestPossibleRegion();
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i<TImage::ImageDimension; i++)
+    {
+    bufflength += AllImage.GetSize()[i];
+    }
+  const unsigned int channels = output->GetNumberOfComponentsPerPixel();
+  // each thread needs its own line object and buffers, which hold
+  // all the channels of a line, one after the other
+  AnchorLineType ThreadLine;
+  ThreadLine.SetSize(pass.SELength);
+  ThreadLine.SetPeriod(pass.Period);
+  ComponentType * buffer = new ComponentType[bufflength * channels];
+  ComponentType * inbuffer = new ComponentType[bufflength * channels];
+  // thread 0 reports its share of the pass as the progress of the pass
+  AnchorSweepMonitor monitor(str->Filter, threadId,
+			     (double)OReg.GetNumberOfPixels() * channels / info->NumberOfThreads,
+			     (float)str->PassNumber / str->Passes, 1.0f / str->Passes);
+  typename SchedulerType::Chunk chunk;
+  while (str->Scheduler->Next(threadId, chunk))
+    {
+    if (!str->Filter->doVectorFaceLines(str->Input, output, pass, ThreadLine, OReg,
+					channels, bufflength, inbuffer, buffer,
+					chunk.First, chunk.Count, monitor))
+      {
+      break;
+      }
+    }
+  delete [] buffer;
+  delete [] inbuffer;
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+bool
+AnchorVectorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::doVectorFaceLines(InputImageConstPointer input,
+		    InputImagePointer output,
+		    const PassType &pass,
+		    AnchorLineType &AnchorLine,
+		    const InputImageRegionType AllImage,
+		    const unsigned int channels,
+		    const unsigned int stride,
+		    ComponentType * inbuffer,
+		    ComponentType * buffer,
+		    const unsigned long first,
+		    const unsigned long count,
+		    AnchorSweepMonitor &monitor)
+{
+  const InputImageRegionType face = pass.Face;
+  IndexType Ind = face.GetIndex();
+  const SizeType FSz = face.GetSize();
+  unsigned long pos = first;
+  for (unsigned d = 0; d < TImage::ImageDimension; d++)
+    {
+    Ind[d] += pos % FSz[d];
+    pos /= FSz[d];
+    }
+  typename KernelType::LType NormLine = pass.Line;
+  NormLine.Normalize();
+  // set a generous tolerance
+  float tol = 1.0/pass.LineOffsets.size();
+  for (unsigned long l = 0; l < count; l++)
+    {
+    unsigned start, end;
+    if (fillVectorLineBuffer(input, Ind, NormLine, tol, pass.LineOffsets, AllImage,
+			     channels, stride, inbuffer, start, end))
+      {
+      unsigned len = end - start + 1;
+      for (unsigned c = 0; c < channels; c++)
+	{
+	AnchorLine.doLine(buffer + c * stride, inbuffer + c * stride, len);
+	}
+      copyVectorLineToImage(output, Ind, pass.LineOffsets, channels, stride,
+			    buffer, start, end);
+      if (!monitor.Completed(len * channels))
+	{
+	return false;
+	}
+      }
+    // next start pixel in raster order
+    for (unsigned d = 0; d < TImage::ImageDimension; d++)
+      {
+      if (++Ind[d] < face.GetIndex()[d] + (long)FSz[d]) break;
+      Ind[d] = face.GetIndex()[d];
+      }
+    }
+  return true;
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+int
+AnchorVectorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::fillVectorLineBuffer(InputImageConstPointer input,
+		       const IndexType StartIndex,
+		       const typename KernelType::LType line,
+		       const float tol,
+		       const typename BresType::OffsetArray &LineOffsets,
+		       const InputImageRegionType AllImage,
+		       const unsigned int channels,
+		       const unsigned int stride,
+		       ComponentType * inbuffer,
+		       unsigned &start,
+		       unsigned &end)
+{
+  int status = computeStartEnd<TImage, BresType, typename KernelType::LType>(StartIndex, line, tol, LineOffsets, AllImage,
+									      start, end);
+  if (!status) return(status);
+
+  unsigned size = end - start + 1;
+  for (unsigned i = 0; i < size; i++)
+    {
+    InputImagePixelType P = input->GetPixel(StartIndex + LineOffsets[start + i]);
+    for (unsigned c = 0; c < channels; c++)
+      {
+      inbuffer[c * stride + i] = P[c];
+      }
+    }
+  return(1);
+}
+
+template <class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorVectorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::copyVectorLineToImage(InputImagePointer output,
+			const IndexType StartIndex,
+			const typename BresType::OffsetArray &LineOffsets,
+			const unsigned int channels,
+			const unsigned int stride,
+			const ComponentType * outbuffer,
+			const unsigned start,
+			const unsigned end)
+{
+  unsigned size = end - start + 1;
+  for (unsigned i = 0; i < size; i++)
+    {
+    IndexType Ind = StartIndex + LineOffsets[start + i];
+    // take a copy of the pixel, so that a VectorImage pixel of the
+    // right length is written back
+    InputImagePixelType P = output->GetPixel(Ind);
+    for (unsigned c = 0; c < channels; c++)
+      {
+      P[c] = outbuffer[c * stride + i];
+      }
+    output->SetPixel(Ind, P);
+    }
+}
+
+template<class TImage, class TKernel, class TFunction1, class TFunction2>
+void
+AnchorVectorErodeDilateImageFilter<TImage, TKernel, TFunction1, TFunction2>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "KernelSet: " << m_KernelSet << std::endl;
+}
+
+} // end namespace itk
+
+#endif
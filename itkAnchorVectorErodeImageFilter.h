@@ -0,0 +1,45 @@
+#ifndef __itkAnchorVectorErodeImageFilter_h
+#define __itkAnchorVectorErodeImageFilter_h
+
+#include "itkAnchorVectorErodeDilateImageFilter.h"
+
+namespace itk {
+
+template<class TImage, class TKernel>
+class  ITK_EXPORT AnchorVectorErodeImageFilter :
+    public AnchorVectorErodeDilateImageFilter<TImage, TKernel, std::less<typename TImage::PixelType::ValueType>, std::less_equal<typename TImage::PixelType::ValueType> >
+
+{
+public:
+  typedef AnchorVectorErodeImageFilter Self;
+  typedef AnchorVectorErodeDilateImageFilter<TImage, TKernel, std::less<typename TImage::PixelType::ValueType>, std::less_equal<typename TImage::PixelType::ValueType> > Superclass;
+
+  /** Runtime information support. */
+  itkTypeMacro(AnchorVectorErodeImageFilter, 
+               AnchorVectorErodeDilateImageFilter);
+
+  typedef SmartPointer<Self>   Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  virtual ~AnchorVectorErodeImageFilter() {}
+protected:
+  AnchorVectorErodeImageFilter(){}
+  void PrintSelf(std::ostream& os, Indent indent) const
+  {
+    os << indent << "Anchor vector erosion: " << std::endl;
+  }
+
+private:
+  
+  AnchorVectorErodeImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+
+} // namespace itk
+
+#endif
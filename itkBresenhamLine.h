@@ -31,6 +31,16 @@ public:
 
   OffsetArray buildLine(LType Direction, unsigned int length);
 
+  // A line that goes exactly through the multiples of an integer
+  // step: if m is the largest coordinate of Step, offset k*m is
+  // k*Step. This is what periodic lines need.
+  OffsetArray buildLine(OffsetType Step, unsigned int length);
+
+private:
+  // the Bresenham line from the origin towards LastIndex, continued
+  // for length pixels
+  OffsetArray walkLine(const IndexType &LastIndex, unsigned int length);
+
 };
 
 
@@ -8,6 +8,33 @@ namespace itk {
 template<unsigned int VDimension>
 typename BresenhamLine<VDimension>::OffsetArray BresenhamLine<VDimension>
 ::buildLine(LType Direction, unsigned int length)
+{
+  IndexType LastIndex;
+  Direction.Normalize();
+  for (unsigned i = 0; i<VDimension;i++)
+    {
+    LastIndex[i] = (IndexValueType)(length*Direction[i]);
+    }
+  return walkLine(LastIndex, length);
+}
+
+template<unsigned int VDimension>
+typename BresenhamLine<VDimension>::OffsetArray BresenhamLine<VDimension>
+::buildLine(OffsetType Step, unsigned int length)
+{
+  // the errors are back to 0 at the end of each step, so the pattern
+  // of the first step repeats all along the line
+  IndexType LastIndex;
+  for (unsigned i = 0; i<VDimension;i++)
+    {
+    LastIndex[i] = Step[i];
+    }
+  return walkLine(LastIndex, length);
+}
+
+template<unsigned int VDimension>
+typename BresenhamLine<VDimension>::OffsetArray BresenhamLine<VDimension>
+::walkLine(const IndexType &LastIndex, unsigned int length)
 {
   // copied from the line iterator
   /** Variables that drive the Bresenham-Algorithm */
@@ -34,15 +61,10 @@ typename BresenhamLine<VDimension>::OffsetArray BresenhamLine<VDimension>
 
   OffsetArray result(length);
   
-  IndexType m_CurrentImageIndex, StartIndex, LastIndex;
-  Direction.Normalize();
+  IndexType m_CurrentImageIndex, StartIndex;
   // we are going to start at 0
   m_CurrentImageIndex.Fill(0);
   StartIndex.Fill(0);
-  for (unsigned i = 0; i<VDimension;i++)
-    {
-    LastIndex[i] = (IndexValueType)(length*Direction[i]);
-    }
   // Find the dominant direction
   IndexValueType maxDistance = 0;
   unsigned int maxDistanceDimension;
@@ -62,6 +62,38 @@ public:
   // lines is the number of elements in the decomposition
   static Self Poly(RadiusType radius, unsigned lines);
 
+  /** A single line, whose number of pixels is its largest coordinate
+   * made odd, as for the lines of the other kernels */
+  static Self Line(const LType &line);
+
+  /** A kernel made of the non zero pixels of an image, which must
+   * have an odd size in each dimension. The kernel isn't decomposable
+   * until it is given to Decompose. */
+  template < class TImage > static Self FromImage(const TImage * image);
+
+  /** Look for lines whose dilation of a single pixel reproduces the
+   * kernel, which may be a Ball, a mask drawn by the user or one read
+   * with FromImage. The shape made by the lines is convex and
+   * symmetric about the centre, so other kernels can only be
+   * approximated. tolerance is the fraction of the pixels of the
+   * kernel that may differ from the shape of the lines. The result is
+   * decomposable, with the shape of the lines in its buffer, if such
+   * lines are found, and otherwise is a copy of the kernel. The
+   * radius grows if the lines reach past the kernel. */
+  static Self Decompose(const Self &kernel, float tolerance = 0.0);
+
+  /** A disc or a sphere, or an ellipse or an ellipsoid for different
+   * radii, made of contiguous lines along the axes and the diagonals
+   * and of periodic lines along knight's moves like (2, 1). A periodic
+   * line has a pixel every period pixels, and its Bresenham line goes
+   * exactly through them, so that, unlike with the oblique lines of
+   * Poly, the shape is the same everywhere in the image. The lengths
+   * are fitted to Ball, which is approached more closely than by Poly
+   * with the same number of lines. lines is the number of directions
+   * the fit may use: the axes and the diagonals, 4 in 2D and 13 in
+   * 3D, and the knight's moves above that, which 0 also selects. */
+  static Self Periodic(RadiusType radius, unsigned lines = 0);
+
   bool GetDecomposable() const
   {
     return m_Decomposable;
@@ -72,6 +104,20 @@ public:
     return(m_Lines);
   }
 
+  /** The periods of the lines. It may be empty, when all the lines
+   * are contiguous. */
+  const std::vector<unsigned int> & GetPeriods() const
+  {
+    return(m_Periods);
+  }
+
+  /** The period of line i: 1 for a contiguous line, and for a
+   * periodic line the largest coordinate of its step */
+  unsigned int GetPeriod(unsigned int i) const
+  {
+    return (i < m_Periods.size()) ? m_Periods[i] : 1;
+  }
+
   void PrintSelf(std::ostream &os, Indent indent) const;
 
   template < class ImageType > typename ImageType::Pointer GetImage();
@@ -85,6 +131,7 @@ private:
   bool m_Decomposable;
 
   DecompType m_Lines;
+  std::vector<unsigned int> m_Periods;
   
   // dispatch between 2D and 3D
   struct DispatchBase {};
@@ -106,6 +153,29 @@ private:
 
   bool checkParallel(LType NewVec, DecompType Lines);
 
+  // the primitive integer directions with coordinates in
+  // [-extent, extent], one of each pair of opposite directions
+  static void mkDirections(int extent, DecompType &directions);
+
+  // the lines with the given number of steps along the directions,
+  // which are periodic for directions with coordinates beyond 1
+  static void mkLines(const DecompType &directions,
+		      const std::vector<int> &steps, DecompType &lines,
+		      std::vector<unsigned int> &periods);
+
+  // the lines along directions that reproduce kernel best, as in
+  // Decompose. difference is the number of pixels that differ.
+  static Self fitLines(const Self &kernel, const DecompType &directions,
+		       float tolerance, unsigned long &difference);
+
+  // dilate the centre pixel of shape, of the given size, with the
+  // lines, and count the pixels that differ from target
+  static unsigned long shapeDifference(const DecompType &lines,
+				       const std::vector<unsigned int> &periods,
+				       const std::vector<unsigned char> &target,
+				       const SizeType &size,
+				       std::vector<unsigned char> &shape);
+
   typedef struct {
     LType P1, P2, P3;
   } FacetType;
@@ -113,7 +183,7 @@ private:
 };
 } // namespace itk
 
-#ifndef ITK_MANUAL_INSTANTIATION
+#if !defined(ITK_MANUAL_INSTANTIATION) && !defined(ANCHOR_MANUAL_INSTANTIATION)
 #include "itkFlatStructuringElement.txx"
 #endif
 
@@ -5,6 +5,7 @@
 #include "itkFlatStructuringElement.h"
 #include <math.h>
 #include <vector>
+#include <limits>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -12,14 +13,20 @@
 
 #include "itkImage.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
 #include "itkFloodFilledSpatialFunctionConditionalIterator.h"
 #include "itkEllipsoidInteriorExteriorSpatialFunction.h" 
 
 #include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorStridedMorphology.h"
 
 
 namespace itk
 {
+// itkAnchorStridedMorphology.h includes this file before declaring
+// the class
+template<class TPixel, unsigned int VDimension> class AnchorStridedMorphology;
+
 template<unsigned int VDimension>
 FlatStructuringElement<VDimension> FlatStructuringElement<VDimension>
 ::Poly(RadiusType radius, unsigned lines)
@@ -635,6 +642,33 @@ FlatStructuringElement<VDimension> FlatStructuringElement<VDimension>
   return(res);
 }
 
+template<unsigned int VDimension>
+FlatStructuringElement<VDimension> FlatStructuringElement<VDimension>
+::Line(const LType &line)
+{
+  FlatStructuringElement res = FlatStructuringElement();
+  res.m_Decomposable = true;
+  // a line of 2k+1 pixels takes k steps on either side of the centre
+  float largest = 0;
+  for (unsigned i = 0; i < VDimension; i++)
+    {
+    largest = std::max(largest, (float)fabs(line[i]));
+    }
+  unsigned int half = getLinePixels<LType>(line) / 2;
+  RadiusType radius;
+  for (unsigned i = 0; i < VDimension; i++)
+    {
+    radius[i] = largest > 0 ? (unsigned long)ceil(half * fabs(line[i]) / largest) : 0;
+    }
+  res.SetRadius(radius);
+  if (largest > 0)
+    {
+    res.m_Lines.push_back(line);
+    }
+  res.ComputeBufferFromLines();
+  return(res);
+}
+
 
 
 template<unsigned int VDimension>
@@ -741,6 +775,378 @@ FlatStructuringElement<VDimension> FlatStructuringElement<VDimension>
 }
 
 
+template<unsigned int VDimension>
+template< class TImage >
+FlatStructuringElement<VDimension> FlatStructuringElement<VDimension>
+::FromImage(const TImage * image)
+{
+  typename TImage::RegionType region = image->GetLargestPossibleRegion();
+  RadiusType radius;
+  for (unsigned i = 0; i < VDimension; i++)
+    {
+    if (region.GetSize()[i] % 2 == 0)
+      {
+      itkGenericExceptionMacro(<< "The image of a kernel must have an odd size, not " << region.GetSize());
+      }
+    radius[i] = region.GetSize()[i] / 2;
+    }
+  FlatStructuringElement res = FlatStructuringElement();
+  res.SetRadius( radius );
+  res.m_Decomposable = false;
+
+  ImageRegionConstIterator<TImage> it(image, region);
+  Iterator kernel_it;
+  for (it.GoToBegin(), kernel_it=res.Begin();!it.IsAtEnd();++it,++kernel_it)
+    {
+    *kernel_it = (it.Get() != NumericTraits<typename TImage::PixelType>::Zero);
+    }
+  return res;
+}
+
+template<unsigned int VDimension>
+FlatStructuringElement<VDimension> FlatStructuringElement<VDimension>
+::Decompose(const Self &kernel, float tolerance)
+{
+  // Only the axes and the diagonals are used: the Bresenham lines of
+  // other directions alternate between two patterns, so their shape
+  // depends on where the pixel is on the line.
+  DecompType directions;
+  mkDirections(1, directions);
+  unsigned long difference;
+  return fitLines(kernel, directions, tolerance, difference);
+}
+
+template<unsigned int VDimension>
+FlatStructuringElement<VDimension> FlatStructuringElement<VDimension>
+::Periodic(RadiusType radius, unsigned lines)
+{
+  const float any = std::numeric_limits<float>::max();
+  Self ball = Ball(radius);
+  DecompType directions, moves;
+  mkDirections(1, directions);
+  unsigned long difference;
+  Self res = fitLines(ball, directions, any, difference);
+  if (lines == 0 || lines > directions.size())
+    {
+    // the knight's moves, whose periodic lines have a period of 2
+    mkDirections(2, moves);
+    for (unsigned d = 0; d < moves.size(); d++)
+      {
+      float largest = 0, sum = 0;
+      for (unsigned i = 0; i < VDimension; i++)
+	{
+	largest = std::max(largest, (float)fabs(moves[d][i]));
+	sum += fabs(moves[d][i]);
+	}
+      if (largest == 2 && sum == 3) directions.push_back(moves[d]);
+      }
+    // the search is local, and the one with more directions isn't
+    // always the better one
+    unsigned long periodicDifference;
+    Self periodic = fitLines(ball, directions, any, periodicDifference);
+    if (periodicDifference < difference)
+      {
+      res = periodic;
+      }
+    }
+  return res;
+}
+
+template<unsigned int VDimension>
+FlatStructuringElement<VDimension> FlatStructuringElement<VDimension>
+::fitLines(const Self &kernel, const DecompType &directions, float tolerance,
+	   unsigned long &difference)
+{
+  FlatStructuringElement res = kernel;
+  res.m_Decomposable = false;
+  res.m_Lines.clear();
+  res.m_Periods.clear();
+
+  // the kernel, centred in a buffer twice as large, so that the lines
+  // may grow past it without being clipped
+  RadiusType radius = kernel.GetRadius();
+  SizeType size;
+  unsigned long total = 1;
+  for (unsigned i = 0; i < VDimension; i++)
+    {
+    size[i] = 4 * radius[i] + 3;
+    total *= size[i];
+    }
+  std::vector<unsigned char> target(total, 0);
+  DecompType points;
+  for (unsigned n = 0; n < kernel.Size(); n++)
+    {
+    if (!kernel[n]) continue;
+    typename Superclass::OffsetType O = kernel.GetOffset(n);
+    LType P;
+    unsigned long pos = 0, stride = 1;
+    for (unsigned i = 0; i < VDimension; i++)
+      {
+      P[i] = O[i];
+      pos += (O[i] + 2 * radius[i] + 1) * stride;
+      stride *= size[i];
+      }
+    target[pos] = 1;
+    points.push_back(P);
+    }
+  difference = 0;
+  if (points.empty())
+    {
+    return res;
+    }
+
+  // the shape of lines L_i of length s_i is a zonotope, whose width
+  // along a normal n is sum_i s_i |L_i.n|. Fit the lengths to the
+  // widths of the kernel along many normals, by non negative least
+  // squares, to get a first guess.
+  DecompType normals;
+  mkDirections(VDimension == 2 ? 8 : 3, normals);
+  const unsigned nd = directions.size();
+  const unsigned nn = normals.size();
+  std::vector<float> residual(nn), norms(nd, 0.0), lengths(nd, 0.0);
+  std::vector<std::vector<float> > A(nd, std::vector<float>(nn));
+  for (unsigned n = 0; n < nn; n++)
+    {
+    normals[n].Normalize();
+    float low = points[0] * normals[n], high = low;
+    for (unsigned p = 1; p < points.size(); p++)
+      {
+      float d = points[p] * normals[n];
+      if (d < low) low = d;
+      if (d > high) high = d;
+      }
+    residual[n] = low - high;
+    }
+  for (unsigned d = 0; d < nd; d++)
+    {
+    LType U = directions[d];
+    U.Normalize();
+    for (unsigned n = 0; n < nn; n++)
+      {
+      A[d][n] = fabs(U * normals[n]);
+      norms[d] += A[d][n] * A[d][n];
+      }
+    }
+  for (unsigned iter = 0; iter < 200; iter++)
+    {
+    for (unsigned d = 0; d < nd; d++)
+      {
+      float g = 0.0;
+      for (unsigned n = 0; n < nn; n++)
+	{
+	g += A[d][n] * residual[n];
+	}
+      float next = lengths[d] - g / norms[d];
+      if (next < 0) next = 0;
+      float step = next - lengths[d];
+      lengths[d] = next;
+      for (unsigned n = 0; n < nn; n++)
+	{
+	residual[n] += step * A[d][n];
+	}
+      }
+    }
+
+  // the lines have an odd number of points: a line of 2k+1 points
+  // takes 2k steps along its direction
+  std::vector<int> steps(nd), trial;
+  for (unsigned d = 0; d < nd; d++)
+    {
+    steps[d] = 2 * (int)(lengths[d] / directions[d].GetNorm() / 2.0 + 0.5);
+    }
+
+  // then move the lengths, two pixels at a time, one line or a pair
+  // of lines at once, while the shape gets closer to the kernel
+  std::vector<unsigned char> shape;
+  DecompType lines;
+  std::vector<unsigned int> periods;
+  mkLines(directions, steps, lines, periods);
+  unsigned long best = shapeDifference(lines, periods, target, size, shape);
+  bool improved = true;
+  while (improved && best > 0)
+    {
+    improved = false;
+    for (unsigned pairs = 0; pairs < 2 && !improved; pairs++)
+      {
+      for (unsigned d = 0; d < nd && !improved; d++)
+	{
+	for (unsigned e = (pairs ? d + 1 : nd); e <= nd && !improved; e++)
+	  {
+	  for (int move = 0; move < 4 && !improved; move++)
+	    {
+	    trial = steps;
+	    trial[d] += (move & 1) ? 2 : -2;
+	    if (e < nd)
+	      {
+	      trial[e] += (move & 2) ? 2 : -2;
+	      if (trial[e] < 0) continue;
+	      }
+	    else if (move > 1)
+	      {
+	      continue;
+	      }
+	    if (trial[d] < 0) continue;
+	    mkLines(directions, trial, lines, periods);
+	    unsigned long diff = shapeDifference(lines, periods, target, size, shape);
+	    if (diff < best)
+	      {
+	      best = diff;
+	      steps = trial;
+	      improved = true;
+	      }
+	    }
+	  }
+	}
+      }
+    }
+
+  difference = best;
+  if (best > tolerance * points.size())
+    {
+    return res;
+    }
+  mkLines(directions, steps, res.m_Lines, res.m_Periods);
+  if (res.m_Lines.empty())
+    {
+    // a single pixel
+    LType L;
+    L.Fill(0);
+    L[0] = 1;
+    res.m_Lines.push_back(L);
+    res.m_Periods.push_back(1);
+    }
+  res.m_Decomposable = true;
+  shapeDifference(res.m_Lines, res.m_Periods, target, size, shape);
+  // grow the kernel if the lines reach past it
+  RadiusType reach = radius;
+  for (unsigned long pos = 0; pos < shape.size(); pos++)
+    {
+    if (!shape[pos]) continue;
+    unsigned long r = pos;
+    for (unsigned i = 0; i < VDimension; i++)
+      {
+      long o = (long)(r % size[i]) - (long)(2 * radius[i] + 1);
+      r /= size[i];
+      if ((unsigned long)labs(o) > reach[i]) reach[i] = labs(o);
+      }
+    }
+  res.SetRadius(reach);
+  for (unsigned n = 0; n < res.Size(); n++)
+    {
+    typename Superclass::OffsetType O = res.GetOffset(n);
+    unsigned long pos = 0, stride = 1;
+    for (unsigned i = 0; i < VDimension; i++)
+      {
+      pos += (O[i] + 2 * radius[i] + 1) * stride;
+      stride *= size[i];
+      }
+    res[n] = shape[pos];
+    }
+  return res;
+}
+
+template<unsigned int VDimension>
+void
+FlatStructuringElement<VDimension>::
+mkDirections(int extent, DecompType &directions)
+{
+  directions.clear();
+  const int side = 2 * extent + 1;
+  int count = 1;
+  for (unsigned i = 0; i < VDimension; i++)
+    {
+    count *= side;
+    }
+  for (int c = 0; c < count; c++)
+    {
+    LType D;
+    int r = c, first = 0, g = 0;
+    for (unsigned i = 0; i < VDimension; i++)
+      {
+      int v = r % side - extent;
+      r /= side;
+      D[i] = v;
+      if (first == 0) first = v;
+      // gcd of the coordinates
+      int a = g, b = (v < 0) ? -v : v;
+      while (b)
+	{
+	int t = a % b;
+	a = b;
+	b = t;
+	}
+      g = a;
+      }
+    if (first > 0 && g == 1) directions.push_back(D);
+    }
+}
+
+template<unsigned int VDimension>
+void
+FlatStructuringElement<VDimension>::
+mkLines(const DecompType &directions, const std::vector<int> &steps,
+	DecompType &lines, std::vector<unsigned int> &periods)
+{
+  // a line along a direction with coordinates in {-1, 0, 1}, scaled
+  // by n, has n pixels. A direction with a larger coordinate m gives
+  // a periodic line of period m, whose steps + 1 points span steps * m
+  // + 1 pixels.
+  lines.clear();
+  periods.clear();
+  for (unsigned d = 0; d < directions.size(); d++)
+    {
+    if (steps[d] <= 0) continue;
+    unsigned int period = 0;
+    for (unsigned i = 0; i < VDimension; i++)
+      {
+      period = std::max(period, (unsigned int)fabs(directions[d][i]));
+      }
+    lines.push_back(directions[d] * ((float)(steps[d] * period + 1) / period));
+    periods.push_back(period);
+    }
+}
+
+template<unsigned int VDimension>
+unsigned long
+FlatStructuringElement<VDimension>::
+shapeDifference(const DecompType &lines,
+		const std::vector<unsigned int> &periods,
+		const std::vector<unsigned char> &target,
+		const SizeType &size,
+		std::vector<unsigned char> &shape)
+{
+  typedef AnchorStridedMorphology<unsigned char, VDimension> StridedType;
+  typename StridedType::SizeType Size;
+  typename StridedType::StrideType Strides;
+  unsigned long centre = 0, stride = 1;
+  for (unsigned i = 0; i < VDimension; i++)
+    {
+    Size[i] = size[i];
+    Strides[i] = stride;
+    centre += (size[i] / 2) * stride;
+    stride *= size[i];
+    }
+  shape.assign(target.size(), 0);
+  shape[centre] = 1;
+  if (!lines.empty())
+    {
+    FlatStructuringElement K = FlatStructuringElement();
+    K.m_Decomposable = true;
+    K.m_Lines = lines;
+    K.m_Periods = periods;
+    typename StridedType::Pointer dilate = StridedType::New();
+    dilate->SetKernel(K);
+    dilate->SetOperation(StridedType::DILATE);
+    dilate->Run(&(shape[0]), Strides, &(shape[0]), Strides, Size);
+    }
+  unsigned long diff = 0;
+  for (unsigned long n = 0; n < shape.size(); n++)
+    {
+    if (shape[n] != target[n]) ++diff;
+    }
+  return diff;
+}
+
 template<unsigned int VDimension>
 bool
 FlatStructuringElement<VDimension>::
@@ -768,7 +1174,12 @@ void FlatStructuringElement< VDimension >
     os << indent << "SE decomposition:" << std::endl;
     for (unsigned i = 0;i < m_Lines.size(); i++)
       {
-      os << indent << m_Lines[i] << std::endl;
+      os << indent << m_Lines[i];
+      if (GetPeriod(i) > 1)
+	{
+	os << " period " << GetPeriod(i);
+	}
+      os << std::endl;
       }
     }
 }
@@ -791,6 +1202,28 @@ ComputeBufferFromLines()
   // Image typedef
   typedef Image<bool, VDimension> ImageType;
 
+  // grow the kernel if the lines reach past it, so that the buffer
+  // holds the whole shape
+  typedef BresenhamLine<VDimension> BresType;
+  RadiusType radius = this->GetRadius();
+  typename ImageType::SizeType reach;
+  reach.Fill(0);
+  for (unsigned i = 0; i < m_Lines.size(); i++)
+    {
+    unsigned int SELength = getLinePixels<LType>(m_Lines[i]) | 1;
+    typename BresType::OffsetArray offsets = mkLineOffsets<BresType, LType>(m_Lines[i], this->GetPeriod(i), 2 * SELength);
+    typename ImageType::SizeType r = getLineReach<ImageType, BresType>(offsets, SELength);
+    for (unsigned d = 0; d < VDimension; d++)
+      {
+      reach[d] += r[d];
+      }
+    }
+  for (unsigned d = 0; d < VDimension; d++)
+    {
+    radius[d] = std::max((unsigned long)radius[d], (unsigned long)reach[d]);
+    }
+  this->SetRadius(radius);
+
   // Create an image to hold the ellipsoid
   //
   typename ImageType::Pointer sourceImage = ImageType::New();
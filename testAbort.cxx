@@ -0,0 +1,188 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkCommand.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+
+// check that the progress is reported during the passes, and that an
+// abort requested from a progress observer stops the sweep at the
+// next check and leaves a copy of the input in the output
+const int dim = 3;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::Image< PType, dim - 1 > SType;
+typedef itk::FlatStructuringElement<dim> SEType;
+
+class ProgressObserver : public itk::Command
+{
+public:
+  typedef ProgressObserver Self;
+  typedef itk::Command Superclass;
+  typedef itk::SmartPointer<Self> Pointer;
+  itkNewMacro(Self);
+
+  void Execute(const itk::Object *, const itk::EventObject &)
+  {
+  }
+  void Execute(itk::Object * caller, const itk::EventObject & event)
+  {
+    if (!itk::ProgressEvent().CheckEvent(&event))
+      {
+      return;
+      }
+    itk::ProcessObject * filter = dynamic_cast<itk::ProcessObject *>(caller);
+    float p = filter->GetProgress();
+    if (p < m_Last) m_Decreasing = true;
+    m_Last = p;
+    if (filter->GetAbortGenerateData())
+      {
+      m_AfterAbort++;
+      }
+    else
+      {
+      m_Events++;
+      }
+    if ((m_AbortAt > 0) && (p >= m_AbortAt))
+      {
+      filter->AbortGenerateDataOn();
+      }
+  }
+  unsigned m_Events;
+  unsigned m_AfterAbort;
+  float m_AbortAt;
+  float m_Last;
+  bool m_Decreasing;
+protected:
+  ProgressObserver()
+  {
+    m_Events = 0;
+    m_AfterAbort = 0;
+    m_AbortAt = 0;
+    m_Last = 0;
+    m_Decreasing = false;
+  }
+};
+
+template <class TFilter>
+int check(const char * name, IType * input, const SEType &K, int threads)
+{
+  int errors = 0;
+  unsigned passes = K.GetLines().size();
+  {
+  // a full run reports progress many times per pass
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->SetNumberOfThreads(threads);
+  ProgressObserver::Pointer observer = ProgressObserver::New();
+  filter->AddObserver(itk::ProgressEvent(), observer);
+  filter->Update();
+  if ((observer->m_Events < 4 * passes) || observer->m_Decreasing || (observer->m_Last < 0.999))
+    {
+    std::cerr << name << ": " << observer->m_Events << " progress events, last "
+	      << observer->m_Last << std::endl;
+    errors++;
+    }
+  }
+  {
+  // abort after a quarter of the work
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->SetNumberOfThreads(threads);
+  ProgressObserver::Pointer observer = ProgressObserver::New();
+  observer->m_AbortAt = 0.25;
+  filter->AddObserver(itk::ProgressEvent(), observer);
+  bool aborted = false;
+  try
+    {
+    filter->Update();
+    }
+  catch (itk::ProcessAborted &)
+    {
+    aborted = true;
+    }
+  if (!aborted || (observer->m_Last > 0.5) || observer->m_AfterAbort)
+    {
+    std::cerr << name << ": not aborted at " << observer->m_Last << std::endl;
+    errors++;
+    }
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<IType> it(input, input->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (filter->GetOutput()->GetPixel(it.GetIndex()) != it.Get()) ++diff;
+    }
+  if (diff)
+    {
+    std::cerr << name << ": " << diff << " pixels of the aborted output differ from the input" << std::endl;
+    errors++;
+    }
+  }
+  return errors;
+}
+
+template <class TFilter>
+class Scheduled : public TFilter
+{
+public:
+  typedef Scheduled Self;
+  typedef itk::SmartPointer<Self> Pointer;
+  itkNewMacro(Self);
+protected:
+  Scheduled()
+  {
+    this->UseLineSchedulerOn();
+  }
+};
+
+int main(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius depth" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< SType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+
+  // a stack of shifted copies of the image, big enough for several
+  // checks per pass
+  SType::RegionType In = reader->GetOutput()->GetLargestPossibleRegion();
+  IType::RegionType All;
+  IType::SizeType ASize;
+  ASize[0] = In.GetSize()[0];
+  ASize[1] = In.GetSize()[1];
+  ASize[2] = atoi(argv[4]);
+  All.SetSize(ASize);
+  IType::Pointer stack = IType::New();
+  stack->SetRegions(All);
+  stack->Allocate();
+  itk::ImageRegionIteratorWithIndex<IType> stIt(stack, All);
+  for (stIt.GoToBegin(); !stIt.IsAtEnd(); ++stIt)
+    {
+    IType::IndexType Idx = stIt.GetIndex();
+    SType::IndexType SIdx;
+    SIdx[0] = In.GetIndex()[0] + (Idx[0] + 7 * Idx[2]) % ASize[0];
+    SIdx[1] = In.GetIndex()[1] + (Idx[1] + 3 * Idx[2]) % ASize[1];
+    stIt.Set(reader->GetOutput()->GetPixel(SIdx));
+    }
+
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  SEType K = SEType::Poly(Rad, atoi(argv[2]));
+
+  typedef itk::AnchorDilateImageFilter<IType, SEType> DilateType;
+  typedef itk::AnchorOpenImageFilter<IType, SEType> OpenType;
+  int errors = 0;
+  errors += check<DilateType>("dilate", stack, K, 1);
+  errors += check<Scheduled<DilateType> >("scheduled dilate", stack, K, 4);
+  errors += check<OpenType>("open", stack, K, 1);
+  return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
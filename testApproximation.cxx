@@ -0,0 +1,140 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+
+// compare the approximate erosions and dilations with the exact ones:
+// each must be within the reported error of the other, i.e. below the
+// other dilated by a box of that radius, or above it eroded
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::FlatStructuringElement<dim> SEType;
+typedef itk::AnchorErodeImageFilter<IType, SEType> ErodeType;
+typedef itk::AnchorDilateImageFilter<IType, SEType> DilateType;
+
+template <class TFilter>
+IType::Pointer runFilter(IType * input, const SEType &K, unsigned maxError,
+			 unsigned &error, unsigned &factor)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->SetMaximumError(maxError);
+  filter->Update();
+  error = filter->GetApproximationError();
+  factor = filter->GetShrinkFactor();
+  IType::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  return result;
+}
+
+template <class TFilter>
+IType::Pointer runFilter(IType * input, const SEType &K)
+{
+  unsigned error, factor;
+  return runFilter<TFilter>(input, K, 0, error, factor);
+}
+
+// count the pixels where low > high
+unsigned long countAbove(IType * low, IType * high)
+{
+  unsigned long count = 0;
+  itk::ImageRegionIteratorWithIndex<IType> it(low, low->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() > high->GetPixel(it.GetIndex())) ++count;
+    }
+  return count;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius maxError" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  int lines = atoi(argv[2]);
+  SEType K = lines ? SEType::Poly(Rad, lines) : SEType::Box(Rad);
+  unsigned maxError = atoi(argv[4]);
+
+  bool ok = true;
+  unsigned dilateError, erodeError, factor;
+  IType::Pointer exactDilate = runFilter<DilateType>(input, K);
+  IType::Pointer exactErode = runFilter<ErodeType>(input, K);
+  IType::Pointer approxDilate = runFilter<DilateType>(input, K, maxError, dilateError, factor);
+  IType::Pointer approxErode = runFilter<ErodeType>(input, K, maxError, erodeError, factor);
+  std::cout << "shrink factor " << factor << ", error " << dilateError << std::endl;
+  if ((factor < 2) || (dilateError == 0) || (dilateError > maxError) || (erodeError != dilateError))
+    {
+    std::cerr << "the approximation wasn't used as expected" << std::endl;
+    ok = false;
+    }
+  else
+    {
+    SEType::RadiusType ERad;
+    ERad.Fill(dilateError);
+    SEType E = SEType::Box(ERad);
+    unsigned long diff = 0;
+    diff += countAbove(approxDilate, runFilter<DilateType>(exactDilate, E));
+    diff += countAbove(exactDilate, runFilter<DilateType>(approxDilate, E));
+    diff += countAbove(runFilter<ErodeType>(exactErode, E), approxErode);
+    diff += countAbove(runFilter<ErodeType>(approxErode, E), exactErode);
+    if (diff)
+      {
+      std::cerr << diff << " pixels are beyond the error" << std::endl;
+      ok = false;
+      }
+    }
+
+  // the closing is the approximate dilation followed by the
+  // approximate erosion
+  typedef itk::AnchorCloseImageFilter<IType, SEType> CloseType;
+  CloseType::Pointer close = CloseType::New();
+  close->SetInput(input);
+  close->SetKernel(K);
+  close->SetMaximumError(maxError);
+  close->Update();
+  unsigned closeError;
+  IType::Pointer chain = runFilter<ErodeType>(approxDilate, K, maxError, closeError, factor);
+  if ((closeError != close->GetApproximationError()) ||
+      countAbove(chain, close->GetOutput()) || countAbove(close->GetOutput(), chain))
+    {
+    std::cerr << "the approximate closing differs" << std::endl;
+    ok = false;
+    }
+
+  // an error too small to shrink the oblique lines gives the exact
+  // closing
+  SEType O = SEType::Poly(Rad, 6);
+  CloseType::Pointer exactClose = CloseType::New();
+  exactClose->SetInput(input);
+  exactClose->SetKernel(O);
+  exactClose->Update();
+  close->SetKernel(O);
+  close->SetMaximumError(1);
+  close->Update();
+  if ((close->GetShrinkFactor() != 1) || (close->GetApproximationError() != 0) ||
+      countAbove(exactClose->GetOutput(), close->GetOutput()) ||
+      countAbove(close->GetOutput(), exactClose->GetOutput()))
+    {
+    std::cerr << "the closing without shrinking isn't exact" << std::endl;
+    ok = false;
+    }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
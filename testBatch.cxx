@@ -0,0 +1,186 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+
+#include <fstream>
+#include <sys/stat.h>
+
+// "write" prepares volumes and a job file for anchorBatch in a
+// directory, "check" compares what anchorBatch wrote with the filters
+typedef unsigned char PType;
+typedef itk::Image< PType, 2 > SType;
+typedef itk::Image< PType, 3 > IType;
+
+template <class TImage>
+bool writeRaw(TImage * image, const std::string &fileName)
+{
+  std::ofstream out(fileName.c_str(), std::ios::binary);
+  out.write(reinterpret_cast<const char *>(image->GetBufferPointer()),
+	    image->GetBufferedRegion().GetNumberOfPixels() * sizeof(PType));
+  return out.good();
+}
+
+template <class TImage>
+typename TImage::Pointer readRaw(const typename TImage::RegionType &region, const std::string &fileName)
+{
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(region);
+  image->Allocate();
+  std::ifstream in(fileName.c_str(), std::ios::binary);
+  in.read(reinterpret_cast<char *>(image->GetBufferPointer()),
+	  region.GetNumberOfPixels() * sizeof(PType));
+  if (!in)
+    {
+    std::cerr << "Can't read " << fileName << std::endl;
+    return 0;
+    }
+  return image;
+}
+
+template <class TFilter, class TImage>
+unsigned long compare(TImage * input, const typename TFilter::KernelType &K,
+		      const std::string &fileName)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->Update();
+  typename TImage::RegionType All = input->GetLargestPossibleRegion();
+  typename TImage::Pointer result = readRaw<TImage>(All, fileName);
+  if (!result)
+    {
+    return All.GetNumberOfPixels();
+    }
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<TImage> it(filter->GetOutput(), All);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (result->GetPixel(it.GetIndex()) != it.Get()) ++diff;
+    }
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ in " << fileName << std::endl;
+    }
+  return diff;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " write|check input directory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string mode = argv[1];
+  std::string dir = argv[3];
+
+  typedef itk::ImageFileReader< SType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  SType::RegionType SAll = reader->GetOutput()->GetLargestPossibleRegion();
+
+  // a stack of shifted copies of the image
+  IType::RegionType All;
+  IType::SizeType ASize;
+  ASize[0] = SAll.GetSize()[0];
+  ASize[1] = SAll.GetSize()[1];
+  ASize[2] = 5;
+  All.SetSize(ASize);
+
+  if (mode == "write")
+    {
+    mkdir(dir.c_str(), 0755);
+    IType::Pointer stack = IType::New();
+    stack->SetRegions(All);
+    stack->Allocate();
+    itk::ImageRegionIteratorWithIndex<IType> stIt(stack, All);
+    for (stIt.GoToBegin(); !stIt.IsAtEnd(); ++stIt)
+      {
+      IType::IndexType Idx = stIt.GetIndex();
+      SType::IndexType SIdx;
+      SIdx[0] = SAll.GetIndex()[0] + (Idx[0] + 7 * Idx[2]) % ASize[0];
+      SIdx[1] = SAll.GetIndex()[1] + (Idx[1] + 3 * Idx[2]) % ASize[1];
+      stIt.Set(reader->GetOutput()->GetPixel(SIdx));
+      }
+    if (!writeRaw(stack.GetPointer(), dir + "/stack.raw") ||
+	!writeRaw(reader->GetOutput(), dir + "/slice.raw") ||
+	!writeRaw(reader->GetOutput(), dir + "/inplace.raw"))
+      {
+      std::cerr << "Can't write the volumes" << std::endl;
+      return EXIT_FAILURE;
+      }
+    std::ofstream header((dir + "/stack.mhd").c_str());
+    header << "ObjectType = Image" << std::endl
+	   << "NDims = 3" << std::endl
+	   << "DimSize = " << ASize[0] << " " << ASize[1] << " " << ASize[2] << std::endl
+	   << "ElementType = MET_UCHAR" << std::endl
+	   << "ElementDataFile = stack.raw" << std::endl;
+    std::ofstream jobs((dir + "/jobs.txt").c_str());
+    jobs << "# operation kernel radius type input output [size]" << std::endl
+	 << "dilate box 2x3x1 uchar stack.mhd stack_dilate.mhd" << std::endl
+	 << "open poly8 5 uchar slice.raw slice_open.raw "
+	 << SAll.GetSize()[0] << "x" << SAll.GetSize()[1] << std::endl
+	 << std::endl
+	 << "close poly6 2 uchar stack.mhd stack_close.raw" << std::endl
+	 << "erode poly4 7 uchar slice.raw slice_erode.mhd "
+	 << SAll.GetSize()[0] << "x" << SAll.GetSize()[1] << std::endl
+	 // a job reading the output of the previous one, in place
+	 << "erode box 3x2x1 uchar stack.mhd stack_chain.mhd" << std::endl
+	 << "dilate box 3x2x1 uchar stack_chain.mhd stack_chain.mhd" << std::endl
+	 << "dilate poly4 3 uchar inplace.raw inplace.raw "
+	 << SAll.GetSize()[0] << "x" << SAll.GetSize()[1] << std::endl;
+    return (header && jobs) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+  IType::Pointer stack = readRaw<IType>(All, dir + "/stack.raw");
+  SType::Pointer slice = readRaw<SType>(SAll, dir + "/slice.raw");
+  if (!stack || !slice)
+    {
+    return EXIT_FAILURE;
+    }
+  typedef itk::FlatStructuringElement<3> SE3Type;
+  typedef itk::FlatStructuringElement<2> SE2Type;
+  SE3Type::RadiusType Rad3;
+  SE2Type::RadiusType Rad2;
+  unsigned long diff = 0;
+
+  Rad3[0] = 2; Rad3[1] = 3; Rad3[2] = 1;
+  diff += compare<itk::AnchorDilateImageFilter<IType, SE3Type> >(stack.GetPointer(), SE3Type::Box(Rad3), dir + "/stack_dilate.raw");
+  Rad2.Fill(5);
+  diff += compare<itk::AnchorOpenImageFilter<SType, SE2Type> >(slice.GetPointer(), SE2Type::Poly(Rad2, 8), dir + "/slice_open.raw");
+  Rad3.Fill(2);
+  diff += compare<itk::AnchorCloseImageFilter<IType, SE3Type> >(stack.GetPointer(), SE3Type::Poly(Rad3, 6), dir + "/stack_close.raw");
+  Rad2.Fill(7);
+  diff += compare<itk::AnchorErodeImageFilter<SType, SE2Type> >(slice.GetPointer(), SE2Type::Poly(Rad2, 4), dir + "/slice_erode.raw");
+
+  Rad3[0] = 3; Rad3[1] = 2; Rad3[2] = 1;
+  typedef itk::AnchorErodeImageFilter<IType, SE3Type> Erode3Type;
+  Erode3Type::Pointer erode = Erode3Type::New();
+  erode->SetInput(stack);
+  erode->SetKernel(SE3Type::Box(Rad3));
+  erode->Update();
+  diff += compare<itk::AnchorDilateImageFilter<IType, SE3Type> >(erode->GetOutput(), SE3Type::Box(Rad3), dir + "/stack_chain.raw");
+  Rad2.Fill(3);
+  diff += compare<itk::AnchorDilateImageFilter<SType, SE2Type> >(slice.GetPointer(), SE2Type::Poly(Rad2, 4), dir + "/inplace.raw");
+
+  // the headers are renamed into place with their data
+  const char * headers[] = { "stack_dilate.mhd", "slice_erode.mhd", "stack_chain.mhd" };
+  for (unsigned i = 0; i < 3; i++)
+    {
+    struct stat st;
+    std::string header = dir + "/" + headers[i];
+    if (stat(header.c_str(), &st) || !stat((header + ".tmp").c_str(), &st))
+      {
+      std::cerr << header << " wasn't renamed into place" << std::endl;
+      diff++;
+      }
+    }
+  return diff ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
@@ -0,0 +1,181 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+
+// compare the chords of the kernels that aren't decomposable, balls
+// and a mask of no particular shape, with a neighbourhood filter: the
+// minimum over the pixels of the kernel for an erosion, and the
+// maximum over the pixels of the mirrored kernel for a dilation,
+// ignoring the pixels outside the image
+
+template <class TImage, class TKernel>
+typename TImage::Pointer bruteForce(const TImage * input, const TKernel &K, bool dilate)
+{
+  typedef typename TImage::PixelType PType;
+  const typename TImage::RegionType All = input->GetLargestPossibleRegion();
+  typename TImage::Pointer output = TImage::New();
+  output->SetRegions(All);
+  output->Allocate();
+  itk::ImageRegionIteratorWithIndex<TImage> it(output, All);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    bool found = false;
+    PType extreme = 0;
+    for (unsigned n = 0; n < K.Size(); n++)
+      {
+      if (!K[n]) continue;
+      typename TImage::IndexType Idx = dilate ? it.GetIndex() - K.GetOffset(n) : it.GetIndex() + K.GetOffset(n);
+      if (!All.IsInside(Idx)) continue;
+      PType v = input->GetPixel(Idx);
+      if (!found || (dilate ? v > extreme : v < extreme))
+	{
+	extreme = v;
+	found = true;
+	}
+      }
+    it.Set(extreme);
+    }
+  return output;
+}
+
+template <class TFilter, class TImage>
+typename TImage::Pointer apply(TImage * input, const typename TFilter::KernelType &K,
+			       const typename TImage::RegionType &region)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->GetOutput()->SetRequestedRegion(region);
+  filter->Update();
+  typename TImage::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  return result;
+}
+
+template <class TImage>
+bool compare(const TImage * expected, const TImage * result,
+	     const typename TImage::RegionType &region, const std::string &name)
+{
+  unsigned long diff = 0;
+  itk::ImageRegionConstIteratorWithIndex<TImage> it(expected, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (result->GetPixel(it.GetIndex()) != it.Get()) ++diff;
+    }
+  if (diff)
+    {
+    std::cerr << name << ": " << diff << " pixels differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+template <class TImage>
+bool check(TImage * input, const itk::FlatStructuringElement<TImage::ImageDimension> &K,
+	   const std::string &name)
+{
+  typedef itk::FlatStructuringElement<TImage::ImageDimension> SEType;
+  typename TImage::RegionType All = input->GetLargestPossibleRegion();
+  // the middle half of the image, whose input is padded by the
+  // kernel for the erosions and the dilations
+  typename TImage::RegionType Middle = All;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    Middle.SetIndex(i, All.GetIndex()[i] + All.GetSize()[i] / 4);
+    Middle.SetSize(i, std::max(1UL, (unsigned long)All.GetSize()[i] / 2));
+    }
+
+  typename TImage::Pointer eroded = bruteForce<TImage>(input, K, false);
+  typename TImage::Pointer dilated = bruteForce<TImage>(input, K, true);
+  bool ok = true;
+  ok &= compare<TImage>(eroded, apply<itk::AnchorErodeImageFilter<TImage, SEType> >(input, K, All), All, name + " erode");
+  ok &= compare<TImage>(dilated, apply<itk::AnchorDilateImageFilter<TImage, SEType> >(input, K, All), All, name + " dilate");
+  ok &= compare<TImage>(eroded, apply<itk::AnchorErodeImageFilter<TImage, SEType> >(input, K, Middle), Middle, name + " erode region");
+  ok &= compare<TImage>(dilated, apply<itk::AnchorDilateImageFilter<TImage, SEType> >(input, K, Middle), Middle, name + " dilate region");
+  ok &= compare<TImage>(bruteForce<TImage>(eroded, K, true),
+			apply<itk::AnchorOpenImageFilter<TImage, SEType> >(input, K, All), All, name + " open");
+  ok &= compare<TImage>(bruteForce<TImage>(dilated, K, false),
+			apply<itk::AnchorCloseImageFilter<TImage, SEType> >(input, K, All), All, name + " close");
+  return ok;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " input radius" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::Image< unsigned char, 2 > IType;
+  typedef itk::FlatStructuringElement<2> SEType;
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+  int radius = atoi(argv[2]);
+
+  bool ok = true;
+  SEType::RadiusType Rad;
+  Rad.Fill(radius);
+  ok &= check<IType>(input, SEType::Ball(Rad), "disc");
+  Rad[1] = radius / 2 + 1;
+  ok &= check<IType>(input, SEType::Ball(Rad), "ellipse");
+
+  // a mask that isn't symmetric, with several chords on a row
+  IType::Pointer mask = IType::New();
+  IType::RegionType MReg;
+  IType::SizeType MSize;
+  MSize.Fill(2 * radius + 1);
+  MReg.SetSize(MSize);
+  mask->SetRegions(MReg);
+  mask->Allocate();
+  itk::ImageRegionIteratorWithIndex<IType> mIt(mask, MReg);
+  for (mIt.GoToBegin(); !mIt.IsAtEnd(); ++mIt)
+    {
+    IType::IndexType Idx = mIt.GetIndex();
+    mIt.Set(((Idx[0] * 7 + Idx[1] * 3) % 5 < 2) || (Idx[0] > Idx[1]));
+    }
+  ok &= check<IType>(input, SEType::FromImage(mask.GetPointer()), "mask");
+
+  // balls in 3D, on a stack of shifted copies of the image
+  typedef itk::Image< short, 3 > VType;
+  typedef itk::FlatStructuringElement<3> SE3Type;
+  VType::Pointer stack = VType::New();
+  VType::RegionType VReg;
+  VType::SizeType VSize;
+  VSize[0] = 40;
+  VSize[1] = 35;
+  VSize[2] = 13;
+  VReg.SetSize(VSize);
+  stack->SetRegions(VReg);
+  stack->Allocate();
+  const IType::RegionType In = input->GetLargestPossibleRegion();
+  itk::ImageRegionIteratorWithIndex<VType> vIt(stack, VReg);
+  for (vIt.GoToBegin(); !vIt.IsAtEnd(); ++vIt)
+    {
+    VType::IndexType Idx = vIt.GetIndex();
+    IType::IndexType SIdx;
+    SIdx[0] = In.GetIndex()[0] + (Idx[0] + 7 * Idx[2]) % In.GetSize()[0];
+    SIdx[1] = In.GetIndex()[1] + (Idx[1] + 3 * Idx[2]) % In.GetSize()[1];
+    vIt.Set((short)input->GetPixel(SIdx) - 100);
+    }
+  for (int r = 1; r <= 3; r++)
+    {
+    SE3Type::RadiusType Rad3;
+    Rad3.Fill(r);
+    ok &= check<VType>(stack, SE3Type::Ball(Rad3), "ball");
+    }
+
+  if (!ok)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include "itkImage.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorDilateImageFilter.h"
+
+// decompose masks into lines, and compare the shapes of the lines with
+// the masks and with the dilation of a single pixel by the filter
+template <unsigned int dim>
+unsigned long countPixels(const itk::FlatStructuringElement<dim> &K)
+{
+  unsigned long count = 0;
+  for (unsigned n = 0; n < K.Size(); n++)
+    {
+    if (K[n]) ++count;
+    }
+  return count;
+}
+
+template <unsigned int dim>
+bool checkDecomposition(const itk::FlatStructuringElement<dim> &mask,
+			float tolerance, const char * name)
+{
+  typedef itk::FlatStructuringElement<dim> SEType;
+  typedef itk::Image<unsigned char, dim> IType;
+  SEType K = SEType::Decompose(mask, tolerance);
+  if (!K.GetDecomposable())
+    {
+    std::cerr << name << " wasn't decomposed" << std::endl;
+    return false;
+    }
+  unsigned long diff = 0;
+  for (unsigned n = 0; n < mask.Size(); n++)
+    {
+    if (K[n] != mask[n]) ++diff;
+    }
+  unsigned long count = countPixels(mask);
+  std::cout << name << ": " << K.GetLines().size() << " lines, "
+	    << diff << " of " << count << " pixels differ" << std::endl;
+  if (diff > tolerance * count)
+    {
+    std::cerr << name << " differs by more than the tolerance" << std::endl;
+    return false;
+    }
+
+  // the buffer of the kernel is what the filter does to a pixel
+  typename IType::Pointer point = IType::New();
+  typename IType::RegionType region;
+  typename IType::SizeType size;
+  typename IType::IndexType centre;
+  for (unsigned i = 0; i < dim; i++)
+    {
+    size[i] = K.GetSize(i);
+    centre[i] = K.GetRadius(i);
+    }
+  region.SetSize(size);
+  point->SetRegions(region);
+  point->Allocate();
+  point->FillBuffer(0);
+  point->SetPixel(centre, 255);
+  typedef itk::AnchorDilateImageFilter<IType, SEType> FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(point);
+  filter->SetKernel(K);
+  filter->Update();
+  itk::ImageRegionIteratorWithIndex<IType> it(filter->GetOutput(), region);
+  unsigned n = 0;
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it, ++n)
+    {
+    if ((it.Get() != 0) != K[n])
+      {
+      std::cerr << name << " doesn't match its dilation at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// a mask through an image, the way a user would give one
+template <unsigned int dim>
+itk::FlatStructuringElement<dim> mkMask(itk::FlatStructuringElement<dim> K)
+{
+  typedef itk::Image<unsigned char, dim> IType;
+  typename IType::Pointer image = K.template GetImage<IType>();
+  return itk::FlatStructuringElement<dim>::FromImage(image.GetPointer());
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " radius2D radius3D tolerance" << std::endl;
+    return EXIT_FAILURE;
+    }
+  typedef itk::FlatStructuringElement<2> SE2Type;
+  typedef itk::FlatStructuringElement<3> SE3Type;
+  SE2Type::RadiusType Rad2;
+  SE3Type::RadiusType Rad3;
+  Rad2.Fill(atoi(argv[1]));
+  Rad3.Fill(atoi(argv[2]));
+  float tolerance = atof(argv[3]);
+
+  bool ok = true;
+  // shapes made of lines are found exactly
+  ok &= checkDecomposition(mkMask(SE2Type::Box(Rad2)), 0.0, "box 2D");
+  ok &= checkDecomposition(mkMask(SE2Type::Poly(Rad2, 4)), 0.0, "poly4 2D");
+  ok &= checkDecomposition(mkMask(SE3Type::Box(Rad3)), 0.0, "box 3D");
+  Rad2[1] = Rad2[0] / 2;
+  ok &= checkDecomposition(mkMask(SE2Type::Box(Rad2)), 0.0, "rectangle 2D");
+  Rad2[1] = Rad2[0];
+
+  // balls are approximated
+  ok &= checkDecomposition(SE2Type::Ball(Rad2), tolerance, "ball 2D");
+  ok &= checkDecomposition(SE3Type::Ball(Rad3), tolerance, "ball 3D");
+  Rad2[1] = Rad2[0] / 2 + 1;
+  ok &= checkDecomposition(SE2Type::Ball(Rad2), tolerance, "ellipse 2D");
+  Rad2[1] = Rad2[0];
+
+  // a triangle isn't symmetric, and is left alone
+  SE2Type triangle;
+  triangle.SetRadius(Rad2);
+  for (unsigned n = 0; n < triangle.Size(); n++)
+    {
+    SE2Type::OffsetType O = triangle.GetOffset(n);
+    triangle[n] = (O[0] >= 0 && O[1] >= 0 && O[0] + O[1] <= (long)Rad2[0]);
+    }
+  SE2Type T = SE2Type::Decompose(triangle, 0.0);
+  if (T.GetDecomposable() || countPixels(T) != countPixels(triangle))
+    {
+    std::cerr << "the triangle was decomposed" << std::endl;
+    ok = false;
+    }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,168 @@
+// only use the instantiations of the library
+#define ANCHOR_MANUAL_INSTANTIATION
+
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+#include "itkAnchorMorphologyDispatch.h"
+
+// run the dispatcher on images of several types, and compare the
+// results with the filters applied to the unsigned char image
+typedef unsigned char PType;
+typedef itk::Image< PType, 2 > IType;
+typedef itk::Image< PType, 3 > I3Type;
+
+template <class TOut, class TIn>
+typename TOut::Pointer convert(TIn * input)
+{
+  typename TOut::Pointer output = TOut::New();
+  output->SetRegions(input->GetLargestPossibleRegion());
+  output->Allocate();
+  itk::ImageRegionIteratorWithIndex<TOut> it(output, output->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    it.Set(static_cast<typename TOut::PixelType>(input->GetPixel(it.GetIndex())));
+    }
+  return output;
+}
+
+template <class TFilter, class TImage>
+typename TImage::Pointer runFilter(TImage * input, const typename TFilter::KernelType &K)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->Update();
+  typename TImage::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  return result;
+}
+
+// the dispatched result, of type TOther, against the expected
+// unsigned char one
+template <class TOther, class TImage>
+unsigned long compare(itk::AnchorMorphologyDispatch * dispatch, TImage * input,
+		      TImage * expected, const char * name)
+{
+  typename TOther::Pointer other = convert<TOther>(input);
+  itk::DataObject::Pointer result = dispatch->Run(other.GetPointer());
+  TOther * typed = dynamic_cast<TOther *>(result.GetPointer());
+  if (!typed)
+    {
+    std::cerr << name << ": the result doesn't have the type of the input" << std::endl;
+    return 1;
+    }
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<TImage> it(expected, expected->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (typed->GetPixel(it.GetIndex()) != static_cast<typename TOther::PixelType>(it.Get())) ++diff;
+    }
+  if (diff)
+    {
+    std::cerr << name << ": " << diff << " pixels differ" << std::endl;
+    }
+  return diff;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType::Pointer input = reader->GetOutput();
+  unsigned int lines = atoi(argv[2]);
+  unsigned long radius = atoi(argv[3]);
+
+  // a small stack for the 3D types
+  IType::RegionType In = input->GetLargestPossibleRegion();
+  I3Type::RegionType All;
+  I3Type::SizeType ASize;
+  ASize[0] = In.GetSize()[0];
+  ASize[1] = In.GetSize()[1];
+  ASize[2] = 4;
+  All.SetSize(ASize);
+  I3Type::Pointer stack = I3Type::New();
+  stack->SetRegions(All);
+  stack->Allocate();
+  itk::ImageRegionIteratorWithIndex<I3Type> stIt(stack, All);
+  for (stIt.GoToBegin(); !stIt.IsAtEnd(); ++stIt)
+    {
+    I3Type::IndexType Idx = stIt.GetIndex();
+    IType::IndexType SIdx;
+    SIdx[0] = In.GetIndex()[0] + (Idx[0] + 5 * Idx[2]) % ASize[0];
+    SIdx[1] = In.GetIndex()[1] + Idx[1];
+    stIt.Set(input->GetPixel(SIdx));
+    }
+
+  typedef itk::FlatStructuringElement<2> SEType;
+  SEType::RadiusType Rad;
+  Rad.Fill(radius);
+  SEType K = SEType::Poly(Rad, lines);
+  typedef itk::FlatStructuringElement<3> SE3Type;
+  SE3Type::RadiusType Rad3;
+  Rad3[0] = radius;
+  Rad3[1] = 2;
+  Rad3[2] = 1;
+
+  itk::AnchorMorphologyDispatch::Pointer dispatch = itk::AnchorMorphologyDispatch::New();
+  unsigned long diff = 0;
+
+  dispatch->SetLines(lines);
+  dispatch->SetRadius(radius);
+  dispatch->SetOperation(itk::AnchorMorphologyDispatch::DILATE);
+  IType::Pointer dilated = runFilter<itk::AnchorDilateImageFilter<IType, SEType> >(input.GetPointer(), K);
+  diff += compare<IType>(dispatch, input.GetPointer(), dilated.GetPointer(), "uchar dilate");
+  diff += compare<itk::Image<int, 2> >(dispatch, input.GetPointer(), dilated.GetPointer(), "int dilate");
+
+  dispatch->SetOperation(itk::AnchorMorphologyDispatch::OPEN);
+  IType::Pointer opened = runFilter<itk::AnchorOpenImageFilter<IType, SEType> >(input.GetPointer(), K);
+  diff += compare<itk::Image<short, 2> >(dispatch, input.GetPointer(), opened.GetPointer(), "short open");
+  diff += compare<itk::Image<double, 2> >(dispatch, input.GetPointer(), opened.GetPointer(), "double open");
+
+  // a box with a radius for each dimension
+  itk::AnchorMorphologyDispatch::RadiusType Radius(3);
+  Radius[0] = Rad3[0];
+  Radius[1] = Rad3[1];
+  Radius[2] = Rad3[2];
+  dispatch->SetLines(0);
+  dispatch->SetRadius(Radius);
+  dispatch->SetOperation(itk::AnchorMorphologyDispatch::ERODE);
+  I3Type::Pointer eroded = runFilter<itk::AnchorErodeImageFilter<I3Type, SE3Type> >(stack.GetPointer(), SE3Type::Box(Rad3));
+  diff += compare<itk::Image<float, 3> >(dispatch, stack.GetPointer(), eroded.GetPointer(), "float erode");
+  dispatch->SetOperation(itk::AnchorMorphologyDispatch::CLOSE);
+  I3Type::Pointer closed = runFilter<itk::AnchorCloseImageFilter<I3Type, SE3Type> >(stack.GetPointer(), SE3Type::Box(Rad3));
+  diff += compare<itk::Image<unsigned short, 3> >(dispatch, stack.GetPointer(), closed.GetPointer(), "ushort close");
+
+  // an unsupported type
+  typedef itk::Image<float, 4> I4Type;
+  I4Type::Pointer four = I4Type::New();
+  if (itk::AnchorMorphologyDispatch::CanRun(four) || !itk::AnchorMorphologyDispatch::CanRun(stack))
+    {
+    std::cerr << "CanRun is wrong" << std::endl;
+    diff++;
+    }
+  try
+    {
+    dispatch->Run(four.GetPointer());
+    std::cerr << "a 4D image was accepted" << std::endl;
+    diff++;
+    }
+  catch (itk::ExceptionObject &)
+    {
+    }
+  return diff ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
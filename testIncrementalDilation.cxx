@@ -0,0 +1,126 @@
+#include "itkImageFileReader.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+
+#include "itkAnchorDilateImageFilter.h"
+
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::FlatStructuringElement<dim> SEType;
+typedef itk::AnchorDilateImageFilter<IType, SEType> FilterType;
+
+// the number of pixels of the output of filter that differ from a
+// full update
+unsigned long compareWithFull(FilterType * filter, IType * image, const SEType &K)
+{
+  FilterType::Pointer full = FilterType::New();
+  full->SetInput( image );
+  full->SetKernel(K);
+  full->Update();
+
+  IType::RegionType All = image->GetLargestPossibleRegion();
+  itk::ImageRegionConstIterator<IType> it1(filter->GetOutput(), All);
+  itk::ImageRegionConstIterator<IType> it2(full->GetOutput(), All);
+  unsigned long diff = 0;
+  for (it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2)
+    {
+    if (it1.Get() != it2.Get()) ++diff;
+    }
+  return diff;
+}
+
+// edit a few parts of an image and compare the incremental update
+// with a full one, then edit it without a dirty region and change
+// the kernel, which both need a full update
+int main(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius" << std::endl;
+    return EXIT_FAILURE;
+    }
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+
+  // the image that gets edited
+  IType::Pointer image = reader->GetOutput();
+  image->DisconnectPipeline();
+
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  SEType K = SEType::Poly(Rad, atoi(argv[2]));
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetKernel(K);
+  filter->IncrementalUpdateOn();
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+  filter->Update();
+
+  IType::RegionType All = image->GetLargestPossibleRegion();
+  for (int edit = 0; edit < 3; edit++)
+    {
+    // a brush stroke, partly outside the image for the last one
+    IType::RegionType Stroke;
+    IType::IndexType Start;
+    IType::SizeType Size;
+    for (unsigned i = 0; i < dim; i++)
+      {
+      Start[i] = All.GetIndex()[i] + (edit + 1) * All.GetSize()[i] / 3 - 4;
+      Size[i] = 5 + 3 * edit;
+      }
+    Stroke.SetIndex(Start);
+    Stroke.SetSize(Size);
+    Stroke.Crop(All);
+    itk::ImageRegionIterator<IType> sIt(image, Stroke);
+    for (sIt.GoToBegin(); !sIt.IsAtEnd(); ++sIt)
+      {
+      sIt.Set(sIt.Get() + 100 + 50 * edit);
+      }
+    image->Modified();
+    filter->AddDirtyRegion(Stroke);
+    filter->Update();
+
+    unsigned long diff = compareWithFull(filter, image, K);
+    if (diff)
+      {
+      std::cerr << diff << " pixels differ after edit " << edit << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // an edit of the whole image, without a dirty region
+  itk::ImageRegionIterator<IType> iIt(image, All);
+  for (iIt.GoToBegin(); !iIt.IsAtEnd(); ++iIt)
+    {
+    iIt.Set(255 - iIt.Get());
+    }
+  image->Modified();
+  filter->Update();
+  unsigned long diff = compareWithFull(filter, image, K);
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ after an edit without a dirty region" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // another kernel
+  Rad.Fill(atoi(argv[3]) / 2 + 1);
+  K = SEType::Box(Rad);
+  filter->SetKernel(K);
+  filter->Update();
+  diff = compareWithFull(filter, image, K);
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ after a change of kernel" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
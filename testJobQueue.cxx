@@ -0,0 +1,326 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkCommand.h"
+
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorJobQueue.h"
+
+#include <unistd.h>
+
+// run erosions and dilations on a job queue: the results are those
+// of Update, the threads of the running filters stay within the
+// maximum of the queue, the jobs start by priority, and queued and
+// running jobs can be cancelled
+
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::FlatStructuringElement<dim> SEType;
+typedef itk::AnchorErodeImageFilter<IType, SEType> ErodeType;
+typedef itk::AnchorDilateImageFilter<IType, SEType> DilateType;
+
+// counts the threads of the filters between their start and end
+// events, records the order of the starts, and can hold a filter at
+// its start until it is released
+class StartObserver : public itk::Command
+{
+public:
+  typedef StartObserver Self;
+  typedef itk::Command Superclass;
+  typedef itk::SmartPointer<Self> Pointer;
+  itkNewMacro(Self);
+
+  void Execute(itk::Object * caller, const itk::EventObject & event)
+  {
+    itk::ProcessObject * filter = static_cast<itk::ProcessObject *>(caller);
+    m_Mutex.Lock();
+    if (itk::StartEvent().CheckEvent(&event))
+      {
+      m_Threads += filter->GetNumberOfThreads();
+      if (m_Threads > m_MostThreads) m_MostThreads = m_Threads;
+      m_Order.push_back(filter);
+      }
+    else
+      {
+      m_Threads -= filter->GetNumberOfThreads();
+      }
+    while (itk::StartEvent().CheckEvent(&event) && (filter == m_Hold))
+      {
+      m_Mutex.Unlock();
+      usleep(1000);
+      m_Mutex.Lock();
+      }
+    m_Mutex.Unlock();
+  }
+  void Hold(itk::ProcessObject * filter)
+  {
+    m_Mutex.Lock();
+    m_Hold = filter;
+    m_Mutex.Unlock();
+  }
+  void Execute(const itk::Object *, const itk::EventObject &) {}
+
+  int m_Threads;
+  int m_MostThreads;
+  std::vector<itk::ProcessObject *> m_Order;
+  itk::ProcessObject * m_Hold;
+  itk::SimpleMutexLock m_Mutex;
+
+protected:
+  StartObserver()
+  {
+    m_Threads = 0;
+    m_MostThreads = 0;
+    m_Hold = 0;
+  }
+};
+
+// counts the EndEvent of the jobs
+class EndObserver : public itk::Command
+{
+public:
+  typedef EndObserver Self;
+  typedef itk::Command Superclass;
+  typedef itk::SmartPointer<Self> Pointer;
+  itkNewMacro(Self);
+
+  void Execute(itk::Object *, const itk::EventObject &)
+  {
+    m_Mutex.Lock();
+    ++m_Ends;
+    m_Mutex.Unlock();
+  }
+  void Execute(const itk::Object *, const itk::EventObject &) {}
+
+  int m_Ends;
+  itk::SimpleMutexLock m_Mutex;
+
+protected:
+  EndObserver()
+  {
+    m_Ends = 0;
+  }
+};
+
+template <class TFilter>
+typename TFilter::Pointer mkFilter(IType * input, int radius, int threads, StartObserver * observer)
+{
+  SEType::RadiusType Rad;
+  Rad.Fill(radius);
+  // an image of its own, as the jobs run together, which shares the
+  // pixels of input
+  IType::Pointer view = IType::New();
+  view->Graft(input);
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(view);
+  filter->SetKernel(SEType::Box(Rad));
+  filter->SetNumberOfThreads(threads);
+  filter->UseLineSchedulerOn();
+  filter->UseSmallKernelsOff();
+  filter->AddObserver(itk::StartEvent(), observer);
+  filter->AddObserver(itk::EndEvent(), observer);
+  return filter;
+}
+
+bool same(IType * a, IType * b)
+{
+  itk::ImageRegionIteratorWithIndex<IType> it(a, a->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (b->GetPixel(it.GetIndex()) != it.Get()) return false;
+    }
+  return true;
+}
+
+void waitForStatus(itk::AnchorJob * job, itk::AnchorJob::StatusType status)
+{
+  while (job->GetStatus() != status)
+    {
+    usleep(1000);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " input" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType::Pointer input = reader->GetOutput();
+  input->DisconnectPipeline();
+  int errors = 0;
+
+  // many jobs of several threads, against their synchronous update
+  {
+  itk::AnchorJobQueue::Pointer queue = itk::AnchorJobQueue::New();
+  queue->SetNumberOfWorkers(6);
+  queue->SetMaximumNumberOfThreads(4);
+  StartObserver::Pointer observer = StartObserver::New();
+  EndObserver::Pointer ends = EndObserver::New();
+  std::vector<itk::AnchorJob::Pointer> jobs;
+  for (int i = 0; i < 24; i++)
+    {
+    int radius = 1 + i % 5;
+    // some filters have more threads than the maximum
+    int threads = (i % 6 == 5) ? 16 : 1 + i % 3;
+    itk::ProcessObject::Pointer filter;
+    if (i % 2)
+      {
+      filter = mkFilter<ErodeType>(input, radius, threads, observer).GetPointer();
+      }
+    else
+      {
+      filter = mkFilter<DilateType>(input, radius, threads, observer).GetPointer();
+      }
+    jobs.push_back(queue->Submit(filter, i % 4, ends));
+    }
+  queue->WaitForAll();
+  for (unsigned i = 0; i < jobs.size(); i++)
+    {
+    if (!jobs[i]->Wait())
+      {
+      std::cerr << "job " << i << " didn't finish: " << jobs[i]->GetErrorMessage() << std::endl;
+      errors++;
+      continue;
+      }
+    int radius = 1 + i % 5;
+    bool ok;
+    if (i % 2)
+      {
+      ErodeType::Pointer sync = mkFilter<ErodeType>(input, radius, 1, StartObserver::New());
+      sync->Update();
+      ok = same(sync->GetOutput(), static_cast<ErodeType *>(jobs[i]->GetFilter())->GetOutput());
+      }
+    else
+      {
+      DilateType::Pointer sync = mkFilter<DilateType>(input, radius, 1, StartObserver::New());
+      sync->Update();
+      ok = same(sync->GetOutput(), static_cast<DilateType *>(jobs[i]->GetFilter())->GetOutput());
+      }
+    if (!ok)
+      {
+      std::cerr << "job " << i << " differs from Update" << std::endl;
+      errors++;
+      }
+    }
+  for (unsigned i = 0; i < jobs.size(); i++)
+    {
+    if ((jobs[i]->GetNumberOfThreads() > 4) || (jobs[i]->GetFilter()->GetNumberOfThreads() > 4))
+      {
+      std::cerr << "job " << i << " runs " << jobs[i]->GetFilter()->GetNumberOfThreads() << " threads, for a maximum of 4" << std::endl;
+      errors++;
+      }
+    }
+  if (observer->m_MostThreads > 4)
+    {
+    std::cerr << observer->m_MostThreads << " threads used together, for a maximum of 4" << std::endl;
+    errors++;
+    }
+  if (ends->m_Ends != (int)jobs.size())
+    {
+    std::cerr << ends->m_Ends << " end events for " << jobs.size() << " jobs" << std::endl;
+    errors++;
+    }
+  }
+
+  // a single worker, held by a first job while the others are queued
+  {
+  itk::AnchorJobQueue::Pointer queue = itk::AnchorJobQueue::New();
+  queue->SetNumberOfWorkers(1);
+  queue->SetMaximumQueueLength(4);
+  StartObserver::Pointer observer = StartObserver::New();
+  ErodeType::Pointer first = mkFilter<ErodeType>(input, 2, 1, observer);
+  observer->Hold(first);
+  itk::AnchorJob::Pointer held = queue->Submit(first, 0);
+  waitForStatus(held, itk::AnchorJob::RUNNING);
+  std::vector<itk::AnchorJob::Pointer> jobs;
+  int priorities[] = { 0, 2, 1, 2 };
+  for (int i = 0; i < 4; i++)
+    {
+    jobs.push_back(queue->Submit(mkFilter<ErodeType>(input, 1 + i, 1, observer), priorities[i]));
+    }
+  if (queue->Submit(mkFilter<ErodeType>(input, 1, 1, observer), 5))
+    {
+    std::cerr << "a job was queued beyond the maximum length" << std::endl;
+    errors++;
+    }
+  // cancel a queued job, which never starts
+  jobs[2]->Cancel();
+  if ((jobs[2]->GetStatus() != itk::AnchorJob::CANCELLED) || jobs[2]->Wait())
+    {
+    std::cerr << "the queued job wasn't cancelled" << std::endl;
+    errors++;
+    }
+  observer->Hold(0);
+  queue->WaitForAll();
+  // by priority, then in the order of submission
+  std::vector<itk::ProcessObject *> order;
+  order.push_back(first);
+  order.push_back(jobs[1]->GetFilter());
+  order.push_back(jobs[3]->GetFilter());
+  order.push_back(jobs[0]->GetFilter());
+  if (observer->m_Order != order)
+    {
+    std::cerr << "the jobs didn't start by priority" << std::endl;
+    errors++;
+    }
+  }
+
+  // cancel a running job on a large image
+  {
+  IType::Pointer large = IType::New();
+  IType::RegionType Region;
+  IType::SizeType Size;
+  Size.Fill(2000);
+  Region.SetSize(Size);
+  large->SetRegions(Region);
+  large->Allocate();
+  const IType::RegionType In = input->GetLargestPossibleRegion();
+  itk::ImageRegionIteratorWithIndex<IType> lIt(large, Region);
+  for (lIt.GoToBegin(); !lIt.IsAtEnd(); ++lIt)
+    {
+    IType::IndexType Idx = lIt.GetIndex();
+    IType::IndexType SIdx;
+    SIdx[0] = In.GetIndex()[0] + Idx[0] % In.GetSize()[0];
+    SIdx[1] = In.GetIndex()[1] + Idx[1] % In.GetSize()[1];
+    lIt.Set(input->GetPixel(SIdx));
+    }
+  itk::AnchorJobQueue::Pointer queue = itk::AnchorJobQueue::New();
+  StartObserver::Pointer observer = StartObserver::New();
+  ErodeType::Pointer filter = mkFilter<ErodeType>(large, 0, 1, observer);
+  SEType::RadiusType Rad;
+  Rad.Fill(15);
+  filter->SetKernel(SEType::Poly(Rad, 12));
+  observer->Hold(filter);
+  itk::AnchorJob::Pointer job = queue->Submit(filter, 0);
+  waitForStatus(job, itk::AnchorJob::RUNNING);
+  job->Cancel();
+  observer->Hold(0);
+  if (job->Wait() || (job->GetStatus() != itk::AnchorJob::CANCELLED) || (filter->GetProgress() > 0.5))
+    {
+    std::cerr << "the running job wasn't cancelled, progress " << filter->GetProgress() << std::endl;
+    errors++;
+    }
+  }
+
+  // the global queue
+  {
+  DilateType::Pointer filter = mkFilter<DilateType>(input, 3, 2, StartObserver::New());
+  itk::AnchorJob::Pointer job = itk::UpdateAsync(filter);
+  if (!job || !job->Wait())
+    {
+    std::cerr << "the job of the global queue failed" << std::endl;
+    errors++;
+    }
+  }
+
+  return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+#include "itkAnchorOpenBankImageFilter.h"
+#include "itkAnchorCloseBankImageFilter.h"
+
+// compare the banks of line openings and closings with the extremum
+// of separate openings and closings by the same lines
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::Image< unsigned short, dim > OType;
+typedef itk::FlatStructuringElement<dim> SEType;
+
+template <class TBank, class TFilter, class TCompare>
+unsigned long compare(IType * input, unsigned length, unsigned angles, int threads)
+{
+  typename TBank::Pointer bank = TBank::New();
+  bank->SetInput(input);
+  bank->SetLength(length);
+  bank->SetNumberOfAngles(angles);
+  bank->SetNumberOfThreads(threads);
+  bank->ComputeOrientationOn();
+  bank->Update();
+
+  // the orientation is optional
+  typename TBank::Pointer plain = TBank::New();
+  plain->SetInput(input);
+  plain->SetLength(length);
+  plain->SetAngles(bank->GetAngles());
+  plain->Update();
+
+  IType::RegionType All = input->GetLargestPossibleRegion();
+  IType::Pointer best = IType::New();
+  best->SetRegions(All);
+  best->Allocate();
+  OType::Pointer orientation = OType::New();
+  orientation->SetRegions(All);
+  orientation->Allocate();
+  TCompare better;
+  for (unsigned i = 0; i < angles; i++)
+    {
+    typename TFilter::Pointer filter = TFilter::New();
+    filter->SetInput(input);
+    filter->SetKernel(SEType::Line(bank->GetLine(i)));
+    filter->Update();
+    itk::ImageRegionIteratorWithIndex<IType> it(filter->GetOutput(), All);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      if ((i == 0) || better(it.Get(), best->GetPixel(it.GetIndex())))
+	{
+	best->SetPixel(it.GetIndex(), it.Get());
+	orientation->SetPixel(it.GetIndex(), i);
+	}
+      }
+    }
+
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<IType> it(best, All);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if ((bank->GetOutput()->GetPixel(it.GetIndex()) != it.Get()) ||
+	(plain->GetOutput()->GetPixel(it.GetIndex()) != it.Get()) ||
+	(bank->GetOrientationOutput()->GetPixel(it.GetIndex()) != orientation->GetPixel(it.GetIndex())))
+      {
+      ++diff;
+      }
+    }
+  return diff;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << "Usage: " << argv[0] << " input length angles threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+  unsigned length = atoi(argv[2]);
+  unsigned angles = atoi(argv[3]);
+  int threads = atoi(argv[4]);
+
+  typedef itk::AnchorOpenBankImageFilter<IType, OType> OpenBankType;
+  typedef itk::AnchorCloseBankImageFilter<IType, OType> CloseBankType;
+  typedef itk::AnchorOpenImageFilter<IType, SEType> OpenType;
+  typedef itk::AnchorCloseImageFilter<IType, SEType> CloseType;
+
+  bool ok = true;
+  unsigned long diff = compare<OpenBankType, OpenType, std::greater<PType> >(input, length, angles, threads);
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ in the opening bank" << std::endl;
+    ok = false;
+    }
+  diff = compare<CloseBankType, CloseType, std::less<PType> >(input, length, angles, threads);
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ in the closing bank" << std::endl;
+    ok = false;
+    }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,143 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorLineScheduler.h"
+
+// compare the sweep of the line scheduler with the plain sweep, on an
+// image and on a stack, and check that the chunks of the scheduler
+// cover the faces
+typedef unsigned char PType;
+typedef itk::Image< PType, 2 > SType;
+typedef itk::Image< PType, 3 > IType;
+
+template <class TFilter, class TImage>
+unsigned long compare(TImage * input, const typename TFilter::KernelType &K, int threads)
+{
+  typename TFilter::Pointer plain = TFilter::New();
+  plain->SetInput(input);
+  plain->SetKernel(K);
+  plain->SetNumberOfThreads(1);
+  plain->Update();
+
+  typename TFilter::Pointer scheduled = TFilter::New();
+  scheduled->SetInput(input);
+  scheduled->SetKernel(K);
+  scheduled->SetNumberOfThreads(threads);
+  scheduled->UseLineSchedulerOn();
+  scheduled->Update();
+
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<TImage> it(plain->GetOutput(), input->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (scheduled->GetOutput()->GetPixel(it.GetIndex()) != it.Get()) ++diff;
+    }
+  return diff;
+}
+
+// drain the deques of all the threads from one thread, which has to
+// steal all the chunks of the others
+template <class TImage, class TKernel>
+unsigned long checkChunks(const typename TImage::RegionType &All, const TKernel &K, unsigned threads)
+{
+  typedef itk::BresenhamLine<TImage::ImageDimension> BresType;
+  typedef itk::AnchorLineScheduler<TImage, BresType, typename TKernel::LType> SchedulerType;
+  unsigned int bufflength = 0;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    bufflength += All.GetSize()[i];
+    }
+  unsigned long errors = 0;
+  SchedulerType scheduler;
+  for (unsigned i = 0; i < K.GetLines().size(); i++)
+    {
+    typename SchedulerType::PassType pass = itk::mkLinePass<TImage, BresType, typename TKernel::LType>(All, K.GetLines()[i], bufflength);
+    scheduler.Initialize(pass, All, threads);
+    std::vector<int> covered(pass.Face.GetNumberOfPixels(), 0);
+    typename SchedulerType::Chunk chunk;
+    unsigned long chunks = 0, weight = 0;
+    while (scheduler.Next(0, chunk))
+      {
+      for (unsigned long p = chunk.First; p < chunk.First + chunk.Count; p++)
+	{
+	if (p < covered.size()) covered[p]++;
+	}
+      chunks++;
+      weight += chunk.Weight;
+      }
+    for (unsigned long p = 0; p < covered.size(); p++)
+      {
+      if (covered[p] != 1) ++errors;
+      }
+    if (weight != scheduler.GetTotalWeight()) ++errors;
+    if (chunks != scheduler.GetNumberOfChunks()) ++errors;
+    if ((threads > 1) && (scheduler.GetNumberOfSteals() == 0) && (chunks > threads)) ++errors;
+    }
+  return errors;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< SType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  int threads = atoi(argv[4]);
+
+  // a stack of shifted copies of the image
+  SType::RegionType In = reader->GetOutput()->GetLargestPossibleRegion();
+  IType::RegionType All;
+  IType::SizeType ASize;
+  ASize[0] = In.GetSize()[0];
+  ASize[1] = In.GetSize()[1];
+  ASize[2] = 9;
+  All.SetSize(ASize);
+  IType::Pointer stack = IType::New();
+  stack->SetRegions(All);
+  stack->Allocate();
+  itk::ImageRegionIteratorWithIndex<IType> stIt(stack, All);
+  for (stIt.GoToBegin(); !stIt.IsAtEnd(); ++stIt)
+    {
+    IType::IndexType Idx = stIt.GetIndex();
+    SType::IndexType SIdx;
+    SIdx[0] = In.GetIndex()[0] + (Idx[0] + 7 * Idx[2]) % ASize[0];
+    SIdx[1] = In.GetIndex()[1] + (Idx[1] + 3 * Idx[2]) % ASize[1];
+    stIt.Set(reader->GetOutput()->GetPixel(SIdx));
+    }
+
+  typedef itk::FlatStructuringElement<2> SE2Type;
+  SE2Type::RadiusType Rad2;
+  Rad2.Fill(atoi(argv[3]));
+  SE2Type K2 = SE2Type::Poly(Rad2, atoi(argv[2]));
+  typedef itk::FlatStructuringElement<3> SE3Type;
+  SE3Type::RadiusType Rad3;
+  Rad3.Fill(atoi(argv[3]));
+  SE3Type K3 = SE3Type::Poly(Rad3, 7);
+
+  unsigned long diff = 0;
+  diff += compare<itk::AnchorDilateImageFilter<SType, SE2Type> >(reader->GetOutput(), K2, threads);
+  diff += compare<itk::AnchorErodeImageFilter<SType, SE2Type> >(reader->GetOutput(), K2, threads);
+  diff += compare<itk::AnchorDilateImageFilter<IType, SE3Type> >(stack.GetPointer(), K3, threads);
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ between the scheduled and plain sweeps" << std::endl;
+    return EXIT_FAILURE;
+    }
+  unsigned long errors = checkChunks<SType>(In, K2, threads) + checkChunks<IType>(All, K3, threads);
+  if (errors)
+    {
+    std::cerr << errors << " errors in the chunks of the scheduler" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
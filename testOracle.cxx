@@ -0,0 +1,411 @@
+#include "itkImage.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+
+#include <sstream>
+
+// compare the filters with a brute force minimum or maximum over the
+// pixels of the kernel, on random cases: pixel types, dimensions,
+// kernels, lines of odd and even lengths, images smaller than the
+// kernel, requested regions and the threaded and tiled sweeps. A case
+// that fails is shrunk while it still fails, and the smallest one is
+// reported.
+//
+// The lines of the kernels are along the axes, the diagonals or
+// periodic, so that the kernel is the same everywhere in the
+// image. The passes don't see the pixels outside the image, so only
+// the erosions and dilations by boxes and single lines are compared up
+// to the border of the image, and the others where the kernel fits in
+// the image. The openings keep the monotone ends of the lines at the
+// border, unlike an erosion followed by a dilation, so they are
+// compared where the kernel fits twice.
+
+// a small generator, so that a seed gives the same case everywhere
+class Random
+{
+public:
+  Random(unsigned long seed)
+  {
+    m_State = seed * 2654435761UL + 1;
+  }
+  unsigned Next(unsigned n)
+  {
+    m_State = m_State * 1103515245UL + 12345UL;
+    return (unsigned)((m_State >> 16) & 0x7fff) % n;
+  }
+private:
+  unsigned long m_State;
+};
+
+enum { Erode, Dilate, Open, Close };
+enum { BoxKernel, LineKernel, PolyKernel, BallKernel, PeriodicKernel };
+enum { Plain, Scheduled, Tiled };
+const char * Operations[] = { "erode", "dilate", "open", "close" };
+const char * Kernels[] = { "box", "line", "poly", "ball", "periodic" };
+const char * Paths[] = { "plain", "scheduled", "tiled" };
+const char * Types[] = { "unsigned char", "short", "float" };
+
+struct Case
+{
+  unsigned Type;
+  unsigned Dimension;
+  unsigned Operation;
+  unsigned Kernel;
+  unsigned Radius[3];
+  int Direction[3];
+  unsigned Length;
+  unsigned Size[3];
+  bool UseRegion;
+  unsigned Path;
+  unsigned TileSize;
+  unsigned long ImageSeed;
+  unsigned Sparsity;
+
+  std::string Describe() const
+  {
+    std::ostringstream s;
+    s << Types[Type] << " " << Dimension << "D, " << Operations[Operation]
+      << " by " << Kernels[Kernel];
+    if (Kernel == LineKernel)
+      {
+      s << " of " << Length << " pixels along";
+      for (unsigned i = 0; i < Dimension; i++) s << " " << Direction[i];
+      }
+    else
+      {
+      s << " of radius";
+      for (unsigned i = 0; i < Dimension; i++) s << " " << Radius[i];
+      }
+    s << ", image";
+    for (unsigned i = 0; i < Dimension; i++) s << " " << Size[i];
+    s << " (seed " << ImageSeed << ", 1 pixel in " << Sparsity << ")"
+      << (UseRegion ? ", requested region" : "") << ", " << Paths[Path];
+    if (Path == Tiled) s << " " << TileSize;
+    return s.str();
+  }
+};
+
+Case mkCase(unsigned long seed)
+{
+  Random r(seed);
+  Case c;
+  c.Type = r.Next(3);
+  c.Dimension = 2 + r.Next(2);
+  c.Operation = r.Next(4);
+  c.Kernel = r.Next(5);
+  unsigned maxRadius = c.Dimension == 2 ? 6 : 3;
+  unsigned maxSize = c.Dimension == 2 ? 30 : 12;
+  unsigned radius = 1 + r.Next(maxRadius);
+  bool zero = true;
+  for (unsigned i = 0; i < 3; i++)
+    {
+    // boxes may be flat along some axes
+    c.Radius[i] = (c.Kernel == BoxKernel) ? r.Next(maxRadius + 1) : radius;
+    c.Direction[i] = (int)r.Next(3) - 1;
+    zero = zero && (c.Direction[i] == 0 || i >= c.Dimension);
+    // some images are smaller than the kernel
+    c.Size[i] = 1 + r.Next(maxSize);
+    }
+  if (zero) c.Direction[0] = 1;
+  c.Length = 1 + r.Next(2 * maxRadius + 2);
+  c.UseRegion = (c.Operation == Erode || c.Operation == Dilate) && r.Next(3) == 0;
+  c.Path = (c.Operation == Erode || c.Operation == Dilate) ? r.Next(3) : Plain;
+  c.TileSize = 2 + r.Next(8);
+  c.ImageSeed = seed;
+  c.Sparsity = 1 + r.Next(8);
+  return c;
+}
+
+template <unsigned int dim>
+itk::FlatStructuringElement<dim> mkKernel(const Case &c)
+{
+  typedef itk::FlatStructuringElement<dim> SEType;
+  typename SEType::RadiusType Rad;
+  for (unsigned i = 0; i < dim; i++) Rad[i] = c.Radius[i];
+  switch (c.Kernel)
+    {
+    case LineKernel:
+    {
+    typename SEType::LType L;
+    for (unsigned i = 0; i < dim; i++) L[i] = c.Direction[i] * (float)c.Length;
+    return SEType::Line(L);
+    }
+    case PolyKernel:
+      // the axes and the diagonals
+      return SEType::Poly(Rad, dim == 2 ? 4 : 7);
+    case BallKernel:
+      return SEType::Decompose(SEType::Ball(Rad), 1.0);
+    case PeriodicKernel:
+      return SEType::Periodic(Rad);
+    default:
+      return SEType::Box(Rad);
+    }
+}
+
+// the region where the result of the filter is exactly the brute force
+template <class TImage, class TKernel>
+bool getCheckedRegion(const Case &c, const TKernel &K, const typename TImage::RegionType &All,
+		      typename TImage::RegionType &region)
+{
+  region = All;
+  bool opening = (c.Operation == Open || c.Operation == Close);
+  if (!opening && (c.Kernel == BoxKernel || c.Kernel == LineKernel))
+    {
+    return true;
+    }
+  // the kernel must fit in the image, twice for an opening
+  unsigned margin = opening ? 2 : 1;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    long m = margin * K.GetRadius(i);
+    if ((long)All.GetSize()[i] <= 2 * m) return false;
+    region.SetIndex(i, All.GetIndex()[i] + m);
+    region.SetSize(i, All.GetSize()[i] - 2 * m);
+    }
+  return true;
+}
+
+// the minimum, or the maximum, of the pixels of the image under the
+// kernel centred on each pixel of region
+template <class TImage, class TKernel>
+typename TImage::Pointer bruteForce(const TImage * input, const TKernel &K, bool dilate,
+				    const typename TImage::RegionType &region)
+{
+  typedef typename TImage::PixelType PType;
+  typename TImage::Pointer output = TImage::New();
+  output->SetRegions(input->GetLargestPossibleRegion());
+  output->Allocate();
+  output->FillBuffer(0);
+  const typename TImage::RegionType All = input->GetLargestPossibleRegion();
+  itk::ImageRegionIteratorWithIndex<TImage> it(output, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    bool found = false;
+    PType extreme = 0;
+    for (unsigned n = 0; n < K.Size(); n++)
+      {
+      if (!K[n]) continue;
+      typename TImage::IndexType Idx = it.GetIndex() + K.GetOffset(n);
+      if (!All.IsInside(Idx)) continue;
+      PType v = input->GetPixel(Idx);
+      if (!found || (dilate ? v > extreme : v < extreme))
+	{
+	extreme = v;
+	found = true;
+	}
+      }
+    it.Set(extreme);
+    }
+  return output;
+}
+
+template <class TFilter, class TImage, class TKernel>
+typename TImage::Pointer runFilter(const Case &c, TImage * input, const TKernel &K,
+				   const typename TImage::RegionType &region)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->SetNumberOfThreads(1);
+  filter->GetOutput()->SetRequestedRegion(region);
+  filter->Update();
+  typename TImage::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  return result;
+}
+
+template <class TFilter, class TImage, class TKernel>
+typename TImage::Pointer runFastFilter(const Case &c, TImage * input, const TKernel &K,
+				       const typename TImage::RegionType &region)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->SetNumberOfThreads(1);
+  if (c.Path == Scheduled)
+    {
+    filter->SetNumberOfThreads(3);
+    filter->UseLineSchedulerOn();
+    }
+  else if (c.Path == Tiled)
+    {
+    typename TImage::SizeType TSize;
+    TSize.Fill(c.TileSize);
+    filter->UseTilingOn();
+    filter->SetTileSize(TSize);
+    filter->SetFusedPasses(c.TileSize % 3);
+    }
+  filter->GetOutput()->SetRequestedRegion(region);
+  filter->Update();
+  typename TImage::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  return result;
+}
+
+// the number of pixels where the filter differs from the brute force
+template <class PType, unsigned int dim>
+unsigned long runCase(const Case &c, bool report)
+{
+  typedef itk::Image<PType, dim> IType;
+  typedef itk::FlatStructuringElement<dim> SEType;
+  typename IType::RegionType All;
+  typename IType::SizeType Size;
+  for (unsigned i = 0; i < dim; i++) Size[i] = c.Size[i];
+  All.SetSize(Size);
+  typename IType::Pointer input = IType::New();
+  input->SetRegions(All);
+  input->Allocate();
+  Random r(c.ImageSeed);
+  itk::ImageRegionIteratorWithIndex<IType> it(input, All);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    PType v = (PType)(r.Next(c.Sparsity) == 0 ? r.Next(200) : 50);
+    if (c.Type == 1) v -= 100;
+    if (c.Type == 2) v = v / 3;
+    it.Set(v);
+    }
+
+  SEType K = mkKernel<dim>(c);
+  typename IType::RegionType Requested = All;
+  if (c.UseRegion)
+    {
+    // the middle half of the image
+    for (unsigned i = 0; i < dim; i++)
+      {
+      Requested.SetIndex(i, All.GetSize()[i] / 4);
+      Requested.SetSize(i, std::max(1UL, (unsigned long)All.GetSize()[i] / 2));
+      }
+    }
+  typename IType::RegionType Checked;
+  if (!getCheckedRegion<IType>(c, K, All, Checked) || !Checked.Crop(Requested))
+    {
+    return 0;
+    }
+
+  typename IType::Pointer expected, result;
+  switch (c.Operation)
+    {
+    case Erode:
+      expected = bruteForce<IType>(input, K, false, Checked);
+      result = runFastFilter<itk::AnchorErodeImageFilter<IType, SEType> >(c, input.GetPointer(), K, Requested);
+      break;
+    case Dilate:
+      expected = bruteForce<IType>(input, K, true, Checked);
+      result = runFastFilter<itk::AnchorDilateImageFilter<IType, SEType> >(c, input.GetPointer(), K, Requested);
+      break;
+    case Open:
+      expected = bruteForce<IType>(bruteForce<IType>(input, K, false, All), K, true, Checked);
+      result = runFilter<itk::AnchorOpenImageFilter<IType, SEType> >(c, input.GetPointer(), K, Requested);
+      break;
+    default:
+      expected = bruteForce<IType>(bruteForce<IType>(input, K, true, All), K, false, Checked);
+      result = runFilter<itk::AnchorCloseImageFilter<IType, SEType> >(c, input.GetPointer(), K, Requested);
+      break;
+    }
+
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<IType> cit(expected, Checked);
+  for (cit.GoToBegin(); !cit.IsAtEnd(); ++cit)
+    {
+    if (result->GetPixel(cit.GetIndex()) != cit.Get())
+      {
+      if (report && !diff)
+	{
+	std::cerr << "  at " << cit.GetIndex() << " expected "
+		  << (double)cit.Get() << ", got " << (double)result->GetPixel(cit.GetIndex()) << std::endl;
+	}
+      ++diff;
+      }
+    }
+  return diff;
+}
+
+unsigned long runCase(const Case &c, bool report = false)
+{
+  if (c.Dimension == 2)
+    {
+    switch (c.Type)
+      {
+      case 0: return runCase<unsigned char, 2>(c, report);
+      case 1: return runCase<short, 2>(c, report);
+      default: return runCase<float, 2>(c, report);
+      }
+    }
+  switch (c.Type)
+    {
+    case 0: return runCase<unsigned char, 3>(c, report);
+    case 1: return runCase<short, 3>(c, report);
+    default: return runCase<float, 3>(c, report);
+    }
+}
+
+// shrink a failing case, one change at a time, while it still fails
+Case minimize(Case c)
+{
+  bool shrunk = true;
+  while (shrunk)
+    {
+    shrunk = false;
+    std::vector<Case> candidates;
+    for (unsigned i = 0; i < c.Dimension; i++)
+      {
+      Case s = c;
+      if (s.Size[i] > 1) { s.Size[i] = (s.Size[i] + 1) / 2; candidates.push_back(s); }
+      s = c;
+      if (s.Size[i] > 1) { --s.Size[i]; candidates.push_back(s); }
+      s = c;
+      if (s.Radius[i] > (c.Kernel == BoxKernel ? 0U : 1U)) { --s.Radius[i]; candidates.push_back(s); }
+      }
+    Case s = c;
+    if (s.Length > 1) { --s.Length; candidates.push_back(s); }
+    s = c;
+    if (s.UseRegion) { s.UseRegion = false; candidates.push_back(s); }
+    s = c;
+    if (s.Path != Plain) { s.Path = Plain; candidates.push_back(s); }
+    s = c;
+    if (s.Sparsity < 64) { s.Sparsity *= 2; candidates.push_back(s); }
+    for (unsigned k = 0; k < candidates.size(); k++)
+      {
+      if (runCase(candidates[k]))
+	{
+	c = candidates[k];
+	shrunk = true;
+	break;
+	}
+      }
+    }
+  return c;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " seed cases" << std::endl;
+    return EXIT_FAILURE;
+    }
+  unsigned long seed = atol(argv[1]);
+  unsigned cases = atoi(argv[2]);
+
+  unsigned failures = 0;
+  for (unsigned n = 0; n < cases; n++)
+    {
+    Case c = mkCase(seed * 100003UL + n);
+    unsigned long diff = runCase(c);
+    if (diff)
+      {
+      ++failures;
+      std::cerr << diff << " pixels differ for " << c.Describe() << std::endl;
+      Case m = minimize(c);
+      std::cerr << "smallest failing case: " << m.Describe() << std::endl;
+      runCase(m, true);
+      }
+    }
+  std::cout << cases - failures << " of " << cases << " cases agree" << std::endl;
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
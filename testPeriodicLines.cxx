@@ -0,0 +1,318 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+
+// the periodic lines go exactly through the pixels of the kernel, so
+// away from the borders the filters must give the same result as a
+// brute force computation with the buffer of the kernel
+typedef unsigned char PType;
+
+// the pixels that differ between a kernel and a ball of the same
+// radius, including those outside the other one
+template <unsigned int dim>
+unsigned long countDifference(const itk::FlatStructuringElement<dim> &K,
+			      const itk::FlatStructuringElement<dim> &Ball)
+{
+  typedef typename itk::FlatStructuringElement<dim>::OffsetType OffsetType;
+  unsigned long diff = 0;
+  for (unsigned n = 0; n < K.Size(); n++)
+    {
+    OffsetType O = K.GetOffset(n);
+    bool inBall = true;
+    for (unsigned i = 0; i < dim; i++)
+      {
+      if ((unsigned long)labs(O[i]) > Ball.GetRadius(i)) inBall = false;
+      }
+    if (K[n] != (inBall && Ball[O])) ++diff;
+    }
+  for (unsigned n = 0; n < Ball.Size(); n++)
+    {
+    OffsetType O = Ball.GetOffset(n);
+    bool inK = true;
+    for (unsigned i = 0; i < dim; i++)
+      {
+      if ((unsigned long)labs(O[i]) > K.GetRadius(i)) inK = false;
+      }
+    if (Ball[n] && !inK) ++diff;
+    }
+  return diff;
+}
+
+// erode or dilate region of input by the buffer of K
+template <class TImage, class TKernel>
+typename TImage::Pointer bruteForce(TImage * input, const TKernel &K,
+				    const typename TImage::RegionType &region,
+				    bool dilate)
+{
+  typename TImage::Pointer result = TImage::New();
+  result->SetRegions(input->GetLargestPossibleRegion());
+  result->Allocate();
+  result->FillBuffer(0);
+  itk::ImageRegionIteratorWithIndex<TImage> it(result, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    PType extreme = dilate ? 0 : 255;
+    for (unsigned n = 0; n < K.Size(); n++)
+      {
+      if (!K[n]) continue;
+      PType V = input->GetPixel(it.GetIndex() + K.GetOffset(n));
+      if (dilate ? (V > extreme) : (V < extreme)) extreme = V;
+      }
+    it.Set(extreme);
+    }
+  return result;
+}
+
+template <class TFilter, class TImage>
+typename TImage::Pointer runFilter(TImage * input, const typename TFilter::KernelType &K)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->Update();
+  typename TImage::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  return result;
+}
+
+template <class TImage>
+unsigned long countDiff(TImage * a, TImage * b, const typename TImage::RegionType &region)
+{
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<TImage> it(a, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() != b->GetPixel(it.GetIndex())) ++diff;
+    }
+  return diff;
+}
+
+// the region of the image at least margin pixels away from the borders
+template <class TRegion>
+TRegion shrinkRegion(TRegion region, const typename TRegion::SizeType &margin)
+{
+  typename TRegion::IndexType Start = region.GetIndex();
+  typename TRegion::SizeType Size = region.GetSize();
+  for (unsigned i = 0; i < TRegion::ImageDimension; i++)
+    {
+    Start[i] += margin[i];
+    Size[i] = (Size[i] > 2 * margin[i]) ? Size[i] - 2 * margin[i] : 0;
+    }
+  region.SetIndex(Start);
+  region.SetSize(Size);
+  return region;
+}
+
+template <class TImage>
+bool checkFilters(TImage * input, const itk::FlatStructuringElement<TImage::ImageDimension> &K,
+		  const char * name)
+{
+  typedef itk::FlatStructuringElement<TImage::ImageDimension> SEType;
+  typedef itk::AnchorDilateImageFilter<TImage, SEType> DilateType;
+  typedef itk::AnchorErodeImageFilter<TImage, SEType> ErodeType;
+  typedef itk::AnchorOpenImageFilter<TImage, SEType> OpenType;
+  typename TImage::RegionType All = input->GetLargestPossibleRegion();
+  typename TImage::RegionType Inner = shrinkRegion(All, K.GetRadius());
+  typename TImage::SizeType Margin2;
+  for (unsigned i = 0; i < TImage::ImageDimension; i++)
+    {
+    Margin2[i] = 2 * K.GetRadius(i);
+    }
+  typename TImage::RegionType Inner2 = shrinkRegion(All, Margin2);
+
+  bool ok = true;
+  typename TImage::Pointer dilate = runFilter<DilateType>(input, K);
+  typename TImage::Pointer erode = runFilter<ErodeType>(input, K);
+  if (countDiff(dilate.GetPointer(), bruteForce(input, K, Inner, true).GetPointer(), Inner) ||
+      countDiff(erode.GetPointer(), bruteForce(input, K, Inner, false).GetPointer(), Inner))
+    {
+    std::cerr << name << ": the erosion or the dilation differs from the brute force one" << std::endl;
+    ok = false;
+    }
+  typename DilateType::Pointer tiled = DilateType::New();
+  tiled->SetInput(input);
+  tiled->SetKernel(K);
+  tiled->SetUseTiling(true);
+  tiled->Update();
+  if (countDiff(dilate.GetPointer(), tiled->GetOutput(), All))
+    {
+    std::cerr << name << ": the tiled dilation differs" << std::endl;
+    ok = false;
+    }
+  typename TImage::Pointer open = runFilter<OpenType>(input, K);
+  typename TImage::Pointer chain = bruteForce(erode.GetPointer(), K, Inner2, true);
+  if (countDiff(open.GetPointer(), chain.GetPointer(), Inner2))
+    {
+    std::cerr << name << ": the opening differs from the brute force one" << std::endl;
+    ok = false;
+    }
+  return ok;
+}
+
+// the buffer of the kernel must be what the filter does to a pixel
+template <unsigned int dim>
+bool checkBuffer(const itk::FlatStructuringElement<dim> &K, const char * name)
+{
+  typedef itk::FlatStructuringElement<dim> SEType;
+  typedef itk::Image<PType, dim> IType;
+  typename IType::Pointer point = IType::New();
+  typename IType::RegionType region;
+  typename IType::SizeType size;
+  typename IType::IndexType centre;
+  for (unsigned i = 0; i < dim; i++)
+    {
+    size[i] = K.GetSize(i);
+    centre[i] = K.GetRadius(i);
+    }
+  region.SetSize(size);
+  point->SetRegions(region);
+  point->Allocate();
+  point->FillBuffer(0);
+  point->SetPixel(centre, 255);
+  typename IType::Pointer dilate = runFilter<itk::AnchorDilateImageFilter<IType, SEType> >(point.GetPointer(), K);
+  itk::ImageRegionIteratorWithIndex<IType> it(dilate, region);
+  unsigned n = 0;
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it, ++n)
+    {
+    if ((it.Get() != 0) != K[n])
+      {
+      std::cerr << name << " doesn't match its dilation at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " input radius2D radius3D" << std::endl;
+    return EXIT_FAILURE;
+    }
+  typedef itk::Image<PType, 2> IType;
+  typedef itk::Image<PType, 3> VType;
+  typedef itk::FlatStructuringElement<2> SE2Type;
+  typedef itk::FlatStructuringElement<3> SE3Type;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+
+  SE2Type::RadiusType Rad2;
+  SE3Type::RadiusType Rad3;
+  Rad2.Fill(atoi(argv[2]));
+  Rad3.Fill(atoi(argv[3]));
+
+  bool ok = true;
+  // a disc, closer to the ball than the polygon of as many lines
+  SE2Type Ball2 = SE2Type::Ball(Rad2);
+  SE2Type K2 = SE2Type::Periodic(Rad2);
+  SE2Type P2 = SE2Type::Poly(Rad2, K2.GetLines().size());
+  unsigned long periodicDiff = countDifference(K2, Ball2);
+  unsigned long polyDiff = countDifference(P2, Ball2);
+  std::cout << "disc: " << K2.GetLines().size() << " lines, " << periodicDiff
+	    << " pixels differ from the ball, " << polyDiff << " for the polygon" << std::endl;
+  bool periodic = false;
+  for (unsigned i = 0; i < K2.GetLines().size(); i++)
+    {
+    if (K2.GetPeriod(i) > 1) periodic = true;
+    }
+  if (!periodic || periodicDiff > polyDiff)
+    {
+    std::cerr << "the periodic disc isn't better than the polygon" << std::endl;
+    ok = false;
+    }
+  ok &= checkBuffer(K2, "disc");
+  ok &= checkFilters(input, K2, "disc");
+
+  // an ellipse
+  Rad2[1] = Rad2[0] / 2 + 1;
+  SE2Type E2 = SE2Type::Periodic(Rad2);
+  ok &= checkBuffer(E2, "ellipse");
+  ok &= checkFilters(input, E2, "ellipse");
+
+  // a sphere, on a stack of shifted copies of the image
+  SE3Type K3 = SE3Type::Periodic(Rad3);
+  SE3Type Ball3 = SE3Type::Ball(Rad3);
+  unsigned long sphereDiff = countDifference(K3, Ball3);
+  unsigned long polySphereDiff = countDifference(SE3Type::Poly(Rad3, 6), Ball3);
+  std::cout << "sphere: " << K3.GetLines().size() << " lines, " << sphereDiff
+	    << " pixels differ from the ball, " << polySphereDiff << " for the polyhedron" << std::endl;
+  if (sphereDiff > polySphereDiff)
+    {
+    std::cerr << "the periodic sphere isn't better than the polyhedron" << std::endl;
+    ok = false;
+    }
+  ok &= checkBuffer(K3, "sphere");
+
+  IType::RegionType SAll = input->GetLargestPossibleRegion();
+  VType::RegionType All;
+  VType::SizeType ASize;
+  ASize[0] = std::min(SAll.GetSize()[0], (unsigned long)32);
+  ASize[1] = std::min(SAll.GetSize()[1], (unsigned long)32);
+  ASize[2] = 4 * K3.GetRadius(2) + 3;
+  All.SetSize(ASize);
+  VType::Pointer stack = VType::New();
+  stack->SetRegions(All);
+  stack->Allocate();
+  itk::ImageRegionIteratorWithIndex<VType> stIt(stack, All);
+  for (stIt.GoToBegin(); !stIt.IsAtEnd(); ++stIt)
+    {
+    VType::IndexType Idx = stIt.GetIndex();
+    IType::IndexType SIdx;
+    SIdx[0] = SAll.GetIndex()[0] + (Idx[0] + 7 * Idx[2]) % SAll.GetSize()[0];
+    SIdx[1] = SAll.GetIndex()[1] + (Idx[1] + 3 * Idx[2]) % SAll.GetSize()[1];
+    stIt.Set(input->GetPixel(SIdx));
+    }
+  ok &= checkFilters(stack.GetPointer(), K3, "sphere");
+
+  // the periodic lines of the disc in every slice of the stack
+  typedef itk::AnchorDilateImageFilter<VType, SE3Type> SliceDilateType;
+  SliceDilateType::Pointer sliceDilate = SliceDilateType::New();
+  sliceDilate->SetInput(stack);
+  sliceDilate->SetSliceKernel(K2, 2);
+  sliceDilate->Update();
+  unsigned long sliceDiff = 0;
+  for (unsigned z = 0; z < ASize[2]; z++)
+    {
+    IType::Pointer slice = IType::New();
+    IType::RegionType SReg;
+    IType::SizeType SSize;
+    SSize[0] = ASize[0];
+    SSize[1] = ASize[1];
+    SReg.SetSize(SSize);
+    slice->SetRegions(SReg);
+    slice->Allocate();
+    itk::ImageRegionIteratorWithIndex<IType> slIt(slice, SReg);
+    VType::IndexType Idx;
+    Idx[2] = z;
+    for (slIt.GoToBegin(); !slIt.IsAtEnd(); ++slIt)
+      {
+      Idx[0] = slIt.GetIndex()[0];
+      Idx[1] = slIt.GetIndex()[1];
+      slIt.Set(stack->GetPixel(Idx));
+      }
+    IType::Pointer dilate = runFilter<itk::AnchorDilateImageFilter<IType, SE2Type> >(slice.GetPointer(), K2);
+    for (slIt.GoToBegin(); !slIt.IsAtEnd(); ++slIt)
+      {
+      Idx[0] = slIt.GetIndex()[0];
+      Idx[1] = slIt.GetIndex()[1];
+      if (sliceDilate->GetOutput()->GetPixel(Idx) != dilate->GetPixel(slIt.GetIndex())) ++sliceDiff;
+      }
+    }
+  if (sliceDiff)
+    {
+    std::cerr << sliceDiff << " pixels differ in the slices" << std::endl;
+    ok = false;
+    }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,187 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include <algorithm>
+
+#include "itkAnchorRankImageFilter.h"
+
+// compare the rank filter by lines with the rank over the box: it
+// must be exact for the minimum, the maximum and a single line, the
+// same for all the pixel types, and close to the requested rank
+// otherwise
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::Image< short, dim > SType;
+typedef itk::Image< float, dim > FType;
+typedef itk::FlatStructuringElement<dim> SEType;
+
+template <class TImage>
+typename TImage::Pointer rank(TImage * input, const SEType &K, float r)
+{
+  typedef itk::AnchorRankImageFilter<TImage, SEType> FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->SetRank(r);
+  filter->Update();
+  typename TImage::Pointer result = filter->GetOutput();
+  return result;
+}
+
+// the pixels of the window of Idx, of the given radius, clipped to
+// the image
+void window(IType * image, IType::IndexType Idx, const SEType::RadiusType &radius,
+	    std::vector<PType> &pixels)
+{
+  IType::RegionType All = image->GetLargestPossibleRegion();
+  IType::IndexType Start;
+  IType::SizeType Size;
+  for (unsigned d = 0; d < dim; d++)
+    {
+    long first = std::max(Idx[d] - (long)radius[d], All.GetIndex()[d]);
+    long last = std::min(Idx[d] + (long)radius[d], All.GetIndex()[d] + (long)All.GetSize()[d] - 1);
+    Start[d] = first;
+    Size[d] = last - first + 1;
+    }
+  IType::RegionType Win;
+  Win.SetIndex(Start);
+  Win.SetSize(Size);
+  pixels.clear();
+  itk::ImageRegionIteratorWithIndex<IType> it(image, Win);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    pixels.push_back(it.Get());
+    }
+  std::sort(pixels.begin(), pixels.end());
+}
+
+// the number of pixels that differ from the rank over the window, and
+// the distance of the rank of the result in the window to r
+unsigned long compare(IType * input, IType * result, const SEType::RadiusType &radius,
+		      float r, double &rankError, double &levelError)
+{
+  IType::RegionType All = input->GetLargestPossibleRegion();
+  std::vector<PType> pixels;
+  unsigned long diff = 0;
+  rankError = 0;
+  levelError = 0;
+  itk::ImageRegionIteratorWithIndex<IType> it(result, All);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    window(input, it.GetIndex(), radius, pixels);
+    unsigned long n = pixels.size();
+    PType exact = pixels[(unsigned long)(r * (n - 1))];
+    if (it.Get() == exact) continue;
+    ++diff;
+    levelError += fabs((double)it.Get() - exact);
+    // the result has the ranks [low, high] in the window
+    unsigned long low = std::lower_bound(pixels.begin(), pixels.end(), it.Get()) - pixels.begin();
+    unsigned long high = std::upper_bound(pixels.begin(), pixels.end(), it.Get()) - pixels.begin();
+    if (low == high)
+      {
+      // not a pixel of the window
+      rankError += 1;
+      continue;
+      }
+    double lowRank = (double)low / (n - 1);
+    double highRank = (double)(high - 1) / (n - 1);
+    rankError += std::min(fabs(lowRank - r), fabs(highRank - r));
+    }
+  rankError /= All.GetNumberOfPixels();
+  levelError /= All.GetNumberOfPixels();
+  return diff;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << "Usage: " << argv[0] << " input radius rank maxRankError" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+  IType::RegionType All = input->GetLargestPossibleRegion();
+  unsigned radius = atoi(argv[2]);
+  float r = atof(argv[3]);
+  double maxRankError = atof(argv[4]);
+
+  SEType::RadiusType rad;
+  rad.Fill(radius);
+  SEType K = SEType::Box(rad);
+  bool ok = true;
+  double rankError, levelError;
+
+  // the minimum and the maximum along the lines are the erosion and
+  // the dilation by the box
+  if (compare(input, rank<IType>(input, K, 0.0), rad, 0.0, rankError, levelError) ||
+      compare(input, rank<IType>(input, K, 1.0), rad, 1.0, rankError, levelError))
+    {
+    std::cerr << "the minimum or the maximum differ" << std::endl;
+    ok = false;
+    }
+
+  // a single line is exact
+  SEType::LType line;
+  line.Fill(0);
+  line[0] = 2 * radius + 1;
+  SEType::RadiusType lineRad;
+  lineRad.Fill(0);
+  lineRad[0] = radius;
+  unsigned long diff = compare(input, rank<IType>(input, SEType::Line(line), r), lineRad, r,
+			       rankError, levelError);
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ with a single line" << std::endl;
+    ok = false;
+    }
+
+  // a vector of counts is used for unsigned char and short, with
+  // negative values for short, and a map for float
+  IType::Pointer result = rank<IType>(input, K, r);
+  SType::Pointer sinput = SType::New();
+  sinput->SetRegions(All);
+  sinput->Allocate();
+  FType::Pointer finput = FType::New();
+  finput->SetRegions(All);
+  finput->Allocate();
+  itk::ImageRegionIteratorWithIndex<IType> it(input, All);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    sinput->SetPixel(it.GetIndex(), (short)it.Get() - 128);
+    finput->SetPixel(it.GetIndex(), it.Get() / 4.0f);
+    }
+  SType::Pointer sresult = rank<SType>(sinput, K, r);
+  FType::Pointer fresult = rank<FType>(finput, K, r);
+  diff = 0;
+  itk::ImageRegionIteratorWithIndex<IType> rit(result, All);
+  for (rit.GoToBegin(); !rit.IsAtEnd(); ++rit)
+    {
+    if ((sresult->GetPixel(rit.GetIndex()) != (short)rit.Get() - 128) ||
+	(fresult->GetPixel(rit.GetIndex()) != rit.Get() / 4.0f))
+      {
+      ++diff;
+      }
+    }
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ between the pixel types" << std::endl;
+    ok = false;
+    }
+
+  diff = compare(input, result, rad, r, rankError, levelError);
+  std::cout << "box " << 2 * radius + 1 << ", rank " << r << ": "
+	    << 100.0 * (All.GetNumberOfPixels() - diff) / All.GetNumberOfPixels() << "% exact, "
+	    << "mean difference " << levelError << ", mean rank error " << rankError << std::endl;
+  if (rankError > maxRankError)
+    {
+    std::cerr << "the mean rank error is above " << maxRankError << std::endl;
+    ok = false;
+    }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
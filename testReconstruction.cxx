@@ -0,0 +1,140 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpeningByReconstructionImageFilter.h"
+#include "itkAnchorClosingByReconstructionImageFilter.h"
+
+// compare the openings and closings by reconstruction with the
+// geodesic dilations or erosions of the marker repeated until they
+// don't change anything
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::FlatStructuringElement<dim> SEType;
+
+// the reconstruction of marker under mask, or above it for a
+// closing, by the brute force method
+template <class TCompare>
+void reconstruct(IType * marker, IType * mask, bool fullyConnected)
+{
+  TCompare better;
+  IType::RegionType All = mask->GetLargestPossibleRegion();
+  bool changed = true;
+  while (changed)
+    {
+    changed = false;
+    itk::ImageRegionIteratorWithIndex<IType> it(marker, All);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      IType::IndexType Idx = it.GetIndex();
+      PType v = it.Get();
+      for (int dy = -1; dy <= 1; dy++)
+	{
+	for (int dx = -1; dx <= 1; dx++)
+	  {
+	  if (!fullyConnected && (dx != 0) && (dy != 0)) continue;
+	  IType::IndexType N = Idx;
+	  N[0] += dx;
+	  N[1] += dy;
+	  if (!All.IsInside(N)) continue;
+	  if (better(marker->GetPixel(N), v)) v = marker->GetPixel(N);
+	  }
+	}
+      if (better(v, mask->GetPixel(Idx))) v = mask->GetPixel(Idx);
+      if (v != it.Get())
+	{
+	it.Set(v);
+	changed = true;
+	}
+      }
+    }
+}
+
+template <class TFilter, class TMarker, class TCompare>
+bool check(IType * input, const SEType &K, int threads)
+{
+  bool ok = true;
+  typename TMarker::Pointer marker = TMarker::New();
+  marker->SetInput(input);
+  marker->SetKernel(K);
+  marker->Update();
+  IType::Pointer expected = marker->GetOutput();
+
+  for (int full = 0; full < 2; full++)
+    {
+    IType::Pointer copy = IType::New();
+    copy->SetRegions(expected->GetLargestPossibleRegion());
+    copy->Allocate();
+    itk::ImageRegionIteratorWithIndex<IType> cit(copy, copy->GetLargestPossibleRegion());
+    for (cit.GoToBegin(); !cit.IsAtEnd(); ++cit)
+      {
+      cit.Set(expected->GetPixel(cit.GetIndex()));
+      }
+    reconstruct<TCompare>(copy, input, full);
+
+    for (int t = 1; t <= threads; t += threads - 1)
+      {
+      typename TFilter::Pointer filter = TFilter::New();
+      filter->SetInput(input);
+      filter->SetKernel(K);
+      filter->SetFullyConnected(full);
+      filter->SetNumberOfThreads(t);
+      filter->Update();
+      unsigned long diff = 0;
+      for (cit.GoToBegin(); !cit.IsAtEnd(); ++cit)
+	{
+	if (filter->GetOutput()->GetPixel(cit.GetIndex()) != cit.Get()) ++diff;
+	}
+      if (diff)
+	{
+	std::cerr << diff << " pixels differ with " << t << " threads, fully connected " << full << std::endl;
+	ok = false;
+	}
+      std::cout << t << " threads, fully connected " << full << ": "
+		<< filter->GetNumberOfRounds() << " rounds" << std::endl;
+      if (threads == 1) break;
+      }
+    }
+  return ok;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " input radius threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[2]));
+  SEType K = SEType::Box(Rad);
+  int threads = atoi(argv[3]);
+
+  typedef itk::AnchorOpeningByReconstructionImageFilter<IType, SEType> OpeningType;
+  typedef itk::AnchorClosingByReconstructionImageFilter<IType, SEType> ClosingType;
+  typedef itk::AnchorErodeImageFilter<IType, SEType> ErodeType;
+  typedef itk::AnchorDilateImageFilter<IType, SEType> DilateType;
+
+  bool ok = true;
+  if (!check<OpeningType, ErodeType, std::greater<PType> >(input, K, threads))
+    {
+    std::cerr << "the openings differ" << std::endl;
+    ok = false;
+    }
+  if (!check<ClosingType, DilateType, std::less<PType> >(input, K, threads))
+    {
+    std::cerr << "the closings differ" << std::endl;
+    ok = false;
+    }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
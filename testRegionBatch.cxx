@@ -0,0 +1,202 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+#include "itkAnchorRegionBatch.h"
+
+// compute many small regions, some of them on the edges of the image
+// and some overlapping, with a region batch, and compare them with
+// the same part of the erosion, dilation, opening and closing filters
+// applied to the whole image, for boxes, polygons and discs, with a
+// packed buffer and with an image per region
+
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::FlatStructuringElement<dim> SEType;
+typedef itk::AnchorRegionBatch<IType, SEType> BatchType;
+
+template <class TFilter>
+IType::Pointer wholeImage(IType * input, const SEType &K)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->Update();
+  IType::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  return result;
+}
+
+// the pixels of region i, from the packed buffer or from its image
+PType batchPixel(BatchType * batch, unsigned long i, const IType::IndexType &Idx)
+{
+  const IType::RegionType R = batch->GetRegions()[i];
+  if (!batch->GetPackedOutput())
+    {
+    return batch->GetOutput(i)->GetPixel(Idx);
+    }
+  unsigned long offset = 0;
+  unsigned long stride = 1;
+  for (unsigned d = 0; d < dim; d++)
+    {
+    offset += (Idx[d] - R.GetIndex()[d]) * stride;
+    stride *= R.GetSize()[d];
+    }
+  return batch->GetBufferPointer()[batch->GetBufferOffset(i) + offset];
+}
+
+bool check(BatchType * batch, const IType * expected, const std::string &name)
+{
+  unsigned long diff = 0;
+  for (unsigned long i = 0; i < batch->GetNumberOfRegions(); i++)
+    {
+    itk::ImageRegionConstIteratorWithIndex<IType> it(expected, batch->GetRegions()[i]);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      if (batchPixel(batch, i, it.GetIndex()) != it.Get()) ++diff;
+      }
+    }
+  if (diff)
+    {
+    std::cerr << name << ": " << diff << " pixels differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+bool checkKernel(IType * input, const BatchType::RegionListType &regions,
+		 const SEType &K, const std::string &name)
+{
+  IType::Pointer expected[4];
+  expected[BatchType::ERODE] = wholeImage<itk::AnchorErodeImageFilter<IType, SEType> >(input, K);
+  expected[BatchType::DILATE] = wholeImage<itk::AnchorDilateImageFilter<IType, SEType> >(input, K);
+  expected[BatchType::OPEN] = wholeImage<itk::AnchorOpenImageFilter<IType, SEType> >(input, K);
+  expected[BatchType::CLOSE] = wholeImage<itk::AnchorCloseImageFilter<IType, SEType> >(input, K);
+  const char * operations[] = { " erode", " dilate", " open", " close" };
+
+  // one batch for all the operations, so that the plan and the buffer
+  // are reused
+  BatchType::Pointer batch = BatchType::New();
+  batch->SetInput(input);
+  batch->SetKernel(K);
+  batch->SetRegions(regions);
+  bool ok = true;
+  for (int op = 0; op < 4; op++)
+    {
+    batch->SetOperation((BatchType::OperationType)op);
+    for (int packed = 1; packed >= 0; packed--)
+      {
+      batch->SetPackedOutput(packed);
+      batch->SetNumberOfThreads(packed ? 4 : 1);
+      batch->Compute();
+      ok &= check(batch, expected[op], name + operations[op] + (packed ? " packed" : " images"));
+      }
+    }
+  return ok;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " input radius" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+  int radius = atoi(argv[2]);
+  const IType::RegionType All = input->GetLargestPossibleRegion();
+
+  // regions of 1 to 24 pixels a side anywhere in the image, cropped
+  // by its edges, and an empty one
+  BatchType::RegionListType regions;
+  unsigned long seed = 12345;
+  for (int i = 0; i < 200; i++)
+    {
+    IType::RegionType R;
+    for (unsigned d = 0; d < dim; d++)
+      {
+      seed = seed * 1103515245 + 12345;
+      long size = 1 + (seed >> 16) % 24;
+      seed = seed * 1103515245 + 12345;
+      long start = All.GetIndex()[d] - size / 2 + (long)((seed >> 16) % All.GetSize()[d]);
+      R.SetIndex(d, start);
+      R.SetSize(d, size);
+      }
+    R.Crop(All);
+    regions.push_back(R);
+    }
+  regions.push_back(All);
+  IType::RegionType Empty = All;
+  Empty.SetSize(0, 0);
+  regions.push_back(Empty);
+
+  bool ok = true;
+  SEType::RadiusType Rad;
+  Rad.Fill(radius);
+  ok &= checkKernel(input, regions, SEType::Box(Rad), "box");
+  ok &= checkKernel(input, regions, SEType::Poly(Rad, 4), "poly");
+  ok &= checkKernel(input, regions, SEType::Ball(Rad), "disc");
+
+  // a packed output outlives the next Compute, with the same or more
+  // pixels
+  BatchType::Pointer batch = BatchType::New();
+  batch->SetInput(input);
+  batch->SetKernel(SEType::Box(Rad));
+  batch->SetRegions(regions);
+  batch->Compute();
+  IType::Pointer kept = batch->GetOutput(0);
+  IType::Pointer eroded = wholeImage<itk::AnchorErodeImageFilter<IType, SEType> >(input, SEType::Box(Rad));
+  batch->SetOperation(BatchType::DILATE);
+  batch->Compute();
+  batch->AddRegion(All);
+  batch->Compute();
+  unsigned long keptDiff = 0;
+  itk::ImageRegionConstIteratorWithIndex<IType> keptIt(eroded, regions[0]);
+  for (keptIt.GoToBegin(); !keptIt.IsAtEnd(); ++keptIt)
+    {
+    if (kept->GetPixel(keptIt.GetIndex()) != keptIt.Get()) ++keptDiff;
+    }
+  if (keptDiff)
+    {
+    std::cerr << "an output was overwritten by the next Compute" << std::endl;
+    ok = false;
+    }
+
+  // a region outside the image is refused
+  batch = BatchType::New();
+  batch->SetInput(input);
+  batch->SetKernel(SEType::Box(Rad));
+  IType::RegionType Outside = All;
+  Outside.SetIndex(0, All.GetIndex()[0] + 1);
+  batch->AddRegion(Outside);
+  bool caught = false;
+  try
+    {
+    batch->Compute();
+    }
+  catch (itk::ExceptionObject &)
+    {
+    caught = true;
+    }
+  if (!caught)
+    {
+    std::cerr << "a region outside the image was computed" << std::endl;
+    ok = false;
+    }
+
+  if (!ok)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorErodeImageFilter.h"
+
+#include <functional>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+// compare slabs computed by worker processes with the plain sweep of
+// a stack, then check that a worker killed by a signal makes the
+// update fail rather than hang, and that other children of the
+// application aren't reaped
+const int dim = 3;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::Image< PType, dim - 1 > SType;
+typedef itk::FlatStructuringElement<dim> SEType;
+
+// the first worker to compare two pixels kills itself
+pid_t parent;
+int * killFlag;
+struct KillingLess
+{
+  bool operator()(const PType &a, const PType &b) const
+  {
+    if (*killFlag && (getpid() != parent) && __sync_lock_test_and_set(killFlag, 0))
+      {
+      raise(SIGKILL);
+      }
+    return a < b;
+  }
+};
+
+template <class TFilter>
+unsigned long compare(IType * stack, const SEType &K, unsigned processes, unsigned fused)
+{
+  typename TFilter::Pointer plain = TFilter::New();
+  plain->SetInput(stack);
+  plain->SetKernel(K);
+  plain->Update();
+
+  typename TFilter::Pointer slabs = TFilter::New();
+  slabs->SetInput(stack);
+  slabs->SetKernel(K);
+  slabs->SetNumberOfProcesses(processes);
+  slabs->SetFusedPasses(fused);
+  slabs->Update();
+
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<IType> it(plain->GetOutput(), stack->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (slabs->GetOutput()->GetPixel(it.GetIndex()) != it.Get()) ++diff;
+    }
+  return diff;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 6)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius processes fusedpasses" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< SType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+
+  // a stack of shifted copies of the image
+  const unsigned long depth = 11;
+  SType::RegionType In = reader->GetOutput()->GetLargestPossibleRegion();
+  IType::RegionType All;
+  IType::SizeType ASize;
+  ASize[0] = In.GetSize()[0];
+  ASize[1] = In.GetSize()[1];
+  ASize[2] = depth;
+  All.SetSize(ASize);
+  IType::Pointer stack = IType::New();
+  stack->SetRegions(All);
+  stack->Allocate();
+  itk::ImageRegionIteratorWithIndex<IType> stIt(stack, All);
+  for (stIt.GoToBegin(); !stIt.IsAtEnd(); ++stIt)
+    {
+    IType::IndexType Idx = stIt.GetIndex();
+    SType::IndexType SIdx;
+    SIdx[0] = In.GetIndex()[0] + (Idx[0] + 7 * Idx[2]) % ASize[0];
+    SIdx[1] = In.GetIndex()[1] + (Idx[1] + 3 * Idx[2]) % ASize[1];
+    stIt.Set(reader->GetOutput()->GetPixel(SIdx));
+    }
+
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  SEType K = SEType::Poly(Rad, atoi(argv[2]));
+  unsigned processes = atoi(argv[4]);
+  unsigned fused = atoi(argv[5]);
+
+  // a child of the application, which the filter must leave alone
+  pid_t other = fork();
+  if (other == 0)
+    {
+    _exit(3);
+    }
+
+  unsigned long diff = 0;
+  diff += compare<itk::AnchorDilateImageFilter<IType, SEType> >(stack, K, processes, fused);
+  diff += compare<itk::AnchorErodeImageFilter<IType, SEType> >(stack, K, processes, fused);
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ between the slabs and the plain sweep" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int status;
+  if ((waitpid(other, &status, 0) != other) || !WIFEXITED(status) || (WEXITSTATUS(status) != 3))
+    {
+    std::cerr << "The filter reaped a process that wasn't one of its workers" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (processes > 1)
+    {
+    parent = getpid();
+    killFlag = static_cast<int *>(mmap(0, sizeof(int), PROT_READ | PROT_WRITE,
+				       MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    *killFlag = 1;
+    typedef itk::AnchorErodeDilateImageFilter<IType, SEType, KillingLess, std::less_equal<PType> > KilledType;
+    KilledType::Pointer killed = KilledType::New();
+    killed->SetInput(stack);
+    killed->SetKernel(K);
+    killed->SetNumberOfProcesses(processes);
+    killed->SetFusedPasses(fused);
+    // a hang is reported as a failure
+    alarm(60);
+    bool thrown = false;
+    try
+      {
+      killed->Update();
+      }
+    catch (itk::ExceptionObject &)
+      {
+      thrown = true;
+      }
+    alarm(0);
+    if (!thrown || *killFlag)
+      {
+      std::cerr << "No failure when a worker is killed" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (waitpid(-1, 0, WNOHANG) != -1)
+      {
+      std::cerr << "Worker processes were left behind" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,140 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+
+// compare the batch mode on a stack with the 2D filters applied to
+// each slice
+const int dim = 3;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::Image< PType, dim - 1 > SType;
+
+int main(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius axis [tilesize]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< SType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+
+  // a stack of shifted copies of the image
+  const unsigned long depth = 6;
+  SType::RegionType In = reader->GetOutput()->GetLargestPossibleRegion();
+  IType::RegionType All;
+  IType::SizeType ASize;
+  ASize[0] = In.GetSize()[0];
+  ASize[1] = In.GetSize()[1];
+  ASize[2] = depth;
+  All.SetSize(ASize);
+  IType::Pointer stack = IType::New();
+  stack->SetRegions(All);
+  stack->Allocate();
+  itk::ImageRegionIteratorWithIndex<IType> stIt(stack, All);
+  for (stIt.GoToBegin(); !stIt.IsAtEnd(); ++stIt)
+    {
+    IType::IndexType Idx = stIt.GetIndex();
+    SType::IndexType SIdx;
+    SIdx[0] = In.GetIndex()[0] + (Idx[0] + 7 * Idx[2]) % ASize[0];
+    SIdx[1] = In.GetIndex()[1] + (Idx[1] + 3 * Idx[2]) % ASize[1];
+    stIt.Set(reader->GetOutput()->GetPixel(SIdx));
+    }
+
+  typedef itk::FlatStructuringElement<dim - 1> SEType;
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  SEType K = SEType::Poly(Rad, atoi(argv[2]));
+  unsigned int axis = atoi(argv[4]);
+
+  typedef itk::AnchorDilateImageFilter<IType, itk::FlatStructuringElement<dim> > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( stack );
+  filter->SetSliceKernel(K, axis);
+  filter->SetNumberOfThreads(3);
+  if (argc > 5)
+    {
+    FilterType::SizeType TSize;
+    TSize.Fill(atoi(argv[5]));
+    filter->UseTilingOn();
+    filter->SetTileSize(TSize);
+    }
+  filter->Update();
+
+  typedef itk::AnchorOpenImageFilter<IType, itk::FlatStructuringElement<dim> > OpenType;
+  OpenType::Pointer open = OpenType::New();
+  open->SetInput( stack );
+  open->SetSliceKernel(K, axis);
+  open->Update();
+
+  typedef itk::AnchorDilateImageFilter<SType, SEType> SliceFilterType;
+  typedef itk::AnchorOpenImageFilter<SType, SEType> SliceOpenType;
+  SType::RegionType SReg;
+  SType::IndexType SStart;
+  SType::SizeType SSize;
+  for (unsigned i = 0, k = 0; i < dim; i++)
+    {
+    if (i == axis) continue;
+    SStart[k] = All.GetIndex()[i];
+    SSize[k] = All.GetSize()[i];
+    k++;
+    }
+  SReg.SetIndex(SStart);
+  SReg.SetSize(SSize);
+
+  unsigned long diff = 0;
+  for (unsigned long s = 0; s < All.GetSize()[axis]; s++)
+    {
+    IType::RegionType Slice = All;
+    Slice.SetIndex(axis, All.GetIndex()[axis] + s);
+    Slice.SetSize(axis, 1);
+
+    SType::Pointer slice = SType::New();
+    slice->SetRegions(SReg);
+    slice->Allocate();
+    itk::ImageRegionIteratorWithIndex<IType> it(stack, Slice);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      SType::IndexType Idx;
+      for (unsigned i = 0, k = 0; i < dim; i++)
+	{
+	if (i != axis) Idx[k++] = it.GetIndex()[i];
+	}
+      slice->SetPixel(Idx, it.Get());
+      }
+
+    SliceFilterType::Pointer sfilter = SliceFilterType::New();
+    sfilter->SetInput(slice);
+    sfilter->SetKernel(K);
+    sfilter->Update();
+    SliceOpenType::Pointer sopen = SliceOpenType::New();
+    sopen->SetInput(slice);
+    sopen->SetKernel(K);
+    sopen->Update();
+
+    itk::ImageRegionIteratorWithIndex<IType> oit(filter->GetOutput(), Slice);
+    for (oit.GoToBegin(); !oit.IsAtEnd(); ++oit)
+      {
+      SType::IndexType Idx;
+      for (unsigned i = 0, k = 0; i < dim; i++)
+	{
+	if (i != axis) Idx[k++] = oit.GetIndex()[i];
+	}
+      if (sfilter->GetOutput()->GetPixel(Idx) != oit.Get()) ++diff;
+      if (sopen->GetOutput()->GetPixel(Idx) != open->GetOutput()->GetPixel(oit.GetIndex())) ++diff;
+      }
+    }
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ between batch and slice by slice results" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
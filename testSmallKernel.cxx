@@ -0,0 +1,141 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+#include "itkAnchorSmallKernel.h"
+
+// compare the small kernel path, at each level of vector
+// instructions, with the anchor lines
+
+template <class TFilter, class TImage>
+typename TImage::Pointer apply(TImage * input, const typename TFilter::KernelType &K, bool small)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->SetUseSmallKernels(small);
+  filter->Update();
+  typename TImage::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  return result;
+}
+
+template <class TFilter, class TImage>
+bool compare(TImage * input, const typename TFilter::KernelType &K, const char * name)
+{
+  typename TImage::Pointer expected = apply<TFilter, TImage>(input, K, false);
+  bool ok = true;
+  for (int level = itk::AnchorSimd::Scalar; level <= itk::AnchorSimd::GetSupportedLevel(); level++)
+    {
+    itk::AnchorSimd::SetLevel(level);
+    typename TImage::Pointer result = apply<TFilter, TImage>(input, K, true);
+    unsigned long diff = 0;
+    itk::ImageRegionIteratorWithIndex<TImage> it(expected, expected->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      if (result->GetPixel(it.GetIndex()) != it.Get()) ++diff;
+      }
+    if (diff)
+      {
+      std::cerr << name << ", " << itk::AnchorSimd::GetLevelName(level) << ": "
+		<< diff << " pixels differ" << std::endl;
+      ok = false;
+      }
+    }
+  itk::AnchorSimd::SetLevel(itk::AnchorSimd::AVX2);
+  return ok;
+}
+
+template <class TImage>
+bool check(TImage * input, const char * type, bool poly)
+{
+  const unsigned int dim = TImage::ImageDimension;
+  typedef itk::FlatStructuringElement<dim> SEType;
+  bool ok = true;
+  for (int r = 1; r <= 3; r++)
+    {
+    typename SEType::RadiusType Rad;
+    Rad.Fill(r);
+    std::vector<SEType> kernels;
+    kernels.push_back(SEType::Box(Rad));
+    if (poly)
+      {
+      kernels.push_back(SEType::Poly(Rad, 4));
+      }
+    for (unsigned k = 0; k < kernels.size(); k++)
+      {
+      const SEType &K = kernels[k];
+      if (!itk::isSmallKernel(K.GetLines(), K.GetPeriods()))
+	{
+	std::cerr << type << ": kernel " << k << " of radius " << r << " isn't small" << std::endl;
+	ok = false;
+	continue;
+	}
+      ok &= compare<itk::AnchorErodeImageFilter<TImage, SEType>, TImage>(input, K, type);
+      ok &= compare<itk::AnchorDilateImageFilter<TImage, SEType>, TImage>(input, K, type);
+      ok &= compare<itk::AnchorOpenImageFilter<TImage, SEType>, TImage>(input, K, type);
+      ok &= compare<itk::AnchorCloseImageFilter<TImage, SEType>, TImage>(input, K, type);
+      }
+    }
+  return ok;
+}
+
+// an image of random values, of odd sizes so that the rows end with
+// a part of a vector
+template <class TImage>
+typename TImage::Pointer randomImage(unsigned long size, typename TImage::PixelType range)
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::RegionType region;
+  typename TImage::SizeType sz;
+  for (unsigned d = 0; d < TImage::ImageDimension; d++)
+    {
+    sz[d] = size + 2 * d + 1;
+    }
+  region.SetSize(sz);
+  image->SetRegions(region);
+  image->Allocate();
+  srand(1);
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    it.Set((typename TImage::PixelType)(range * ((double)rand() / RAND_MAX) - range / 2));
+    }
+  return image;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " input" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::Image< unsigned char, 2 > IType;
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+
+  std::cout << "vector instructions: "
+	    << itk::AnchorSimd::GetLevelName(itk::AnchorSimd::GetSupportedLevel()) << std::endl;
+
+  bool ok = true;
+  ok &= check<IType>(reader->GetOutput(), "unsigned char", true);
+  ok &= check< itk::Image<short, 2> >(randomImage< itk::Image<short, 2> >(70, 2000), "short", true);
+  ok &= check< itk::Image<unsigned short, 2> >(randomImage< itk::Image<unsigned short, 2> >(45, 65000), "unsigned short", true);
+  ok &= check< itk::Image<float, 2> >(randomImage< itk::Image<float, 2> >(50, 100), "float", true);
+  ok &= check< itk::Image<int, 2> >(randomImage< itk::Image<int, 2> >(40, 1000), "int", true);
+  ok &= check< itk::Image<unsigned char, 3> >(randomImage< itk::Image<unsigned char, 3> >(21, 255), "unsigned char 3D", false);
+
+  if (!ok)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorStreamingDilate.h"
+
+// push shifted copies of an image and compare each result with the
+// dilation of the frames followed by the maximum over the last ones,
+// then again after a change of kernel, which restarts the stream
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+
+int main(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius frames" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+
+  typedef itk::FlatStructuringElement<dim> SEType;
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  SEType K = SEType::Poly(Rad, atoi(argv[2]));
+  unsigned int frames = atoi(argv[4]);
+
+  typedef itk::AnchorStreamingDilate<IType, SEType> StreamType;
+  StreamType::Pointer stream = StreamType::New();
+  stream->SetKernel(K);
+  stream->SetNumberOfFrames(frames);
+
+  typedef itk::AnchorDilateImageFilter<IType, SEType> FilterType;
+  IType::RegionType All = reader->GetOutput()->GetLargestPossibleRegion();
+  std::vector<IType::Pointer> dilated;
+
+  // the same image object is reused for every frame
+  IType::Pointer frame = IType::New();
+  frame->SetRegions(All);
+  frame->Allocate();
+
+  for (unsigned long n = 0; n < 6 * frames + 4; n++)
+    {
+    unsigned long f = n % (3 * frames + 2);
+    if (n && !f)
+      {
+      Rad.Fill(atoi(argv[3]) / 2 + 1);
+      K = SEType::Poly(Rad, atoi(argv[2]));
+      stream->SetKernel(K);
+      dilated.clear();
+      }
+    // a moving copy of the input, brighter every other frame
+    itk::ImageRegionIteratorWithIndex<IType> fIt(frame, All);
+    for (fIt.GoToBegin(); !fIt.IsAtEnd(); ++fIt)
+      {
+      IType::IndexType Idx = fIt.GetIndex();
+      IType::IndexType SIdx;
+      SIdx[0] = All.GetIndex()[0] + (Idx[0] - All.GetIndex()[0] + 5 * f) % All.GetSize()[0];
+      SIdx[1] = All.GetIndex()[1] + (Idx[1] - All.GetIndex()[1] + 2 * f) % All.GetSize()[1];
+      PType v = reader->GetOutput()->GetPixel(SIdx);
+      fIt.Set((f % 2) ? v : v / 2);
+      }
+    frame->Modified();
+    IType::Pointer result = stream->PushFrame(frame);
+
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(frame);
+    filter->SetKernel(K);
+    filter->Update();
+    IType::Pointer d = filter->GetOutput();
+    d->DisconnectPipeline();
+    dilated.push_back(d);
+
+    unsigned long diff = 0;
+    itk::ImageRegionIteratorWithIndex<IType> cIt(result, All);
+    for (cIt.GoToBegin(); !cIt.IsAtEnd(); ++cIt)
+      {
+      PType Extreme = 0;
+      for (unsigned long g = (f + 1 > frames) ? f + 1 - frames : 0; g <= f; g++)
+	{
+	Extreme = std::max(Extreme, dilated[g]->GetPixel(cIt.GetIndex()));
+	}
+      if (Extreme != cIt.Get()) ++diff;
+      }
+    if (diff)
+      {
+      std::cerr << diff << " pixels differ at frame " << n << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+#include "itkAnchorStridedMorphology.h"
+
+// compare the strided entry point, on a transposed and flipped view
+// of a padded buffer and in place on a plain buffer, with the image
+// filters
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::FlatStructuringElement<dim> SEType;
+typedef itk::AnchorStridedMorphology<PType, dim> StridedType;
+
+template <class TFilter>
+IType::Pointer runFilter(IType * input, const SEType &K)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput(input);
+  filter->SetKernel(K);
+  filter->Update();
+  IType::Pointer result = filter->GetOutput();
+  result->DisconnectPipeline();
+  return result;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+  IType::RegionType All = input->GetLargestPossibleRegion();
+  const long nx = All.GetSize()[0];
+  const long ny = All.GetSize()[1];
+
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  SEType K = SEType::Poly(Rad, atoi(argv[2]));
+
+  IType::Pointer expected[4];
+  expected[StridedType::ERODE] = runFilter<itk::AnchorErodeImageFilter<IType, SEType> >(input, K);
+  expected[StridedType::DILATE] = runFilter<itk::AnchorDilateImageFilter<IType, SEType> >(input, K);
+  expected[StridedType::OPEN] = runFilter<itk::AnchorOpenImageFilter<IType, SEType> >(input, K);
+  expected[StridedType::CLOSE] = runFilter<itk::AnchorCloseImageFilter<IType, SEType> >(input, K);
+
+  // the pixel (x, y) is at row x, column ny - 1 - y of a buffer with
+  // rows of ny + 5 pixels
+  const long pitch = ny + 5;
+  std::vector<PType> view(nx * pitch, 0);
+  std::vector<PType> plain(nx * ny);
+  std::vector<PType> out(nx * pitch, 0);
+  StridedType::SizeType Size;
+  Size[0] = nx;
+  Size[1] = ny;
+  StridedType::StrideType ViewStrides;
+  ViewStrides[0] = pitch * sizeof(PType);
+  ViewStrides[1] = -(long)sizeof(PType);
+  StridedType::StrideType PlainStrides;
+  PlainStrides[0] = sizeof(PType);
+  PlainStrides[1] = nx * sizeof(PType);
+  const long viewStart = ny - 1;
+
+  StridedType::Pointer strided = StridedType::New();
+  strided->SetKernel(K);
+  unsigned long diff = 0;
+  for (int op = StridedType::ERODE; op <= StridedType::CLOSE; op++)
+    {
+    itk::ImageRegionIteratorWithIndex<IType> it(input, All);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      IType::IndexType Idx = it.GetIndex();
+      long x = Idx[0] - All.GetIndex()[0];
+      long y = Idx[1] - All.GetIndex()[1];
+      view[viewStart + x * pitch - y] = it.Get();
+      plain[x + y * nx] = it.Get();
+      }
+    strided->SetOperation((StridedType::OperationType)op);
+    // from the view to the same layout in another buffer
+    strided->Run(&(view[viewStart]), ViewStrides, &(out[viewStart]), ViewStrides, Size);
+    // in place
+    strided->Run(&(plain[0]), PlainStrides, &(plain[0]), PlainStrides, Size);
+
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      IType::IndexType Idx = it.GetIndex();
+      long x = Idx[0] - All.GetIndex()[0];
+      long y = Idx[1] - All.GetIndex()[1];
+      PType E = expected[op]->GetPixel(Idx);
+      if (out[viewStart + x * pitch - y] != E) ++diff;
+      if (plain[x + y * nx] != E) ++diff;
+      }
+    // the padding is left alone
+    for (long x = 0; x < nx; x++)
+      {
+      for (long p = ny; p < pitch; p++)
+	{
+	if (out[x * pitch + p] != 0) ++diff;
+	}
+      }
+    }
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ from the image filters" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // a kernel without lines copies the view
+  Rad.Fill(0);
+  strided->SetKernel(SEType::Box(Rad));
+  strided->SetOperation(StridedType::DILATE);
+  std::fill(out.begin(), out.end(), 0);
+  strided->Run(&(view[viewStart]), ViewStrides, &(out[viewStart]), ViewStrides, Size);
+  if (out != view)
+    {
+    std::cerr << "a kernel without lines didn't copy the input" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
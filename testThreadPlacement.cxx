@@ -0,0 +1,239 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenBankImageFilter.h"
+#include "itkAnchorThreadPlacement.h"
+
+// first touch allocation and pinned threads must give the same result
+// as the plain sweeps. On a host with a single node the first touch is
+// forced, so that it is exercised anyway.
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::Image< PType, dim + 1 > VType;
+typedef itk::Image< unsigned short, dim > OType;
+typedef itk::FlatStructuringElement<dim> SEType;
+
+template <class TImage>
+unsigned long compare(TImage * a, TImage * b)
+{
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<TImage> it(a, a->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (b->GetPixel(it.GetIndex()) != it.Get()) ++diff;
+    }
+  return diff;
+}
+
+// the CPUs the process may run on, as a list
+std::string allowedCPUs()
+{
+  std::string list;
+#if defined(__linux__)
+  cpu_set_t mask;
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+    {
+    for (int c = 0; c < CPU_SETSIZE; c++)
+      {
+      if (CPU_ISSET(c, &mask))
+	{
+	char buf[16];
+	sprintf(buf, "%s%d", list.empty() ? "" : ",", c);
+	list += buf;
+	}
+      }
+    }
+#endif
+  return list;
+}
+
+bool checkPlacement()
+{
+  bool ok = true;
+  itk::AnchorThreadPlacement placement;
+  if (!placement.SetCPUList("0-3,8") || (placement.GetCPUs().size() != 5) ||
+      (placement.GetCPUs()[3] != 3) || (placement.GetCPUs()[4] != 8))
+    {
+    std::cerr << "0-3,8 isn't parsed" << std::endl;
+    ok = false;
+    }
+  if (placement.SetCPUList("3-1") || placement.SetCPUList("a") ||
+      placement.SetCPUList("1,") || placement.SetCPUList("2-x") ||
+      !placement.GetCPUs().empty())
+    {
+    std::cerr << "an invalid list is accepted" << std::endl;
+    ok = false;
+    }
+  if (!placement.SetCPUList("") || !placement.GetCPUs().empty())
+    {
+    std::cerr << "an empty list isn't accepted" << std::endl;
+    ok = false;
+    }
+  if (itk::AnchorThreadPlacement::GetNumberOfNodes() < 1)
+    {
+    std::cerr << "no NUMA node" << std::endl;
+    ok = false;
+    }
+  std::cout << itk::AnchorThreadPlacement::GetNumberOfNodes() << " NUMA nodes" << std::endl;
+
+#if defined(__linux__)
+  // pin this thread to the last CPU it may use, and get its affinity
+  // back afterwards
+  std::string cpus = allowedCPUs();
+  std::string last = cpus.substr(cpus.rfind(',') + 1);
+  placement.SetCPUList(last);
+  cpu_set_t before;
+  sched_getaffinity(0, sizeof(before), &before);
+    {
+    itk::AnchorPinnedThread pin(placement, 5);
+    cpu_set_t pinned;
+    sched_getaffinity(0, sizeof(pinned), &pinned);
+    if (!pin.GetPinned() || (CPU_COUNT(&pinned) != 1) || !CPU_ISSET(atoi(last.c_str()), &pinned))
+      {
+      std::cerr << "the thread isn't pinned to CPU " << last << std::endl;
+      ok = false;
+      }
+    }
+  cpu_set_t after;
+  sched_getaffinity(0, sizeof(after), &after);
+  if (!CPU_EQUAL(&before, &after))
+    {
+    std::cerr << "the affinity of the thread isn't restored" << std::endl;
+    ok = false;
+    }
+#endif
+  return ok;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " input radius threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+  int threads = atoi(argv[3]);
+
+  bool ok = checkPlacement();
+
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[2]));
+  SEType K = SEType::Poly(Rad, 4);
+  std::string cpus = allowedCPUs();
+
+  typedef itk::AnchorDilateImageFilter<IType, SEType> FilterType;
+  FilterType::Pointer plain = FilterType::New();
+  plain->SetInput(input);
+  plain->SetKernel(K);
+  plain->SetNumberOfThreads(1);
+  plain->Update();
+
+  // as found on this host, and forced to two nodes
+  for (unsigned nodes = 0; nodes <= 2; nodes += 2)
+    {
+    itk::AnchorThreadPlacement::SetNumberOfNodes(nodes);
+    FilterType::Pointer placed = FilterType::New();
+    placed->SetInput(input);
+    placed->SetKernel(K);
+    placed->SetNumberOfThreads(threads);
+    placed->UseLineSchedulerOn();
+    placed->UseFirstTouchOn();
+    placed->SetCPUList(cpus);
+    placed->Update();
+    unsigned long diff = compare<IType>(plain->GetOutput(), placed->GetOutput());
+    if (diff)
+      {
+      std::cerr << diff << " pixels differ with the line scheduler and " << nodes << " nodes" << std::endl;
+      ok = false;
+      }
+    }
+
+  // batch mode, on a stack of shifted copies of the image
+  IType::RegionType In = input->GetLargestPossibleRegion();
+  VType::RegionType All;
+  VType::SizeType ASize;
+  ASize[0] = In.GetSize()[0];
+  ASize[1] = In.GetSize()[1];
+  ASize[2] = 5;
+  All.SetSize(ASize);
+  VType::Pointer stack = VType::New();
+  stack->SetRegions(All);
+  stack->Allocate();
+  itk::ImageRegionIteratorWithIndex<VType> stIt(stack, All);
+  for (stIt.GoToBegin(); !stIt.IsAtEnd(); ++stIt)
+    {
+    VType::IndexType Idx = stIt.GetIndex();
+    IType::IndexType SIdx;
+    SIdx[0] = In.GetIndex()[0] + (Idx[0] + 7 * Idx[2]) % ASize[0];
+    SIdx[1] = In.GetIndex()[1] + (Idx[1] + 3 * Idx[2]) % ASize[1];
+    stIt.Set(input->GetPixel(SIdx));
+    }
+  typedef itk::AnchorDilateImageFilter<VType, itk::FlatStructuringElement<dim + 1> > StackFilterType;
+  StackFilterType::Pointer stackPlain = StackFilterType::New();
+  stackPlain->SetInput(stack);
+  stackPlain->SetSliceKernel(K, 2);
+  stackPlain->SetNumberOfThreads(threads);
+  stackPlain->Update();
+  StackFilterType::Pointer stackPlaced = StackFilterType::New();
+  stackPlaced->SetInput(stack);
+  stackPlaced->SetSliceKernel(K, 2);
+  stackPlaced->SetNumberOfThreads(threads);
+  stackPlaced->UseFirstTouchOn();
+  stackPlaced->SetCPUList(cpus);
+  stackPlaced->Update();
+  unsigned long diff = compare<VType>(stackPlain->GetOutput(), stackPlaced->GetOutput());
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ in batch mode" << std::endl;
+    ok = false;
+    }
+
+  // a bank of openings with its orientation image
+  typedef itk::AnchorOpenBankImageFilter<IType, OType> BankType;
+  BankType::Pointer bankPlain = BankType::New();
+  bankPlain->SetInput(input);
+  bankPlain->SetNumberOfAngles(12);
+  bankPlain->ComputeOrientationOn();
+  bankPlain->SetNumberOfThreads(1);
+  bankPlain->Update();
+  BankType::Pointer bankPlaced = BankType::New();
+  bankPlaced->SetInput(input);
+  bankPlaced->SetNumberOfAngles(12);
+  bankPlaced->ComputeOrientationOn();
+  bankPlaced->SetNumberOfThreads(threads);
+  bankPlaced->UseFirstTouchOn();
+  bankPlaced->SetCPUList(cpus);
+  bankPlaced->Update();
+  if (compare<IType>(bankPlain->GetOutput(), bankPlaced->GetOutput()) ||
+      compare<OType>(bankPlain->GetOrientationOutput(), bankPlaced->GetOrientationOutput()))
+    {
+    std::cerr << "the banks differ" << std::endl;
+    ok = false;
+    }
+
+  // an invalid list is refused
+  bool thrown = false;
+  try
+    {
+    plain->SetCPUList("1-");
+    }
+  catch (itk::ExceptionObject &)
+    {
+    thrown = true;
+    }
+  if (!thrown)
+    {
+    std::cerr << "an invalid CPU list is accepted" << std::endl;
+    ok = false;
+    }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,162 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionConstIterator.h"
+
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorOpenImageFilter.h"
+#include "itkAnchorCloseImageFilter.h"
+#include "itkAnchorTileCache.h"
+
+// compare the tiles of the cache and the requested regions of the
+// filters with the filters applied to the whole image, before and
+// after a change of tile size
+const int dim = 2;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+
+unsigned long compare(const IType * full, const IType * part, const IType::RegionType &region)
+{
+  itk::ImageRegionConstIterator<IType> it1(full, region);
+  itk::ImageRegionConstIterator<IType> it2(part, region);
+  unsigned long diff = 0;
+  for (it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2)
+    {
+    if (it1.Get() != it2.Get()) ++diff;
+    }
+  return diff;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius tilesize" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+
+  typedef itk::FlatStructuringElement<dim> SEType;
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  SEType K = SEType::Poly(Rad, atoi(argv[2]));
+
+  typedef itk::AnchorErodeImageFilter<IType, SEType> ErodeType;
+  typedef itk::AnchorDilateImageFilter<IType, SEType> DilateType;
+
+  ErodeType::Pointer erode = ErodeType::New();
+  erode->SetInput( reader->GetOutput() );
+  erode->SetKernel(K);
+  DilateType::Pointer dilate = DilateType::New();
+  dilate->SetInput( reader->GetOutput() );
+  dilate->SetKernel(K);
+  typedef itk::AnchorOpenImageFilter<IType, SEType> OpenType;
+  typedef itk::AnchorCloseImageFilter<IType, SEType> CloseType;
+  OpenType::Pointer open = OpenType::New();
+  open->SetInput( reader->GetOutput() );
+  open->SetKernel(K);
+  CloseType::Pointer close = CloseType::New();
+  close->SetInput( reader->GetOutput() );
+  close->SetKernel(K);
+  erode->Update();
+  dilate->Update();
+  open->Update();
+  close->Update();
+
+  typedef itk::AnchorTileCache<IType, SEType> CacheType;
+  CacheType::Pointer cache = CacheType::New();
+  CacheType::SizeType TSize;
+  TSize.Fill(atoi(argv[4]));
+  cache->SetTileSize(TSize);
+  cache->SetMaximumNumberOfTiles(6);
+  cache->SetInput( reader->GetOutput() );
+
+  const IType * results[4];
+  results[CacheType::ERODE] = erode->GetOutput();
+  results[CacheType::DILATE] = dilate->GetOutput();
+  results[CacheType::OPEN] = open->GetOutput();
+  results[CacheType::CLOSE] = close->GetOutput();
+
+  IType::RegionType All = reader->GetOutput()->GetLargestPossibleRegion();
+  IType::IndexType Corner;
+  for (unsigned i = 0; i < dim; i++)
+    {
+    Corner[i] = All.GetIndex()[i] + All.GetSize()[i] - 1;
+    }
+  CacheType::IndexType Last = cache->GetTileIndex(Corner);
+  // pan across the image twice, so that some tiles come from the
+  // cache, some are prefetched and some have been dropped
+  for (int pass = 0; pass < 2; pass++)
+    {
+    for (long y = 0; y <= Last[1]; y++)
+      {
+      for (long x = 0; x <= Last[0]; x++)
+	{
+	CacheType::IndexType Tile;
+	Tile[0] = x;
+	Tile[1] = y;
+	for (int op = 0; op < 4; op++)
+	  {
+	  IType::ConstPointer T = cache->GetTile(Tile, K, (CacheType::OperationType)op);
+	  unsigned long diff = compare(results[op], T, cache->GetTileRegion(Tile));
+	  if (diff)
+	    {
+	    std::cerr << diff << " pixels differ in tile " << Tile << " for operation " << op << std::endl;
+	    return EXIT_FAILURE;
+	    }
+	  }
+	}
+      }
+    }
+  std::cout << cache->GetNumberOfComputedTiles() << " tiles computed" << std::endl;
+
+  // another tile size drops the tiles of the old one
+  TSize.Fill(atoi(argv[4]) / 2 + 1);
+  cache->SetTileSize(TSize);
+  if (cache->GetNumberOfCachedTiles())
+    {
+    std::cerr << "tiles of the old size were kept" << std::endl;
+    return EXIT_FAILURE;
+    }
+  CacheType::IndexType First;
+  First.Fill(1);
+  for (int op = 0; op < 4; op++)
+    {
+    IType::ConstPointer T = cache->GetTile(First, K, (CacheType::OperationType)op);
+    if (T->GetBufferedRegion() != cache->GetTileRegion(First) ||
+	compare(results[op], T, cache->GetTileRegion(First)))
+      {
+      std::cerr << "wrong tile after a change of tile size for operation " << op << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // a requested region of the filter
+  IType::RegionType Part;
+  IType::IndexType PStart;
+  IType::SizeType PSize;
+  for (unsigned i = 0; i < dim; i++)
+    {
+    PStart[i] = All.GetIndex()[i] + All.GetSize()[i] / 4;
+    PSize[i] = All.GetSize()[i] / 2;
+    }
+  Part.SetIndex(PStart);
+  Part.SetSize(PSize);
+  DilateType::Pointer part = DilateType::New();
+  part->SetInput( reader->GetOutput() );
+  part->SetKernel(K);
+  part->GetOutput()->SetRequestedRegion(Part);
+  part->Update();
+  unsigned long diff = compare(dilate->GetOutput(), part->GetOutput(), Part);
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ in the requested region" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
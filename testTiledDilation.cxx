@@ -0,0 +1,69 @@
+#include "itkImageFileReader.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionConstIterator.h"
+
+#include "itkAnchorDilateImageFilter.h"
+
+// compare the tiled sweep with the normal one
+int main(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius fusedpasses [tilesize]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const int dim = 2;
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+
+  typedef itk::FlatStructuringElement<dim> SEType;
+
+  typedef itk::AnchorDilateImageFilter<IType, SEType> FilterType;
+
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  SEType K = SEType::Poly(Rad, atoi(argv[2]));
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetKernel(K);
+  filter->Update();
+
+  FilterType::Pointer tiled = FilterType::New();
+  tiled->SetInput( reader->GetOutput() );
+  tiled->SetKernel(K);
+  tiled->UseTilingOn();
+  tiled->SetFusedPasses(atoi(argv[4]));
+  if (argc > 5)
+    {
+    FilterType::SizeType TSize;
+    TSize.Fill(atoi(argv[5]));
+    tiled->SetTileSize(TSize);
+    }
+  itk::SimpleFilterWatcher watcher(tiled, "tiled");
+  tiled->Update();
+
+  itk::ImageRegionConstIterator<IType> it1(filter->GetOutput(),
+					   filter->GetOutput()->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<IType> it2(tiled->GetOutput(),
+					   tiled->GetOutput()->GetLargestPossibleRegion());
+  unsigned long diff = 0;
+  for (it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2)
+    {
+    if (it1.Get() != it2.Get()) ++diff;
+    }
+  if (diff)
+    {
+    std::cerr << diff << " pixels differ between tiled and untiled results" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
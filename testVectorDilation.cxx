@@ -0,0 +1,196 @@
+#include "itkImageFileReader.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkVector.h"
+#include "itkVectorImage.h"
+
+#include "itkAnchorDilateImageFilter.h"
+#include "itkAnchorErodeImageFilter.h"
+#include "itkAnchorVectorDilateImageFilter.h"
+#include "itkAnchorVectorErodeImageFilter.h"
+
+// compare the marginal filters on images of vectors and on vector
+// images with the scalar filters applied to each channel
+const int dim = 2;
+const unsigned int channels = 3;
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef itk::Image< itk::Vector<PType, channels>, dim > VType;
+typedef itk::VectorImage< PType, dim > VIType;
+typedef itk::FlatStructuringElement<dim> SEType;
+
+// the channels are the image, its negative and a shifted copy
+PType channel(IType * image, IType::IndexType Idx, unsigned c)
+{
+  IType::RegionType All = image->GetLargestPossibleRegion();
+  if (c == 1)
+    {
+    return 255 - image->GetPixel(Idx);
+    }
+  if (c == 2)
+    {
+    Idx[0] = All.GetIndex()[0] + (Idx[0] - All.GetIndex()[0] + 11) % All.GetSize()[0];
+    }
+  return image->GetPixel(Idx);
+}
+
+template <class TScalarFilter>
+unsigned long compareChannel(IType * input, unsigned c, const SEType &K,
+			     VType * vout, VIType * viout)
+{
+  IType::RegionType All = input->GetLargestPossibleRegion();
+  IType::Pointer plane = IType::New();
+  plane->SetRegions(All);
+  plane->Allocate();
+  itk::ImageRegionIteratorWithIndex<IType> it(plane, All);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    it.Set(channel(input, it.GetIndex(), c));
+    }
+  typename TScalarFilter::Pointer filter = TScalarFilter::New();
+  filter->SetInput(plane);
+  filter->SetKernel(K);
+  filter->Update();
+
+  unsigned long diff = 0;
+  itk::ImageRegionIteratorWithIndex<IType> oit(filter->GetOutput(), All);
+  for (oit.GoToBegin(); !oit.IsAtEnd(); ++oit)
+    {
+    if (vout->GetPixel(oit.GetIndex())[c] != oit.Get()) ++diff;
+    if (viout->GetPixel(oit.GetIndex())[c] != oit.Get()) ++diff;
+    }
+  return diff;
+}
+
+int main(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " input lines radius" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+  IType * input = reader->GetOutput();
+  IType::RegionType All = input->GetLargestPossibleRegion();
+
+  VType::Pointer vimage = VType::New();
+  vimage->SetRegions(All);
+  vimage->Allocate();
+  VIType::Pointer viimage = VIType::New();
+  viimage->SetRegions(All);
+  viimage->SetVectorLength(channels);
+  viimage->Allocate();
+  itk::ImageRegionIteratorWithIndex<VType> vit(vimage, All);
+  for (vit.GoToBegin(); !vit.IsAtEnd(); ++vit)
+    {
+    VType::PixelType P;
+    VIType::PixelType VP(channels);
+    for (unsigned c = 0; c < channels; c++)
+      {
+      P[c] = channel(input, vit.GetIndex(), c);
+      VP[c] = P[c];
+      }
+    vit.Set(P);
+    viimage->SetPixel(vit.GetIndex(), VP);
+    }
+
+  SEType::RadiusType Rad;
+  Rad.Fill(atoi(argv[3]));
+  SEType K = SEType::Poly(Rad, atoi(argv[2]));
+
+  typedef itk::AnchorVectorDilateImageFilter<VType, SEType> VDilateType;
+  VDilateType::Pointer vdilate = VDilateType::New();
+  vdilate->SetInput(vimage);
+  vdilate->SetKernel(K);
+  vdilate->Update();
+  typedef itk::AnchorVectorDilateImageFilter<VIType, SEType> VIDilateType;
+  VIDilateType::Pointer vidilate = VIDilateType::New();
+  vidilate->SetInput(viimage);
+  vidilate->SetKernel(K);
+  vidilate->Update();
+
+  typedef itk::AnchorVectorErodeImageFilter<VType, SEType> VErodeType;
+  VErodeType::Pointer verode = VErodeType::New();
+  verode->SetInput(vimage);
+  verode->SetKernel(K);
+  verode->Update();
+  typedef itk::AnchorVectorErodeImageFilter<VIType, SEType> VIErodeType;
+  VIErodeType::Pointer vierode = VIErodeType::New();
+  vierode->SetInput(viimage);
+  vierode->SetKernel(K);
+  vierode->Update();
+
+  if (vidilate->GetOutput()->GetNumberOfComponentsPerPixel() != channels)
+    {
+    std::cerr << "Wrong number of components in the output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::AnchorDilateImageFilter<IType, SEType> DilateType;
+  typedef itk::AnchorErodeImageFilter<IType, SEType> ErodeType;
+  unsigned long diff = 0;
+  for (unsigned c = 0; c < channels; c++)
+    {
+    diff += compareChannel<DilateType>(input, c, K, vdilate->GetOutput(), vidilate->GetOutput());
+    diff += compareChannel<ErodeType>(input, c, K, verode->GetOutput(), vierode->GetOutput());
+    }
+  if (diff)
+    {
+    std::cerr << diff << " components differ from the scalar results" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // a part of the image, with the lines shared by two threads, only
+  // computes and reads the part of the image it needs
+  IType::RegionType Part;
+  IType::IndexType PStart;
+  IType::SizeType PSize;
+  for (unsigned i = 0; i < dim; i++)
+    {
+    PStart[i] = All.GetIndex()[i] + All.GetSize()[i] / 2;
+    PSize[i] = All.GetSize()[i] / 4;
+    }
+  Part.SetIndex(PStart);
+  Part.SetSize(PSize);
+  VIDilateType::Pointer part = VIDilateType::New();
+  part->SetInput(viimage);
+  part->SetKernel(K);
+  part->SetNumberOfThreads(2);
+  part->UpdateOutputInformation();
+  part->GetOutput()->SetRequestedRegion(Part);
+  part->Update();
+  IType::RegionType Needed = Part;
+  Needed.PadByRadius(Rad);
+  Needed.Crop(All);
+  if (!part->GetOutput()->GetBufferedRegion().IsInside(Part) ||
+      !Needed.IsInside(part->GetOutput()->GetBufferedRegion()))
+    {
+    std::cerr << "The whole image was computed for a part of it" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!Needed.IsInside(viimage->GetRequestedRegion()) ||
+      (viimage->GetRequestedRegion() == All))
+    {
+    std::cerr << "Wrong input requested region " << viimage->GetRequestedRegion() << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::ImageRegionIteratorWithIndex<VIType> pit(part->GetOutput(), Part);
+  for (pit.GoToBegin(); !pit.IsAtEnd(); ++pit)
+    {
+    for (unsigned c = 0; c < channels; c++)
+      {
+      if (pit.Get()[c] != vidilate->GetOutput()->GetPixel(pit.GetIndex())[c]) ++diff;
+      }
+    }
+  if (diff)
+    {
+    std::cerr << diff << " components differ in the requested region" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+